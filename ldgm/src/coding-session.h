@@ -15,7 +15,7 @@
 #ifndef CODING_SESSION
 #define CODING_SESSION
 
-#include <map>
+#include "rtp/received_extents.hpp"
 
 /** \class Coding_session
  *  \brief Abstract class Coding_session
@@ -45,12 +45,12 @@ class Coding_session
 	 * @param received_data Received data (source and parity)
 	 * @param buf_size Size of the received buffer
 	 * @param frame_size Output parameter for storing size of the decoded frame
-	 * @param valid_data Map storing pairs <offset, number of bytes> of received data
+	 * @param valid_data Received byte ranges of received_data
 	 * @return Recovered source data
 	 * */
 	virtual char*
 	    decode_frame ( char* received_data, int buf_size, int* frame_size, 
-		    std::map<int,int> valid_data) = 0;
+		    const received_extents &valid_data) = 0;
 };
 
 #endif
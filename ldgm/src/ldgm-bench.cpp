@@ -0,0 +1,241 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ldgm-bench.cpp
+ *
+ *    Description:  Microbenchmark of CPU LDGM coding
+ *
+ *                  Encodes a random frame, drops packets with the given loss
+ *                  rate and measures decoding time and recovery success for
+ *                  combinations of frame size, k/m/c, loss rate and decoder
+ *                  thread count. Intended to choose LDGM parameters for
+ *                  CPU-only receivers.
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "ldgm-session-cpu.h"
+#include "rtp/received_extents.hpp"
+#include "xor-simd.h"
+#include "../matrix-gen/matrix-generator.h"
+
+using std::string;
+using std::vector;
+using clk = std::chrono::steady_clock;
+
+struct kmc {
+    int k, m, c;
+};
+
+static void usage(const char *progname)
+{
+    printf("Usage:\n\t%s [-s <sizes>] [-p <k:m:c>[,...]] [-l <loss%%>[,...]] "
+           "[-t <threads>[,...]] [-P <pkt_size>] [-n <iter>]\n\n", progname);
+    printf("\t-s - frame sizes in bytes, suffixes k/M allowed (default 1M,16588800 - 4K UYVY)\n"
+           "\t-p - LDGM parameters (default 1000:500:7,1500:650:6,2000:1000:8)\n"
+           "\t-l - packet loss rates in percent (default 1,2,5)\n"
+           "\t-t - decoder thread counts (default 1)\n"
+           "\t-P - packet payload size used to simulate the loss (default 8000)\n"
+           "\t-n - iterations per combination (default 10)\n");
+}
+
+static vector<string> split(const char *str)
+{
+    vector<string> ret;
+    string s = str;
+    size_t pos = 0;
+    while (true) {
+        size_t next = s.find(',', pos);
+        ret.push_back(s.substr(pos, next - pos));
+        if (next == string::npos) {
+            return ret;
+        }
+        pos = next + 1;
+    }
+}
+
+static long parse_size(const string &s)
+{
+    char *end = nullptr;
+    double val = strtod(s.c_str(), &end);
+    if (*end == 'k' || *end == 'K') {
+        val *= 1000;
+    } else if (*end == 'M') {
+        val *= 1000 * 1000;
+    }
+    return (long) val;
+}
+
+/// XOR throughput of available kernels on a typical packet size
+static void bench_xor()
+{
+    const int len = 8000;
+    const int iters = 20000;
+    vector<char> src(len, 0x5a), dst(len, 0x3c);
+    printf("XOR kernels (%d B, best: %s):", len, ldgm_xor_best_isa());
+    for (const char *isa : { "scalar", "sse2", "avx2", "avx512" }) {
+        ldgm_xor_func_t f = ldgm_xor_get(isa);
+        if (f == nullptr) {
+            continue;
+        }
+        auto t0 = clk::now();
+        for (int i = 0; i < iters; ++i) {
+            f(dst.data(), src.data(), len);
+        }
+        double sec = std::chrono::duration<double>(clk::now() - t0).count();
+        printf(" %s %.1f GB/s", isa, (double) len * iters / sec / 1e9);
+    }
+    printf("\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+    vector<long> sizes = { 1000 * 1000, 3840 * 2160 * 2 };
+    vector<kmc> params = { { 1000, 500, 7 }, { 1500, 650, 6 }, { 2000, 1000, 8 } };
+    vector<double> losses = { 1, 2, 5 };
+    vector<int> thread_counts = { 1 };
+    int pkt_size = 8000;
+    int iterations = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "P:hl:n:p:s:t:")) != -1) {
+        switch (opt) {
+        case 'P':
+            pkt_size = atoi(optarg);
+            break;
+        case 'l':
+            losses.clear();
+            for (auto &s : split(optarg)) {
+                losses.push_back(atof(s.c_str()));
+            }
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 'p':
+            params.clear();
+            for (auto &s : split(optarg)) {
+                kmc p{};
+                if (sscanf(s.c_str(), "%d:%d:%d", &p.k, &p.m, &p.c) != 3) {
+                    fprintf(stderr, "Wrong LDGM parameters: %s\n", s.c_str());
+                    return 1;
+                }
+                params.push_back(p);
+            }
+            break;
+        case 's':
+            sizes.clear();
+            for (auto &s : split(optarg)) {
+                sizes.push_back(parse_size(s));
+            }
+            break;
+        case 't':
+            thread_counts.clear();
+            for (auto &s : split(optarg)) {
+                thread_counts.push_back(atoi(s.c_str()));
+            }
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (pkt_size <= 0 || iterations <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bench_xor();
+
+    std::mt19937 rng(1);
+    char matrix_file[] = "/tmp/ldgm-bench-XXXXXX";
+    int fd = mkstemp(matrix_file);
+    if (fd == -1) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    printf("%10s %16s %6s %4s %10s %10s %10s %9s\n", "frame [B]", "k:m:c",
+           "loss%", "thr", "enc [ms]", "dec [ms]", "dec max", "recovered");
+    for (const kmc &p : params) {
+        if (generate_ldgm_matrix(matrix_file, p.k, p.m, p.c, 1, 0) != 0) {
+            fprintf(stderr, "Unable to generate matrix %d:%d:%d\n", p.k, p.m, p.c);
+            continue;
+        }
+        for (int threads : thread_counts) {
+            LDGM_session_cpu session;
+            session.set_params(p.k, p.m, p.c);
+            session.set_pcMatrix(matrix_file);
+            session.set_threads(threads);
+            for (long size : sizes) {
+                vector<char> frame(size);
+                for (auto &b : frame) {
+                    b = (char) rng();
+                }
+                int buf_size = 0;
+                auto t0 = clk::now();
+                char *encoded = session.encode_frame(frame.data(), size, &buf_size);
+                double enc_ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+                if (encoded == nullptr) {
+                    continue;
+                }
+                if (buf_size / (p.k + p.m) > USHRT_MAX) {
+                    fprintf(stderr, "%ld B: symbol size exceeds 64 KiB, increase k\n", size);
+                    session.free_out_buf(encoded);
+                    continue;
+                }
+                vector<char> rx(buf_size);
+                for (double loss : losses) {
+                    std::bernoulli_distribution lost(loss / 100.0);
+                    double dec_sum = 0;
+                    double dec_max = 0;
+                    int ok = 0;
+                    for (int i = 0; i < iterations; ++i) {
+                        memcpy(rx.data(), encoded, buf_size);
+                        received_extents extents;
+                        for (int pos = 0; pos < buf_size; pos += pkt_size) {
+                            const int len = std::min(pkt_size, buf_size - pos);
+                            if (lost(rng)) {
+                                memset(rx.data() + pos, 0, len);
+                            } else {
+                                extents.add(pos, len);
+                            }
+                        }
+                        int frame_size = 0;
+                        t0 = clk::now();
+                        char *out = session.decode_frame(rx.data(), buf_size, &frame_size, extents);
+                        double ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+                        dec_sum += ms;
+                        dec_max = std::max(dec_max, ms);
+                        ok += frame_size == size && memcmp(out, frame.data(), size) == 0;
+                    }
+                    char kmc_str[32];
+                    snprintf(kmc_str, sizeof kmc_str, "%d:%d:%d", p.k, p.m, p.c);
+                    printf("%10ld %16s %6.2f %4d %10.3f %10.3f %10.3f %8.1f%%\n",
+                           size, kmc_str, loss, threads, enc_ms,
+                           dec_sum / iterations, dec_max,
+                           100.0 * ok / iterations);
+                    fflush(stdout);
+                }
+                session.free_out_buf(encoded);
+            }
+        }
+    }
+    unlink(matrix_file);
+    return 0;
+}
@@ -20,6 +20,14 @@
 #ifndef  LDGM_SESSION_CPU_INC
 #define  LDGM_SESSION_CPU_INC
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "ldgm-session.h"
 //#include "timer-util.h"
 
@@ -39,6 +47,7 @@ class LDGM_session_cpu : public LDGM_session
 		no_frames=0;
 	}                            /* constructor */
 	~LDGM_session_cpu () {
+		set_threads(1);
 		printf("LDGM TIME CPU: %f ms\n",this->elapsed_sum2/(double)this->no_frames2 );
 	 }                            /* constructor */
 
@@ -50,10 +59,12 @@ class LDGM_session_cpu : public LDGM_session
 
 	char*                                                                             
 	    decode_frame ( char* received_data, int buf_size, int* frame_size,
-		    std::map<int, int> valid_data );
+		    const received_extents &valid_data );
 
+	/// number of threads recovering independent parity equations in
+	/// decode_frame() (including the calling one)
 	void
-	    iterate ( Tanner_graph *graph);
+	    set_threads ( int count );
 
 	void
 	    free_out_buf (char *buf);
@@ -65,10 +76,45 @@ class LDGM_session_cpu : public LDGM_session
 	/* ====================  DATA MEMBERS  ======================================= */
 
     private:
+	bool
+	    recover ( char *received, int p_size, int constraint, int variable );
+
+	void
+	    build_adjacency ();
+
+	void
+	    run_parallel ( int count, const std::function<void(int)> &task );
+
+	void
+	    worker ();
+
 	/* ====================  DATA MEMBERS  ======================================= */
     double elapsed_sum;
 	long no_frames;
 
+	/// parity check matrix in the CSR form, built from pcm on first decode
+	const int *adj_pcm = nullptr;
+	std::vector<int> con_start, con_vars; ///< variables of each constraint
+	std::vector<int> var_start, var_cons; ///< constraints of each variable
+
+	/// per-frame peeling decoder state
+	std::vector<char> var_done;
+	std::vector<int> unknown_cnt; ///< not yet known variables per constraint
+	std::vector<int> frontier;    ///< constraints with a single unknown
+	std::vector<std::pair<int, int>> wave; ///< (constraint, variable) to recover
+
+	/// worker threads for run_parallel()
+	std::vector<std::thread> threads;
+	std::mutex pool_lock;
+	std::condition_variable pool_cv;
+	std::condition_variable pool_done_cv;
+	const std::function<void(int)> *pool_task = nullptr;
+	int pool_count = 0;
+	std::atomic<int> pool_next{0};
+	int pool_running = 0;
+	unsigned pool_generation = 0;
+	bool pool_exit = false;
+
 }; /* -----  end of class LDGM_session_cpu  ----- */
 
 #endif   /* ----- #ifndef LDGM_SESSION_CPU_INC  ----- */
@@ -162,7 +162,7 @@ void LDGM_session_gpu::encode ( char *source_data, char *parity )
 
 }
 
-char *LDGM_session_gpu::decode_frame ( char *received_data, int buf_size, int *frame_size, std::map<int, int> valid_data )
+char *LDGM_session_gpu::decode_frame ( char *received_data, int buf_size, int *frame_size, const received_extents &valid_data )
 {
     char *received = received_data;
 
@@ -172,24 +172,6 @@ char *LDGM_session_gpu::decode_frame ( char *received_data, int buf_size, int *f
     int p_size = buf_size / (param_m + param_k);
     // printf("%d p_size K: %d, M: %d, buf_size: %d, max_row_weight: %d \n",p_size,param_k,param_m,buf_size,max_row_weight);
 
-    //We need to merge intervals in the valid data vector
-    std::map <int, int> merged_intervals;
-    std::map<int, int>::iterator map_it;
-
-    if ( valid_data.size() != 0 )
-    {
-        for ( map_it = valid_data.begin(); map_it != valid_data.end(); )
-        {
-            int start = map_it->first;
-            int length = map_it->second;
-            while ( start + length == (++map_it)->first )
-                length += map_it->second;
-            merged_intervals.insert ( std::pair<int, int> (start, length) );
-        }
-    }
-
-    
-
     cudaError_t error;
     if (error_vec == NULL)
     {
@@ -209,26 +191,14 @@ char *LDGM_session_gpu::decode_frame ( char *received_data, int buf_size, int *f
     memset(sync_vec, 0, sizeof(int) * (param_k + param_m));
     int not_done = 0;
 
-    if ( merged_intervals.size() != 0
-       )
+    if ( !valid_data.empty() )
     {
 
         for (int i = 0; i < param_k + param_m; i++)
         {
             int node_offset = i * p_size;
 
-            map_it = merged_intervals.begin();
-
-            bool found = false;
-            while ( (map_it->first <= node_offset) && map_it != merged_intervals.end() )
-            {
-                map_it++;
-                found = true;
-            }
-            if ( found ) map_it--;
-
-            if ( found && (map_it->first + map_it->second) >=
-                    (node_offset + p_size) )
+            if ( valid_data.contains(node_offset, p_size) )
             {
                 //OK
                 error_vec[i] = 0;
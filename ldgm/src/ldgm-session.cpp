@@ -222,7 +222,7 @@ LDGM_session::encode_frame ( char* frame, int frame_size, int* out_buf_size )
 }
 
 char*
-LDGM_session::encode_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int frame_size, int* out_buf_size )
+LDGM_session::alloc_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int frame_size, int* out_buf_size )
 {
     int buf_size;
     int ps;
@@ -238,7 +238,6 @@ LDGM_session::encode_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int
     ps = buf_size/param_k;
 
     packet_size = ps;
-//    printf ( "ps: %d\n", ps );
     buf_size += param_m*ps;
     *out_buf_size = buf_size;
 
@@ -249,7 +248,10 @@ LDGM_session::encode_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int
         printf ( "Unable to allocate aligned memory\n" );
         return NULL;
     }
-    memset(out_buf, 0, buf_size);
+    // parity is zeroed by encode_parity()
+    memset(out_buf, 0, header_size);
+    memset((char *) out_buf + header_size + overall_size, 0,
+           param_k * ps - header_size - overall_size);
 
     //Insert frame size and copy input data into buffer
 
@@ -259,6 +261,28 @@ LDGM_session::encode_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int
     memcpy( ((char*)out_buf) + header_size, my_hdr, my_hdr_size);
     memcpy( ((char*)out_buf) + header_size + my_hdr_size, frame, frame_size);
 
+    return (char *) out_buf;
+}
+
+void
+LDGM_session::encode_parity ( char *buf, int ps )
+{
+    packet_size = ps;
+    memset(buf + param_k * ps, 0, param_m * ps);
+    this->encode ( buf, buf + param_k * ps );
+}
+
+char*
+LDGM_session::encode_hdr_frame ( char *my_hdr, int my_hdr_size, char* frame, int frame_size, int* out_buf_size )
+{
+    char *out_buf = alloc_hdr_frame(my_hdr, my_hdr_size, frame, frame_size, out_buf_size);
+    if (out_buf == NULL)
+    {
+        return NULL;
+    }
+    int ps = packet_size;
+    memset(out_buf + param_k * ps, 0, param_m * ps);
+
 #if 0
     int my_frame_size=my_hdr_size+frame_size;
 
@@ -75,6 +75,16 @@ class LDGM_session : public Coding_session
 	char*
 	    encode_hdr_frame( char *hdr, int hdr_size, char* frame, int frame_size, int* out_buf_size );
 
+	/* allocates encoded buffer and fills in only its systematic part (first
+	 * k packets), parity can be computed later by encode_parity() */
+	char*
+	    alloc_hdr_frame( char *hdr, int hdr_size, char* frame, int frame_size, int* out_buf_size );
+
+	/* computes parity of a buffer returned by alloc_hdr_frame() with the
+	 * packet size ps */
+	void
+	    encode_parity ( char *buf, int ps );
+
 	virtual void
 	    encode ( char* data, char* parity ) = 0;
 	
@@ -86,7 +96,7 @@ class LDGM_session : public Coding_session
 
 	virtual char*
 	    decode_frame ( char* received_data, int buf_size, int* frame_size, 
-		    std::map<int, int>  valid_data ) = 0;
+		    const received_extents &valid_data ) = 0;
 
 	void
 	    set_params ( unsigned short k,
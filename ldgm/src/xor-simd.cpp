@@ -0,0 +1,159 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  xor-simd.cpp
+ *
+ *    Description:  XOR kernels for LDGM coding with runtime ISA dispatch
+ *
+ *                  AVX2 and AVX-512 variants are compiled with function target
+ *                  attributes so that they do not require raising the -m flags
+ *                  of the whole build and are selected by CPUID at runtime.
+ *
+ * =====================================================================================
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "xor-simd.h"
+
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define LDGM_XOR_X86 1
+#include <immintrin.h>
+#endif
+
+/// XORs the tail not covered by the vector loop
+static inline void xor_tail(char *dst, const char *src, int len)
+{
+    int i = 0;
+    for ( ; i + 8 <= len; i += 8) {
+        uint64_t s, d;
+        memcpy(&s, src + i, sizeof s);
+        memcpy(&d, dst + i, sizeof d);
+        d ^= s;
+        memcpy(dst + i, &d, sizeof d);
+    }
+    for ( ; i < len; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+static void xor_scalar(char *dst, const char *src, int len)
+{
+    xor_tail(dst, src, len);
+}
+
+#ifdef LDGM_XOR_X86
+__attribute__((target("sse2")))
+static void xor_sse2(char *dst, const char *src, int len)
+{
+    int i = 0;
+    for ( ; i + 64 <= len; i += 64) {
+        for (int j = 0; j < 64; j += 16) {
+            __m128i s = _mm_loadu_si128((const __m128i *)(const void *) (src + i + j));
+            __m128i d = _mm_loadu_si128((__m128i *)(void *) (dst + i + j));
+            _mm_storeu_si128((__m128i *)(void *) (dst + i + j), _mm_xor_si128(s, d));
+        }
+    }
+    for ( ; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(const void *) (src + i));
+        __m128i d = _mm_loadu_si128((__m128i *)(void *) (dst + i));
+        _mm_storeu_si128((__m128i *)(void *) (dst + i), _mm_xor_si128(s, d));
+    }
+    xor_tail(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void xor_avx2(char *dst, const char *src, int len)
+{
+    int i = 0;
+    for ( ; i + 128 <= len; i += 128) {
+        for (int j = 0; j < 128; j += 32) {
+            __m256i s = _mm256_loadu_si256((const __m256i *)(const void *) (src + i + j));
+            __m256i d = _mm256_loadu_si256((__m256i *)(void *) (dst + i + j));
+            _mm256_storeu_si256((__m256i *)(void *) (dst + i + j), _mm256_xor_si256(s, d));
+        }
+    }
+    for ( ; i + 32 <= len; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(const void *) (src + i));
+        __m256i d = _mm256_loadu_si256((__m256i *)(void *) (dst + i));
+        _mm256_storeu_si256((__m256i *)(void *) (dst + i), _mm256_xor_si256(s, d));
+    }
+    xor_tail(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx512f")))
+static void xor_avx512(char *dst, const char *src, int len)
+{
+    int i = 0;
+    for ( ; i + 256 <= len; i += 256) {
+        for (int j = 0; j < 256; j += 64) {
+            __m512i s = _mm512_loadu_si512(src + i + j);
+            __m512i d = _mm512_loadu_si512(dst + i + j);
+            _mm512_storeu_si512(dst + i + j, _mm512_xor_si512(s, d));
+        }
+    }
+    for ( ; i + 64 <= len; i += 64) {
+        __m512i s = _mm512_loadu_si512(src + i);
+        __m512i d = _mm512_loadu_si512(dst + i);
+        _mm512_storeu_si512(dst + i, _mm512_xor_si512(s, d));
+    }
+    // remaining whole 32-bit words with a masked load/store (byte masks
+    // would need AVX512BW)
+    const int words = (len - i) / 4;
+    if (words > 0) {
+        const __mmask16 m = (__mmask16) ((1U << words) - 1);
+        __m512i s = _mm512_maskz_loadu_epi32(m, src + i);
+        __m512i d = _mm512_maskz_loadu_epi32(m, dst + i);
+        _mm512_mask_storeu_epi32(dst + i, m, _mm512_xor_si512(s, d));
+        i += words * 4;
+    }
+    xor_tail(dst + i, src + i, len - i);
+}
+#endif // defined LDGM_XOR_X86
+
+ldgm_xor_func_t ldgm_xor_get(const char *isa)
+{
+    if (isa == NULL) {
+        isa = ldgm_xor_best_isa();
+    }
+    if (strcmp(isa, "scalar") == 0) {
+        return xor_scalar;
+    }
+#ifdef LDGM_XOR_X86
+    __builtin_cpu_init();
+    if (strcmp(isa, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        return xor_sse2;
+    }
+    if (strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        return xor_avx2;
+    }
+    if (strcmp(isa, "avx512") == 0 && __builtin_cpu_supports("avx512f")) {
+        return xor_avx512;
+    }
+#endif
+    return NULL;
+}
+
+const char *ldgm_xor_best_isa()
+{
+#ifdef LDGM_XOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return "avx512";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return "avx2";
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
+
+void ldgm_xor(char *dst, const char *src, int len)
+{
+    static const ldgm_xor_func_t func = ldgm_xor_get(NULL);
+    func(dst, src, len);
+}
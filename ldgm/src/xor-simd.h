@@ -0,0 +1,32 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  xor-simd.h
+ *
+ *    Description:  XOR kernels for LDGM coding with runtime ISA dispatch
+ *
+ * =====================================================================================
+ */
+
+#ifndef XOR_SIMD_H
+#define XOR_SIMD_H
+
+/**
+ * XORs len bytes of src into dst. Buffers needn't be aligned.
+ */
+typedef void (*ldgm_xor_func_t)(char *dst, const char *src, int len);
+
+/**
+ * Returns XOR kernel for the given instruction set ("avx512", "avx2",
+ * "sse2" or "scalar") or the best one supported by the CPU if isa is NULL.
+ * Returns NULL if the ISA is unknown or not supported by the CPU/compiler.
+ */
+ldgm_xor_func_t ldgm_xor_get(const char *isa);
+
+/// name of the ISA of the kernel returned by ldgm_xor_get(NULL)
+const char *ldgm_xor_best_isa();
+
+/// XOR using the best kernel available
+void ldgm_xor(char *dst, const char *src, int len);
+
+#endif // XOR_SIMD_H
@@ -38,6 +38,8 @@
 #include "capture_filter.h"
 
 #include <assert.h>           // for assert
+#include <pthread.h>          // for pthread_mutex_lock, pthread_mutex_unlock
+#include <stddef.h>           // for offsetof
 #include <stdio.h>            // for printf, fprintf, stderr
 #include <stdlib.h>           // for free, NULL, atoi, calloc, malloc
 #include <string.h>           // for strcasecmp, strchr, strcmp, strdup...
@@ -47,10 +49,37 @@
 #include "module.h"           // for module, module_done, module_init_default
 #include "utils/color_out.h"  // for color_printf, TERM_BOLD, TERM_RESET
 #include "utils/list.h"       // for simple_linked_list_pop, simple_linked_l...
+#include "utils/video_frame_pool.h"
+#include "video_frame.h"      // for VIDEO_FRAME_DISPOSE, vf_alloc, vf_free
+
+enum {
+        MAX_FREE_SHELLS = 8,
+};
+
+/**
+ * Frame struct sharing tiles of a frame it wraps. Used to let metadata-only
+ * filters modify frame properties without altering the frame struct owned
+ * by the producer.
+ */
+struct frame_shell {
+        struct frame_shell_pool *pool;
+        struct video_frame *inner;
+        struct video_frame *frame;
+        unsigned max_tiles;
+};
+
+/// free-list of frame shells, shared by the chain and the shells given out
+struct frame_shell_pool {
+        pthread_mutex_t lock;
+        struct frame_shell *free_shells[MAX_FREE_SHELLS];
+        int free_count;
+        int refs; ///< chain + shells given out
+};
 
 struct capture_filter {
         struct module mod;
         struct simple_linked_list *filters;
+        struct frame_shell_pool *shells;
 };
 
 struct capture_filter_instance {
@@ -58,6 +87,80 @@ struct capture_filter_instance {
         void *state;
 };
 
+static void frame_shell_free(struct frame_shell *shell)
+{
+        vf_free(shell->frame);
+        free(shell);
+}
+
+static void frame_shell_pool_unref(struct frame_shell_pool *pool)
+{
+        pthread_mutex_lock(&pool->lock);
+        bool last = --pool->refs == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (!last) {
+                return;
+        }
+        for (int i = 0; i < pool->free_count; ++i) {
+                frame_shell_free(pool->free_shells[i]);
+        }
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+}
+
+static void frame_shell_dispose(struct video_frame *f)
+{
+        struct frame_shell *shell = f->callbacks.dispose_udata;
+        struct frame_shell_pool *pool = shell->pool;
+        VIDEO_FRAME_DISPOSE(shell->inner);
+        shell->inner = NULL;
+
+        pthread_mutex_lock(&pool->lock);
+        if (pool->free_count < MAX_FREE_SHELLS) {
+                pool->free_shells[pool->free_count++] = shell;
+                shell = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (shell != NULL) {
+                frame_shell_free(shell);
+        }
+        frame_shell_pool_unref(pool);
+}
+
+/**
+ * @returns frame struct owned by the chain sharing data (and properties) of
+ * in, which gets disposed together with the returned frame
+ */
+static struct video_frame *frame_shell_wrap(struct frame_shell_pool *pool,
+                                            struct video_frame *in)
+{
+        struct frame_shell *shell = NULL;
+        pthread_mutex_lock(&pool->lock);
+        if (pool->free_count > 0) {
+                shell = pool->free_shells[--pool->free_count];
+        }
+        pool->refs += 1;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (shell == NULL) {
+                shell = calloc(1, sizeof *shell);
+                shell->pool = pool;
+        }
+        if (shell->max_tiles < in->tile_count) {
+                vf_free(shell->frame);
+                shell->frame = vf_alloc((int) in->tile_count);
+                shell->max_tiles = in->tile_count;
+        }
+        memcpy(shell->frame, in,
+               offsetof(struct video_frame, tiles) +
+                   in->tile_count * sizeof(struct tile));
+        memset(&shell->frame->callbacks, 0, sizeof shell->frame->callbacks);
+        shell->frame->callbacks.dispose = frame_shell_dispose;
+        shell->frame->callbacks.dispose_udata = shell;
+        shell->inner = in;
+        return shell->frame;
+}
+
 static int create_filter(struct capture_filter *s, char *cfg)
 {
         bool found = false;
@@ -122,6 +225,9 @@ int capture_filter_init(struct module *parent, const char *cfg, struct capture_f
              *tmp = NULL;
 
         s->filters = simple_linked_list_init();
+        s->shells = calloc(1, sizeof *s->shells);
+        pthread_mutex_init(&s->shells->lock, NULL);
+        s->shells->refs = 1;
 
         module_init_default(&s->mod);
         s->mod.cls = MODULE_CLASS_FILTER;
@@ -162,6 +268,7 @@ void capture_filter_destroy(struct capture_filter *state)
         }
 
         simple_linked_list_destroy(s->filters);
+        frame_shell_pool_unref(s->shells);
 
         module_done(&s->mod);
 
@@ -211,6 +318,34 @@ static struct response *process_message(struct capture_filter *s, struct msg_uni
         return new_response(RESPONSE_OK, NULL);
 }
 
+static bool frame_struct_owned(const struct video_frame *f)
+{
+        return f->callbacks.dispose == frame_shell_dispose ||
+               video_frame_pool_is_disposable_frame(f);
+}
+
+/**
+ * Runs the filter in place if possible to avoid allocating (and copying)
+ * new frame, otherwise its regular filter callback.
+ */
+static struct video_frame *run_filter(struct capture_filter *s,
+                                      struct capture_filter_instance *inst,
+                                      struct video_frame *frame)
+{
+        const struct capture_filter_info *info = inst->functions;
+        if (frame == NULL || info->filter_in_place == NULL) {
+                return info->filter(inst->state, frame);
+        }
+        if ((info->flags & CAPTURE_FILTER_METADATA_ONLY) != 0) {
+                if (!frame_struct_owned(frame)) {
+                        frame = frame_shell_wrap(s->shells, frame);
+                }
+        } else if (!video_frame_pool_is_disposable_frame(frame)) {
+                return info->filter(inst->state, frame);
+        }
+        return info->filter_in_place(inst->state, frame);
+}
+
 struct video_frame *capture_filter(struct capture_filter *state, struct video_frame *frame) {
         struct capture_filter *s = state;
 
@@ -223,8 +358,49 @@ struct video_frame *capture_filter(struct capture_filter *state, struct video_fr
         for (list_it it = simple_linked_list_it_init(s->filters);
              it != LIST_IT_END;) {
                 struct capture_filter_instance *inst = (struct capture_filter_instance *) simple_linked_list_it_next(&it);
-                frame = inst->functions->filter(inst->state, frame);
+                frame = run_filter(s, inst, frame);
         }
         return frame;
 }
 
+struct capture_filter_pool {
+        struct video_frame_pool *pool;
+        struct video_desc desc;
+};
+
+struct capture_filter_pool *capture_filter_pool_init(void)
+{
+        return calloc(1, sizeof(struct capture_filter_pool));
+}
+
+struct video_frame *capture_filter_pool_get_frame(struct capture_filter_pool *s,
+                                                  struct video_desc desc,
+                                                  char *ext_buffer)
+{
+        if (ext_buffer != NULL) {
+                struct video_frame *out = vf_alloc_desc(desc);
+                out->tiles[0].data = ext_buffer;
+                out->callbacks.dispose = vf_free;
+                return out;
+        }
+        if (s->pool == NULL) {
+                s->pool = video_frame_pool_init(desc, 0);
+                s->desc = desc;
+        } else if (!video_desc_eq(s->desc, desc)) {
+                video_frame_pool_reconfigure(s->pool, desc);
+                s->desc = desc;
+        }
+        return video_frame_pool_get_disposable_frame(s->pool);
+}
+
+void capture_filter_pool_destroy(struct capture_filter_pool *s)
+{
+        if (s == NULL) {
+                return;
+        }
+        if (s->pool != NULL) {
+                video_frame_pool_release(s->pool);
+        }
+        free(s);
+}
+
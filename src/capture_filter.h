@@ -38,7 +38,9 @@
 #ifndef CAPTURE_FILTER_H_
 #define CAPTURE_FILTER_H_
 
-#define CAPTURE_FILTER_ABI_VERSION 4
+#include "types.h"     // for video_desc
+
+#define CAPTURE_FILTER_ABI_VERSION 5
 
 #ifdef __cplusplus
 extern "C" {
@@ -64,6 +66,32 @@ struct module;
 typedef struct video_frame *capture_filter_filter_fn(void               *state,
                                                      struct video_frame *f);
 
+/**
+ * @brief Performs filtering in place (optional)
+ *
+ * Same as capture_filter_filter_fn but called by the filter chain instead of
+ * capture_filter_info.filter when the frame is exclusively owned by the
+ * chain, ie. it was obtained from a video_frame_pool (eg. by
+ * capture_filter_pool_get_frame() of a preceding filter). The filter may then
+ * alter the frame data and return the frame itself. For filters flagged
+ * @ref CAPTURE_FILTER_METADATA_ONLY it is called always - the chain passes
+ * its own copy of the frame struct if needed and pixel data must not be
+ * touched.
+ *
+ * If the operation cannot be done in place (eg. output pixel format
+ * differs), the filter may still return a new frame as
+ * capture_filter_info.filter would.
+ *
+ * @param f  input frame, never nullptr
+ */
+typedef capture_filter_filter_fn capture_filter_in_place_fn;
+
+/// @anchor capture_filter_flags
+enum {
+        /// filter_in_place changes just the frame properties, not pixels
+        CAPTURE_FILTER_METADATA_ONLY = 1 << 0,
+};
+
 struct capture_filter_info {
         /// @brief Initializes capture filter
         /// @param      parent parent module
@@ -75,8 +103,35 @@ struct capture_filter_info {
         int (*init)(struct module *parent, const char *cfg, void **state);
         void (*done)(void *state);
         capture_filter_filter_fn *filter;
+        capture_filter_in_place_fn *filter_in_place; ///< may be NULL
+        unsigned flags; ///< @ref capture_filter_flags
 };
 
+/**
+ * @brief Recycling allocator of output frames for capture filters
+ *
+ * Replaces per-frame vf_alloc_desc() + malloc() in filters producing new
+ * frames. Frames returned by capture_filter_pool_get_frame() are recognized
+ * by the chain as exclusively owned, so that subsequent filters may process
+ * them in place.
+ */
+struct capture_filter_pool;
+struct capture_filter_pool *capture_filter_pool_init(void);
+/**
+ * @param ext_buffer if not NULL, the frame uses this buffer instead of a
+ *                   pooled one (used by vo_postprocess capture filter
+ *                   wrapper), otherwise pass NULL
+ * @returns frame with tiles according to desc, disposable with
+ *          VIDEO_FRAME_DISPOSE()
+ */
+struct video_frame *capture_filter_pool_get_frame(struct capture_filter_pool *pool,
+                                                  struct video_desc desc,
+                                                  char *ext_buffer);
+/**
+ * Frames that are still in use are freed when disposed.
+ */
+void capture_filter_pool_destroy(struct capture_filter_pool *pool);
+
 struct capture_filter;
 struct module;
 struct video_frame;
@@ -49,7 +49,8 @@
 #include "debug.h"
 #include "host.h"             // for exit_uv
 #include "lib_common.h"
-#include "pixfmt_conv.h"      // for get_best_decoder_from, get_decoder_from_to
+#include "pixfmt_conv.h"      // for DEFAULT_R_SHIFT, DEFAULT_G_SHIFT, DEFA...
+#include "pixfmt_conv_plan.h" // for pixfmt_conv_chain_create, pixfmt_conv_...
 #include "types.h"            // for tile, video_desc, video_frame, codec_t
 #include "utils/color_out.h"
 #include "utils/list.h"
@@ -79,15 +80,6 @@ struct capture_filter_display {
         pthread_t thread_id;
 };
 
-static codec_t select_display_codec(codec_t *display_codecs, codec_t recv_codec) {
-        if (codec_is_in_set(recv_codec, display_codecs)) {
-                return recv_codec;
-        }
-        codec_t out = VIDEO_CODEC_NONE;
-        get_best_decoder_from(recv_codec, display_codecs, &out);
-        return out;
-}
-
 static void *worker(void *arg) {
         struct capture_filter_display *s = arg;
         struct video_desc configured_desc = { 0 };
@@ -104,9 +96,7 @@ static void *worker(void *arg) {
         if (!display_ctl_property(s->d, DISPLAY_PROPERTY_RGB_SHIFT, rgb_shift, &len)) {
                 log_msg(LOG_LEVEL_WARNING, MOD_NAME "Cannot query display RGB shift!\n");
         }
-        decoder_t dec = NULL;
-        int src_linesize = 0;
-        int dst_linesize = 0;
+        struct pixfmt_conv_chain *conv = NULL;
 
         while (1) {
                 pthread_mutex_lock(&s->lock);
@@ -124,8 +114,12 @@ static void *worker(void *arg) {
                 if (!video_desc_eq(configured_desc, new_desc)) {
                         char buf[1024];
                         struct video_desc display_desc = new_desc;
-                        display_desc.color_spec = select_display_codec(display_codecs, new_desc.color_spec);
-                        if (!display_desc.color_spec || !display_reconfigure(s->d, display_desc)) {
+                        display_desc.color_spec = VIDEO_CODEC_NONE;
+                        pixfmt_conv_chain_destroy(conv);
+                        conv = pixfmt_conv_chain_create_frame(
+                            new_desc.color_spec, display_codecs,
+                            &display_desc.color_spec, (int) f->tiles[0].width);
+                        if (!conv || !display_reconfigure(s->d, display_desc)) {
                                 MSG(ERROR, "Unable to reconfigure to %s!\n",
                                     video_desc_to_string(display_desc,
                                                          sizeof buf, buf));
@@ -134,19 +128,15 @@ static void *worker(void *arg) {
                         MSG(NOTICE, "Reconfigured display to %s\n",
                             video_desc_to_string(display_desc, sizeof buf,
                                                  buf));
-                        dec = get_decoder_from_to(new_desc.color_spec, display_desc.color_spec);
-                        src_linesize = vc_get_linesize(f->tiles[0].width, f->color_spec);
-                        dst_linesize = vc_get_linesize(f->tiles[0].width, display_desc.color_spec);
                         configured_desc = new_desc;
                 }
                 struct video_frame *df = display_get_frame(s->d);
-                for (size_t i = 0; i < f->tiles[0].height; ++i) {
-                        dec((unsigned char *) df->tiles[0].data + i * dst_linesize, (unsigned char *) f->tiles[0].data + i * src_linesize, dst_linesize, rgb_shift[0], rgb_shift[1], rgb_shift[2]);
-                }
+                pixfmt_conv_chain_frame(conv, (unsigned char *) df->tiles[0].data, (unsigned char *) f->tiles[0].data, (int) f->tiles[0].height, rgb_shift[0], rgb_shift[1], rgb_shift[2]);
                 display_put_frame(s->d, df, PUTF_BLOCKING);
                 vf_free(f);
         }
 
+        pixfmt_conv_chain_destroy(conv);
         return NULL;
 }
 
@@ -133,6 +133,17 @@ static void dispose_frame(struct video_frame *f) {
         vf_free(f);
 }
 
+/// @returns whether the current frame is to be passed
+static bool
+pass_frame(struct state_every *s)
+{
+        if (s->num == 0) {
+                return false;
+        }
+        s->current = (s->current + 1) % s->num;
+        return s->current < s->denom;
+}
+
 static struct video_frame *filter(void *state, struct video_frame *in)
 {
         if (in == nullptr) {
@@ -140,14 +151,7 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         }
         struct state_every *s = state;
 
-        if (s->num == 0) {
-                VIDEO_FRAME_DISPOSE(in);
-                return NULL;
-        }
-
-        s->current = (s->current + 1) % s->num;
-
-        if (s->current >= s->denom) {
+        if (!pass_frame(s)) {
                 VIDEO_FRAME_DISPOSE(in);
                 return NULL;
         }
@@ -169,6 +173,18 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return frame;
 }
 
+static struct video_frame *
+filter_in_place(void *state, struct video_frame *f)
+{
+        struct state_every *s = state;
+        if (!pass_frame(s)) {
+                VIDEO_FRAME_DISPOSE(f);
+                return NULL;
+        }
+        f->fps /= (double) s->num / s->denom;
+        return f;
+}
+
 // for ADD_VO_PP_CAPTURE_FILTER_WRAPP
 static void
 vo_pp_set_out_buffer(void *state, char *buffer)
@@ -181,6 +197,8 @@ static const struct capture_filter_info capture_filter_every = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
+        .flags = CAPTURE_FILTER_METADATA_ONLY,
 };
 
 REGISTER_MODULE(every, &capture_filter_every, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
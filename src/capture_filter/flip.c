@@ -47,6 +47,7 @@
 #include "debug.h"
 #include "lib_common.h"
 #include "utils/color_out.h"
+#include "utils/macros.h"         // for MIN
 #include "video_codec.h"
 #include "video_frame.h"
 #include "vo_postprocess/capture_filter_wrapper.h"
@@ -56,6 +57,7 @@ static void done(void *state);
 static struct video_frame *filter(void *state, struct video_frame *in);
 
 struct state_flip {
+        struct capture_filter_pool *pool;
         char *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
 };
 
@@ -66,13 +68,17 @@ static int init(struct module *parent, const char *cfg, void **state)
                 color_printf(TRED(TBOLD("flip")) " capture filter flips the video vertically (across horizontal axis), takes no arguments\n");
                 return strcmp(cfg, "help") == 0 ? 1 : -1;
         }
-        *state = calloc(1, sizeof(struct state_flip));
+        struct state_flip *s = calloc(1, sizeof(struct state_flip));
+        s->pool = capture_filter_pool_init();
+        *state = s;
         return 0;
 }
 
 static void done(void *state)
 {
-        free(state);
+        struct state_flip *s = state;
+        capture_filter_pool_destroy(s->pool);
+        free(s);
 }
 
 static struct video_frame *filter(void *state, struct video_frame *in)
@@ -81,14 +87,9 @@ static struct video_frame *filter(void *state, struct video_frame *in)
                 return nullptr;
         }
         struct state_flip *s = state;
-        struct video_frame *out = vf_alloc_desc(video_desc_from_frame(in));
-        if (s->vo_pp_out_buffer) {
-                out->tiles[0].data = s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = (char *) (malloc(out->tiles[0].data_len));
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out = capture_filter_pool_get_frame(
+            s->pool, video_desc_from_frame(in), s->vo_pp_out_buffer);
+        vf_copy_metadata(out, in);
 
         unsigned char *in_data = (unsigned char *) in->tiles[0].data;
         unsigned char *out_data = (unsigned char *) out->tiles[0].data;
@@ -103,6 +104,33 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return out;
 }
 
+static void swap_lines(unsigned char *a, unsigned char *b, size_t len)
+{
+        unsigned char tmp[4096];
+        while (len > 0) {
+                size_t n = MIN(len, sizeof tmp);
+                memcpy(tmp, a, n);
+                memcpy(a, b, n);
+                memcpy(b, tmp, n);
+                a += n;
+                b += n;
+                len -= n;
+        }
+}
+
+static struct video_frame *filter_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        unsigned char *data = (unsigned char *) f->tiles[0].data;
+        size_t linesize = vc_get_linesize(f->tiles[0].width, f->color_spec);
+        unsigned int height = f->tiles[0].height;
+        for (unsigned int y = 0; y < height / 2; ++y) {
+                swap_lines(data + y * linesize,
+                           data + (height - y - 1) * linesize, linesize);
+        }
+        return f;
+}
+
 static void vo_pp_set_out_buffer(void *state, char *buffer)
 {
         struct state_flip *s = state;
@@ -113,6 +141,7 @@ static const struct capture_filter_info capture_filter_flip = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
 };
 
 REGISTER_MODULE(flip, &capture_filter_flip, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
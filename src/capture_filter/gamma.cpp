@@ -69,6 +69,7 @@ struct state_capture_filter_gamma {
 public:
         int out_depth; ///< 0, 8 or 16 (0 means keep)
         void *vo_pp_out_buffer{}; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
+        struct capture_filter_pool *pool = capture_filter_pool_init();
 
         explicit state_capture_filter_gamma(double gamma, int out_depth) : out_depth(out_depth) {
                 for (int i = 0; i <= numeric_limits<uint8_t>::max(); ++i) { // 8->8
@@ -93,7 +94,14 @@ public:
                 }
         }
 
-        void apply_gamma(int in_depth, int out_depth, size_t in_len, void const * __restrict in, void * __restrict out) {
+        ~state_capture_filter_gamma() {
+                capture_filter_pool_destroy(pool);
+        }
+        state_capture_filter_gamma(const state_capture_filter_gamma &) = delete;
+        state_capture_filter_gamma &operator=(const state_capture_filter_gamma &) = delete;
+
+        /// @note in and out may point to the same buffer if depths are equal
+        void apply_gamma(int in_depth, int out_depth, size_t in_len, void const *in, void *out) {
                 if (in_depth == CHAR_BIT && out_depth == CHAR_BIT) {
                         apply_lut<uint8_t, uint8_t>(in_len, lut8, in, out);
                 } else if (in_depth == 2 * CHAR_BIT && out_depth == 2 * CHAR_BIT) {
@@ -134,7 +142,8 @@ private:
                 vector<data<inT, outT>> d;
                 vector<task_result_handle_t> handles(cpus);
                 for (unsigned int i = 0; i < cpus; i++) {
-                        d.push_back({in_len / cpus, lut, in_data + i * (in_len / cpus), out_data + i * (in_len / cpus)});
+                        size_t len = i == cpus - 1 ? in_len - i * (in_len / cpus) : in_len / cpus;
+                        d.push_back({len, lut, in_data + i * (in_len / cpus), out_data + i * (in_len / cpus)});
                 }
                 for (unsigned int i = 0; i < cpus; i++) {
                         handles[i] = task_run_async(state_capture_filter_gamma::compute<inT, outT>, static_cast<void *>(&(d[i])));
@@ -209,20 +218,15 @@ static auto filter(void *state, struct video_frame *in) -> video_frame *
         if (s->out_depth != 0) {
                 out_desc.color_spec = s->out_depth == 8 ? RGB : RG48;
         }
-        struct video_frame *out = vf_alloc_desc(out_desc);
-        if (s->vo_pp_out_buffer != nullptr) {
-                out->tiles[0].data = (char *) s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = (char *) malloc(out->tiles[0].data_len);
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out = capture_filter_pool_get_frame(
+            s->pool, out_desc, static_cast<char *>(s->vo_pp_out_buffer));
+        vf_copy_metadata(out, in);
 
         try {
                 s->apply_gamma(get_bits_per_component(in->color_spec), get_bits_per_component(out_desc.color_spec), in->tiles[0].data_len, in->tiles[0].data, out->tiles[0].data);
         } catch(...) {
                 LOG(LOG_LEVEL_ERROR) << MOD_NAME << "Only 8-bit and 16-bit codecs are currently supported!\n";
-                vf_free(out);
+                VIDEO_FRAME_DISPOSE(out);
                 out = nullptr;
         }
 
@@ -231,6 +235,19 @@ static auto filter(void *state, struct video_frame *in) -> video_frame *
         return out;
 }
 
+static auto filter_in_place(void *state, struct video_frame *f) -> video_frame *
+{
+        auto *s = static_cast<state_capture_filter_gamma *>(state);
+        const int depth = get_bits_per_component(f->color_spec);
+        if ((f->color_spec != RGB && f->color_spec != RG48) ||
+            (s->out_depth != 0 && s->out_depth != depth)) {
+                return filter(state, f);
+        }
+        s->apply_gamma(depth, depth, f->tiles[0].data_len, f->tiles[0].data,
+                       f->tiles[0].data);
+        return f;
+}
+
 static void vo_pp_set_out_buffer(void *state, char *buffer)
 {
         auto *s = (state_capture_filter_gamma *) state;
@@ -241,6 +258,8 @@ static const struct capture_filter_info capture_filter_gamma = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
+        .flags = 0,
 };
 
 REGISTER_MODULE(gamma, &capture_filter_gamma, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
@@ -53,6 +53,7 @@ static void done(void *state);
 static struct video_frame *filter(void *state, struct video_frame *in);
 
 struct state_grayscale {
+        struct capture_filter_pool *pool;
         char *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
 };
 
@@ -63,13 +64,17 @@ static int init(struct module *parent, const char *cfg, void **state)
                 color_printf(TRED(TBOLD("grayscale")) " converts image to grayscale, takes no arguments\n");
                 return strcmp(cfg, "help") == 0 ? 1 : -1;
         }
-        *state = calloc(1, sizeof(struct state_grayscale));
+        struct state_grayscale *s = calloc(1, sizeof(struct state_grayscale));
+        s->pool = capture_filter_pool_init();
+        *state = s;
         return 0;
 }
 
 static void done(void *state)
 {
-        free(state);
+        struct state_grayscale *s = state;
+        capture_filter_pool_destroy(s->pool);
+        free(s);
 }
 
 static struct video_frame *filter(void *state, struct video_frame *in)
@@ -83,14 +88,9 @@ static struct video_frame *filter(void *state, struct video_frame *in)
                 log_msg(LOG_LEVEL_WARNING, "Cannot create grayscale from other codec than UYVY!\n");
                 return in;
         }
-        struct video_frame *out = vf_alloc_desc(video_desc_from_frame(in));
-        if (s->vo_pp_out_buffer) {
-                out->tiles[0].data = s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = (char *) malloc(out->tiles[0].data_len);
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out = capture_filter_pool_get_frame(
+            s->pool, video_desc_from_frame(in), s->vo_pp_out_buffer);
+        vf_copy_metadata(out, in);
 
         unsigned char *in_data = (unsigned char *) in->tiles[0].data;
         unsigned char *out_data = (unsigned char *) out->tiles[0].data;
@@ -106,6 +106,20 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return out;
 }
 
+static struct video_frame *filter_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        if (f->color_spec != UYVY) {
+                log_msg(LOG_LEVEL_WARNING, "Cannot create grayscale from other codec than UYVY!\n");
+                return f;
+        }
+        unsigned char *data = (unsigned char *) f->tiles[0].data;
+        for (unsigned int i = 0; i < f->tiles[0].width * f->tiles[0].height; ++i) {
+                data[2 * i] = 127;
+        }
+        return f;
+}
+
 static void vo_pp_set_out_buffer(void *state, char *buffer)
 {
         struct state_grayscale *s = state;
@@ -117,6 +131,7 @@ static const struct capture_filter_info capture_filter_grayscale = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
 };
 
 REGISTER_MODULE(grayscale, &capture_filter_grayscale, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
@@ -50,7 +50,7 @@
 #include "utils/macros.h"
 #include "types.h"                                  // for tile, video_frame
 #include "video_codec.h"
-#include "video_frame.h"                            // for vf_free, VIDEO_FR...
+#include "video_frame.h"                            // for VIDEO_FRAME_DISPOSE
 #include "vo_postprocess/capture_filter_wrapper.h"
 
 struct module;
@@ -60,6 +60,7 @@ struct module;
 struct state_capture_filter_matrix {
         double transform_matrix[9];
         bool check_bounds;
+        struct capture_filter_pool *pool;
         void *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
 };
 
@@ -115,13 +116,16 @@ static int init(struct module *parent, const char *cfg, void **state)
                 return -1;
         }
 
+        s->pool = capture_filter_pool_init();
         *state = s;
         return 0;
 }
 
 static void done(void *state)
 {
-        free(state);
+        struct state_capture_filter_matrix *s = state;
+        capture_filter_pool_destroy(s->pool);
+        free(s);
 }
 
 static struct video_frame *filter(void *state, struct video_frame *in)
@@ -134,14 +138,9 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         if (in->color_spec == UYVY) {
                 desc.color_spec = RGB;
         }
-        struct video_frame *out = vf_alloc_desc(desc);
-        if (s->vo_pp_out_buffer) {
-                out->tiles[0].data = s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = malloc(out->tiles[0].data_len);
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out =
+            capture_filter_pool_get_frame(s->pool, desc, s->vo_pp_out_buffer);
+        vf_copy_metadata(out, in);
 
         if (s->check_bounds) {
                 if (in->color_spec == UYVY) {
@@ -227,7 +226,7 @@ static struct video_frame *filter(void *state, struct video_frame *in)
                 } else {
                         log_msg(LOG_LEVEL_ERROR, MOD_NAME "Only UYVY, RGB or RG48 is currently supported!\n");
                         VIDEO_FRAME_DISPOSE(in);
-                        vf_free(out);
+                        VIDEO_FRAME_DISPOSE(out);
                         return NULL;
                 }
         } else {
@@ -302,7 +301,7 @@ static struct video_frame *filter(void *state, struct video_frame *in)
                 } else {
                         log_msg(LOG_LEVEL_ERROR, MOD_NAME "Only UYVY, RGB or RG48 is currently supported!\n");
                         VIDEO_FRAME_DISPOSE(in);
-                        vf_free(out);
+                        VIDEO_FRAME_DISPOSE(out);
                         return NULL;
                 }
         }
@@ -74,6 +74,7 @@ static const double y601_y709_matrix[9] = {
 
 struct state_capture_filter_matrix2 {
         double transform_matrix[MATRIX_VOL];
+        struct capture_filter_pool *pool;
         void  *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper
                                  ///< (otherwise unused)
         void  *y416_tmp_buffer;
@@ -151,6 +152,7 @@ init(struct module *parent, const char *cfg, void **state)
                 free(s);
                 return -1;
         }
+        s->pool = capture_filter_pool_init();
 
         *state = s;
         return 0;
@@ -160,6 +162,7 @@ static void
 done(void *state)
 {
         struct state_capture_filter_matrix2 *s = state;
+        capture_filter_pool_destroy(s->pool);
         free(s->y416_tmp_buffer);
         free(state);
 }
@@ -208,7 +211,7 @@ convert_apply_y416(struct state_capture_filter_matrix2 *s,
 
         const size_t tmp_len =
             vc_get_datalen(in->tiles[0].width, in->tiles[0].height, Y416);
-        if (s->y416_tmp_buffer_sz <= tmp_len) {
+        if (s->y416_tmp_buffer_sz < tmp_len) {
                 free(s->y416_tmp_buffer);
                 s->y416_tmp_buffer    = malloc(tmp_len);
                 s->y416_tmp_buffer_sz = tmp_len;
@@ -242,6 +245,23 @@ convert_apply_y416(struct state_capture_filter_matrix2 *s,
         return true;
 }
 
+/// @note in and out may be the same frame
+static void
+apply(struct state_capture_filter_matrix2 *s, struct video_frame *in,
+      struct video_frame *out)
+{
+        if (in->color_spec == UYVY) {
+                apply_to_uyvy(s, in, out);
+                return;
+        }
+        if (codec_is_a_rgb(in->color_spec) || !convert_apply_y416(s, in, out)) {
+                MSG(ERROR,
+                    "Sorry, only UYVY and YCbCr modes convertible to "
+                    "and from Y416 are supported by now (have %s).\n",
+                    get_codec_name(in->color_spec));
+        }
+}
+
 static struct video_frame *
 filter(void *state, struct video_frame *in)
 {
@@ -249,34 +269,23 @@ filter(void *state, struct video_frame *in)
                 return nullptr;
         }
         struct state_capture_filter_matrix2 *s = state;
-        struct video_desc desc = video_desc_from_frame(in);
-        struct video_frame *out = vf_alloc_desc(desc);
-        if (s->vo_pp_out_buffer) {
-                out->tiles[0].data = s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = malloc(out->tiles[0].data_len);
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out = capture_filter_pool_get_frame(
+            s->pool, video_desc_from_frame(in), s->vo_pp_out_buffer);
+        vf_copy_metadata(out, in);
 
-        if (in->color_spec == UYVY) {
-                apply_to_uyvy(s, in, out);
-        } else {
-                if (codec_is_a_rgb(in->color_spec) ||
-                    !convert_apply_y416(s, in, out)) {
-                        MSG(ERROR,
-                            "Sorry, only UYVY and YCbCr modes convertible to "
-                            "and from Y416 are supported by now (have %s).\n",
-                            get_codec_name(in->color_spec));
-                        VIDEO_FRAME_DISPOSE(in);
-                        return out;
-                }
-        }
+        apply(s, in, out);
 
         VIDEO_FRAME_DISPOSE(in);
         return out;
 }
 
+static struct video_frame *
+filter_in_place(void *state, struct video_frame *f)
+{
+        apply(state, f, f);
+        return f;
+}
+
 static void
 vo_pp_set_out_buffer(void *state, char *buffer)
 {
@@ -285,9 +294,10 @@ vo_pp_set_out_buffer(void *state, char *buffer)
 }
 
 static const struct capture_filter_info capture_filter_matrix2 = {
-        .init   = init,
-        .done   = done,
-        .filter = filter,
+        .init            = init,
+        .done            = done,
+        .filter          = filter,
+        .filter_in_place = filter_in_place,
 };
 
 REGISTER_MODULE(matrix2, &capture_filter_matrix2, LIBRARY_CLASS_CAPTURE_FILTER,
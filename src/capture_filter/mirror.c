@@ -54,6 +54,7 @@ static void done(void *state);
 static struct video_frame *filter(void *state, struct video_frame *in);
 
 struct state_mirror {
+        struct capture_filter_pool *pool;
         char *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
 };
 
@@ -64,13 +65,17 @@ static int init(struct module *parent, const char *cfg, void **state)
                 color_printf(TRED(TBOLD("mirror")) " capture filter flips the video horizontally (across vertical axis), takes no arguments\n");
                 return strcmp(cfg, "help") == 0 ? 1 : -1;
         }
-        *state = calloc(1, sizeof(struct state_mirror));
+        struct state_mirror *s = calloc(1, sizeof(struct state_mirror));
+        s->pool = capture_filter_pool_init();
+        *state = s;
         return 0;
 }
 
 static void done(void *state)
 {
-        free(state);
+        struct state_mirror *s = state;
+        capture_filter_pool_destroy(s->pool);
+        free(s);
 }
 
 static void mirror_line_UYVY(unsigned char *dst, const unsigned char *src, int linesize)
@@ -92,6 +97,26 @@ static void mirror_line_UYVY(unsigned char *dst, const unsigned char *src, int l
         }
 }
 
+static void mirror_line_UYVY_in_place(unsigned char *line, int linesize)
+{
+        unsigned char *left = line;
+        unsigned char *right = line + linesize - 4;
+        while (left <= right) {
+                unsigned char l[4] = { left[0], left[1], left[2], left[3] };
+                unsigned char r[4] = { right[0], right[1], right[2], right[3] };
+                left[0] = r[0];
+                left[1] = r[3];
+                left[2] = r[2];
+                left[3] = r[1];
+                right[0] = l[0];
+                right[1] = l[3];
+                right[2] = l[2];
+                right[3] = l[1];
+                left += 4;
+                right -= 4;
+        }
+}
+
 static struct video_frame *filter(void *state, struct video_frame *in)
 {
         if (in == nullptr) {
@@ -104,14 +129,9 @@ static struct video_frame *filter(void *state, struct video_frame *in)
                 return in;
         }
 
-        struct video_frame *out = vf_alloc_desc(video_desc_from_frame(in));
-        if (s->vo_pp_out_buffer) {
-                out->tiles[0].data = s->vo_pp_out_buffer;
-        } else {
-                out->tiles[0].data = (char *) malloc(out->tiles[0].data_len);
-                out->callbacks.data_deleter = vf_data_deleter;
-        }
-        out->callbacks.dispose = vf_free;
+        struct video_frame *out = capture_filter_pool_get_frame(
+            s->pool, video_desc_from_frame(in), s->vo_pp_out_buffer);
+        vf_copy_metadata(out, in);
 
         unsigned char *in_data = (unsigned char *) in->tiles[0].data;
         unsigned char *out_data = (unsigned char *) out->tiles[0].data;
@@ -126,6 +146,21 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return out;
 }
 
+static struct video_frame *filter_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        if (f->color_spec != UYVY) {
+                log_msg(LOG_LEVEL_WARNING, "Only supported colorspace for mirror is currently UYVY!\n");
+                return f;
+        }
+        unsigned char *data = (unsigned char *) f->tiles[0].data;
+        int linesize = vc_get_linesize(f->tiles[0].width, f->color_spec);
+        for (unsigned int y = 0; y < f->tiles[0].height; ++y) {
+                mirror_line_UYVY_in_place(data + y * linesize, linesize);
+        }
+        return f;
+}
+
 static void vo_pp_set_out_buffer(void *state, char *buffer)
 {
         struct state_mirror *s = state;
@@ -136,6 +171,7 @@ static const struct capture_filter_info capture_filter_mirror = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
 };
 
 REGISTER_MODULE(mirror, &capture_filter_mirror, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
@@ -164,6 +164,14 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return out;
 }
 
+static struct video_frame *filter_in_place(void *state, struct video_frame *f)
+{
+        struct state_override_prop *s = state;
+        f->fps = s->new_desc.fps;
+        f->interlacing = s->new_desc.interlacing;
+        return f;
+}
+
 static void
 vo_pp_set_out_buffer(void *state, char *buffer)
 {
@@ -175,6 +183,8 @@ static const struct capture_filter_info capture_filter_override_prop = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
+        .flags = CAPTURE_FILTER_METADATA_ONLY,
 };
 
 REGISTER_MODULE(override_prop, &capture_filter_override_prop, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
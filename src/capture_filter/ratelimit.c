@@ -118,10 +118,26 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return frame;
 }
 
+static struct video_frame *filter_in_place(void *state, struct video_frame *f)
+{
+        struct state_ratelimit *s = state;
+
+        if (get_time_in_ns() < s->next_frame_time) {
+                VIDEO_FRAME_DISPOSE(f);
+                return NULL;
+        }
+        f->fps = s->fps;
+        s->next_frame_time += (time_ns_t) SEC_TO_NS(1.0 / s->fps);
+
+        return f;
+}
+
 static const struct capture_filter_info capture_filter_ratelimit = {
         .init = init,
         .done = done,
         .filter = filter,
+        .filter_in_place = filter_in_place,
+        .flags = CAPTURE_FILTER_METADATA_ONLY,
 };
 
 REGISTER_MODULE(ratelimit, &capture_filter_ratelimit, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
@@ -55,6 +55,7 @@
 #include "debug.h"
 #include "lib_common.h"
 #include "utils/color_out.h"
+#include "utils/fused_scale.h"
 #include "utils/macros.h"
 #include "utils/parallel_conv.h"
 #include "video_codec.h"
@@ -71,11 +72,16 @@ static struct video_frame *filter(void *state, struct video_frame *in);
 
 struct state_resize {
     struct resize_param param;
+    enum fused_scale_algo fused_algo; ///< FUSED_SCALE_ALGO_UNKN - OpenCV only
     struct video_desc saved_desc;
     struct video_desc out_desc;
     char *vo_pp_out_buffer; ///< buffer to write to if we use vo_pp wrapper (otherwise unused)
     decoder_t decoder;
     struct video_frame *dec_frame;
+    struct capture_filter_pool *pool;
+
+    struct fused_scale *fused; ///< used instead of decoder+OpenCV if set
+    int dst_x, dst_y, dst_w, dst_h; ///< scaled image position (letterboxing)
 };
 
 static void usage() {
@@ -95,11 +101,15 @@ static void usage() {
         "\nOptions:\n"
         "\t" TBOLD(
             "algo") " - scaling algorithm to use (list with `algo:help`)\n");
+    color_printf("\nUYVY, v210, RGB, RGBA, R10k and RG48 input is scaled "
+                 "natively in a single pass\n(except of the " TBOLD(
+                     "nearest") " algorithm), other input with OpenCV.\n");
     color_printf("\n");
 }
 
 static int
-parse_fmt(char *cfg, struct resize_param *param)
+parse_fmt(char *cfg, struct resize_param *param,
+          enum fused_scale_algo *fused_algo)
 {
     char *save_ptr = NULL;
     char *item     = NULL;
@@ -110,6 +120,7 @@ parse_fmt(char *cfg, struct resize_param *param)
             if (param->algo < 0) {
                     return param->algo == RESIZE_ALGO_HELP_SHOWN ? 1 : -1;
             }
+            *fused_algo = fused_scale_algo_from_string(strchr(item, '=') + 1);
             continue;
         }
         if (!isdigit(item[0]) && item[0] != '.') {
@@ -149,6 +160,7 @@ static int init(struct module * parent, const char *cfg, void **state)
 {
     UNUSED(parent);
     struct resize_param param = { .algo = RESIZE_ALGO_DFL };
+    enum fused_scale_algo fused_algo = FUSED_SCALE_LINEAR;
 
     if(strcasecmp(cfg, "help") == 0) {
         usage();
@@ -156,7 +168,7 @@ static int init(struct module * parent, const char *cfg, void **state)
     }
 
     char *fmt = strdup(cfg);
-    const int rc = parse_fmt(fmt, &param);
+    const int rc = parse_fmt(fmt, &param, &fused_algo);
     free(fmt);
     if (rc != 0) {
         return rc;
@@ -164,6 +176,8 @@ static int init(struct module * parent, const char *cfg, void **state)
 
     struct state_resize *s = calloc(1, sizeof(struct state_resize));
     s->param = param;
+    s->fused_algo = fused_algo;
+    s->pool = capture_filter_pool_init();
 
     *state = s;
     return 0;
@@ -174,23 +188,71 @@ cleanup_common(struct state_resize *s)
 {
     vf_free(s->dec_frame);
     s->dec_frame = NULL;
+    fused_scale_destroy(s->fused);
+    s->fused = NULL;
 }
 
 static void
 done(void *state)
 {
-    cleanup_common((struct state_resize *) state);
+    struct state_resize *s = state;
+    cleanup_common(s);
+    capture_filter_pool_destroy(s->pool);
     free(state);
 }
 
+/// places the scaled image to the output keeping the aspect ratio
+static void
+compute_dst_rect(struct state_resize *s, const struct video_desc *in_desc)
+{
+    s->dst_x = 0;
+    s->dst_y = 0;
+    s->dst_w = (int) s->out_desc.width;
+    s->dst_h = (int) s->out_desc.height;
+    if (s->param.mode != USE_DIMENSIONS) {
+        return;
+    }
+    const double in_aspect  = (double) in_desc->width / in_desc->height;
+    const double out_aspect = (double) s->dst_w / s->dst_h;
+    if (in_aspect > out_aspect) {
+        s->dst_h = MAX((int) (s->dst_w / in_aspect), 1);
+        s->dst_y = ((int) s->out_desc.height - s->dst_h) / 2;
+    } else if (in_aspect < out_aspect) {
+        s->dst_w = MAX((int) (s->dst_h * in_aspect), 1);
+        s->dst_x = ((int) s->out_desc.width - s->dst_w) / 2;
+    }
+}
+
 static bool
-reconfigure_if_needed(struct state_resize *s, const struct video_frame *in)
+configure_fused(struct state_resize *s, const struct video_desc *in_desc)
 {
-    if (video_desc_eq(video_desc_from_frame(in), s->saved_desc)) {
-        return true;
+    s->out_desc.color_spec =
+        get_bits_per_component(in_desc->color_spec) == DEPTH8 ? RGB : RG48;
+    compute_dst_rect(s, in_desc);
+    const struct fused_scale_params params = {
+        .in_codec   = in_desc->color_spec,
+        .in_width   = (int) in_desc->width,
+        .in_height  = (int) in_desc->height,
+        .out_codec  = s->out_desc.color_spec,
+        .out_width  = s->dst_w,
+        .out_height = s->dst_h,
+        .algo       = s->fused_algo,
+        .threads    = 0,
+    };
+    s->fused = fused_scale_init(&params);
+    if (s->fused == NULL) {
+        return false;
     }
+    MSG(INFO, "Scaling natively to output pixfmt %s using %s algorithm.\n",
+        get_codec_name(s->out_desc.color_spec),
+        fused_scale_algo_to_string(s->fused_algo));
+    return true;
+}
+
+static bool
+configure_opencv(struct state_resize *s, const struct video_frame *in)
+{
     struct video_desc dec_desc         = video_desc_from_frame(in);
-    s->out_desc                        = video_desc_from_frame(in);
     const codec_t supp_in_codecs[] = { RESIZE_SUPPORTED_PIXFMT_INIT,
                                            VIDEO_CODEC_NONE };
     if (codec_is_in_set(in->color_spec, supp_in_codecs)) {
@@ -211,7 +273,45 @@ reconfigure_if_needed(struct state_resize *s, const struct video_frame *in)
     MSG(INFO, "Decoding through %s to output pixfmt %s.\n",
         get_codec_name(dec_desc.color_spec),
         get_codec_name(s->out_desc.color_spec));
+    if (s->decoder != vc_memcpy) {
+        s->dec_frame               = vf_alloc_desc_data(dec_desc);
+    }
+    return true;
+}
 
+/// clears the parts of the output not covered by the scaled image
+static void
+clear_margins(const struct state_resize *s, char *data)
+{
+    const codec_t codec     = s->out_desc.color_spec;
+    const size_t  linesize  = vc_get_linesize(s->out_desc.width, codec);
+    const size_t  left      = vc_get_linesize(s->dst_x, codec);
+    const size_t  img_size  = vc_get_linesize(s->dst_w, codec);
+    const size_t  right     = linesize - left - img_size;
+    const size_t  bottom_y  = (size_t) s->dst_y + s->dst_h;
+
+    memset(data, 0, s->dst_y * linesize);
+    memset(data + bottom_y * linesize, 0,
+           (s->out_desc.height - bottom_y) * linesize);
+    if (left == 0 && right == 0) {
+        return;
+    }
+    for (size_t y = s->dst_y; y < bottom_y; ++y) {
+        memset(data + y * linesize, 0, left);
+        memset(data + y * linesize + left + img_size, 0, right);
+    }
+}
+
+static bool
+reconfigure_if_needed(struct state_resize *s, const struct video_frame *in)
+{
+    if (video_desc_eq(video_desc_from_frame(in), s->saved_desc)) {
+        return true;
+    }
+    cleanup_common(s);
+    s->saved_desc = (struct video_desc){ 0 }; // retry next frame if failed
+    const struct video_desc in_desc = video_desc_from_frame(in);
+    s->out_desc = in_desc;
     if (s->param.mode == USE_DIMENSIONS) {
         s->out_desc.width  = s->param.target_width;
         s->out_desc.height = s->param.target_height;
@@ -219,11 +319,15 @@ reconfigure_if_needed(struct state_resize *s, const struct video_frame *in)
         s->out_desc.width = in->tiles[0].width * s->param.factor;
         s->out_desc.height = in->tiles[0].height * s->param.factor;
     }
-    s->saved_desc = video_desc_from_frame(in);
-    cleanup_common(s);
-    if (s->decoder != vc_memcpy) {
-        s->dec_frame               = vf_alloc_desc_data(dec_desc);
+
+    const bool use_fused = s->fused_algo != FUSED_SCALE_ALGO_UNKN &&
+                           fused_scale_is_supported(in->color_spec);
+    if (!(use_fused ? configure_fused(s, &in_desc)
+                    : configure_opencv(s, in))) {
+        return false;
     }
+    s->saved_desc = in_desc;
+
     MSG(NOTICE, "resizing from %dx%d to %dx%d\n", s->saved_desc.width,
         s->saved_desc.height, s->out_desc.width, s->out_desc.height);
     return true;
@@ -241,15 +345,22 @@ static struct video_frame *filter(void *state, struct video_frame *in)
         return NULL;
     }
 
-    struct video_frame *out_frame = vf_alloc_desc(s->out_desc);
-    if (s->vo_pp_out_buffer) {
-        out_frame->tiles[0].data = s->vo_pp_out_buffer;
-    } else {
-        out_frame->tiles[0].data = (char *) malloc(out_frame->tiles[0].data_len);
-        out_frame->callbacks.data_deleter = vf_data_deleter;
-    }
+    struct video_frame *out_frame =
+        capture_filter_pool_get_frame(s->pool, s->out_desc, s->vo_pp_out_buffer);
 
     for (unsigned int i = 0; i < out_frame->tile_count; i++) {
+        if (s->fused != NULL) {
+            const int pitch = vc_get_linesize(s->out_desc.width,
+                                              s->out_desc.color_spec);
+            char *dst = out_frame->tiles[i].data + (size_t) s->dst_y * pitch +
+                        vc_get_linesize(s->dst_x, s->out_desc.color_spec);
+            clear_margins(s, out_frame->tiles[i].data);
+            fused_scale_frame(
+                s->fused, in->tiles[i].data,
+                vc_get_linesize(in->tiles[i].width, in->color_spec), dst,
+                pitch);
+            continue;
+        }
         if (s->decoder != vc_memcpy) {
             parallel_pix_conv(
                 (int) in->tiles[i].height, s->dec_frame->tiles[i].data,
@@ -268,8 +379,6 @@ static struct video_frame *filter(void *state, struct video_frame *in)
 
     VIDEO_FRAME_DISPOSE(in);
 
-    out_frame->callbacks.dispose = vf_free;
-
     return out_frame;
 }
 
@@ -283,6 +392,8 @@ static const struct capture_filter_info capture_filter_resize = {
     init,
     done,
     filter,
+    NULL,
+    0,
 };
 
 REGISTER_MODULE(resize, &capture_filter_resize, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
@@ -50,6 +50,7 @@
 #include "crypto/openssl_encrypt.h"
 
 #include <assert.h>           // for assert
+#include <pthread.h>
 #include <stdint.h>           // for uint32_t
 #include <stdlib.h>           // for free, abort, calloc
 #include <string.h>           // for NULL, memcpy, strcmp, strlen
@@ -85,8 +86,14 @@
 #define GCM_TAG_LEN 16
 #define MOD_NAME "[encrypt] "
 
+enum { MAX_CTX_POOL = 64 };
+
 struct openssl_encrypt {
-        EVP_CIPHER_CTX *ctx;
+        /// contexts not currently used by openssl_encrypt() (so that it can
+        /// be called from multiple threads concurrently)
+        EVP_CIPHER_CTX *ctx_pool[MAX_CTX_POOL];
+        int ctx_pool_count;
+        pthread_mutex_t lock;
         const EVP_CIPHER *cipher;
         enum openssl_mode mode;
         unsigned char key_hash[16];
@@ -181,7 +188,7 @@ openssl_encrypt_init(struct openssl_encrypt **state, const char *passphrase)
                 return -1;
         }
 
-        s->ctx = EVP_CIPHER_CTX_new();
+        pthread_mutex_init(&s->lock, NULL);
         s->mode = mode;
         log_msg(LOG_LEVEL_INFO, MOD_NAME "Encryption set to mode %d\n", (int) mode);
 
@@ -191,13 +198,40 @@ openssl_encrypt_init(struct openssl_encrypt **state, const char *passphrase)
 
 static void openssl_encrypt_destroy(struct openssl_encrypt *s)
 {
-        EVP_CIPHER_CTX_free(s->ctx);
+        for (int i = 0; i < s->ctx_pool_count; ++i) {
+                EVP_CIPHER_CTX_free(s->ctx_pool[i]);
+        }
+        pthread_mutex_destroy(&s->lock);
         free(s);
 }
 
+static EVP_CIPHER_CTX *
+get_ctx(struct openssl_encrypt *s)
+{
+        EVP_CIPHER_CTX *ctx = NULL;
+        pthread_mutex_lock(&s->lock);
+        if (s->ctx_pool_count > 0) {
+                ctx = s->ctx_pool[--s->ctx_pool_count];
+        }
+        pthread_mutex_unlock(&s->lock);
+        return ctx != NULL ? ctx : EVP_CIPHER_CTX_new();
+}
+
+static void
+put_ctx(struct openssl_encrypt *s, EVP_CIPHER_CTX *ctx)
+{
+        pthread_mutex_lock(&s->lock);
+        if (s->ctx_pool_count < MAX_CTX_POOL) {
+                s->ctx_pool[s->ctx_pool_count++] = ctx;
+                ctx = NULL;
+        }
+        pthread_mutex_unlock(&s->lock);
+        EVP_CIPHER_CTX_free(ctx);
+}
+
 #define CHECK(action, errmsg) do { int rc = action; if (rc != 1) { log_msg(LOG_LEVEL_ERROR, MOD_NAME errmsg ": %s\n", ERR_error_string(ERR_get_error(), NULL)); return 0; } } while(0)
 
-static int openssl_encrypt(struct openssl_encrypt *encryption,
+static int do_encrypt(struct openssl_encrypt *encryption, EVP_CIPHER_CTX *ctx,
                 char *plaintext, int data_len, char *aad, int aad_len, char *ciphertext)
 {
         memcpy(ciphertext, &data_len, sizeof(uint32_t));
@@ -211,33 +245,44 @@ static int openssl_encrypt(struct openssl_encrypt *encryption,
         memcpy(ciphertext + total_len, ivec, sizeof ivec);
         total_len += sizeof ivec;
 
-        CHECK(EVP_CipherInit(encryption->ctx, encryption->cipher, encryption->key_hash, ivec, 1), "Cannot initialize cipher");
-        /* Set IV length if default 12 bytes (96 bits) is not appropriate */
-        CHECK(EVP_CIPHER_CTX_ctrl(encryption->ctx, EVP_CTRL_GCM_SET_IVLEN, sizeof ivec, NULL), "set IV len");
+        CHECK(EVP_CipherInit(ctx, encryption->cipher, encryption->key_hash, ivec, 1), "Cannot initialize cipher");
+        // GCM IV length stays at the default 12 bytes (leading part of the 16
+        // transmitted) - EVP_CTRL_GCM_SET_IVLEN after the IV is set had no
+        // effect with OpenSSL 1.1 and breaks the cipher with OpenSSL 3
         int out_len = 0;
         if (encryption->mode == MODE_AES128_GCM) {
                 if (aad_len > 0) {
-                        EVP_EncryptUpdate(encryption->ctx, NULL, &out_len, (unsigned char *) aad, aad_len);
+                        EVP_EncryptUpdate(ctx, NULL, &out_len, (unsigned char *) aad, aad_len);
                 }
         }
-        CHECK(EVP_CipherUpdate(encryption->ctx, (unsigned char *) ciphertext + total_len, &out_len, (unsigned char *) plaintext, data_len), "EVP_CipherUpdate");
+        CHECK(EVP_CipherUpdate(ctx, (unsigned char *) ciphertext + total_len, &out_len, (unsigned char *) plaintext, data_len), "EVP_CipherUpdate");
         total_len += out_len;
         if (encryption->mode != MODE_AES128_GCM) {
                 uint32_t crc = crc32buf(aad, aad_len);
                 crc = crc32buf_with_oldcrc(plaintext, data_len, crc);
-                CHECK(EVP_CipherUpdate(encryption->ctx, (unsigned char *) ciphertext + total_len, &out_len, (unsigned char *) &crc, sizeof crc), "EVP_CipherUpdate CRC");
+                CHECK(EVP_CipherUpdate(ctx, (unsigned char *) ciphertext + total_len, &out_len, (unsigned char *) &crc, sizeof crc), "EVP_CipherUpdate CRC");
                 total_len += out_len;
         }
-        CHECK(EVP_CipherFinal(encryption->ctx, (unsigned char *) ciphertext + total_len, &out_len), "EVP_CipherFinal");
+        CHECK(EVP_CipherFinal(ctx, (unsigned char *) ciphertext + total_len, &out_len), "EVP_CipherFinal");
         total_len += out_len;
         if (encryption->mode == MODE_AES128_GCM) {
-                CHECK(EVP_CIPHER_CTX_ctrl(encryption->ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LEN, ciphertext + total_len), "GCM get tag");
+                CHECK(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LEN, ciphertext + total_len), "GCM get tag");
                 total_len += GCM_TAG_LEN;
         }
 
         return total_len;
 }
 
+static int openssl_encrypt(struct openssl_encrypt *encryption,
+                char *plaintext, int data_len, char *aad, int aad_len, char *ciphertext)
+{
+        EVP_CIPHER_CTX *ctx = get_ctx(encryption);
+        const int ret = do_encrypt(encryption, ctx, plaintext, data_len, aad,
+                                   aad_len, ciphertext);
+        put_ctx(encryption, ctx);
+        return ret;
+}
+
 static int openssl_get_overhead(struct openssl_encrypt *s)
 {
         return sizeof(uint32_t) /* data_len */ +
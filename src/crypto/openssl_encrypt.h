@@ -88,6 +88,8 @@ struct openssl_encrypt_info {
          * @param[out] ciphertext   resulting ciphertext, can be up to (plaintext_len + MAX_CRYPTO_EXCEED) length
          * @returns   size of written ciphertext
          * @retval 0 on error
+         * @note may be called concurrently from multiple threads (with the
+         * same state)
          */
         int (*encrypt)(struct openssl_encrypt *encryption,
                         char *plaintext, int plaintext_len, char *aad, int aad_len, char *ciphertext);
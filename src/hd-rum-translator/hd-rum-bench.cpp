@@ -0,0 +1,627 @@
+/**
+ * @file   hd-rum-translator/hd-rum-bench.cpp
+ * @brief  load generator and benchmark for hd-rum-transcode
+ *
+ * Runs the reflector with loopback replicas as a child process (POSIX only).
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "rtp/rtp_types.h" // for PT_VIDEO, video_payload_hdr_t
+
+using std::string;
+using std::vector;
+
+#define NS_PER_SEC 1000000000LL
+#define DEFAULT_PORT 15004
+#define DEFAULT_PKT_SIZE 1400
+#define DEFAULT_DURATION 10
+#define DEFAULT_REPLICAS 2
+#define SEND_BATCH 32
+#define RECV_BATCH 64
+#define HIST_MAX_US 1000000 ///< latencies above are counted only as overflow
+#define WARMUP_TIMEOUT_NS (5 * NS_PER_SEC)
+#define DRAIN_NS (NS_PER_SEC / 2)
+#define WARMUP_SEQ UINT64_MAX
+#define RTP_HDR_LEN 12
+
+/// bench data following RTP and video payload headers
+struct bench_trailer {
+    uint64_t seq;
+    int64_t send_time_ns;
+};
+
+#define MIN_PKT_SIZE \
+    (RTP_HDR_LEN + (int) sizeof(video_payload_hdr_t) + \
+     (int) sizeof(struct bench_trailer))
+
+struct bench_opts {
+    long long rate = 0; ///< packets per second, 0 - unlimited
+    int pkt_size = DEFAULT_PKT_SIZE;
+    int replicas = DEFAULT_REPLICAS;
+    int duration = DEFAULT_DURATION;
+    int port = DEFAULT_PORT;
+    string reflector;
+    string bufsize = "8M";
+    vector<string> reflector_args;
+    bool verbose = false;
+};
+
+struct replica_stats {
+    int fd = -1;
+    int port = 0;
+    bool alive = false;
+    uint64_t received = 0;
+    uint64_t reordered = 0;
+    uint64_t max_seq = 0;
+};
+
+struct bench_state {
+    std::atomic<bool> should_stop{ false };
+    std::atomic<int> alive_replicas{ 0 }; ///< replicas that received a packet
+    vector<replica_stats> replicas;
+    vector<uint64_t> hist = vector<uint64_t>(HIST_MAX_US + 1); ///< [us]
+    uint64_t hist_overflow = 0;
+    int64_t max_latency_ns = 0;
+};
+
+static int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void usage(const char *progname)
+{
+    printf("Usage:\n\t%s [-r <pkt_per_sec>] [-s <pkt_size>] [-n <replicas>] "
+           "[-d <seconds>]\n\t\t[-p <port>] [-b <buffer_size>] "
+           "[-R <reflector>] [-v] [-- <reflector_global_opts>]\n\n",
+           progname);
+    printf("Sends synthetic UltraGrid RTP video packets through "
+           "hd-rum-transcode running\nwith N loopback replicas and reports "
+           "throughput, loss, latency and reflector\nCPU usage.\n\n");
+    printf("\t-r <pkt_per_sec> - sending rate, 0 for unlimited (default)\n");
+    printf("\t-s <pkt_size>    - UDP payload size (default %d, min %d)\n",
+           DEFAULT_PKT_SIZE, MIN_PKT_SIZE);
+    printf("\t-n <replicas>    - number of output ports (default %d)\n",
+           DEFAULT_REPLICAS);
+    printf("\t-d <seconds>     - measurement duration (default %d)\n",
+           DEFAULT_DURATION);
+    printf("\t-p <port>        - reflector listening port, replicas use the "
+           "following\n\t\t\t   even ports (default %d)\n",
+           DEFAULT_PORT);
+    printf("\t-b <buffer_size> - reflector buffer size (default 8M)\n");
+    printf("\t-R <reflector>   - reflector executable (default "
+           "hd-rum-transcode\n\t\t\t   next to this binary)\n");
+    printf("\t-v               - show reflector output\n");
+    printf("\nExample:\n\t%s -r 100000 -n 4 -- --writer-threads 2\n",
+           progname);
+}
+
+/**
+ * @retval 0 success
+ * @retval 1 help shown
+ * @retval -1 error
+ */
+static int parse_opts(int argc, char **argv, struct bench_opts *opts)
+{
+    int ch = 0;
+    while ((ch = getopt(argc, argv, "R:b:d:hn:p:r:s:v")) != -1) {
+        switch (ch) {
+        case 'R':
+            opts->reflector = optarg;
+            break;
+        case 'b':
+            opts->bufsize = optarg;
+            break;
+        case 'd':
+            opts->duration = atoi(optarg);
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 1;
+        case 'n':
+            opts->replicas = atoi(optarg);
+            break;
+        case 'p':
+            opts->port = atoi(optarg);
+            break;
+        case 'r':
+            opts->rate = atoll(optarg);
+            break;
+        case 's':
+            opts->pkt_size = atoi(optarg);
+            break;
+        case 'v':
+            opts->verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    for (int i = optind; i < argc; ++i) {
+        opts->reflector_args.emplace_back(argv[i]);
+    }
+    if (opts->pkt_size < MIN_PKT_SIZE || opts->pkt_size > 9000) {
+        fprintf(stderr, "Packet size must be in range [%d..9000]!\n",
+                MIN_PKT_SIZE);
+        return -1;
+    }
+    if (opts->replicas < 1 || opts->duration < 1 || opts->rate < 0 ||
+        opts->port <= 0 || opts->port + 2 * opts->replicas > USHRT_MAX) {
+        fprintf(stderr, "Wrong replica count, duration, rate or port!\n");
+        return -1;
+    }
+    if (opts->reflector.empty()) {
+        string self = argv[0];
+        const size_t slash = self.rfind('/');
+        opts->reflector = (slash == string::npos ? string(".")
+                                                 : self.substr(0, slash)) +
+                          "/hd-rum-transcode";
+    }
+    return 0;
+}
+
+static int bind_loopback(int port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int bufsize = 16 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof bufsize);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof addr) != 0) {
+        fprintf(stderr, "Cannot bind port %d: %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static pid_t spawn_reflector(const struct bench_opts *opts)
+{
+    vector<string> args{ opts->reflector };
+    args.insert(args.end(), opts->reflector_args.begin(),
+                opts->reflector_args.end());
+    args.push_back(opts->bufsize);
+    args.push_back(std::to_string(opts->port));
+    for (int i = 0; i < opts->replicas; ++i) {
+        args.emplace_back("-P");
+        args.push_back(std::to_string(opts->port + 2 * (i + 1)));
+        args.emplace_back("127.0.0.1");
+    }
+    vector<char *> argv;
+    for (auto &a : args) {
+        argv.push_back(&a[0]);
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!opts->verbose) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execv(argv[0], argv.data());
+        fprintf(stderr, "Cannot execute %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+    if (pid < 0) {
+        perror("fork");
+    }
+    return pid;
+}
+
+/// @returns reflector process CPU time in ns or -1 if not available
+static int64_t get_process_cpu_ns(pid_t pid)
+{
+#ifdef __linux__
+    char path[64];
+    snprintf(path, sizeof path, "/proc/%d/stat", (int) pid);
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        return -1;
+    }
+    char buf[1024];
+    size_t len = fread(buf, 1, sizeof buf - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+    // skip pid and (comm), which may contain spaces
+    const char *p = strrchr(buf, ')');
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    if (p == nullptr ||
+        sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2) {
+        return -1;
+    }
+    return (int64_t) (utime + stime) * NS_PER_SEC / sysconf(_SC_CLK_TCK);
+#else
+    (void) pid;
+    return -1;
+#endif
+}
+
+static void account_packet(struct bench_state *s, struct replica_stats *r,
+                           const char *data, int len, int64_t now)
+{
+    if (len < MIN_PKT_SIZE) {
+        return;
+    }
+    struct bench_trailer tr;
+    memcpy(&tr, data + RTP_HDR_LEN + sizeof(video_payload_hdr_t), sizeof tr);
+    if (!r->alive) {
+        r->alive = true;
+        s->alive_replicas += 1;
+    }
+    if (tr.seq == WARMUP_SEQ) {
+        return;
+    }
+    r->received += 1;
+    if (tr.seq < r->max_seq) {
+        r->reordered += 1;
+    }
+    r->max_seq = std::max(r->max_seq, tr.seq);
+
+    const int64_t latency = now - tr.send_time_ns;
+    s->max_latency_ns = std::max(s->max_latency_ns, latency);
+    const int64_t latency_us = latency / 1000;
+    if (latency_us >= 0 && latency_us <= HIST_MAX_US) {
+        s->hist[latency_us] += 1;
+    } else {
+        s->hist_overflow += 1;
+    }
+}
+
+static void receiver(struct bench_state *s, int pkt_size)
+{
+    vector<struct pollfd> fds;
+    for (auto &r : s->replicas) {
+        fds.push_back({ r.fd, POLLIN, 0 });
+    }
+    vector<char> bufs((size_t) RECV_BATCH * pkt_size);
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[RECV_BATCH] = {};
+    struct iovec iov[RECV_BATCH];
+    for (int i = 0; i < RECV_BATCH; ++i) {
+        iov[i].iov_base = &bufs[(size_t) i * pkt_size];
+        iov[i].iov_len = pkt_size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    while (!s->should_stop.load(std::memory_order_relaxed)) {
+        if (poll(fds.data(), fds.size(), 100) <= 0) {
+            continue;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if ((fds[i].revents & POLLIN) == 0) {
+                continue;
+            }
+            struct replica_stats *r = &s->replicas[i];
+#ifdef HAVE_RECVMMSG
+            const int ret =
+                recvmmsg(r->fd, msgs, RECV_BATCH, MSG_DONTWAIT, nullptr);
+            const int64_t now = now_ns();
+            for (int j = 0; j < ret; ++j) {
+                account_packet(s, r, (char *) iov[j].iov_base,
+                               msgs[j].msg_len, now);
+            }
+#else
+            const ssize_t ret =
+                recv(r->fd, bufs.data(), pkt_size, MSG_DONTWAIT);
+            account_packet(s, r, bufs.data(), ret, now_ns());
+#endif
+        }
+    }
+}
+
+/// builds a packet resembling an uncompressed UltraGrid video packet
+static void fill_packet(char *pkt, int pkt_size, uint64_t seq)
+{
+    const uint16_t rtp_seq = htons((uint16_t) seq);
+    pkt[0] = (char) 0x80; // version 2
+    pkt[1] = PT_VIDEO;
+    memcpy(pkt + 2, &rtp_seq, sizeof rtp_seq);
+    const uint32_t ts = htonl((uint32_t) (seq / 512) * 3000);
+    memcpy(pkt + 4, &ts, sizeof ts);
+    const uint32_t ssrc = htonl(0xBE7C4);
+    memcpy(pkt + 8, &ssrc, sizeof ssrc);
+
+    const uint32_t payload_len = pkt_size - RTP_HDR_LEN - sizeof(video_payload_hdr_t);
+    video_payload_hdr_t hdr;
+    hdr[0] = htonl((uint32_t) (seq / 512) & 0x3FFFFF); // substream 0, buffer
+    hdr[1] = htonl((uint32_t) (seq % 512) * payload_len);
+    hdr[2] = htonl(512 * payload_len);
+    hdr[3] = htonl(1920 << 16 | 1080);
+    hdr[4] = htonl(0x55595659); // 'UYVY'
+    hdr[5] = htonl(30U << 22 | 1U << 19 | 1U << 15);
+    memcpy(pkt + RTP_HDR_LEN, hdr, sizeof hdr);
+
+    struct bench_trailer tr = { seq, now_ns() };
+    memcpy(pkt + RTP_HDR_LEN + sizeof hdr, &tr, sizeof tr);
+}
+
+/// @returns number of sent packets or -1 on error
+static int send_packets(int fd, vector<char> *pkts, int pkt_size, int count,
+                        uint64_t first_seq)
+{
+    for (int i = 0; i < count; ++i) {
+        fill_packet(&(*pkts)[(size_t) i * pkt_size], pkt_size,
+                    first_seq == WARMUP_SEQ ? WARMUP_SEQ : first_seq + i);
+    }
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[SEND_BATCH] = {};
+    struct iovec iov[SEND_BATCH];
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = &(*pkts)[(size_t) i * pkt_size];
+        iov[i].iov_len = pkt_size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int sent = 0;
+    while (sent < count) {
+        int ret = sendmmsg(fd, msgs + sent, count - sent, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == ENOBUFS || errno == EAGAIN) {
+                continue;
+            }
+            return sent > 0 ? sent : -1;
+        }
+        sent += ret;
+    }
+    return sent;
+#else
+    for (int i = 0; i < count; ++i) {
+        while (send(fd, &(*pkts)[(size_t) i * pkt_size], pkt_size, 0) < 0) {
+            if (errno != EINTR && errno != ENOBUFS && errno != EAGAIN) {
+                return i > 0 ? i : -1;
+            }
+        }
+    }
+    return count;
+#endif
+}
+
+static double percentile(const struct bench_state *s, uint64_t total,
+                         double pct)
+{
+    const uint64_t target = (uint64_t) (total * pct / 100.0);
+    uint64_t acc = 0;
+    for (size_t i = 0; i < s->hist.size(); ++i) {
+        acc += s->hist[i];
+        if (acc > target) {
+            return (double) i;
+        }
+    }
+    return (double) s->max_latency_ns / 1000;
+}
+
+static void report(const struct bench_opts *opts, const struct bench_state *s,
+                   uint64_t sent, int64_t duration_ns, int64_t cpu_ns)
+{
+    const double secs = (double) duration_ns / NS_PER_SEC;
+    printf("\nSent %" PRIu64 " packets of %d B in %.2f s = %.0f pkt/s "
+           "(%.3f Gbps)\n",
+           sent, opts->pkt_size, secs, sent / secs,
+           sent * opts->pkt_size * 8 / secs / 1e9);
+
+    uint64_t total_received = 0;
+    printf("\n%-8s %-6s %12s %12s %8s %10s\n", "replica", "port", "received",
+           "lost", "loss[%]", "reordered");
+    for (size_t i = 0; i < s->replicas.size(); ++i) {
+        const replica_stats &r = s->replicas[i];
+        const uint64_t lost = sent > r.received ? sent - r.received : 0;
+        printf("%-8zu %-6d %12" PRIu64 " %12" PRIu64 " %8.3f %10" PRIu64 "\n",
+               i, r.port, r.received, lost,
+               sent > 0 ? 100.0 * lost / sent : 0.0, r.reordered);
+        total_received += r.received;
+    }
+    printf("\nForwarded %.0f pkt/s in total\n", total_received / secs);
+
+    uint64_t samples = s->hist_overflow;
+    for (uint64_t n : s->hist) {
+        samples += n;
+    }
+    if (samples > 0) {
+        printf("Latency [us]: p50 %.0f, p90 %.0f, p99 %.0f, p99.9 %.0f, "
+               "max %.0f\n",
+               percentile(s, samples, 50), percentile(s, samples, 90),
+               percentile(s, samples, 99), percentile(s, samples, 99.9),
+               (double) s->max_latency_ns / 1000);
+    }
+    if (cpu_ns >= 0 && sent > 0) {
+        printf("Reflector CPU: %.3f s (%.0f%%), %.3f us per received packet, "
+               "%.3f us per forwarded packet\n",
+               (double) cpu_ns / NS_PER_SEC, 100.0 * cpu_ns / duration_ns,
+               (double) cpu_ns / 1000 / sent,
+               total_received > 0 ? (double) cpu_ns / 1000 / total_received
+                                  : 0.0);
+    } else {
+        printf("Reflector CPU usage not available\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts;
+    const int rc = parse_opts(argc, argv, &opts);
+    if (rc != 0) {
+        return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    struct bench_state s;
+    s.replicas.resize(opts.replicas);
+    for (int i = 0; i < opts.replicas; ++i) {
+        s.replicas[i].port = opts.port + 2 * (i + 1);
+        s.replicas[i].fd = bind_loopback(s.replicas[i].port);
+        if (s.replicas[i].fd < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in dst = {};
+    dst.sin_family = AF_INET;
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    dst.sin_port = htons(opts.port);
+    int sndbuf = 16 * 1024 * 1024;
+    setsockopt(tx_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+    if (tx_fd < 0 ||
+        connect(tx_fd, (struct sockaddr *) &dst, sizeof dst) != 0) {
+        perror("sender socket");
+        return EXIT_FAILURE;
+    }
+
+    const pid_t pid = spawn_reflector(&opts);
+    if (pid < 0) {
+        return EXIT_FAILURE;
+    }
+
+    std::thread rx_thread(receiver, &s, opts.pkt_size);
+    vector<char> pkts((size_t) SEND_BATCH * opts.pkt_size);
+
+    // wait until the reflector forwards to all replicas
+    const int64_t warmup_start = now_ns();
+    while (s.alive_replicas.load() < opts.replicas) {
+        if (now_ns() - warmup_start > WARMUP_TIMEOUT_NS ||
+            waitpid(pid, nullptr, WNOHANG) == pid) {
+            fprintf(stderr, "Reflector %s is not forwarding to all "
+                            "replicas!\n",
+                    opts.reflector.c_str());
+            s.should_stop = true;
+            rx_thread.join();
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            return EXIT_FAILURE;
+        }
+        send_packets(tx_fd, &pkts, opts.pkt_size, 1, WARMUP_SEQ);
+        usleep(10000);
+    }
+    usleep(DRAIN_NS / 1000);
+
+    printf("Sending %d B packets at %s to %d replicas for %d s...\n",
+           opts.pkt_size,
+           opts.rate > 0 ? std::to_string(opts.rate).append(" pkt/s").c_str()
+                         : "unlimited rate",
+           opts.replicas, opts.duration);
+    const int64_t cpu_start = get_process_cpu_ns(pid);
+    const int64_t start = now_ns();
+    const int64_t end = start + opts.duration * NS_PER_SEC;
+    uint64_t sent = 0;
+    int64_t now = start;
+    while ((now = now_ns()) < end) {
+        int count = SEND_BATCH;
+        if (opts.rate > 0) {
+            const uint64_t due = (uint64_t) ((double) (now - start) *
+                                             opts.rate / NS_PER_SEC);
+            if (due <= sent) {
+                const int64_t next = start + (int64_t) ((double) (sent + 1) *
+                                                        NS_PER_SEC / opts.rate);
+                struct timespec ts = { 0, (long) std::min<int64_t>(
+                                              next - now, 1000000) };
+                nanosleep(&ts, nullptr);
+                continue;
+            }
+            count = (int) std::min<uint64_t>(due - sent, SEND_BATCH);
+        }
+        const int ret = send_packets(tx_fd, &pkts, opts.pkt_size, count, sent);
+        if (ret < 0) {
+            perror("send");
+            break;
+        }
+        sent += ret;
+    }
+    const int64_t duration = now_ns() - start;
+    usleep(DRAIN_NS / 1000);
+    const int64_t cpu_end = get_process_cpu_ns(pid);
+    s.should_stop = true;
+    rx_thread.join();
+
+    kill(pid, SIGINT);
+    struct rusage ru = {};
+    int status = 0;
+    if (wait4(pid, &status, 0, &ru) < 0) {
+        perror("wait4");
+    }
+    int64_t cpu_ns = -1;
+    if (cpu_start >= 0 && cpu_end >= 0) {
+        cpu_ns = cpu_end - cpu_start;
+    } else { // whole process lifetime, including startup
+        cpu_ns = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * NS_PER_SEC +
+                 (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000LL;
+    }
+
+    report(&opts, &s, sent, duration, cpu_ns);
+
+    for (auto &r : s.replicas) {
+        close(r.fd);
+    }
+    close(tx_fd);
+    return EXIT_SUCCESS;
+}
+
+/* vim: set sw=4 expandtab : */
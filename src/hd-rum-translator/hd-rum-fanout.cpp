@@ -0,0 +1,100 @@
+/**
+ * @file   hd-rum-translator/hd-rum-fanout.cpp
+ * @brief  batched sending of reflected packets to multiple replicas
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "hd-rum-translator/hd-rum-fanout.h"
+
+#include <algorithm>
+
+using std::vector;
+
+void
+hd_rum_fanout::send(const vector<fanout_dest> &dests, char *const *pkts,
+                    const int *lens, size_t pkt_count, unsigned queue_depth)
+{
+        if (dests.empty() || pkt_count == 0) {
+                return;
+        }
+        // group destinations by socket (stable to keep the replica order)
+        m_order.resize(dests.size());
+        for (size_t i = 0; i < dests.size(); ++i) {
+                m_order[i] = i;
+        }
+        std::stable_sort(m_order.begin(), m_order.end(),
+                         [&dests](size_t a, size_t b) {
+                                 return dests[a].sock < dests[b].sock;
+                         });
+
+        for (size_t first = 0; first < m_order.size();) {
+                socket_udp *sock = dests[m_order[first]].sock;
+                size_t      last = first;
+                while (last < m_order.size() &&
+                       dests[m_order[last]].sock == sock) {
+                        last += 1;
+                }
+                // packet-major order - every replica gets a packet before
+                // any of them gets the next one
+                m_dgrams.clear();
+                m_owner.clear();
+                for (size_t p = 0; p < pkt_count; ++p) {
+                        for (size_t d = first; d < last; ++d) {
+                                const fanout_dest &dest = dests[m_order[d]];
+                                m_dgrams.push_back({ pkts[p], lens[p],
+                                                     dest.addr, dest.addrlen,
+                                                     0 });
+                                m_owner.push_back(dest.stats);
+                        }
+                }
+                udp_sendto_multi(sock, m_dgrams.data(), (int) m_dgrams.size());
+
+                for (size_t d = first; d < last; ++d) {
+                        fanout_replica_stats *st = dests[m_order[d]].stats;
+                        st->sent += pkt_count;
+                        st->queue_depth = queue_depth;
+                        if (queue_depth > st->max_queue_depth) {
+                                st->max_queue_depth = queue_depth;
+                        }
+                }
+                for (size_t i = 0; i < m_dgrams.size(); ++i) {
+                        if (m_dgrams[i].err != 0) {
+                                m_owner[i]->sent -= 1;
+                                m_owner[i]->errors += 1;
+                                m_owner[i]->last_error = m_dgrams[i].err;
+                        }
+                }
+                first = last;
+        }
+}
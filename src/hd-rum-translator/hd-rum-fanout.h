@@ -0,0 +1,81 @@
+/**
+ * @file   hd-rum-translator/hd-rum-fanout.h
+ * @brief  batched sending of reflected packets to multiple replicas
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HD_RUM_FANOUT_H_6a1f0c3e9b42
+#define HD_RUM_FANOUT_H_6a1f0c3e9b42
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rtp/net_udp.h"
+
+/// per-replica counters, may be read from other threads
+struct fanout_replica_stats {
+        std::atomic<uint64_t> sent{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<int>      last_error{ 0 }; ///< errno of last failure
+        /// packets waiting in the queue when the replica was last served
+        std::atomic<unsigned> queue_depth{ 0 };
+        std::atomic<unsigned> max_queue_depth{ 0 };
+};
+
+struct fanout_dest {
+        socket_udp                  *sock; ///< destinations with same sock are batched together
+        struct sockaddr             *addr;
+        socklen_t                    addrlen;
+        struct fanout_replica_stats *stats;
+};
+
+/**
+ * Sends a batch of packets to all destinations. Packets to destinations
+ * sharing a socket are passed in a single udp_sendto_multi() (sendmmsg())
+ * call, packet payloads are not copied.
+ */
+class hd_rum_fanout {
+public:
+        void send(const std::vector<fanout_dest> &dests, char *const *pkts,
+                  const int *lens, size_t pkt_count, unsigned queue_depth);
+
+private:
+        std::vector<udp_dgram>             m_dgrams;
+        std::vector<fanout_replica_stats *> m_owner; ///< stats of m_dgrams[i]
+        std::vector<size_t>                m_order;
+};
+
+#endif // defined HD_RUM_FANOUT_H_6a1f0c3e9b42
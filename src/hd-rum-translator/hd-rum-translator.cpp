@@ -45,6 +45,7 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>                              // for min, swap
 #include <atomic>                                 // for atomic, memory_order
 #include <cassert>                                // for assert
 #include <cctype>                                 // for isdigit
@@ -57,6 +58,7 @@
 #include <ctime>                                  // for localtime, strftime
 #include <getopt.h>
 #include <memory>                                 // for shared_ptr, operator!=
+#include <mutex>                                  // for mutex, lock_guard
 #include <pthread.h>
 #include <stdexcept>                              // for invalid_argument
 #include <string>
@@ -70,6 +72,7 @@
 #include "control_socket.h"
 #include "debug.h"
 #include "hd-rum-translator/hd-rum-decompress.h"
+#include "hd-rum-translator/hd-rum-fanout.h"
 #include "hd-rum-translator/hd-rum-recompress.h"
 #include "host.h"
 #include "lib_common.h"
@@ -95,6 +98,10 @@ using std::vector;
 #define MOD_NAME "[hd-rum-trans] "
 
 #define REPLICA_MAGIC 0xd2ff3323
+#define FANOUT_BATCH 64 ///< max packets sent to replicas at once
+#define REPLICA_STATS_INTERVAL_NS (5 * NS_IN_SEC)
+#define MAX_WRITER_THREADS 64
+#define INGEST_BATCH 64 ///< max packets received at once
 
 static void
 set_replica_mod_name(size_t buflen, char *buf, const char *addr,
@@ -109,10 +116,13 @@ set_replica_mod_name(size_t buflen, char *buf, const char *addr,
 }
 
 static void new_message_received(struct module *);
+struct hd_rum_translator_state;
 
 struct replica {
-    replica(const char *addr, uint16_t rx_port, uint16_t tx_port, int bufsize, struct module *parent, int force_ip_version) {
+    replica(const char *addr, uint16_t rx_port, uint16_t tx_port, int bufsize, struct module *parent,
+            struct hd_rum_translator_state *owner, int force_ip_version) {
         magic = REPLICA_MAGIC;
+        this->owner = owner;
         host = addr;
         m_tx_port = tx_port;
         sock = std::shared_ptr<socket_udp>(udp_init(addr, rx_port, tx_port, 255, force_ip_version, false), udp_exit);
@@ -125,6 +135,10 @@ struct replica {
             fprintf(stderr, "Cannot set send buffer to %sB!\n",
                     format_in_si_units(bufsize));
         }
+        if (rx_port == 0 && !is_addr_multicast(addr)) {
+            fanout_key = (udp_is_ipv6(sock.get()) ? 2 : 0) |
+                         (sockaddr.ss_family == AF_INET6 ? 1 : 0);
+        }
         module_init_default(&mod);
         mod.cls = MODULE_CLASS_PORT;
         set_replica_mod_name(sizeof mod.name, mod.name, addr, tx_port);
@@ -141,6 +155,7 @@ struct replica {
 
     struct module mod;
     uint32_t magic;
+    struct hd_rum_translator_state *owner;
     string host;
     int m_tx_port;
 
@@ -149,10 +164,34 @@ struct replica {
         USE_SOCK,
         RECOMPRESS
     };
-    enum type_t type;
+    std::atomic<type_t> type;
     std::shared_ptr<socket_udp> sock;
     sockaddr_storage sockaddr;
     socklen_t sockaddr_len;
+
+    /// unicast replicas with an ephemeral source port and the same key can
+    /// be sent from a single socket, -1 if the own socket must be used
+    int fanout_key = -1;
+    struct fanout_replica_stats stats;
+    uint64_t reported_errors = 0;
+    int shard = -1; ///< index of the writer thread forwarding to this replica
+};
+
+/**
+ * Writer thread state. Each writer walks the packet queue with its own read
+ * cursor and forwards the packets to its subset of replicas. The first
+ * writer additionally processes module messages, feeds the transcoder and
+ * reports statistics.
+ */
+struct writer_shard {
+    struct hd_rum_translator_state *s = nullptr;
+    int idx = 0;
+    pthread_t thread{};
+    std::atomic<struct item *> head{ nullptr }; ///< read cursor
+    bool kick = false;              ///< wake-up request, guarded by qempty_mtx
+    std::atomic<bool> sleeping{ false }; ///< waits for the queue to fill
+    std::mutex lock;                ///< protects replicas
+    vector<replica *> replicas;
 };
 
 struct hd_rum_translator_state {
@@ -174,16 +213,16 @@ struct hd_rum_translator_state {
     int bufsize = 0;
     struct control_state *control_state = nullptr;
     struct item *queue = nullptr;
-    struct item *qhead = nullptr;
-    struct item *qtail = nullptr;
-    int qempty = 1;
-    int qfull = 0;
+    int qsize = 0;
+    std::atomic<struct item *> qtail{ nullptr };
+    std::atomic<bool> producer_waiting{ false }; ///< waits for a free slot
     pthread_mutex_t qempty_mtx;
     pthread_mutex_t qfull_mtx;
     pthread_cond_t qempty_cond;
     pthread_cond_t qfull_cond;
 
     vector<replica *> replicas;
+    vector<std::unique_ptr<writer_shard>> shards;
     std::shared_ptr<socket_udp> server_socket;
     void *decompress = nullptr;
     bool capture_filter_set = false;
@@ -334,6 +373,42 @@ static VOID CALLBACK wsa_deleter(DWORD /* dwErrorCode */,
 }
 #endif
 
+/// assigns the replica to the writer thread with the fewest replicas
+static void shard_add_replica(struct hd_rum_translator_state *s,
+                              struct replica *rep)
+{
+    writer_shard *best = nullptr;
+    size_t best_count = SIZE_MAX;
+    for (auto &sh : s->shards) {
+        std::lock_guard<std::mutex> lk(sh->lock);
+        if (sh->replicas.size() < best_count) {
+            best = sh.get();
+            best_count = sh->replicas.size();
+        }
+    }
+    std::lock_guard<std::mutex> lk(best->lock);
+    best->replicas.push_back(rep);
+    rep->shard = best->idx;
+}
+
+/// removes the replica from its writer, only that writer is blocked meanwhile
+static void shard_remove_replica(struct hd_rum_translator_state *s,
+                                 struct replica *rep)
+{
+    if (rep->shard < 0) {
+        return;
+    }
+    writer_shard *sh = s->shards[rep->shard].get();
+    std::lock_guard<std::mutex> lk(sh->lock);
+    for (auto it = sh->replicas.begin(); it != sh->replicas.end(); ++it) {
+        if (*it == rep) {
+            sh->replicas.erase(it);
+            break;
+        }
+    }
+    rep->shard = -1;
+}
+
 /// prints a warning if there is a setting not applicable on forward-only port
 static void
 print_unapplied_config_warns(const char *fec, bool cap_filter_used)
@@ -358,10 +433,11 @@ static int create_output_port(struct hd_rum_translator_state *s,
 {
         struct replica *rep;
         try {
-            rep = new replica(addr, rx_port, tx_port, bufsize, &s->mod,
+            rep = new replica(addr, rx_port, tx_port, bufsize, &s->mod, s,
                               opts->force_ip_version);
             if(use_server_sock){
                     rep->sock = s->server_socket;
+                    rep->fanout_key = -1;
             }
         } catch (string const & s) {
             fputs(s.c_str(), stderr);
@@ -390,127 +466,221 @@ static int create_output_port(struct hd_rum_translator_state *s,
 
         assert((unsigned) idx == s->replicas.size() - 1);
         recompress_port_set_active(s->recompress, idx, compression != nullptr);
+        shard_add_replica(s, rep);
 
         return idx;
 }
 
-static void *writer(void *arg)
+/// passes the packet for transcoding if needed
+static void pass_to_decompress(struct hd_rum_translator_state *s,
+                               struct item *it)
 {
-    struct hd_rum_translator_state *s =
-        (struct hd_rum_translator_state *) arg;
+    if (recompress_get_num_active_ports(s->recompress) > 0) {
+        ssize_t ret = hd_rum_decompress_write(s->decompress, it->buf, it->size);
+        if (ret < 0) {
+            perror("hd_rum_decompress_write");
+        }
+    }
+}
 
-    while (1) {
-        // first check messages
-        for (unsigned int i = 0; i < s->replicas.size(); i++) {
-            struct message *msg;
-            while ((msg = check_message(&s->replicas[i]->mod))) {
-                struct response *r = change_replica_type(s, &s->replicas[i]->mod, msg, i);
-                free_message(msg, r);
+#ifndef _WIN32
+/**
+ * Sends up to FANOUT_BATCH queued packets to the shard's output ports that
+ * don't need transcoding, stops before a poisoned pill.
+ *
+ * @returns new shard queue head
+ */
+static struct item *forward_packets(struct hd_rum_translator_state *s,
+                                    writer_shard *sh, hd_rum_fanout *fanout,
+                                    vector<fanout_dest> *dests)
+{
+    struct item *const tail = s->qtail.load(std::memory_order_acquire);
+    struct item *const head = sh->head.load(std::memory_order_relaxed);
+    const unsigned depth =
+        ((tail - s->queue) - (head - s->queue) + s->qsize) % s->qsize;
+
+    char *pkts[FANOUT_BATCH];
+    int lens[FANOUT_BATCH];
+    size_t count = 0;
+    struct item *it = head;
+    for (; it != tail && it->size != 0 && count < FANOUT_BATCH; it = it->next) {
+        if (sh->idx == 0) {
+            pass_to_decompress(s, it);
+        }
+        pkts[count] = it->buf;
+        lens[count] = (int) it->size;
+        count += 1;
+    }
+
+    // unicast replicas of the same kind share one socket
+    socket_udp *shared_sock[4] = {};
+    dests->clear();
+    std::lock_guard<std::mutex> lk(sh->lock);
+    for (auto *r : sh->replicas) {
+        if (r->type != replica::type_t::USE_SOCK) {
+            continue;
+        }
+        socket_udp *sock = r->sock.get();
+        if (r->fanout_key >= 0) {
+            if (shared_sock[r->fanout_key] == nullptr) {
+                shared_sock[r->fanout_key] = sock;
             }
+            sock = shared_sock[r->fanout_key];
         }
+        dests->push_back({ sock, (struct sockaddr *) &r->sockaddr,
+                           r->sockaddr_len, &r->stats });
+    }
+    fanout->send(*dests, pkts, lens, count, depth);
+    return it;
+}
+#endif
 
-        struct msg_universal *msg;
-        while ((msg = (struct msg_universal *) check_message(&s->mod))) {
-            struct response *r = NULL;
-            if (strncasecmp(msg->text, "delete-port ", strlen("delete-port ")) == 0) {
-                char *port_spec = msg->text + strlen("delete-port ");
-                int index = -1;
-                if (isdigit(port_spec[0])) {
-                    int i = stoi(port_spec);
-                    if (i >= 0 && i < (int) s->replicas.size()) {
-                        index = i;
-                    } else {
-                        log_msg(LOG_LEVEL_WARNING, "Invalid port index: %d. Not removing.\n", i);
-                    }
+static void report_replica_stats(struct hd_rum_translator_state *s)
+{
+    for (auto *r : s->replicas) {
+        if (r->type != replica::type_t::USE_SOCK) {
+            continue;
+        }
+        const uint64_t errors = r->stats.errors;
+        const int level = errors > r->reported_errors ? LOG_LEVEL_WARNING
+                                                      : LOG_LEVEL_VERBOSE;
+        log_msg(level,
+                MOD_NAME "%s: %" PRIu64 " packets sent, %" PRIu64
+                " send errors%s%s, queue depth %u (max %u)\n",
+                r->mod.name, r->stats.sent.load(), errors,
+                errors > 0 ? ", last: " : "",
+                errors > 0 ? ug_strerror(r->stats.last_error) : "",
+                r->stats.queue_depth.load(), r->stats.max_queue_depth.load());
+        r->reported_errors = errors;
+    }
+}
+
+/// processes replica type changes and port creation/removal requests
+static void process_messages(struct hd_rum_translator_state *s)
+{
+    for (unsigned int i = 0; i < s->replicas.size(); i++) {
+        struct message *msg;
+        while ((msg = check_message(&s->replicas[i]->mod))) {
+            struct response *r = change_replica_type(s, &s->replicas[i]->mod, msg, i);
+            free_message(msg, r);
+        }
+    }
+
+    struct msg_universal *msg;
+    while ((msg = (struct msg_universal *) check_message(&s->mod))) {
+        struct response *r = NULL;
+        if (strncasecmp(msg->text, "delete-port ", strlen("delete-port ")) == 0) {
+            char *port_spec = msg->text + strlen("delete-port ");
+            int index = -1;
+            if (isdigit(port_spec[0])) {
+                int i = stoi(port_spec);
+                if (i >= 0 && i < (int) s->replicas.size()) {
+                    index = i;
                 } else {
-                    int i = 0;
-                    for (auto r : s->replicas) {
-                        if (strcmp(r->mod.name, port_spec) == 0) {
-                            index = i;
-                            break;
-                        }
-                        i++;
-                    }
-                    if (index == -1) {
-                        log_msg(LOG_LEVEL_WARNING, "Unknown port name: %s. Not removing.\n", port_spec);
+                    log_msg(LOG_LEVEL_WARNING, "Invalid port index: %d. Not removing.\n", i);
+                }
+            } else {
+                int i = 0;
+                for (auto r : s->replicas) {
+                    if (strcmp(r->mod.name, port_spec) == 0) {
+                        index = i;
+                        break;
                     }
+                    i++;
                 }
-                if (index >= 0) {
-                    recompress_remove_port(s->recompress, index);
-                    delete s->replicas[index];
-                    s->replicas.erase(s->replicas.begin() + index);
-                    log_msg(LOG_LEVEL_NOTICE, "Deleted output port %d.\n", index);
+                if (index == -1) {
+                    log_msg(LOG_LEVEL_WARNING, "Unknown port name: %s. Not removing.\n", port_spec);
                 }
-            } else if (strncasecmp(msg->text, "create-port", strlen("create-port")) == 0) {
-                // format of parameters is either:
-                // <host>:<port> [<compression>]
-                // or (for compat with older CoUniverse version)
-                // <host> <port> [<compression>]
-                char *host_port, *port_str = NULL, *save_ptr;
-                char *host;
-                int tx_port;
-                strtok_r(msg->text, " ", &save_ptr);
-                host_port = strtok_r(NULL, " ", &save_ptr);
-                if (host_port && (strchr(host_port, ':') != NULL || (port_str = strtok_r(NULL, " ", &save_ptr)) != NULL)) {
-                    if (port_str) {
-                        host = host_port;
-                        tx_port = stoi(port_str);
-                    } else {
-                        tx_port = stoi(strrchr(host_port, ':') + 1);
-                        host = host_port;
-                        *strrchr(host_port, ':') = '\0';
-                    }
-                    // handle square brackets around an IPv6 address
-                    if (host[0] == '[' && host[strlen(host) - 1] == ']') {
-                        host += 1;
-                        host[strlen(host) - 1] = '\0';
-                    }
+            }
+            if (index >= 0) {
+                recompress_remove_port(s->recompress, index);
+                shard_remove_replica(s, s->replicas[index]);
+                delete s->replicas[index];
+                s->replicas.erase(s->replicas.begin() + index);
+                log_msg(LOG_LEVEL_NOTICE, "Deleted output port %d.\n", index);
+            }
+        } else if (strncasecmp(msg->text, "create-port", strlen("create-port")) == 0) {
+            // format of parameters is either:
+            // <host>:<port> [<compression>]
+            // or (for compat with older CoUniverse version)
+            // <host> <port> [<compression>]
+            char *host_port, *port_str = NULL, *save_ptr;
+            char *host;
+            int tx_port;
+            strtok_r(msg->text, " ", &save_ptr);
+            host_port = strtok_r(NULL, " ", &save_ptr);
+            if (host_port && (strchr(host_port, ':') != NULL || (port_str = strtok_r(NULL, " ", &save_ptr)) != NULL)) {
+                if (port_str) {
+                    host = host_port;
+                    tx_port = stoi(port_str);
                 } else {
-                    const char *err_msg = "wrong format";
-                    log_msg(LOG_LEVEL_ERROR, "%s\n", err_msg);
-                    free_message((struct message *) msg, new_response(RESPONSE_BAD_REQUEST, err_msg));
-                    continue;
+                    tx_port = stoi(strrchr(host_port, ':') + 1);
+                    host = host_port;
+                    *strrchr(host_port, ':') = '\0';
                 }
-                char *compress = strtok_r(NULL, " ", &save_ptr);
-
-                struct rxtx_params opts = RXTX_INIT;
-                int idx = create_output_port(
-                    s, host, 0, tx_port, s->bufsize, &opts, compress, nullptr,
-                    RTP_RATE_UNLIMITED, s->server_socket != nullptr);
-
-                if(idx < 0) {
-                    free_message((struct message *) msg, new_response(RESPONSE_INT_SERV_ERR, "Cannot create output port."));
-                    continue;
+                // handle square brackets around an IPv6 address
+                if (host[0] == '[' && host[strlen(host) - 1] == ']') {
+                    host += 1;
+                    host[strlen(host) - 1] = '\0';
                 }
+            } else {
+                const char *err_msg = "wrong format";
+                log_msg(LOG_LEVEL_ERROR, "%s\n", err_msg);
+                free_message((struct message *) msg, new_response(RESPONSE_BAD_REQUEST, err_msg));
+                continue;
+            }
+            char *compress = strtok_r(NULL, " ", &save_ptr);
 
-                if(compress)
-                    log_msg(LOG_LEVEL_NOTICE, "Created new transcoding output port %s:%d:0x%08" PRIx32 ".\n", host, tx_port, recompress_get_port_ssrc(s->recompress, idx));
-                else
-                    log_msg(LOG_LEVEL_NOTICE, "Created new forwarding output port %s:%d.\n", host, tx_port);
+            struct rxtx_params opts = RXTX_INIT;
+            int idx = create_output_port(
+                s, host, 0, tx_port, s->bufsize, &opts, compress, nullptr,
+                RTP_RATE_UNLIMITED, s->server_socket != nullptr);
 
-            } else {
-                r = new_response(RESPONSE_BAD_REQUEST, NULL);
+            if(idx < 0) {
+                free_message((struct message *) msg, new_response(RESPONSE_INT_SERV_ERR, "Cannot create output port."));
+                continue;
             }
 
-            free_message((struct message *) msg, r ? r : new_response(RESPONSE_OK, NULL));
+            if(compress)
+                log_msg(LOG_LEVEL_NOTICE, "Created new transcoding output port %s:%d:0x%08" PRIx32 ".\n", host, tx_port, recompress_get_port_ssrc(s->recompress, idx));
+            else
+                log_msg(LOG_LEVEL_NOTICE, "Created new forwarding output port %s:%d.\n", host, tx_port);
+
+        } else {
+            r = new_response(RESPONSE_BAD_REQUEST, NULL);
+        }
+
+        free_message((struct message *) msg, r ? r : new_response(RESPONSE_OK, NULL));
+    }
+}
+
+static void *writer(void *arg)
+{
+    auto *sh = (writer_shard *) arg;
+    struct hd_rum_translator_state *s = sh->s;
+#ifndef _WIN32
+    hd_rum_fanout fanout;
+    vector<fanout_dest> dests;
+#endif
+    time_ns_t last_stats_report = get_time_in_ns();
+
+    while (1) {
+        // first check messages
+        if (sh->idx == 0) {
+            process_messages(s);
         }
 
         // then process incoming packets
-        while (s->qhead != s->qtail) {
-            if(s->qhead->size == 0) { // poisoned pill
+        struct item *head = sh->head.load(std::memory_order_relaxed);
+        while (head != s->qtail.load(std::memory_order_acquire)) {
+            if(head->size == 0) { // poisoned pill
                 return NULL;
             }
 
-            // pass it for transcoding if needed
-            if (recompress_get_num_active_ports(s->recompress) > 0) {
-                ssize_t ret = hd_rum_decompress_write(s->decompress, s->qhead->buf, s->qhead->size);
-                if (ret < 0) {
-                    perror("hd_rum_decompress_write");
-                }
-            }
+#ifdef _WIN32
+            pass_to_decompress(s, head);
 
             // distribute it to output ports that don't need transcoding
-#ifdef _WIN32
             // send it asynchronously in MSW (performance optimalization)
             SleepEx(0, true); // allow system to call our completion routines in APC
             int ref = 0;
@@ -519,15 +689,15 @@ static void *writer(void *arg)
                     ref++;
                 }
             }
-            struct wsa_aux_storage *aux = (struct wsa_aux_storage *)(void *) ((char *) s->qhead->buf + OFFSET);
+            struct wsa_aux_storage *aux = (struct wsa_aux_storage *)(void *) ((char *) head->buf + OFFSET);
             memset(aux, 0, sizeof *aux);
             aux->overlapped = (WSAOVERLAPPED *) calloc(ref, sizeof(WSAOVERLAPPED));
             aux->ref = ref;
             int overlapped_idx = 0;
             for (unsigned int i = 0; i < s->replicas.size(); i++) {
                 if(s->replicas[i]->type == replica::type_t::USE_SOCK) {
-                    aux->overlapped[overlapped_idx].hEvent = s->qhead->buf;
-                    ssize_t ret = udp_sendto_wsa_async(s->replicas[i]->sock.get(), s->qhead->buf, s->qhead->size,
+                    aux->overlapped[overlapped_idx].hEvent = head->buf;
+                    ssize_t ret = udp_sendto_wsa_async(s->replicas[i]->sock.get(), head->buf, head->size,
                                     wsa_deleter, &aux->overlapped[overlapped_idx], (sockaddr *) &s->replicas[i]->sockaddr, s->replicas[i]->sockaddr_len);
                     if (ret < 0) {
                         perror("Hd-rum-translator send");
@@ -536,43 +706,102 @@ static void *writer(void *arg)
                 }
             }
             // reallocate the buffer since the last one will be freed automatically
-            s->qhead->buf = (char *) malloc(SIZE);
+            head->buf = (char *) malloc(SIZE);
+            head = head->next;
 #else
-            for (unsigned int i = 0; i < s->replicas.size(); i++) {
-                if(s->replicas[i]->type == replica::type_t::USE_SOCK) {
-                    ssize_t ret = udp_sendto(s->replicas[i]->sock.get(), s->qhead->buf, s->qhead->size, (sockaddr *) &s->replicas[i]->sockaddr, s->replicas[i]->sockaddr_len);
-                    if (ret < 0) {
-                        perror("Hd-rum-translator send");
-                    }
-                }
-            }
+            head = forward_packets(s, sh, &fanout, &dests);
 #endif
-            s->qhead = s->qhead->next;
+            sh->head.store(head);
 
-            pthread_mutex_lock(&s->qfull_mtx);
-            s->qfull = 0;
-            pthread_cond_signal(&s->qfull_cond);
-            pthread_mutex_unlock(&s->qfull_mtx);
+            if (s->producer_waiting.load()) {
+                pthread_mutex_lock(&s->qfull_mtx);
+                pthread_cond_signal(&s->qfull_cond);
+                pthread_mutex_unlock(&s->qfull_mtx);
+            }
         }
 
+        if (sh->idx == 0) {
+            const time_ns_t now = get_time_in_ns();
+            if (now - last_stats_report > REPLICA_STATS_INTERVAL_NS) {
+                report_replica_stats(s);
+                last_stats_report = now;
+            }
+        }
+
+        // the producer signals only writers that announced they sleep
         pthread_mutex_lock(&s->qempty_mtx);
-        if (s->qempty)
+        sh->sleeping.store(true);
+        while (!sh->kick && sh->head.load(std::memory_order_relaxed) ==
+                                s->qtail.load()) {
             pthread_cond_wait(&s->qempty_cond, &s->qempty_mtx);
-        s->qempty = 1;
+        }
+        sh->sleeping.store(false, std::memory_order_relaxed);
+        sh->kick = false;
         pthread_mutex_unlock(&s->qempty_mtx);
     }
 
     return NULL;
 }
 
+/// wakes up writers, all of them or only the first one (messages)
+static void kick_writers(struct hd_rum_translator_state *s, bool all)
+{
+    pthread_mutex_lock(&s->qempty_mtx);
+    for (auto &sh : s->shards) {
+        sh->kick = true;
+        if (!all) {
+            break;
+        }
+    }
+    pthread_cond_broadcast(&s->qempty_cond);
+    pthread_mutex_unlock(&s->qempty_mtx);
+}
+
+/// wakes up writers that found the queue empty (called after enqueueing)
+static void wake_sleeping_writers(struct hd_rum_translator_state *s)
+{
+    for (auto &sh : s->shards) {
+        if (sh->sleeping.load()) {
+            pthread_mutex_lock(&s->qempty_mtx);
+            pthread_cond_broadcast(&s->qempty_cond);
+            pthread_mutex_unlock(&s->qempty_mtx);
+            return;
+        }
+    }
+}
+
+/// @returns number of slots that the slowest writer has already consumed
+static int queue_free_slots(struct hd_rum_translator_state *s)
+{
+    const int tail = (int) (s->qtail.load(std::memory_order_relaxed) - s->queue);
+    int free_slots = s->qsize - 1;
+    for (auto &sh : s->shards) {
+        const int head = (int) (sh->head.load() - s->queue);
+        const int depth = (tail - head + s->qsize) % s->qsize;
+        free_slots = std::min(free_slots, s->qsize - 1 - depth);
+    }
+    return free_slots;
+}
+
+/// @param should_exit  stop waiting when set, may be NULL
+static void wait_queue_not_full(struct hd_rum_translator_state *s,
+                                const volatile bool *should_exit)
+{
+    pthread_mutex_lock(&s->qfull_mtx);
+    s->producer_waiting.store(true);
+    while (queue_free_slots(s) == 0 &&
+           (should_exit == nullptr || !*should_exit)) {
+        pthread_cond_wait(&s->qfull_cond, &s->qfull_mtx);
+    }
+    s->producer_waiting.store(false, std::memory_order_relaxed);
+    pthread_mutex_unlock(&s->qfull_mtx);
+}
+
 static void
 new_message_received(struct module *m)
 {
-        auto *s = (struct hd_rum_translator_state *) m->priv_data;
-        pthread_mutex_lock(&s->qempty_mtx);
-        s->qempty = 0;
-        pthread_mutex_unlock(&s->qempty_mtx);
-        pthread_cond_signal(&s->qempty_cond);
+        auto *r = (struct replica *) m->priv_data;
+        kick_writers(r->owner, false);
 }
 
 static void usage(const char *progname) {
@@ -603,6 +832,9 @@ static void usage(const char *progname) {
           << " - compression for conference participants\n"
           << SBOLD("\t--capture-filter|-F <cfg_string>")
           << " - apply video capture filter to incoming video\n"
+          << SBOLD("\t--writer-threads|-W <n>")
+          << " - number of threads forwarding packets to output ports "
+             "(default 1)\n"
           << SBOLD("\t--param|-O") << " - additional parameters\n"
           << SBOLD("\t--help|-h\n") << SBOLD("\t--verbose|-V\n") << SBOLD("\t-v")
           << " - print version\n";
@@ -648,6 +880,7 @@ struct cmdline_parameters {
     const char *capture_filter = NULL;
     int log_level = -1;
     const char *conference_compression = nullptr;
+    int writer_threads = 1;
 };
 
 /// unit_evaluate() is similar but uses SI prefixes
@@ -693,6 +926,7 @@ static int parse_global_opts(int argc, char **argv,
                 { "param",                  required_argument, nullptr, 'O'},
                 { "conference-compression", required_argument, nullptr, 'R'},
                 { "server",                 required_argument, nullptr, 'S'},
+                { "writer-threads",         required_argument, nullptr, 'W'},
                 { "verbose",                optional_argument, nullptr, 'V'},
                 { "capabilities",           no_argument,       nullptr, 'b'},
                 { "help",                   no_argument,       nullptr, 'h'},
@@ -701,7 +935,7 @@ static int parse_global_opts(int argc, char **argv,
                 { "version",                no_argument,       nullptr, 'v'},
                 { nullptr,                  0,                 nullptr, 0  }
         };
-        const char *const optstring = "+BF:LO:R:S:Vbhn:r:v";
+        const char *const optstring = "+BF:LO:R:S:VW:bhn:r:v";
 
         int ch = 0;
         while ((ch = getopt_long(argc, argv, optstring, getopt_options,
@@ -734,6 +968,21 @@ static int parse_global_opts(int argc, char **argv,
                 case 'F':
                         parsed->capture_filter = optarg;
                         break;
+                case 'W':
+                        parsed->writer_threads = stoi(optarg);
+                        if (parsed->writer_threads < 1 ||
+                            parsed->writer_threads > MAX_WRITER_THREADS) {
+                                MSG(ERROR, "Writer thread count must be in "
+                                           "range [1..%d]!\n",
+                                    MAX_WRITER_THREADS);
+                                return -1;
+                        }
+#ifdef _WIN32
+                        MSG(WARNING, "Multiple writer threads not supported "
+                                     "in MSW, using one.\n");
+                        parsed->writer_threads = 1;
+#endif
+                        break;
                 case 'h':
                         usage(argv[0]);
                         return 1;
@@ -1034,8 +1283,6 @@ int main(int argc, char **argv)
     }
 
     int qsize;
-    pthread_t thread;
-    int err = 0;
     int i;
     struct cmdline_parameters params = {};
 
@@ -1089,10 +1336,17 @@ int main(int argc, char **argv)
 
     printf("using UDP send and receive buffer size of %d bytes\n", state.bufsize);
 
-    state.qhead = state.qtail = state.queue = qinit(qsize);
-    if (!state.qhead) {
+    state.qsize = qsize;
+    state.qtail = state.queue = qinit(qsize);
+    if (!state.queue) {
         EXIT(EXIT_FAILURE);
     }
+    for (i = 0; i < params.writer_threads; i++) {
+        state.shards.emplace_back(new writer_shard);
+        state.shards.back()->s = &state;
+        state.shards.back()->idx = i;
+        state.shards.back()->head = state.queue;
+    }
 
     /* input socket */
     if ((sock_in = udp_init_if("localhost", NULL, params.port, 0, 255, false, false)) == NULL) {
@@ -1161,9 +1415,15 @@ int main(int argc, char **argv)
         }
     }
 
-    if (pthread_create(&thread, NULL, writer, (void *) &state)) {
-        fprintf(stderr, "cannot create writer thread\n");
-        EXIT(2);
+    for (auto &sh : state.shards) {
+        if (pthread_create(&sh->thread, NULL, writer, (void *) sh.get())) {
+            fprintf(stderr, "cannot create writer thread\n");
+            EXIT(2);
+        }
+    }
+    if (params.writer_threads > 1) {
+        MSG(INFO, "Forwarding with %d writer threads.\n",
+            params.writer_threads);
     }
 
     uint64_t received_data = 0;
@@ -1181,79 +1441,86 @@ int main(int argc, char **argv)
     volatile bool should_exit = false;
     register_should_exit_callback(&state.mod, hd_rum_translator_should_exit_callback, const_cast<bool *>(&should_exit));
     /* main loop */
+    struct udp_dgram dgrams[INGEST_BATCH];
+    struct sockaddr_storage sin[INGEST_BATCH];
     while (!should_exit) {
-        while (state.qtail->next != state.qhead && !should_exit) {
-            struct timeval timeout = { 1, 0 };
-
-            struct sockaddr_storage sin = {};
-            socklen_t addrlen = sizeof(sin);
-            state.qtail->size = udp_recvfrom_timeout(sock_in, state.qtail->buf, SIZE, &timeout, (sockaddr *) &sin, &addrlen);
-            if(state.qtail->size <= 0)
-                break;
+        const int free_slots = queue_free_slots(&state);
+        if (free_slots == 0) {
+            wait_queue_not_full(&state, &should_exit);
+            continue;
+        }
 
-            struct timeval t;
-            gettimeofday(&t, NULL);
+        // receive directly to the free queue slots
+        const int batch = std::min(free_slots, INGEST_BATCH);
+        struct item *const tail = state.qtail.load(std::memory_order_relaxed);
+        struct item *it = tail;
+        for (int i = 0; i < batch; ++i, it = it->next) {
+            dgrams[i] = { it->buf, MAX_PKT_SIZE, (struct sockaddr *) &sin[i],
+                          sizeof sin[i], 0 };
+        }
+        struct timeval timeout = { 1, 0 };
+        const int count = udp_recvfrom_multi_timeout(sock_in, dgrams, batch,
+                                                     &timeout);
+        if (count < 0) {
+            MSG(WARNING, "read: %s\n", ug_strerror(errno));
+            continue;
+        }
 
-            if(params.out_conf.mode == CONFERENCE){
-                    participant_mgr.tick(sin, addrlen);
+        // empty datagrams are dropped (size 0 is the poisoned pill)
+        it = tail;
+        struct item *out = tail;
+        for (int i = 0; i < count; ++i, it = it->next) {
+            if (params.out_conf.mode == CONFERENCE) {
+                participant_mgr.tick(sin[i], dgrams[i].addrlen);
             }
-
-            received_data += state.qtail->size;
-
-            state.qtail = state.qtail->next;
-
-            pthread_mutex_lock(&state.qempty_mtx);
-            state.qempty = 0;
-            pthread_cond_signal(&state.qempty_cond);
-            pthread_mutex_unlock(&state.qempty_mtx);
-
-            double seconds = tv_diff(t, t0);
-            if (seconds > 5.0) {
-                unsigned long long int cur_data = (received_data - last_data);
-                unsigned long long int bps = cur_data / seconds;
-                char tim_str[20];
-                time_t tim = time(NULL);
-                struct tm *tmp = localtime(&tim);
-                if (tmp) {
-                    strftime(tim_str, sizeof(tim_str), "%F %T", tmp);
-                }
-                char buf[FORMAT_NUM_MAX_SZ];
-                log_msg(LOG_LEVEL_INFO,
-                        "[%s] Received %s B in %.5f seconds = %sbps\n",
-                        tim_str,
-                        format_number_with_delim(cur_data, buf, sizeof buf),
-                        seconds, format_in_si_units(bps * 8));
-                t0 = t;
-                last_data = received_data;
+            if (dgrams[i].len <= 0) {
+                continue;
+            }
+            if (out != it) {
+                std::swap(out->buf, it->buf);
             }
+            out->size = dgrams[i].len;
+            received_data += dgrams[i].len;
+            out = out->next;
+        }
+        if (out != tail) {
+            state.qtail.store(out);
+            wake_sleeping_writers(&state);
         }
 
-        if (state.qtail->size <= 0)
-            continue;
-
-        pthread_mutex_lock(&state.qfull_mtx);
-        if (state.qfull)
-            pthread_cond_wait(&state.qfull_cond, &state.qfull_mtx);
-        state.qfull = 1;
-        pthread_mutex_unlock(&state.qfull_mtx);
-    }
-
-    if (state.qtail->size < 0 && !should_exit) {
-        printf("read: %s\n", strerror(err));
-        EXIT(2);
+        struct timeval t;
+        gettimeofday(&t, NULL);
+        double seconds = tv_diff(t, t0);
+        if (seconds > 5.0) {
+            unsigned long long int cur_data = (received_data - last_data);
+            unsigned long long int bps = cur_data / seconds;
+            char tim_str[20];
+            time_t tim = time(NULL);
+            struct tm *tmp = localtime(&tim);
+            if (tmp) {
+                strftime(tim_str, sizeof(tim_str), "%F %T", tmp);
+            }
+            char buf[FORMAT_NUM_MAX_SZ];
+            log_msg(LOG_LEVEL_INFO,
+                    "[%s] Received %s B in %.5f seconds = %sbps\n",
+                    tim_str,
+                    format_number_with_delim(cur_data, buf, sizeof buf),
+                    seconds, format_in_si_units(bps * 8));
+            t0 = t;
+            last_data = received_data;
+        }
     }
 
-    // pass poisoned pill to the worker
-    state.qtail->size = 0;
-    state.qtail = state.qtail->next;
-
-    pthread_mutex_lock(&state.qempty_mtx);
-    state.qempty = 0;
-    pthread_cond_signal(&state.qempty_cond);
-    pthread_mutex_unlock(&state.qempty_mtx);
+    // pass poisoned pill to the workers
+    wait_queue_not_full(&state, nullptr);
+    state.qtail.load()->size = 0;
+    state.qtail.store(state.qtail.load()->next, std::memory_order_release);
+    kick_writers(&state, true);
 
     alarm(5);
-    pthread_join(thread, NULL);
+    for (auto &sh : state.shards) {
+        pthread_join(sh->thread, NULL);
+    }
 
     hd_rum_translator_deinit(&state);
     udp_exit(sock_in);
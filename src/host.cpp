@@ -138,12 +138,6 @@ static XGetErrorText_fn *XGetErrorTextProc;
 #include <dlfcn.h>
 #endif
 
-#ifdef HAVE_FEC_INIT
-#define restrict __restrict // not a C++ keyword
-extern "C" {
-#include <fec.h>
-}
-#endif
 
 #ifdef __gnu_linux__
 #include <mcheck.h>
@@ -621,10 +615,6 @@ struct init_data *common_preinit(int argc, char *argv[])
 
         load_libgcc();
 
-#ifdef HAVE_FEC_INIT
-        fec_init();
-#endif
-
 #ifdef HAVE_LIBBACKTRACE
         int fd = STDERR_FILENO;
         bt = backtrace_create_state(uv_argv[0], 1 /*thread safe*/,
@@ -1015,8 +1005,13 @@ const char *get_commandline_param(const char *key)
         }
 }
 
+/// @param val value to set, NULL to unset the param
 void set_commandline_param(const char *key, const char *val)
 {
+        if (val == NULL) {
+                commandline_params.erase(key);
+                return;
+        }
         commandline_params[key] = val;
 }
 
@@ -63,7 +63,9 @@
 #include "rtp/pbuf.h"
 
 #include <assert.h>    // for assert
+#include <pthread.h>   // for pthread_mutex_lock, pthread_mutex_unlock
 #include <stdlib.h>    // for NULL, free, malloc
+#include <string.h>    // for memset
 
 #include "config.h"    // for DEBUG
 #include "debug.h"
@@ -89,6 +91,11 @@ struct pdb {
         int count;
         volatile int *delay_ms;
         char stream_identifier[STR_LEN];
+
+        /// loss reported by receivers, see pdb_add_loss_report()
+        pthread_mutex_t loss_report_lock;
+        struct pbuf_loss_report loss_report;
+        int loss_report_count;
 };
 
 /*****************************************************************************/
@@ -254,6 +261,9 @@ struct pdb *pdb_init(const char *stream_id, volatile int *delay_ms)
                 db->delay_ms = delay_ms;
                 snprintf_ch(db->stream_identifier, "%s",
                             IF_NOT_NULL_ELSE(stream_id, "unknown"));
+                pthread_mutex_init(&db->loss_report_lock, NULL);
+                memset(&db->loss_report, 0, sizeof db->loss_report);
+                db->loss_report_count = 0;
         }
         return db;
 }
@@ -275,10 +285,42 @@ void pdb_destroy(struct pdb **db_p)
                 pdb_iter_done(&it);
         }
 
+        pthread_mutex_destroy(&db->loss_report_lock);
         free(db);
         *db_p = NULL;
 }
 
+/**
+ * Accumulates a packet loss report received from a receiver. May be called
+ * from a different thread than pdb_take_loss_report().
+ */
+void pdb_add_loss_report(struct pdb *db, const struct pbuf_loss_report *report)
+{
+        pthread_mutex_lock(&db->loss_report_lock);
+        db->loss_report.expected += report->expected;
+        db->loss_report.received += report->received;
+        for (int i = 0; i < PBUF_LOSS_BURST_BUCKETS; ++i) {
+                db->loss_report.bursts[i] += report->bursts[i];
+        }
+        db->loss_report_count += 1;
+        pthread_mutex_unlock(&db->loss_report_lock);
+}
+
+/**
+ * Moves the loss reports accumulated by pdb_add_loss_report() to report.
+ * @returns number of the reports
+ */
+int pdb_take_loss_report(struct pdb *db, struct pbuf_loss_report *report)
+{
+        pthread_mutex_lock(&db->loss_report_lock);
+        const int ret = db->loss_report_count;
+        *report = db->loss_report;
+        memset(&db->loss_report, 0, sizeof db->loss_report);
+        db->loss_report_count = 0;
+        pthread_mutex_unlock(&db->loss_report_lock);
+        return ret;
+}
+
 static struct pdb_e *
 pdb_create_item(uint32_t ssrc, const char *stream_id, volatile int *delay_ms)
 {
@@ -95,6 +95,7 @@ struct pdb_e {
 };
 
 struct pdb;	/* The participant database */
+struct pbuf_loss_report;
 
 /**
  * @param delay_ms delay to be added to playback. Main reason is to give user a possibility to
@@ -111,6 +112,9 @@ struct pdb_e        *pdb_get(struct pdb *db, uint32_t ssrc);
 int                  pdb_remove(struct pdb *db, uint32_t ssrc, struct pdb_e **item);
 void                 pdb_destroy_item(struct pdb_e *item);
 
+void                 pdb_add_loss_report(struct pdb *db, const struct pbuf_loss_report *report);
+int                  pdb_take_loss_report(struct pdb *db, struct pbuf_loss_report *report);
+
 typedef void *pdb_iter_t;
 /*
  * Iterator for the database.
@@ -73,6 +73,10 @@
 #ifdef __SSSE3__
 #include "tmmintrin.h"
 #endif
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define PIXFMT_CONV_X86 1
+#include <immintrin.h>
+#endif
 
 #define MOD_NAME "[pixfmt_conv] "
 
@@ -3032,6 +3036,770 @@ static void vc_copylineY416toV210(unsigned char * __restrict dst, const unsigned
         }
 }
 
+/*
+ * Runtime-dispatched x86 SIMD variants of the most frequently used line
+ * decoders. Every kernel converts whole vector-sized groups and passes the
+ * rest of the line to the scalar decoder, so the output (including partial
+ * tails) is bit-exact with the scalar reference. Source may be over-read by
+ * less than MAX_PADDING bytes, destination is never written past dst_len.
+ */
+#ifdef PIXFMT_CONV_X86
+/// stores 3 low bytes of each 32-bit word as 24 contiguous bytes
+__attribute__((target("avx2"))) static inline void
+store_3of4_avx2(unsigned char *dst, __m256i v)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, //
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        v = _mm256_shuffle_epi8(v, shuf);
+        v = _mm256_permutevar8x32_epi32(
+            v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i *) (void *) dst, _mm256_castsi256_si128(v));
+        _mm_storel_epi64((__m128i *) (void *) (dst + 16),
+                         _mm256_extracti128_si256(v, 1));
+}
+
+/// stores 3 low bytes of each 32-bit word as 48 contiguous bytes
+__attribute__((target("avx512f,avx512bw"))) static inline void
+store_3of4_avx512(unsigned char *dst, __m512i v)
+{
+        const __m512i shuf = _mm512_broadcast_i32x4(_mm_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+        v = _mm512_shuffle_epi8(v, shuf);
+        v = _mm512_permutexvar_epi32(
+            _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 3, 7,
+                              11, 15),
+            v);
+        _mm512_mask_storeu_epi8(dst, 0xFFFFFFFFFFFFULL, v);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylinev210_avx2(unsigned char *__restrict dst,
+                     const unsigned char *__restrict src, int dst_len,
+                     int rshift, int gshift, int bshift)
+{
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        for (; dst_len >= 24; dst_len -= 24, src += 32, dst += 24) {
+                __m256i w = _mm256_loadu_si256((const void *) src);
+                __m256i a = _mm256_and_si256(_mm256_srli_epi32(w, 2), mask);
+                __m256i b = _mm256_and_si256(_mm256_srli_epi32(w, 4),
+                                             _mm256_slli_epi32(mask, 8));
+                __m256i c = _mm256_and_si256(_mm256_srli_epi32(w, 6),
+                                             _mm256_slli_epi32(mask, 16));
+                store_3of4_avx2(dst, _mm256_or_si256(_mm256_or_si256(a, b), c));
+        }
+        vc_copylinev210(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+vc_copylinev210_avx512(unsigned char *__restrict dst,
+                       const unsigned char *__restrict src, int dst_len,
+                       int rshift, int gshift, int bshift)
+{
+        const __m512i mask = _mm512_set1_epi32(0xFF);
+        for (; dst_len >= 48; dst_len -= 48, src += 64, dst += 48) {
+                __m512i w = _mm512_loadu_si512(src);
+                __m512i a = _mm512_and_si512(_mm512_srli_epi32(w, 2), mask);
+                __m512i b = _mm512_and_si512(_mm512_srli_epi32(w, 4),
+                                             _mm512_slli_epi32(mask, 8));
+                __m512i c = _mm512_and_si512(_mm512_srli_epi32(w, 6),
+                                             _mm512_slli_epi32(mask, 16));
+                store_3of4_avx512(dst,
+                                  _mm512_or_si512(_mm512_or_si512(a, b), c));
+        }
+        vc_copylinev210(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/// expands bytes 0-2 of each word in v to the 10-bit v210 fields
+#define UYVY_WORDS_TO_V210(ISA, v) \
+        _mm##ISA##_or_si##ISA( \
+            _mm##ISA##_or_si##ISA( \
+                _mm##ISA##_slli_epi32( \
+                    _mm##ISA##_and_si##ISA(v, _mm##ISA##_set1_epi32(0xFF)), \
+                    2), \
+                _mm##ISA##_slli_epi32( \
+                    _mm##ISA##_and_si##ISA(v, \
+                                           _mm##ISA##_set1_epi32(0xFF00)), \
+                    4)), \
+            _mm##ISA##_slli_epi32( \
+                _mm##ISA##_and_si##ISA(v, _mm##ISA##_set1_epi32(0xFF0000)), \
+                6))
+
+__attribute__((target("avx2"))) static void
+vc_copylineUYVYtoV210_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, //
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        for (; dst_len >= 32; dst_len -= 32, src += 24, dst += 32) {
+                __m256i v = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128((const void *) src)),
+                    _mm_loadu_si128((const void *) (src + 12)), 1);
+                v = _mm256_shuffle_epi8(v, shuf);
+                _mm256_storeu_si256((void *) dst, UYVY_WORDS_TO_V210(256, v));
+        }
+        vc_copylineUYVYtoV210(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+vc_copylineUYVYtoV210_avx512(unsigned char *__restrict dst,
+                             const unsigned char *__restrict src, int dst_len,
+                             int rshift, int gshift, int bshift)
+{
+        const __m512i spread = _mm512_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0, 6, 7,
+                                                 8, 0, 9, 10, 11, 0);
+        const __m512i shuf = _mm512_broadcast_i32x4(_mm_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+        for (; dst_len >= 64; dst_len -= 64, src += 48, dst += 64) {
+                __m512i v = _mm512_maskz_loadu_epi8(0xFFFFFFFFFFFFULL, src);
+                v = _mm512_shuffle_epi8(_mm512_permutexvar_epi32(spread, v),
+                                        shuf);
+                _mm512_storeu_si512(dst, UYVY_WORDS_TO_V210(512, v));
+        }
+        vc_copylineUYVYtoV210(dst, src, dst_len, rshift, gshift, bshift);
+}
+#undef UYVY_WORDS_TO_V210
+
+__attribute__((target("avx2"))) static void
+vc_copylineY216toUYVY_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            3, 1, 7, 5, 11, 9, 15, 13, -1, -1, -1, -1, -1, -1, -1, -1, //
+            3, 1, 7, 5, 11, 9, 15, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+        for (; dst_len >= 32; dst_len -= 32, src += 64, dst += 32) {
+                __m256i a = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256((const void *) src), shuf);
+                __m256i b = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256((const void *) (src + 32)), shuf);
+                _mm256_storeu_si256(
+                    (void *) dst,
+                    _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b),
+                                             0xD8));
+        }
+        vc_copylineY216toUYVY(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+vc_copylineY216toUYVY_avx512(unsigned char *__restrict dst,
+                             const unsigned char *__restrict src, int dst_len,
+                             int rshift, int gshift, int bshift)
+{
+        const __m512i shuf = _mm512_broadcast_i32x4(_mm_setr_epi8(
+            3, 1, 7, 5, 11, 9, 15, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+        const __m512i idx = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+        for (; dst_len >= 64; dst_len -= 64, src += 128, dst += 64) {
+                __m512i a = _mm512_shuffle_epi8(_mm512_loadu_si512(src), shuf);
+                __m512i b =
+                    _mm512_shuffle_epi8(_mm512_loadu_si512(src + 64), shuf);
+                _mm512_storeu_si512(dst, _mm512_permutex2var_epi64(a, idx, b));
+        }
+        vc_copylineY216toUYVY(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineUYVYtoY216_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            -1, 1, -1, 0, -1, 3, -1, 2, -1, 5, -1, 4, -1, 7, -1, 6, //
+            -1, 9, -1, 8, -1, 11, -1, 10, -1, 13, -1, 12, -1, 15, -1, 14);
+        for (; dst_len >= 32; dst_len -= 32, src += 16, dst += 32) {
+                __m256i v = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128((const void *) src));
+                _mm256_storeu_si256((void *) dst, _mm256_shuffle_epi8(v, shuf));
+        }
+        vc_copylineUYVYtoY216(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/**
+ * R10k (big-endian 10-bit RGB) words to 8-bit components in the low byte
+ * of 32-bit lanes, the same way as the scalar bit-field decoders do it
+ */
+#define R10K_R(ISA, w) _mm##ISA##_and_si##ISA(w, _mm##ISA##_set1_epi32(0xFF))
+#define R10K_G(ISA, w) \
+        _mm##ISA##_or_si##ISA( \
+            _mm##ISA##_and_si##ISA(_mm##ISA##_srli_epi32(w, 6), \
+                                   _mm##ISA##_set1_epi32(0xFC)), \
+            _mm##ISA##_and_si##ISA(_mm##ISA##_srli_epi32(w, 22), \
+                                   _mm##ISA##_set1_epi32(0x3)))
+#define R10K_B(ISA, w) \
+        _mm##ISA##_or_si##ISA( \
+            _mm##ISA##_and_si##ISA(_mm##ISA##_srli_epi32(w, 12), \
+                                   _mm##ISA##_set1_epi32(0xF0)), \
+            _mm##ISA##_srli_epi32(w, 28))
+
+__attribute__((target("avx2"))) static void
+vc_copyliner10k_avx2(unsigned char *__restrict dst,
+                     const unsigned char *__restrict src, int len, int rshift,
+                     int gshift, int bshift)
+{
+        const uint32_t alpha_mask = 0xFFFFFFFFU ^ (0xFFU << rshift) ^
+                                    (0xFFU << gshift) ^ (0xFFU << bshift);
+        const __m256i alpha = _mm256_set1_epi32((int) alpha_mask);
+        const __m128i rs = _mm_cvtsi32_si128(rshift);
+        const __m128i gs = _mm_cvtsi32_si128(gshift);
+        const __m128i bs = _mm_cvtsi32_si128(bshift);
+        for (; len >= 32; len -= 32, src += 32, dst += 32) {
+                __m256i w = _mm256_loadu_si256((const void *) src);
+                __m256i r = _mm256_sll_epi32(R10K_R(256, w), rs);
+                __m256i g = _mm256_sll_epi32(R10K_G(256, w), gs);
+                __m256i b = _mm256_sll_epi32(R10K_B(256, w), bs);
+                _mm256_storeu_si256(
+                    (void *) dst,
+                    _mm256_or_si256(_mm256_or_si256(alpha, r),
+                                    _mm256_or_si256(g, b)));
+        }
+        vc_copyliner10k(dst, src, len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+vc_copyliner10k_avx512(unsigned char *__restrict dst,
+                       const unsigned char *__restrict src, int len,
+                       int rshift, int gshift, int bshift)
+{
+        const uint32_t alpha_mask = 0xFFFFFFFFU ^ (0xFFU << rshift) ^
+                                    (0xFFU << gshift) ^ (0xFFU << bshift);
+        const __m512i alpha = _mm512_set1_epi32((int) alpha_mask);
+        const __m128i rs = _mm_cvtsi32_si128(rshift);
+        const __m128i gs = _mm_cvtsi32_si128(gshift);
+        const __m128i bs = _mm_cvtsi32_si128(bshift);
+        for (; len >= 64; len -= 64, src += 64, dst += 64) {
+                __m512i w = _mm512_loadu_si512(src);
+                __m512i r = _mm512_sll_epi32(R10K_R(512, w), rs);
+                __m512i g = _mm512_sll_epi32(R10K_G(512, w), gs);
+                __m512i b = _mm512_sll_epi32(R10K_B(512, w), bs);
+                _mm512_storeu_si512(
+                    dst, _mm512_or_si512(_mm512_or_si512(alpha, r),
+                                         _mm512_or_si512(g, b)));
+        }
+        vc_copyliner10k(dst, src, len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copyliner10ktoRGB_avx2(unsigned char *__restrict dst,
+                          const unsigned char *__restrict src, int dst_len,
+                          int rshift, int gshift, int bshift)
+{
+        for (; dst_len >= 24; dst_len -= 24, src += 32, dst += 24) {
+                __m256i w = _mm256_loadu_si256((const void *) src);
+                __m256i rgb = _mm256_or_si256(
+                    _mm256_or_si256(R10K_R(256, w),
+                                    _mm256_slli_epi32(R10K_G(256, w), 8)),
+                    _mm256_slli_epi32(R10K_B(256, w), 16));
+                store_3of4_avx2(dst, rgb);
+        }
+        vc_copyliner10ktoRGB(dst, src, dst_len, rshift, gshift, bshift);
+}
+#undef R10K_R
+#undef R10K_G
+#undef R10K_B
+
+/// same integer arithmetic as copylineYUVtoRGB, 8 pixels per iteration
+__attribute__((target("avx2"))) static void
+vc_copylineUYVYtoRGB_avx2(unsigned char *__restrict dst,
+                          const unsigned char *__restrict src, int dst_len,
+                          int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, DEPTH8);
+        const __m256i y_scale = _mm256_set1_epi32(cfs.y_scale);
+        const __m256i r_cr = _mm256_set1_epi32(cfs.r_cr);
+        const __m256i g_cb = _mm256_set1_epi32(cfs.g_cb);
+        const __m256i g_cr = _mm256_set1_epi32(cfs.g_cr);
+        const __m256i b_cb = _mm256_set1_epi32(cfs.b_cb);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i max = _mm256_set1_epi32(255);
+        const __m128i y_shuf = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, -1,
+                                             -1, -1, -1, -1, -1, -1, -1);
+        const __m128i u_shuf = _mm_setr_epi8(0, 0, 4, 4, 8, 8, 12, 12, -1, -1,
+                                             -1, -1, -1, -1, -1, -1);
+        const __m128i v_shuf = _mm_setr_epi8(2, 2, 6, 6, 10, 10, 14, 14, -1,
+                                             -1, -1, -1, -1, -1, -1, -1);
+        for (; dst_len >= 24; dst_len -= 24, src += 16, dst += 24) {
+                __m128i in = _mm_loadu_si128((const void *) src);
+                __m256i y = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, y_shuf));
+                __m256i u = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, u_shuf));
+                __m256i v = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, v_shuf));
+                y = _mm256_mullo_epi32(
+                    _mm256_sub_epi32(y, _mm256_set1_epi32(16)), y_scale);
+                u = _mm256_sub_epi32(u, _mm256_set1_epi32(128));
+                v = _mm256_sub_epi32(v, _mm256_set1_epi32(128));
+                __m256i r = _mm256_add_epi32(y, _mm256_mullo_epi32(v, r_cr));
+                __m256i g = _mm256_add_epi32(
+                    _mm256_add_epi32(y, _mm256_mullo_epi32(u, g_cb)),
+                    _mm256_mullo_epi32(v, g_cr));
+                __m256i b = _mm256_add_epi32(y, _mm256_mullo_epi32(u, b_cb));
+                r = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_srai_epi32(r, COMP_BASE), zero),
+                    max);
+                g = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_srai_epi32(g, COMP_BASE), zero),
+                    max);
+                b = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_srai_epi32(b, COMP_BASE), zero),
+                    max);
+                store_3of4_avx2(
+                    dst, _mm256_or_si256(
+                             _mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                             _mm256_slli_epi32(b, 16)));
+        }
+        vc_copylineUYVYtoRGB(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/// same floating-point arithmetic as vc_copylineUYVYtoRGBA for 4 pixels
+__attribute__((target("avx2"))) static inline void
+uyvy_to_rgba_float_avx2(__m128i y, __m128i u, __m128i v, __m128i *r,
+                        __m128i *g, __m128i *b)
+{
+        const __m256d ys = _mm256_mul_pd(
+            _mm256_set1_pd(1.164),
+            _mm256_cvtepi32_pd(_mm_sub_epi32(y, _mm_set1_epi32(16))));
+        const __m256d ud =
+            _mm256_cvtepi32_pd(_mm_sub_epi32(u, _mm_set1_epi32(128)));
+        const __m256d vd =
+            _mm256_cvtepi32_pd(_mm_sub_epi32(v, _mm_set1_epi32(128)));
+        *r = _mm256_cvttpd_epi32(
+            _mm256_add_pd(ys, _mm256_mul_pd(_mm256_set1_pd(1.793), vd)));
+        *g = _mm256_cvttpd_epi32(_mm256_sub_pd(
+            _mm256_sub_pd(ys, _mm256_mul_pd(_mm256_set1_pd(0.534), vd)),
+            _mm256_mul_pd(_mm256_set1_pd(0.213), ud)));
+        *b = _mm256_cvttpd_epi32(
+            _mm256_add_pd(ys, _mm256_mul_pd(_mm256_set1_pd(2.115), ud)));
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineUYVYtoRGBA_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const uint32_t alpha_mask = 0xFFFFFFFFU ^ (0xFFU << rshift) ^
+                                    (0xFFU << gshift) ^ (0xFFU << bshift);
+        const __m256i alpha = _mm256_set1_epi32((int) alpha_mask);
+        const __m128i rs = _mm_cvtsi32_si128(rshift);
+        const __m128i gs = _mm_cvtsi32_si128(gshift);
+        const __m128i bs = _mm_cvtsi32_si128(bshift);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i max = _mm256_set1_epi32(255);
+        const __m128i y_shuf = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, -1,
+                                             -1, -1, -1, -1, -1, -1, -1);
+        const __m128i u_shuf = _mm_setr_epi8(0, 0, 4, 4, 8, 8, 12, 12, -1, -1,
+                                             -1, -1, -1, -1, -1, -1);
+        const __m128i v_shuf = _mm_setr_epi8(2, 2, 6, 6, 10, 10, 14, 14, -1,
+                                             -1, -1, -1, -1, -1, -1, -1);
+        for (; dst_len >= 32; dst_len -= 32, src += 16, dst += 32) {
+                __m128i in = _mm_loadu_si128((const void *) src);
+                __m256i y = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, y_shuf));
+                __m256i u = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, u_shuf));
+                __m256i v = _mm256_cvtepu8_epi32(_mm_shuffle_epi8(in, v_shuf));
+                __m128i r[2], g[2], b[2];
+                uyvy_to_rgba_float_avx2(
+                    _mm256_castsi256_si128(y), _mm256_castsi256_si128(u),
+                    _mm256_castsi256_si128(v), &r[0], &g[0], &b[0]);
+                uyvy_to_rgba_float_avx2(_mm256_extracti128_si256(y, 1),
+                                        _mm256_extracti128_si256(u, 1),
+                                        _mm256_extracti128_si256(v, 1), &r[1],
+                                        &g[1], &b[1]);
+                __m256i rr = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_set_m128i(r[1], r[0]), zero), max);
+                __m256i gg = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_set_m128i(g[1], g[0]), zero), max);
+                __m256i bb = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_set_m128i(b[1], b[0]), zero), max);
+                _mm256_storeu_si256(
+                    (void *) dst,
+                    _mm256_or_si256(
+                        _mm256_or_si256(alpha, _mm256_sll_epi32(rr, rs)),
+                        _mm256_or_si256(_mm256_sll_epi32(gg, gs),
+                                        _mm256_sll_epi32(bb, bs))));
+        }
+        vc_copylineUYVYtoRGBA(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/**
+ * converts 8 pixels given as 0x00BBGGRR words to UYVY with the same integer
+ * arithmetic as vc_copylineToUYVY
+ */
+__attribute__((target("avx2"))) static inline void
+rgb_words_to_uyvy_avx2(unsigned char *dst, __m256i w,
+                       const struct color_coeffs *cfs)
+{
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        const __m256i r = _mm256_and_si256(w, mask);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(w, 8), mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(w, 16), mask);
+#define RGB_TO(c) \
+        _mm256_add_epi32( \
+            _mm256_add_epi32( \
+                _mm256_mullo_epi32(r, _mm256_set1_epi32(cfs->c##_r)), \
+                _mm256_mullo_epi32(g, _mm256_set1_epi32(cfs->c##_g))), \
+            _mm256_mullo_epi32(b, _mm256_set1_epi32(cfs->c##_b)))
+        __m256i y = _mm256_add_epi32(_mm256_srai_epi32(RGB_TO(y), COMP_BASE),
+                                     _mm256_set1_epi32(16));
+        // [u01 u23 v01 v23] in each lane, u = ((u / 2) >> COMP_BASE) + 128
+        __m256i uv = _mm256_hadd_epi32(RGB_TO(cb), RGB_TO(cr));
+#undef RGB_TO
+        uv = _mm256_add_epi32(uv, _mm256_srli_epi32(uv, 31));
+        uv = _mm256_add_epi32(_mm256_srai_epi32(uv, COMP_BASE + 1),
+                              _mm256_set1_epi32(128));
+        __m256i px = _mm256_packus_epi32(_mm256_and_si256(y, mask),
+                                         _mm256_and_si256(uv, mask));
+        px = _mm256_packus_epi16(px, px);
+        px = _mm256_shuffle_epi8(
+            px, _mm256_setr_epi8(4, 0, 6, 1, 5, 2, 7, 3, -1, -1, -1, -1, -1,
+                                 -1, -1, -1, //
+                                 4, 0, 6, 1, 5, 2, 7, 3, -1, -1, -1, -1, -1,
+                                 -1, -1, -1));
+        _mm_storeu_si128((void *) dst, _mm256_castsi256_si128(
+                                           _mm256_permute4x64_epi64(px, 0x08)));
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineRGBtoUYVY_avx2(unsigned char *__restrict dst,
+                          const unsigned char *__restrict src, int dst_len,
+                          int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, DEPTH8);
+        const __m256i shuf = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, //
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        for (; dst_len >= 16; dst_len -= 16, src += 24, dst += 16) {
+                __m256i v = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128((const void *) src)),
+                    _mm_loadu_si128((const void *) (src + 12)), 1);
+                rgb_words_to_uyvy_avx2(dst, _mm256_shuffle_epi8(v, shuf), &cfs);
+        }
+        vc_copylineRGBtoUYVY(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineRGBAtoUYVY_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, DEPTH8);
+        for (; dst_len >= 16; dst_len -= 16, src += 32, dst += 16) {
+                rgb_words_to_uyvy_avx2(
+                    dst, _mm256_loadu_si256((const void *) src), &cfs);
+        }
+        vc_copylineRGBAtoUYVY(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/// stores 8 pixels of 16-bit components (in 32-bit lanes) as 48 bytes
+__attribute__((target("avx2"))) static inline void
+store_rg48_avx2(unsigned char *dst, __m256i r, __m256i g, __m256i b)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1, //
+            0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+        const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi32(g, 16));
+        // pixels 0, 1 | 4, 5 and 2, 3 | 6, 7, 12 bytes in each lane
+        const __m256i lo = _mm256_shuffle_epi8(_mm256_unpacklo_epi32(rg, b), shuf);
+        const __m256i hi = _mm256_shuffle_epi8(_mm256_unpackhi_epi32(rg, b), shuf);
+        // the 4 excess bytes of each store are overwritten by the next one
+        _mm_storeu_si128((void *) dst, _mm256_castsi256_si128(lo));
+        _mm_storeu_si128((void *) (dst + 12), _mm256_castsi256_si128(hi));
+        _mm_storeu_si128((void *) (dst + 24), _mm256_extracti128_si256(lo, 1));
+        _mm_maskstore_epi32((void *) (dst + 36), _mm_setr_epi32(-1, -1, -1, 0),
+                            _mm256_extracti128_si256(hi, 1));
+}
+
+/// R10k words to 16-bit components (10 valid bits) in 32-bit lanes
+__attribute__((target("avx2"))) static inline void
+load_r10k_rgb16_avx2(const unsigned char *src, __m256i *r, __m256i *g,
+                     __m256i *b)
+{
+        const __m256i bswap = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, //
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        const __m256i mask = _mm256_set1_epi32(0xFFC0);
+        const __m256i w =
+            _mm256_shuffle_epi8(_mm256_loadu_si256((const void *) src), bswap);
+        *r = _mm256_and_si256(_mm256_srli_epi32(w, 16), mask);
+        *g = _mm256_and_si256(_mm256_srli_epi32(w, 6), mask);
+        *b = _mm256_and_si256(_mm256_slli_epi32(w, 4), mask);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copyliner10ktoRG48_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        for (; dst_len >= 48; dst_len -= 48, src += 32, dst += 48) {
+                __m256i r, g, b;
+                load_r10k_rgb16_avx2(src, &r, &g, &b);
+                store_rg48_avx2(dst, r, g, b);
+        }
+        vc_copyliner10ktoRG48(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/// same integer arithmetic as vc_copyliner10ktoY416, 8 pixels per iteration
+__attribute__((target("avx2"))) static void
+vc_copyliner10ktoY416_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, 16);
+        const __m256i lo16 = _mm256_set1_epi32(0xFFFF);
+        for (; dst_len >= 64; dst_len -= 64, src += 32, dst += 64) {
+                __m256i r, g, b;
+                load_r10k_rgb16_avx2(src, &r, &g, &b);
+#define RGB_TO(c, offset) \
+        _mm256_and_si256( \
+            _mm256_add_epi32( \
+                _mm256_srai_epi32( \
+                    _mm256_add_epi32( \
+                        _mm256_add_epi32( \
+                            _mm256_mullo_epi32( \
+                                r, _mm256_set1_epi32(cfs.c##_r)), \
+                            _mm256_mullo_epi32( \
+                                g, _mm256_set1_epi32(cfs.c##_g))), \
+                        _mm256_mullo_epi32(b, _mm256_set1_epi32(cfs.c##_b))), \
+                    COMP_BASE), \
+                _mm256_set1_epi32(offset)), \
+            lo16)
+                __m256i u = RGB_TO(cb, 1 << 15);
+                __m256i y = RGB_TO(y, 1 << 12);
+                __m256i v = RGB_TO(cr, 1 << 15);
+#undef RGB_TO
+                __m256i uy = _mm256_or_si256(u, _mm256_slli_epi32(y, 16));
+                __m256i va = _mm256_or_si256(v, _mm256_slli_epi32(lo16, 16));
+                __m256i lo = _mm256_unpacklo_epi32(uy, va); // px 0, 1 | 4, 5
+                __m256i hi = _mm256_unpackhi_epi32(uy, va); // px 2, 3 | 6, 7
+                _mm256_storeu_si256((void *) dst,
+                                    _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256((void *) (dst + 32),
+                                    _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        vc_copyliner10ktoY416(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineY416toUYVY_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const __m256i shuf = _mm256_setr_epi8(
+            0, 1, 2, 3, 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, //
+            0, 1, 2, 3, 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+        for (; dst_len >= 16; dst_len -= 16, src += 64, dst += 16) {
+                __m256i px[2];
+                for (int i = 0; i < 2; ++i) {
+                        // 8-bit U Y V A words, 2 pixels per lane
+                        __m256i h = _mm256_srli_epi16(
+                            _mm256_loadu_si256((const void *) (src + 32 * i)),
+                            8);
+                        __m256i avg = _mm256_srli_epi16(
+                            _mm256_add_epi16(h, _mm256_srli_si256(h, 8)), 1);
+                        // U Y0 V Y1
+                        px[i] = _mm256_blend_epi16(
+                            _mm256_blend_epi16(avg, h, 0x02),
+                            _mm256_srli_si256(h, 4), 0x08);
+                }
+                // lanes: px 0, 1 | 4, 5 and 2, 3 | 6, 7
+                __m256i out = _mm256_shuffle_epi8(
+                    _mm256_packus_epi16(px[0], px[1]), shuf);
+                out = _mm256_permutevar8x32_epi32(
+                    out, _mm256_setr_epi32(0, 4, 1, 5, 2, 3, 6, 7));
+                _mm_storeu_si128((void *) dst, _mm256_castsi256_si128(out));
+        }
+        vc_copylineY416toUYVY(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+/**
+ * converts 8 Y416 pixels to RGB with the same integer arithmetic as the
+ * scalar Y416 decoders, the output is clamped to the full range of depth
+ */
+__attribute__((target("avx2"))) static inline void
+y416_to_rgb_avx2(const unsigned char *src, const struct color_coeffs *cfs,
+                 int depth, __m256i *r, __m256i *g, __m256i *b)
+{
+        const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        const __m256i lo16 = _mm256_set1_epi32(0xFFFF);
+        const __m256i a = _mm256_permutevar8x32_epi32(
+            _mm256_loadu_si256((const void *) src), idx);
+        const __m256i c = _mm256_permutevar8x32_epi32(
+            _mm256_loadu_si256((const void *) (src + 32)), idx);
+        const __m256i uy = _mm256_permute2x128_si256(a, c, 0x20);
+        const __m256i va = _mm256_permute2x128_si256(a, c, 0x31);
+        const __m256i u = _mm256_sub_epi32(_mm256_and_si256(uy, lo16),
+                                           _mm256_set1_epi32(1 << 15));
+        const __m256i v = _mm256_sub_epi32(_mm256_and_si256(va, lo16),
+                                           _mm256_set1_epi32(1 << 15));
+        const __m256i y = _mm256_mullo_epi32(
+            _mm256_sub_epi32(_mm256_srli_epi32(uy, 16),
+                             _mm256_set1_epi32(1 << 12)),
+            _mm256_set1_epi32(cfs->y_scale));
+        const __m128i shift = _mm_cvtsi32_si128(COMP_BASE + 16 - depth);
+        const __m256i foot = _mm256_set1_epi32(FULL_FOOT(depth));
+        const __m256i head = _mm256_set1_epi32(FULL_HEAD(depth));
+#define CLAMP_COMP(val) \
+        _mm256_min_epi32(_mm256_max_epi32(_mm256_sra_epi32(val, shift), foot), \
+                         head)
+        *r = CLAMP_COMP(_mm256_add_epi32(
+            y, _mm256_mullo_epi32(v, _mm256_set1_epi32(cfs->r_cr))));
+        *g = CLAMP_COMP(_mm256_add_epi32(
+            _mm256_add_epi32(
+                y, _mm256_mullo_epi32(u, _mm256_set1_epi32(cfs->g_cb))),
+            _mm256_mullo_epi32(v, _mm256_set1_epi32(cfs->g_cr))));
+        *b = CLAMP_COMP(_mm256_add_epi32(
+            y, _mm256_mullo_epi32(u, _mm256_set1_epi32(cfs->b_cb))));
+#undef CLAMP_COMP
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineY416toRGB_avx2(unsigned char *__restrict dst,
+                          const unsigned char *__restrict src, int dst_len,
+                          int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, 16);
+        for (; dst_len >= 24; dst_len -= 24, src += 64, dst += 24) {
+                __m256i r, g, b;
+                y416_to_rgb_avx2(src, &cfs, 8, &r, &g, &b);
+                store_3of4_avx2(
+                    dst, _mm256_or_si256(
+                             _mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                             _mm256_slli_epi32(b, 16)));
+        }
+        vc_copylineY416toRGB(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineY416toRGBA_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, 16);
+        const uint32_t alpha_mask = 0xFFFFFFFFU ^ (0xFFU << rshift) ^
+                                    (0xFFU << gshift) ^ (0xFFU << bshift);
+        const __m256i alpha = _mm256_set1_epi32((int) alpha_mask);
+        const __m128i rs = _mm_cvtsi32_si128(rshift);
+        const __m128i gs = _mm_cvtsi32_si128(gshift);
+        const __m128i bs = _mm_cvtsi32_si128(bshift);
+        for (; dst_len >= 32; dst_len -= 32, src += 64, dst += 32) {
+                __m256i r, g, b;
+                y416_to_rgb_avx2(src, &cfs, 8, &r, &g, &b);
+                _mm256_storeu_si256(
+                    (void *) dst,
+                    _mm256_or_si256(
+                        _mm256_or_si256(alpha, _mm256_sll_epi32(r, rs)),
+                        _mm256_or_si256(_mm256_sll_epi32(g, gs),
+                                        _mm256_sll_epi32(b, bs))));
+        }
+        vc_copylineY416toRGBA(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineY416toR10k_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, 16);
+        const __m256i bswap = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, //
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for (; dst_len >= 32; dst_len -= 32, src += 64, dst += 32) {
+                __m256i r, g, b;
+                y416_to_rgb_avx2(src, &cfs, 10, &r, &g, &b);
+                __m256i w = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_slli_epi32(r, 22),
+                                    _mm256_slli_epi32(g, 12)),
+                    _mm256_slli_epi32(b, 2));
+                _mm256_storeu_si256((void *) dst,
+                                    _mm256_shuffle_epi8(w, bswap));
+        }
+        vc_copylineY416toR10k(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+__attribute__((target("avx2"))) static void
+vc_copylineY416toRG48_avx2(unsigned char *__restrict dst,
+                           const unsigned char *__restrict src, int dst_len,
+                           int rshift, int gshift, int bshift)
+{
+        const struct color_coeffs cfs = *get_color_coeffs(CS_DFL, 16);
+        for (; dst_len >= 48; dst_len -= 48, src += 64, dst += 48) {
+                __m256i r, g, b;
+                y416_to_rgb_avx2(src, &cfs, 16, &r, &g, &b);
+                store_rg48_avx2(dst, r, g, b);
+        }
+        vc_copylineY416toRG48(dst, src, dst_len, rshift, gshift, bshift);
+}
+
+enum pixfmt_conv_simd {
+        SIMD_NONE,
+        SIMD_AVX2,
+        SIMD_AVX512,
+};
+
+struct decoder_simd_item {
+        decoder_t decoder;
+        codec_t in;
+        codec_t out;
+        enum pixfmt_conv_simd isa;
+};
+
+/// sorted from the best ISA for each conversion
+static const struct decoder_simd_item simd_decoders[] = {
+        { vc_copylinev210_avx512,       v210, UYVY, SIMD_AVX512 },
+        { vc_copylinev210_avx2,         v210, UYVY, SIMD_AVX2 },
+        { vc_copylineUYVYtoV210_avx512, UYVY, v210, SIMD_AVX512 },
+        { vc_copylineUYVYtoV210_avx2,   UYVY, v210, SIMD_AVX2 },
+        { vc_copylineY216toUYVY_avx512, Y216, UYVY, SIMD_AVX512 },
+        { vc_copylineY216toUYVY_avx2,   Y216, UYVY, SIMD_AVX2 },
+        { vc_copylineUYVYtoY216_avx2,   UYVY, Y216, SIMD_AVX2 },
+        { vc_copyliner10k_avx512,       R10k, RGBA, SIMD_AVX512 },
+        { vc_copyliner10k_avx2,         R10k, RGBA, SIMD_AVX2 },
+        { vc_copyliner10ktoRGB_avx2,    R10k, RGB,  SIMD_AVX2 },
+        { vc_copylineUYVYtoRGB_avx2,    UYVY, RGB,  SIMD_AVX2 },
+        { vc_copylineUYVYtoRGBA_avx2,   UYVY, RGBA, SIMD_AVX2 },
+        { vc_copylineRGBtoUYVY_avx2,    RGB,  UYVY, SIMD_AVX2 },
+        { vc_copylineRGBAtoUYVY_avx2,   RGBA, UYVY, SIMD_AVX2 },
+        { vc_copyliner10ktoRG48_avx2,   R10k, RG48, SIMD_AVX2 },
+        { vc_copyliner10ktoY416_avx2,   R10k, Y416, SIMD_AVX2 },
+        { vc_copylineY416toUYVY_avx2,   Y416, UYVY, SIMD_AVX2 },
+        { vc_copylineY416toRGB_avx2,    Y416, RGB,  SIMD_AVX2 },
+        { vc_copylineY416toRGBA_avx2,   Y416, RGBA, SIMD_AVX2 },
+        { vc_copylineY416toR10k_avx2,   Y416, R10k, SIMD_AVX2 },
+        { vc_copylineY416toRG48_avx2,   Y416, RG48, SIMD_AVX2 },
+};
+
+static enum pixfmt_conv_simd
+get_cpu_simd(void)
+{
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512bw")) {
+                return SIMD_AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+                return SIMD_AVX2;
+        }
+        return SIMD_NONE;
+}
+
+/**
+ * @param exact if true, return only the decoder for ISA isa, otherwise the
+ *              best one up to isa
+ */
+static decoder_t
+get_simd_decoder(codec_t in, codec_t out, enum pixfmt_conv_simd isa,
+                 bool exact)
+{
+        for (unsigned i = 0; i < countof(simd_decoders); ++i) {
+                const struct decoder_simd_item *it = &simd_decoders[i];
+                if (it->in != in || it->out != out || it->isa > isa ||
+                    (exact && it->isa != isa)) {
+                        continue;
+                }
+                return it->decoder;
+        }
+        return NULL;
+}
+#endif // defined PIXFMT_CONV_X86
+
 struct decoder_item {
         decoder_t decoder;
         codec_t in;
@@ -3102,9 +3870,24 @@ static const struct decoder_item decoders[] = {
         { vc_copylineV210toRG48,  v210,  RG48 },
 };
 
+static decoder_t
+get_scalar_decoder(codec_t in, codec_t out)
+{
+        for (unsigned int i = 0; i < sizeof(decoders)/sizeof(struct decoder_item); ++i) {
+                if (decoders[i].in == in && decoders[i].out == out) {
+                        return decoders[i].decoder;
+                }
+        }
+        return NULL;
+}
+
 /**
  * Returns line decoder for specifiedn input and output codec.
  *
+ * On x86, a SIMD variant is returned if there is one for the conversion and
+ * the CPU supports it (AVX2, AVX-512). Its output is identical to the scalar
+ * decoder.
+ *
  * If in == out, vc_memcpy is returned.
  */
 decoder_t get_decoder_from_to(codec_t in, codec_t out) {
@@ -3113,15 +3896,65 @@ decoder_t get_decoder_from_to(codec_t in, codec_t out) {
                 return vc_memcpy;
         }
 
-        for (unsigned int i = 0; i < sizeof(decoders)/sizeof(struct decoder_item); ++i) {
-                if (decoders[i].in == in && decoders[i].out == out) {
-                        return decoders[i].decoder;
-                }
+#ifdef PIXFMT_CONV_X86
+        decoder_t simd = get_simd_decoder(in, out, get_cpu_simd(), false);
+        if (simd != NULL) {
+                return simd;
         }
+#endif
 
-        MSG(DEBUG, "No decoder from %s to %s!\n", get_codec_name(in),
-            get_codec_name(out));
+        decoder_t ret = get_scalar_decoder(in, out);
+        if (ret == NULL) {
+                MSG(DEBUG, "No decoder from %s to %s!\n", get_codec_name(in),
+                    get_codec_name(out));
+        }
+        return ret;
+}
+
+/**
+ * Returns line decoder for given conversion implemented with the instruction
+ * set isa ("avx512", "avx2" or "scalar"). Intended for tests and benchmarks,
+ * get_decoder_from_to() selects the best variant automatically.
+ *
+ * @returns NULL if there is no such variant or the CPU doesn't support isa
+ */
+decoder_t
+get_decoder_from_to_isa(codec_t in, codec_t out, const char *isa)
+{
+        if (strcmp(isa, "scalar") == 0) {
+                return get_scalar_decoder(in, out);
+        }
+#ifdef PIXFMT_CONV_X86
+        enum pixfmt_conv_simd req = SIMD_NONE;
+        if (strcmp(isa, "avx2") == 0) {
+                req = SIMD_AVX2;
+        } else if (strcmp(isa, "avx512") == 0) {
+                req = SIMD_AVX512;
+        }
+        if (req == SIMD_NONE || req > get_cpu_simd()) {
+                return NULL;
+        }
+        return get_simd_decoder(in, out, req, true);
+#else
         return NULL;
+#endif
+}
+
+/// @returns the best instruction set used by get_decoder_from_to()
+const char *
+pixfmt_conv_best_isa(void)
+{
+#ifdef PIXFMT_CONV_X86
+        switch (get_cpu_simd()) {
+        case SIMD_AVX512:
+                return "avx512";
+        case SIMD_AVX2:
+                return "avx2";
+        case SIMD_NONE:
+                break;
+        }
+#endif
+        return "scalar";
 }
 
 // less is better
@@ -89,6 +89,8 @@ typedef decoder_func_t *decoder_t;
 
 [[gnu::const]] decoder_t get_decoder_from_to(codec_t in, codec_t out);
 decoder_t        get_best_decoder_from(codec_t in, const codec_t *out_candidates, codec_t *out);
+decoder_t        get_decoder_from_to_isa(codec_t in, codec_t out, const char *isa);
+const char      *pixfmt_conv_best_isa(void);
 
 decoder_func_t vc_copylineRGBA;
 decoder_func_t vc_copylineToRGBA_inplace;
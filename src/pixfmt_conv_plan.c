@@ -0,0 +1,742 @@
+/**
+ * @file   pixfmt_conv_plan.c
+ * @brief  Multi-hop pixel format conversion planner
+ *
+ * Finds a chain of line decoders (see pixfmt_conv.h) between two pixel
+ * formats when there is no direct one, or when going through an
+ * intermediate format preserves more of the source (bit depth, chroma
+ * subsampling) than a direct conversion to the available target formats.
+ * Equivalent chains are ordered by measured cost (ns per pixel), which is
+ * cached on disk.
+ *
+ * Chains created by pixfmt_conv_chain_create_frame() may also start or end
+ * with a planar format (see planar_edges), those are converted in strips of
+ * 2 lines. The lavc conversions (from/to AVPixelFormat) are not nodes of the
+ * graph - they already combine line decoders with their own conversions.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "from_planar.h"
+#include "host.h"
+#include "pixfmt_conv.h"
+#include "pixfmt_conv_plan.h"
+#include "to_planar.h"
+#include "tv.h"
+#include "utils/fs.h"     // for strdup_path_with_expansion
+#include "utils/macros.h" // for MAX, MIN
+#include "video_codec.h"
+
+#define DEFAULT_COST_CACHE "~/.ug-pixfmt-costs"
+#define MOD_NAME "[pixfmt_conv_plan] "
+
+enum {
+        BENCH_WIDTH   = 1920,
+        BENCH_WARMUP  = 3,
+        BENCH_REPEATS = 15,
+        PLANAR_STRIP  = 2, ///< lines converted at once if planar (4:2:0)
+};
+
+ADD_TO_PARAM("pixfmt-conv-costs", "* pixfmt-conv-costs=<file>|none\n"
+                "  file caching measured costs of pixel format conversions used\n"
+                "  to plan multi-hop conversions (default " DEFAULT_COST_CACHE ")\n");
+
+/**
+ * Conversions from or to a planar format. Those cannot be run per line, so
+ * they are used only as the first or the last hop of a frame chain.
+ */
+static const struct planar_edge {
+        codec_t in;
+        codec_t out;
+        decode_planar_func_t *from_planar;
+        decode_buffer_func_t *to_planar;
+} planar_edges[] = {
+        { I420, UYVY, yuv420p_to_uyvy, NULL         },
+        { UYVY, I420, NULL,            uyvy_to_i420 },
+};
+
+struct pixfmt_conv_chain {
+        int hops;
+        int width;
+        int strip; ///< lines converted at once by pixfmt_conv_chain_frame()
+        codec_t codecs[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        decoder_t decoders[PIXFMT_CONV_PLAN_MAX_HOPS]; ///< NULL for planar hops
+        const struct planar_edge *first; ///< from planar source, if any
+        const struct planar_edge *last;  ///< to planar output, if any
+        int linesize[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        unsigned char *scratch[2]; ///< intermediate lines, used alternately
+};
+
+static pthread_once_t costs_once = PTHREAD_ONCE_INIT;
+static decoder_t conv_dec[VIDEO_CODEC_COUNT][VIDEO_CODEC_COUNT];
+static double conv_cost[VIDEO_CODEC_COUNT][VIDEO_CODEC_COUNT]; ///< ns/pixel
+
+static const struct planar_edge *
+get_planar_edge(codec_t in, codec_t out)
+{
+        for (size_t i = 0; i < sizeof planar_edges / sizeof planar_edges[0];
+             ++i) {
+                if (planar_edges[i].in == in && planar_edges[i].out == out) {
+                        return &planar_edges[i];
+                }
+        }
+        return NULL;
+}
+
+static bool
+has_edge(codec_t in, codec_t out)
+{
+        return conv_dec[in][out] != NULL || get_planar_edge(in, out) != NULL;
+}
+
+/**
+ * sets offsets of line y in planes of I420 frame of given size (layout as
+ * vc_get_datalen() expects)
+ */
+static void
+get_i420_planes(int width, int height, int y, size_t offsets[3],
+                unsigned linesizes[3])
+{
+        const size_t chr_w = (width + 1) / 2;
+        const size_t chr_h = (height + 1) / 2;
+        const size_t chroma = (size_t) width * height;
+        offsets[0] = (size_t) y * width;
+        offsets[1] = chroma + (y / 2) * chr_w;
+        offsets[2] = chroma + chr_h * chr_w + (y / 2) * chr_w;
+        linesizes[0] = width;
+        linesizes[1] = linesizes[2] = chr_w;
+}
+
+/**
+ * Converts lines [y, y + lines) of a width x height frame. The planar side
+ * (src for from_planar, dst for to_planar) is the whole frame, the packed one
+ * just the lines with given pitch.
+ */
+static void
+run_planar_edge(const struct planar_edge *e, unsigned char *dst,
+                int dst_pitch, const unsigned char *src, int src_pitch,
+                int width, int height, int y, int lines, int rshift,
+                int gshift, int bshift)
+{
+        size_t offsets[3];
+        unsigned linesizes[3];
+        get_i420_planes(width, height, y, offsets, linesizes);
+        if (e->from_planar != NULL) {
+                struct from_planar_data d = {
+                        .width = width,
+                        .height = lines,
+                        .out_data = dst,
+                        .out_pitch = dst_pitch,
+                        .in_data = { src + offsets[0], src + offsets[1],
+                                     src + offsets[2] },
+                        .in_linesize = { linesizes[0], linesizes[1],
+                                         linesizes[2] },
+                        .in_depth = DEPTH8,
+                        .log2_chroma_h = 1,
+                        .rgb_shift = { rshift, gshift, bshift },
+                };
+                e->from_planar(d);
+                return;
+        }
+        assert(src_pitch == vc_get_linesize(width, e->in));
+        (void) src_pitch;
+        struct to_planar_data d = {
+                .width = width,
+                .height = lines,
+                .out_data = { dst + offsets[0], dst + offsets[1],
+                              dst + offsets[2] },
+                .out_linesize = { linesizes[0], linesizes[1], linesizes[2] },
+                .in_data = src,
+        };
+        e->to_planar(d);
+}
+
+/// @returns NULL if cache is disabled or the path cannot be determined
+static char *
+get_cost_cache_path(void)
+{
+        const char *path = get_commandline_param("pixfmt-conv-costs");
+        if (path == NULL) {
+                path = DEFAULT_COST_CACHE;
+        }
+        if (strcmp(path, "none") == 0) {
+                return NULL;
+        }
+        char *ret = strdup_path_with_expansion(path);
+        if (ret[0] == '~') { // $HOME not set
+                free(ret);
+                return NULL;
+        }
+        return ret;
+}
+
+static int
+load_costs(const char *path, const char *isa)
+{
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+                return 0;
+        }
+        int count = 0;
+        char line[256];
+        while (fgets(line, sizeof line, f) != NULL) {
+                char file_isa[32];
+                char in_name[32];
+                char out_name[32];
+                double cost = 0;
+                if (line[0] == '#' ||
+                    sscanf(line, "%31s %31s %31s %lf", file_isa, in_name,
+                           out_name, &cost) != 4 ||
+                    strcmp(file_isa, isa) != 0 || cost <= 0) {
+                        continue;
+                }
+                codec_t in = get_codec_from_name(in_name);
+                codec_t out = get_codec_from_name(out_name);
+                if (!has_edge(in, out)) {
+                        continue;
+                }
+                conv_cost[in][out] = cost;
+                count += 1;
+        }
+        fclose(f);
+        return count;
+}
+
+static void
+save_costs(const char *path, const char *isa)
+{
+        char tmp_path[MAX_PATH_SIZE];
+        snprintf(tmp_path, sizeof tmp_path, "%s.tmp", path);
+        FILE *f = fopen(tmp_path, "w");
+        if (f == NULL) {
+                MSG(WARNING, "Cannot write conversion costs to %s!\n",
+                    tmp_path);
+                return;
+        }
+        fprintf(f, "# UltraGrid pixel format conversion costs - <isa> "
+                   "<from> <to> <ns/pixel>\n");
+        for (int in = VIDEO_CODEC_FIRST; in < VIDEO_CODEC_COUNT; ++in) {
+                for (int out = VIDEO_CODEC_FIRST; out < VIDEO_CODEC_COUNT;
+                     ++out) {
+                        if (conv_cost[in][out] > 0) {
+                                fprintf(f, "%s %s %s %.4f\n", isa,
+                                        get_codec_name(in),
+                                        get_codec_name(out),
+                                        conv_cost[in][out]);
+                        }
+                }
+        }
+        if (fclose(f) != 0 || rename(tmp_path, path) != 0) {
+                MSG(WARNING, "Cannot write conversion costs to %s!\n", path);
+                remove(tmp_path);
+        }
+}
+
+static int
+time_cmp(const void *a, const void *b)
+{
+        time_ns_t ta = *(const time_ns_t *) a;
+        time_ns_t tb = *(const time_ns_t *) b;
+        return ta < tb ? -1 : ta > tb;
+}
+
+/// @returns median ns/pixel of converting a BENCH_WIDTH wide line
+static double
+measure_cost(decoder_t dec, codec_t in, codec_t out)
+{
+        const int src_len = vc_get_linesize(BENCH_WIDTH, in);
+        const int dst_len = vc_get_linesize(BENCH_WIDTH, out);
+        // decoders may read more than src_len if dst_len is padded (v210)
+        const size_t src_size = MAX(src_len, 2 * dst_len) + MAX_PADDING;
+        unsigned char *src = malloc(src_size);
+        unsigned char *dst = malloc(dst_len + MAX_PADDING);
+        for (size_t i = 0; i < src_size; ++i) {
+                src[i] = (unsigned char) (i * 37);
+        }
+        time_ns_t t[BENCH_REPEATS];
+        for (int i = -BENCH_WARMUP; i < BENCH_REPEATS; ++i) {
+                time_ns_t start = get_time_in_ns();
+                dec(dst, src, dst_len, DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                    DEFAULT_B_SHIFT);
+                if (i >= 0) {
+                        t[i] = get_time_in_ns() - start;
+                }
+        }
+        free(src);
+        free(dst);
+        qsort(t, BENCH_REPEATS, sizeof t[0], time_cmp);
+        return (double) MAX(t[BENCH_REPEATS / 2], 1) / BENCH_WIDTH;
+}
+
+/// as measure_cost() for a PLANAR_STRIP lines high frame
+static double
+measure_planar_cost(const struct planar_edge *e)
+{
+        const size_t src_size =
+            vc_get_datalen(BENCH_WIDTH, PLANAR_STRIP, e->in) + MAX_PADDING;
+        const size_t dst_size =
+            vc_get_datalen(BENCH_WIDTH, PLANAR_STRIP, e->out) + MAX_PADDING;
+        unsigned char *src = malloc(src_size);
+        unsigned char *dst = malloc(dst_size);
+        for (size_t i = 0; i < src_size; ++i) {
+                src[i] = (unsigned char) (i * 37);
+        }
+        time_ns_t t[BENCH_REPEATS];
+        for (int i = -BENCH_WARMUP; i < BENCH_REPEATS; ++i) {
+                time_ns_t start = get_time_in_ns();
+                run_planar_edge(e, dst, vc_get_linesize(BENCH_WIDTH, e->out),
+                                src, vc_get_linesize(BENCH_WIDTH, e->in),
+                                BENCH_WIDTH, PLANAR_STRIP, 0, PLANAR_STRIP,
+                                DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                                DEFAULT_B_SHIFT);
+                if (i >= 0) {
+                        t[i] = get_time_in_ns() - start;
+                }
+        }
+        free(src);
+        free(dst);
+        qsort(t, BENCH_REPEATS, sizeof t[0], time_cmp);
+        return (double) MAX(t[BENCH_REPEATS / 2], 1) /
+               (BENCH_WIDTH * PLANAR_STRIP);
+}
+
+static void
+costs_init(void)
+{
+        for (int in = VIDEO_CODEC_FIRST; in < VIDEO_CODEC_COUNT; ++in) {
+                for (int out = VIDEO_CODEC_FIRST; out < VIDEO_CODEC_COUNT;
+                     ++out) {
+                        conv_cost[in][out] = -1;
+                        if (in != out) {
+                                conv_dec[in][out] = get_decoder_from_to(in, out);
+                        }
+                }
+        }
+
+        const char *isa = pixfmt_conv_best_isa();
+        char *path = get_cost_cache_path();
+        const int loaded = path != NULL ? load_costs(path, isa) : 0;
+        int measured = 0;
+        for (int in = VIDEO_CODEC_FIRST; in < VIDEO_CODEC_COUNT; ++in) {
+                for (int out = VIDEO_CODEC_FIRST; out < VIDEO_CODEC_COUNT;
+                     ++out) {
+                        if (conv_dec[in][out] == NULL ||
+                            conv_cost[in][out] > 0) {
+                                continue;
+                        }
+                        conv_cost[in][out] =
+                            measure_cost(conv_dec[in][out], in, out);
+                        measured += 1;
+                }
+        }
+        for (size_t i = 0; i < sizeof planar_edges / sizeof planar_edges[0];
+             ++i) {
+                const struct planar_edge *e = &planar_edges[i];
+                if (conv_cost[e->in][e->out] <= 0) {
+                        conv_cost[e->in][e->out] = measure_planar_cost(e);
+                        measured += 1;
+                }
+        }
+        MSG(VERBOSE, "%d conversion costs loaded, %d measured (%s).\n",
+            loaded, measured, isa);
+        if (measured > 0 && path != NULL) {
+                save_costs(path, isa);
+        }
+        free(path);
+}
+
+/**
+ * @returns measured cost of direct conversion in ns per pixel, -1 if there
+ * is no decoder (or planar conversion) from in to out
+ */
+double
+pixfmt_conv_get_cost(codec_t in, codec_t out)
+{
+        pthread_once(&costs_once, costs_init);
+        return conv_cost[in][out];
+}
+
+struct path_eval {
+        struct pixfmt_desc desc; ///< worst properties along the path
+        int inner_depth;         ///< lowest depth of source and intermediates
+        int rgb_changes;         ///< number of (lossy) RGB<->YCbCr conversions
+        double cost;
+        int hops;
+};
+
+static struct path_eval
+evaluate_path(const codec_t *path, int hops)
+{
+        struct path_eval ret = { .desc = get_pixfmt_desc(path[hops]),
+                                 .inner_depth = get_pixfmt_desc(path[0]).depth,
+                                 .hops = hops };
+        for (int i = 1; i <= hops; ++i) {
+                struct pixfmt_desc prev = get_pixfmt_desc(path[i - 1]);
+                struct pixfmt_desc cur = get_pixfmt_desc(path[i]);
+                ret.desc.depth = MIN(ret.desc.depth, cur.depth);
+                if (i < hops) {
+                        ret.inner_depth = MIN(ret.inner_depth, cur.depth);
+                }
+                ret.desc.subsampling =
+                    MIN(ret.desc.subsampling, cur.subsampling);
+                ret.rgb_changes += prev.rgb != cur.rgb;
+                ret.cost += conv_cost[path[i - 1]][path[i]];
+        }
+        return ret;
+}
+
+/// less is better - least degrading path first, then the cheapest one
+static int
+compare_paths(const struct path_eval *a, const struct path_eval *b,
+              const struct pixfmt_desc *src_desc)
+{
+        int ret = compare_pixdesc(&a->desc, &b->desc, src_desc);
+        if (ret != 0) {
+                return ret;
+        }
+        // do not truncate the source before intermediate (eg. color space)
+        // conversions even if the output has lower depth
+        if (a->inner_depth != b->inner_depth) {
+                return a->inner_depth > b->inner_depth ? -1 : 1;
+        }
+        if (a->rgb_changes != b->rgb_changes) {
+                return a->rgb_changes - b->rgb_changes;
+        }
+        if (a->cost != b->cost) {
+                return a->cost < b->cost ? -1 : 1;
+        }
+        return a->hops - b->hops;
+}
+
+struct plan_search {
+        const codec_t *out_candidates;
+        bool planar; ///< planar_edges allowed
+        struct pixfmt_desc src_desc;
+        codec_t path[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        codec_t best[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        struct path_eval best_eval;
+};
+
+static void
+search_paths(struct plan_search *s, int hops)
+{
+        const codec_t cur = s->path[hops];
+        if (hops > 0 && codec_is_in_set(cur, s->out_candidates)) {
+                struct path_eval e = evaluate_path(s->path, hops);
+                if (s->best_eval.hops == 0 ||
+                    compare_paths(&e, &s->best_eval, &s->src_desc) < 0) {
+                        s->best_eval = e;
+                        memcpy(s->best, s->path, sizeof s->best);
+                }
+        }
+        if (hops == PIXFMT_CONV_PLAN_MAX_HOPS) {
+                return;
+        }
+        for (int next = VIDEO_CODEC_FIRST; next < VIDEO_CODEC_COUNT; ++next) {
+                bool visited = false;
+                for (int i = 0; i <= hops; ++i) {
+                        visited = visited || s->path[i] == (codec_t) next;
+                }
+                if (visited) {
+                        continue;
+                }
+                if (conv_dec[cur][next] == NULL) {
+                        // planar format may be only the source or the target
+                        if (!s->planar ||
+                            get_planar_edge(cur, next) == NULL ||
+                            (codec_is_planar(cur) && hops > 0) ||
+                            (codec_is_planar(next) &&
+                             !codec_is_in_set(next, s->out_candidates))) {
+                                continue;
+                        }
+                }
+                s->path[hops + 1] = next;
+                search_paths(s, hops + 1);
+        }
+}
+
+static struct pixfmt_conv_chain *
+chain_create(codec_t in, const codec_t *out_candidates, codec_t *out,
+             int width, bool planar)
+{
+        pthread_once(&costs_once, costs_init);
+
+        struct plan_search s = { .out_candidates = out_candidates,
+                                 .planar = planar,
+                                 .src_desc = get_pixfmt_desc(in),
+                                 .path = { in } };
+        if (codec_is_in_set(in, out_candidates)) {
+                s.best[0] = s.best[1] = in;
+                s.best_eval.hops = 1;
+        } else {
+                search_paths(&s, 0);
+        }
+        if (s.best_eval.hops == 0) {
+                MSG(VERBOSE, "No conversion from %s found!\n",
+                    get_codec_name(in));
+                return NULL;
+        }
+
+        struct pixfmt_conv_chain *chain = calloc(1, sizeof *chain);
+        chain->hops = s.best_eval.hops;
+        chain->width = width;
+        chain->strip = 1;
+        memcpy(chain->codecs, s.best, sizeof chain->codecs);
+        size_t scratch_size = 0;
+        char desc[256] = "";
+        for (int i = 0; i <= chain->hops; ++i) {
+                chain->linesize[i] = vc_get_linesize(width, chain->codecs[i]);
+                if (codec_is_planar(chain->codecs[i])) {
+                        chain->strip = PLANAR_STRIP;
+                }
+                if (i > 0) {
+                        const struct planar_edge *e = get_planar_edge(
+                            chain->codecs[i - 1], chain->codecs[i]);
+                        if (e != NULL) {
+                                *(e->from_planar != NULL ? &chain->first
+                                                         : &chain->last) = e;
+                        } else if (!codec_is_planar(chain->codecs[i])) {
+                                chain->decoders[i - 1] = get_decoder_from_to(
+                                    chain->codecs[i - 1], chain->codecs[i]);
+                                assert(chain->decoders[i - 1] != NULL);
+                        }
+                }
+                if (i > 0 && i < chain->hops) {
+                        // next decoder may over-read if its output is padded
+                        scratch_size = MAX(
+                            scratch_size,
+                            (size_t) MAX(chain->linesize[i],
+                                         2 * vc_get_linesize(
+                                                 width, chain->codecs[i + 1])));
+                }
+                snprintf(desc + strlen(desc), sizeof desc - strlen(desc),
+                         "%s%s", i > 0 ? "->" : "",
+                         get_codec_name(chain->codecs[i]));
+        }
+        if (chain->hops > 1) {
+                for (int i = 0; i < 2; ++i) {
+                        chain->scratch[i] = calloc(
+                            1, chain->strip * scratch_size + MAX_PADDING);
+                }
+        }
+        MSG(VERBOSE, "Conversion path %s, %.3f ns/pixel\n", desc,
+            s.best_eval.cost);
+        *out = chain->codecs[chain->hops];
+        return chain;
+}
+
+/**
+ * Plans conversion from in to one of out_candidates, possibly over
+ * intermediate pixel formats. Preferred is the path that degrades the
+ * source the least (as get_best_decoder_from() does for direct conversions),
+ * then the fastest one.
+ *
+ * The returned chain converts one line at a time, intermediate lines are kept
+ * in a small scratch buffer, so it must not be used by multiple threads
+ * concurrently.
+ *
+ * @param[out] out   selected output pixel format
+ * @param      width width of the converted lines in pixels
+ * @returns chain or NULL if there is no conversion
+ */
+struct pixfmt_conv_chain *
+pixfmt_conv_chain_create(codec_t in, const codec_t *out_candidates,
+                         codec_t *out, int width)
+{
+        if (codec_is_planar(in)) {
+                MSG(VERBOSE, "Planar %s cannot be converted per line!\n",
+                    get_codec_name(in));
+                return NULL;
+        }
+        return chain_create(in, out_candidates, out, width, false);
+}
+
+/**
+ * Same as pixfmt_conv_chain_create() but the chain may also convert from or
+ * to a planar pixel format (eg. I420). Such a chain must be run with
+ * pixfmt_conv_chain_frame().
+ */
+struct pixfmt_conv_chain *
+pixfmt_conv_chain_create_frame(codec_t in, const codec_t *out_candidates,
+                               codec_t *out, int width)
+{
+        return chain_create(in, out_candidates, out, width, true);
+}
+
+void
+pixfmt_conv_chain_destroy(struct pixfmt_conv_chain *chain)
+{
+        if (chain == NULL) {
+                return;
+        }
+        free(chain->scratch[0]);
+        free(chain->scratch[1]);
+        free(chain);
+}
+
+/**
+ * Converts one line of the width given to pixfmt_conv_chain_create(). Shifts
+ * apply to the output format only (if RGBA).
+ */
+void
+pixfmt_conv_chain_line(struct pixfmt_conv_chain *chain,
+                       unsigned char *__restrict dst,
+                       const unsigned char *__restrict src, int rshift,
+                       int gshift, int bshift)
+{
+        assert(chain->first == NULL && chain->last == NULL);
+        const unsigned char *in = src;
+        for (int i = 0; i < chain->hops; ++i) {
+                const bool last = i == chain->hops - 1;
+                unsigned char *out = last ? dst : chain->scratch[i % 2];
+                chain->decoders[i](out, in, chain->linesize[i + 1],
+                                   last ? rshift : DEFAULT_R_SHIFT,
+                                   last ? gshift : DEFAULT_G_SHIFT,
+                                   last ? bshift : DEFAULT_B_SHIFT);
+                in = out;
+        }
+}
+
+/**
+ * Converts the beginning of a line, the output having dst_len bytes - the
+ * semantics is the same as of decoder_t, so that the chain can replace a
+ * line decoder that is passed parts of lines (eg. received packets).
+ */
+void
+pixfmt_conv_chain_line_part(struct pixfmt_conv_chain *chain,
+                            unsigned char *__restrict dst,
+                            const unsigned char *__restrict src, int dst_len,
+                            int rshift, int gshift, int bshift)
+{
+        assert(chain->first == NULL && chain->last == NULL);
+        const codec_t out_codec = chain->codecs[chain->hops];
+        const int block_bytes = get_pf_block_bytes(out_codec);
+        const int pixels =
+            MIN((dst_len + block_bytes - 1) / block_bytes *
+                    get_pf_block_pixels(out_codec),
+                chain->width);
+        const unsigned char *in = src;
+        for (int i = 0; i < chain->hops; ++i) {
+                const bool last = i == chain->hops - 1;
+                unsigned char *out = last ? dst : chain->scratch[i % 2];
+                const int len =
+                    last ? dst_len
+                         : MIN(vc_get_size(pixels, chain->codecs[i + 1]),
+                               chain->linesize[i + 1]);
+                chain->decoders[i](out, in, len,
+                                   last ? rshift : DEFAULT_R_SHIFT,
+                                   last ? gshift : DEFAULT_G_SHIFT,
+                                   last ? bshift : DEFAULT_B_SHIFT);
+                in = out;
+        }
+}
+
+/**
+ * Converts a whole frame of the width given on chain creation. Frames are
+ * tightly packed (pitch is vc_get_linesize(), planar formats laid out as
+ * vc_get_datalen() expects).
+ */
+void
+pixfmt_conv_chain_frame(struct pixfmt_conv_chain *chain,
+                        unsigned char *__restrict dst,
+                        const unsigned char *__restrict src, int height,
+                        int rshift, int gshift, int bshift)
+{
+        if (chain->hops == 1 && chain->codecs[0] == chain->codecs[1] &&
+            codec_is_planar(chain->codecs[0])) {
+                memcpy(dst, src,
+                       vc_get_datalen(chain->width, height, chain->codecs[0]));
+                return;
+        }
+        for (int y = 0; y < height; y += chain->strip) {
+                const int lines = MIN(chain->strip, height - y);
+                const unsigned char *in =
+                    chain->first != NULL
+                        ? src
+                        : src + (size_t) y * chain->linesize[0];
+                for (int i = 0; i < chain->hops; ++i) {
+                        const bool last = i == chain->hops - 1;
+                        const int r = last ? rshift : DEFAULT_R_SHIFT;
+                        const int g = last ? gshift : DEFAULT_G_SHIFT;
+                        const int b = last ? bshift : DEFAULT_B_SHIFT;
+                        const int out_pitch = chain->linesize[i + 1];
+                        unsigned char *out = chain->scratch[i % 2];
+                        if (last) {
+                                out = chain->last != NULL
+                                          ? dst
+                                          : dst + (size_t) y * out_pitch;
+                        }
+                        if (i == 0 && chain->first != NULL) {
+                                run_planar_edge(chain->first, out, out_pitch,
+                                                in, 0, chain->width, height,
+                                                y, lines, r, g, b);
+                        } else if (last && chain->last != NULL) {
+                                run_planar_edge(chain->last, out, 0, in,
+                                                chain->linesize[i],
+                                                chain->width, height, y,
+                                                lines, r, g, b);
+                        } else {
+                                for (int l = 0; l < lines; ++l) {
+                                        chain->decoders[i](
+                                            out + (size_t) l * out_pitch,
+                                            in + (size_t) l * chain->linesize[i],
+                                            out_pitch, r, g, b);
+                                }
+                        }
+                        in = out;
+                }
+        }
+}
+
+/**
+ * @param[out] codecs pixel formats along the path, must hold at least
+ *                    PIXFMT_CONV_PLAN_MAX_HOPS + 1 items
+ * @returns number of conversions
+ */
+int
+pixfmt_conv_chain_get_path(const struct pixfmt_conv_chain *chain,
+                           codec_t *codecs)
+{
+        memcpy(codecs, chain->codecs, (chain->hops + 1) * sizeof(codec_t));
+        return chain->hops;
+}
+
+/* vim: set expandtab sw=8: */
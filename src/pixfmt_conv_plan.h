@@ -0,0 +1,88 @@
+/**
+ * @file   pixfmt_conv_plan.h
+ * @brief  Multi-hop pixel format conversion planner
+ *
+ * Finds a chain of line decoders (see pixfmt_conv.h) between two pixel
+ * formats when there is no direct one, or when going through an
+ * intermediate format preserves more of the source (bit depth, chroma
+ * subsampling) than a direct conversion to the available target formats.
+ * Equivalent chains are ordered by measured cost (ns per pixel), which is
+ * cached on disk.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIXFMT_CONV_PLAN_H_
+#define PIXFMT_CONV_PLAN_H_
+
+#include "types.h" // codec_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+        PIXFMT_CONV_PLAN_MAX_HOPS = 3,
+};
+
+struct pixfmt_conv_chain;
+
+struct pixfmt_conv_chain *pixfmt_conv_chain_create(codec_t in,
+                                                   const codec_t *out_candidates,
+                                                   codec_t *out, int width);
+struct pixfmt_conv_chain *
+pixfmt_conv_chain_create_frame(codec_t in, const codec_t *out_candidates,
+                               codec_t *out, int width);
+void pixfmt_conv_chain_destroy(struct pixfmt_conv_chain *chain);
+void pixfmt_conv_chain_line(struct pixfmt_conv_chain *chain,
+                            unsigned char *__restrict dst,
+                            const unsigned char *__restrict src, int rshift,
+                            int gshift, int bshift);
+void pixfmt_conv_chain_line_part(struct pixfmt_conv_chain *chain,
+                                 unsigned char *__restrict dst,
+                                 const unsigned char *__restrict src,
+                                 int dst_len, int rshift, int gshift,
+                                 int bshift);
+void pixfmt_conv_chain_frame(struct pixfmt_conv_chain *chain,
+                             unsigned char *__restrict dst,
+                             const unsigned char *__restrict src, int height,
+                             int rshift, int gshift, int bshift);
+int  pixfmt_conv_chain_get_path(const struct pixfmt_conv_chain *chain,
+                                codec_t *codecs);
+double pixfmt_conv_get_cost(codec_t in, codec_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // defined PIXFMT_CONV_PLAN_H_
@@ -48,7 +48,6 @@
 #include <chrono>                    // for steady_clock, duration_cast, ope...
 #include <cstring>                   // for memcpy, memset, strcasecmp...
 #include <iostream>                  // for basic_ostream, operator<<, clog
-#include <map>                       // for map
 #include <sstream>                   // for basic_ostringstream
 #include <string>                    // for char_traits, allocator, operator+
 #include <utility>                   // for pair, move, swap
@@ -65,6 +64,7 @@
 #include "lib_common.h"
 #include "rtp/fec.h"                 // for fec
 #include "rtp/pbuf.h"                // for acodec_data, coded_data
+#include "rtp/received_extents.hpp"
 #include "rtp/rtp.h"                 // for RTP_MAX_PACKET_LEN
 #include "rtp/rtp_types.h"           // for BUFNUM_BITS, audio_payload_hdr_t
 #include "types.h"                   // for fec_desc, fec_type
@@ -77,7 +77,6 @@ using std::chrono::duration_cast;
 using std::chrono::seconds;
 using std::chrono::steady_clock;
 using std::hex;
-using std::map;
 using std::ostringstream;
 using std::pair;
 using std::string;
@@ -258,7 +257,7 @@ audio_decoder_reconfigure(struct state_audio_decoder *decoder,
 
 static bool
 audio_fec_decode(struct state_audio_decoder                *decoder,
-                 vector<pair<vector<char>, map<int, int>>> &fec_data,
+                 vector<pair<vector<char>, received_extents>> &fec_data,
                  uint32_t fec_params, audio_frame2 &received_frame)
 {
         fec_desc fec_desc{ .type        = FEC_RS,
@@ -347,8 +346,12 @@ int decode_audio_frame(struct coded_data *cdata, void *pbuf_data, struct pbuf_st
                         decoder->saved_desc.bps,
                         decoder->saved_desc.sample_rate);
         received_frame.set_timestamp(cdata->data->ts);
-        vector<pair<vector<char>, map<int, int>>> fec_data;
+        vector<pair<vector<char>, received_extents>> fec_data;
         uint32_t fec_params = 0;
+        int pkt_count = 0;
+        for (struct coded_data *c = cdata; c != NULL; c = c->nxt) {
+                pkt_count += 1;
+        }
 
         while (cdata != NULL) {
                 char *data;
@@ -427,8 +430,13 @@ int decode_audio_frame(struct coded_data *cdata, void *pbuf_data, struct pbuf_st
                 if (PT_AUDIO_HAS_FEC(pt)) {
                         fec_data.resize(input_channels);
                         fec_data[channel].first.resize(buffer_len);
+                        if (fec_data[channel].second.empty()) {
+                                fec_data[channel].second.reserve(
+                                    (pkt_count + input_channels - 1) /
+                                    input_channels);
+                        }
                         fec_params = ntohl(audio_hdr[3]);
-                        fec_data[channel].second[offset] = length;
+                        fec_data[channel].second.add(offset, length);
                         memcpy(fec_data[channel].first.data() + offset, data, length);
                 } else {
                         int bps = (ntohl(audio_hdr[3]) >> 26) / 8;
@@ -40,9 +40,12 @@
 #include "rtp/fec.h"
 
 #include <cassert>               // for assert
+#include <condition_variable>
 #include <cstdlib>               // for abort, free
 #include <cstring>               // for strlen, strncmp, strtok_r, strdup
 #include <exception>             // for exception
+#include <memory>
+#include <mutex>
 #include <ostream>               // for operator<<, basic_ostream, basic_ost...
 #include <string>
 
@@ -53,13 +56,36 @@
 #include "rtp/rtp_callback.h"
 #include "rtp/rtp_types.h"       // for PT_ENCRYPT_VIDEO, PT_ENCRYPT_VIDEO_LDGM
 #include "utils/macros.h"
+#include "utils/worker.h"
+#include "video_frame.h"
 
 #define MOD_NAME "[fec] "
 
+using std::condition_variable;
 using std::exception;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
 using std::stof;
 using std::stoi;
 using std::string;
+using std::unique_lock;
+
+/// parity computation of a frame from fec_encode_video_frame_streaming()
+struct fec_parity_job {
+        struct fec         *fec;
+        struct video_frame *frame;
+        void (*dispose)(struct video_frame *); ///< original frame dispose
+        mutex               lock;
+        condition_variable  cv;
+        bool                done = false;
+
+        void wait() {
+                unique_lock<mutex> lk(lock);
+                cv.wait(lk, [this] { return done; });
+        }
+};
 
 fec *fec::create_from_config(const char *c_str, bool is_audio) noexcept
 {
@@ -235,6 +261,9 @@ fec_create_from_config(const char *str, bool is_audio)
 void
 fec_destroy(struct fec *s)
 {
+        if (s != nullptr && s->last_parity_job) {
+                s->last_parity_job->wait();
+        }
         delete s;
 }
 
@@ -248,6 +277,87 @@ fec_encode_video_frame(struct fec *fec, const struct video_frame *f)
         return fec->encode_video_frame(f);
 }
 
+static void *
+fec_parity_task(void *arg)
+{
+        auto *job = (shared_ptr<fec_parity_job> *) arg;
+        (*job)->fec->encode_video_frame_parity((*job)->frame);
+        {
+                lock_guard<mutex> lk((*job)->lock);
+                (*job)->done = true;
+        }
+        (*job)->cv.notify_all();
+        delete job;
+        return nullptr;
+}
+
+static void
+fec_wait_parity(struct video_frame *frame)
+{
+        auto *job =
+            (shared_ptr<fec_parity_job> *) frame->callbacks.wait_parity_udata;
+        (*job)->wait();
+}
+
+static void
+fec_streaming_dispose(struct video_frame *frame)
+{
+        auto *job =
+            (shared_ptr<fec_parity_job> *) frame->callbacks.wait_parity_udata;
+        (*job)->wait();
+        frame->callbacks.dispose           = (*job)->dispose;
+        frame->callbacks.wait_parity       = nullptr;
+        frame->callbacks.wait_parity_udata = nullptr;
+        delete job;
+        frame->callbacks.dispose(frame);
+}
+
+/**
+ * Streaming variant of fec_encode_video_frame() - returns as soon as the
+ * systematic part of the frame is ready so that it can be sent while the
+ * parity is computed by a worker thread. The layout (and the wire format)
+ * is the same as with fec_encode_video_frame(), the sender must just call
+ * video_frame_callbacks::wait_parity before sending the parity.
+ *
+ * Falls back to fec_encode_video_frame() if the FEC doesn't support it.
+ */
+struct video_frame *
+fec_encode_video_frame_streaming(struct fec *fec, const struct video_frame *f)
+{
+        // FEC state (eg. LDGM packet size) is shared by the frames
+        if (fec->last_parity_job) {
+                fec->last_parity_job->wait();
+        }
+        struct video_frame *out = fec->encode_video_frame_systematic(f);
+        if (out == nullptr) {
+                return fec->encode_video_frame(f);
+        }
+        auto job     = make_shared<fec_parity_job>();
+        job->fec     = fec;
+        job->frame   = out;
+        job->dispose = out->callbacks.dispose;
+        out->callbacks.dispose     = fec_streaming_dispose;
+        out->callbacks.wait_parity = fec_wait_parity;
+        out->callbacks.wait_parity_udata = new shared_ptr<fec_parity_job>(job);
+        fec->last_parity_job = job;
+        task_run_async_detached(fec_parity_task,
+                                new shared_ptr<fec_parity_job>(job));
+        return out;
+}
+
+/**
+ * @returns offset of the parity in a tile of RS/LDGM encoded frame
+ *
+ * The symbol size differs per tile (video_frame::fec_params holds the one of
+ * the last tile), so it is deduced from the tile length (k + m symbols).
+ */
+size_t
+fec_get_parity_offset(const struct video_frame *f, unsigned tile)
+{
+        const struct fec_desc *p = &f->fec_params;
+        return f->tiles[tile].data_len / (p->k + p->m) * p->k;
+}
+
 struct audio_frame2 *
 fec_encode_audio_frame(struct fec *s, const struct audio_frame2 *f)
 {
@@ -264,25 +374,20 @@ fec_usage()
         color_printf("\nIf neither A: or V: is specified, FEC is set "
                      "to the video (backward compat).\n");
         color_printf("\nOption \"nodup\" - do not duplicate first packet for RS/LDGM.\n");
+        color_printf("Option \"auto\" (" TBOLD("rs:auto") ", " TBOLD("ldgm:auto")
+                     ") - adapt parameters to the loss reported by the receiver.\n");
 
         color_printf("\n" TBOLD("Available") " (compiled-in) FEC modules:\n");
 #ifdef HAVE_LDGM
         color_printf("\t" TBOLD("- ldgm") "\n");
 #endif
         color_printf("\t" TBOLD("- mult") "\n");
-#ifdef HAVE_ZFEC
         color_printf("\t" TBOLD("- rs") "\n");
-#endif
 
-#if !defined HAVE_LDGM || !defined HAVE_ZFEC
-        color_printf("\n" TBOLD("Missing") " from this build:\n");
 #if !defined HAVE_LDGM
+        color_printf("\n" TBOLD("Missing") " from this build:\n");
         color_printf("\t" TBOLD("- ldgm") "\n");
-#endif
-#if !defined HAVE_ZFEC
-        color_printf("\t" TBOLD("- rs") "\n");
-#endif
-#endif // !defined HAVE_LDGM || !defined HAVE_ZFEC
+#endif // !defined HAVE_LDGM
 
         color_printf("\n");
 }
@@ -42,17 +42,30 @@
 #include "types.h"
 
 #ifdef __cplusplus
-#include <map>
 #include <memory>
 #include <stdexcept>
 
+class received_extents;
 struct video_frame;
 struct audio_frame2;
+struct fec_parity_job;
 
 struct fec {
         virtual struct video_frame *
         encode_video_frame(const struct video_frame *video_frame) = 0;
 
+        /**
+         * First phase of streaming encoding - returns frame with only the
+         * systematic part of the tiles (first k symbols) filled in.
+         * @retval nullptr if the FEC doesn't support streaming encoding
+         */
+        virtual struct video_frame *
+        encode_video_frame_systematic(const struct video_frame *) {
+                return nullptr;
+        }
+        /// computes parity of frame returned by encode_video_frame_systematic()
+        virtual void encode_video_frame_parity(struct video_frame *) {}
+
         virtual audio_frame2 encode(audio_frame2 const &) {
                 throw std::logic_error("Selected FEC not implemented for audio!");
         }
@@ -64,13 +77,16 @@ struct fec {
          *               can be read, set len to a non-zero value.
          */
         virtual bool decode(char *in, int in_len, char **out, int *out_len,
-                        const std::map<int, int> &) = 0;
+                        const received_extents &) = 0;
         virtual ~fec() {}
 
         static fec *create_from_config(const char *str, bool is_audio) noexcept;
         static fec *create_from_desc(struct fec_desc) noexcept;
         static int pt_from_fec_type(enum tx_media_type media_type, enum fec_type fec_type, bool encrypted) throw();
         static enum fec_type fec_type_from_pt(int pt) throw();
+
+        /// parity computation of the last frame of streaming encoding
+        std::shared_ptr<fec_parity_job> last_parity_job;
 };
 #endif // __cplusplus
 
@@ -86,6 +102,9 @@ struct audio_frame2 *fec_encode_audio_frame(struct fec                *s,
                                             const struct audio_frame2 *f);
 struct video_frame  *fec_encode_video_frame(struct fec               *s,
                                             const struct video_frame *f);
+struct video_frame *
+fec_encode_video_frame_streaming(struct fec *s, const struct video_frame *f);
+size_t fec_get_parity_offset(const struct video_frame *f, unsigned tile);
 void fec_destroy(struct fec *s);
 int fec_pt_from_fec_type(enum tx_media_type media_type, enum fec_type fec_type, bool encrypted);
 const char *get_fec_desc(struct fec_desc desc, size_t buflen, char *buf);
@@ -0,0 +1,229 @@
+/**
+ * @file   rtp/fec_adapt.c
+ * @brief  closed-loop selection of RS/LDGM parameters from receiver loss
+ *
+ * Receivers report received/expected packet counts and a histogram of loss
+ * burst lengths (RTCP APP, see rtp_loss_report_app()). The controller keeps
+ * a smoothed loss rate (rising immediately, decaying slowly) and the longest
+ * typical burst of the last few reports. From these and the frame size in
+ * packets, it computes the number of symbols a frame is expected to lose and
+ * sizes the parity to cover it with a margin. Protection is raised as soon
+ * as a report demands it but lowered only after several consecutive reports
+ * to avoid oscillation.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rtp/fec_adapt.h"
+
+#include <math.h>             // for ceil, pow
+#include <stdlib.h>           // for calloc, free
+
+#include "rtp/pbuf.h"         // for pbuf_loss_report
+#include "utils/macros.h"     // for CLAMP, MAX, MIN
+
+enum {
+        MIN_REPORT_PKTS  = 100, ///< reports with less packets are ignored
+        BURST_HISTORY    = 4,   ///< reports the burst length is taken from
+        DECREASE_REPORTS = 3,   ///< reports needed to lower the protection
+        RS_MIN_N         = 32,
+        RS_MAX_N         = 255,
+        LDGM_MIN_K       = 256,
+        LDGM_MAX_K       = 8191,
+        LDGM_MIN_M       = 64,
+        LDGM_QUANT       = 32,  ///< LDGM k, m granularity (limits matrix count)
+};
+#define INITIAL_LOSS   0.01 ///< loss assumed until the first report
+#define LOSS_DECAY     0.7  ///< weight of the previous loss estimate
+#define BURST_PCTILE   0.9  ///< burst length covering this ratio of bursts
+#define SAFETY         2.0  ///< margin over the mean symbol loss
+#define LDGM_OVERHEAD  3.0  ///< LDGM is not MDS, matches ldgm.cpp suggested configs
+#define MIN_PARITY     0.02 ///< parity ratio kept even without loss
+#define RS_MAX_PARITY  0.5
+#define CHANGE_TOLERANCE 0.1 ///< relative parity change not worth a reconfig
+#define DUP_MIN_LOSS   0.001 ///< loss rate the 1st packet is duplicated from
+
+struct fec_adapt {
+        enum fec_type type;
+        bool allow_dup;
+        double loss;               ///< smoothed packet loss rate
+        int burst[BURST_HISTORY];  ///< burst lengths of recent reports
+        int burst_idx;
+        bool dirty;                ///< report received since last update
+        int decrease_count;        ///< updates in a row suggesting less parity
+        bool configured;
+        struct fec_desc cur;
+};
+
+struct fec_adapt *fec_adapt_init(enum fec_type type, bool allow_dup_1st_pkt)
+{
+        if (type != FEC_RS && type != FEC_LDGM) {
+                return NULL;
+        }
+        struct fec_adapt *s = calloc(1, sizeof *s);
+        if (s != NULL) {
+                s->type = type;
+                s->allow_dup = allow_dup_1st_pkt;
+                s->loss = INITIAL_LOSS;
+        }
+        return s;
+}
+
+void fec_adapt_destroy(struct fec_adapt *s)
+{
+        free(s);
+}
+
+/// @returns length of loss bursts covering BURST_PCTILE of all bursts
+static int burst_pctile(const struct pbuf_loss_report *report)
+{
+        uint32_t total = 0;
+        for (int i = 0; i < PBUF_LOSS_BURST_BUCKETS; ++i) {
+                total += report->bursts[i];
+        }
+        if (total == 0) {
+                return 0;
+        }
+        uint32_t sum = 0;
+        int i = 0;
+        for (; i < PBUF_LOSS_BURST_BUCKETS - 1; ++i) {
+                sum += report->bursts[i];
+                if (sum >= BURST_PCTILE * total) {
+                        break;
+                }
+        }
+        return (2 << i) - 1; // upper bound of the bucket
+}
+
+void fec_adapt_report(struct fec_adapt *s, const struct pbuf_loss_report *report)
+{
+        if (report->expected < MIN_REPORT_PKTS) {
+                return;
+        }
+        const double loss = report->received >= report->expected
+                                ? 0.0
+                                : (double) (report->expected - report->received) / report->expected;
+        s->loss = MAX(loss, LOSS_DECAY * s->loss + (1.0 - LOSS_DECAY) * loss);
+        s->burst[s->burst_idx++ % BURST_HISTORY] = burst_pctile(report);
+        s->dirty = true;
+}
+
+/**
+ * @returns parity symbols needed for a block of n symbols spread over
+ * frame_pkts packets
+ */
+static double needed_parity(const struct fec_adapt *s, int n, int frame_pkts)
+{
+        int burst = 0;
+        for (int i = 0; i < BURST_HISTORY; ++i) {
+                burst = MAX(burst, s->burst[i]);
+        }
+        const double pkts_per_sym = (double) frame_pkts / n;
+        // a symbol spanning multiple packets is lost with any of them
+        const double sym_loss = pkts_per_sym > 1.0 ? 1.0 - pow(1.0 - s->loss, pkts_per_sym)
+                                                   : s->loss;
+        const double burst_syms = burst > 0 ? ceil(burst / pkts_per_sym) + 1 : 0;
+        return n * sym_loss * SAFETY + burst_syms;
+}
+
+static struct fec_desc compute(const struct fec_adapt *s, int frame_pkts)
+{
+        struct fec_desc d = { .type = s->type };
+        if (s->type == FEC_RS) {
+                const int n = CLAMP(frame_pkts, RS_MIN_N, RS_MAX_N);
+                const double need = ceil(needed_parity(s, n, frame_pkts));
+                const double min_m = ceil(n * MIN_PARITY);
+                const int m = CLAMP((int) need, (int) min_m, (int) (n * RS_MAX_PARITY));
+                d.k = n - m;
+                d.m = m;
+        } else {
+                const int k = CLAMP((frame_pkts + LDGM_QUANT - 1) / LDGM_QUANT * LDGM_QUANT,
+                                    LDGM_MIN_K, LDGM_MAX_K);
+                const double need = ceil(needed_parity(s, k, frame_pkts) * LDGM_OVERHEAD);
+                const int m = CLAMP((int) need, MAX(LDGM_MIN_M, (int) (k * MIN_PARITY)), k);
+                d.k = k;
+                d.m = (m + LDGM_QUANT - 1) / LDGM_QUANT * LDGM_QUANT;
+                d.c = s->loss < 0.02 ? 5 : s->loss < 0.05 ? 6 : 7;
+        }
+        return d;
+}
+
+/**
+ * Computes FEC parameters for the frames to come. Should be called for every
+ * frame, the parameters are reevaluated only after a new report.
+ *
+ * @param frame_pkts  number of packets of the (unprotected) frame
+ * @returns true if desc was set to new parameters
+ */
+bool fec_adapt_update(struct fec_adapt *s, int frame_pkts, struct fec_desc *desc)
+{
+        if (s->configured && !s->dirty) {
+                return false;
+        }
+        s->dirty = false;
+        frame_pkts = MAX(frame_pkts, 1);
+
+        const struct fec_desc d = compute(s, frame_pkts);
+        if (s->configured) {
+                const double cur_ratio = (double) s->cur.m / (s->cur.k + s->cur.m);
+                const double new_ratio = (double) d.m / (d.k + d.m);
+                const double resize = (double) (d.k + d.m) / (s->cur.k + s->cur.m);
+                const bool resized = resize > 1.25 || resize < 0.8;
+                if (new_ratio < cur_ratio * (1.0 - CHANGE_TOLERANCE)) {
+                        if (++s->decrease_count < DECREASE_REPORTS && !resized) {
+                                return false;
+                        }
+                } else if (new_ratio <= cur_ratio * (1.0 + CHANGE_TOLERANCE) && !resized) {
+                        s->decrease_count = 0;
+                        return false;
+                }
+        }
+        s->decrease_count = 0;
+        s->configured = true;
+        s->cur = d;
+        *desc = d;
+        return true;
+}
+
+/**
+ * @returns whether the first packet of a frame (carrying the FEC header of
+ * the tile) should be duplicated
+ */
+bool fec_adapt_dup_1st_pkt(const struct fec_adapt *s)
+{
+        int burst = 0;
+        for (int i = 0; i < BURST_HISTORY; ++i) {
+                burst = MAX(burst, s->burst[i]);
+        }
+        return s->allow_dup && (s->loss >= DUP_MIN_LOSS || burst > 0);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file   rtp/fec_adapt.h
+ * @brief  closed-loop selection of RS/LDGM parameters from receiver loss
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RTP_FEC_ADAPT_H_
+#define RTP_FEC_ADAPT_H_
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "types.h" // for fec_desc, fec_type
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fec_adapt;
+struct pbuf_loss_report;
+
+struct fec_adapt *fec_adapt_init(enum fec_type type, bool allow_dup_1st_pkt);
+void              fec_adapt_destroy(struct fec_adapt *s);
+void              fec_adapt_report(struct fec_adapt *s,
+                                   const struct pbuf_loss_report *report);
+bool              fec_adapt_update(struct fec_adapt *s, int frame_pkts,
+                                   struct fec_desc *desc);
+bool              fec_adapt_dup_1st_pkt(const struct fec_adapt *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTP_FEC_ADAPT_H_
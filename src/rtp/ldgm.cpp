@@ -37,6 +37,7 @@
 
 #include <cassert>
 #include <cerrno>
+#include <algorithm>
 #include <climits>
 #include <cstdio>
 #include <cstdlib>
@@ -61,6 +62,7 @@
 #include "../ldgm/src/ldgm-session.h"
 #include "../ldgm/src/ldgm-session-cpu.h"
 #include "../ldgm/src/ldgm-session-gpu.h"
+#include "../ldgm/src/xor-simd.h"
 #include "../ldgm/matrix-gen/matrix-generator.h"
 #include "../ldgm/matrix-gen/ldpc-matrix.h" // LDGM_MAX_K
 
@@ -68,10 +70,11 @@
 #include "rtp/rtp_callback.h"
 #include "transmit.h"
 #include "utils/color_out.h"
+#include "utils/misc.h"            // for get_cpu_core_count
 #include "video_frame.h"
 
 using std::endl;
-using std::map;
+using std::max;
 using std::ostringstream;
 using std::setprecision;
 using std::shared_ptr;
@@ -210,6 +213,8 @@ void ldgm::set_params(unsigned int k, unsigned int m, unsigned int c, unsigned i
 
 ADD_TO_PARAM("ldgm-device", "* ldgm-device={CPU|GPU}\n"
                 "  specify whether use CPU or GPU for LDGM\n");
+ADD_TO_PARAM("ldgm-decoder-threads", "* ldgm-decoder-threads=<n>|auto\n"
+                "  number of threads used by CPU LDGM decoder (default 1)\n");
 
 void ldgm::init(unsigned int k, unsigned int m, unsigned int c, unsigned int seed)
 {
@@ -232,7 +237,16 @@ void ldgm::init(unsigned int k, unsigned int m, unsigned int c, unsigned int see
 
                 }
         } else {
-                m_coding_session = std::make_unique<LDGM_session_cpu>();
+                auto cpu_session = std::make_unique<LDGM_session_cpu>();
+                if (const char *threads = get_commandline_param("ldgm-decoder-threads")) {
+                        const int count = strcmp(threads, "auto") == 0
+                                              ? get_cpu_core_count()
+                                              : atoi(threads);
+                        cpu_session->set_threads(count);
+                        MSG(INFO, "Using %d LDGM decoder threads (%s XOR).\n",
+                            max(count, 1), ldgm_xor_best_isa());
+                }
+                m_coding_session = std::move(cpu_session);
         }
 
         set_params(k, m, c, seed);
@@ -243,7 +257,7 @@ ldgm::ldgm(unsigned int k, unsigned int m, unsigned int c, unsigned int seed)
         init(k, m, c, seed);
 }
 
-bool ldgm::decode(char *frame, int size, char **out, int *out_size, const map<int, int> &packets) {
+bool ldgm::decode(char *frame, int size, char **out, int *out_size, const received_extents &packets) {
         char *decoded;
         decoded = m_coding_session->decode_frame(frame, size, out_size, packets);
         if (*out_size > 0) {
@@ -427,6 +441,32 @@ check_packet_size(size_t len, int k)
 
 struct video_frame *
 ldgm::encode_video_frame(const struct video_frame *tx_frame)
+{
+        return encode_frame(tx_frame, true);
+}
+
+struct video_frame *
+ldgm::encode_video_frame_systematic(const struct video_frame *tx_frame)
+{
+        return encode_frame(tx_frame, false);
+}
+
+void
+ldgm::encode_video_frame_parity(struct video_frame *out)
+{
+        for (unsigned int i = 0; i < out->tile_count; ++i) {
+                m_coding_session->encode_parity(
+                    out->tiles[i].data,
+                    out->tiles[i].data_len / (m_k + m_m));
+        }
+}
+
+/**
+ * @param with_parity  if false, only the systematic part is filled in (see
+ *                     fec::encode_video_frame_systematic())
+ */
+struct video_frame *
+ldgm::encode_frame(const struct video_frame *tx_frame, bool with_parity)
 {
         // We need to have copy of coding session shared pointer in order to exit
         // gracefully even when destructed LDGM state first with some frame still
@@ -446,13 +486,16 @@ ldgm::encode_video_frame(const struct video_frame *tx_frame)
 
 
         for (unsigned int i = 0; i < tx_frame->tile_count; ++i) {
-                video_payload_hdr_t video_hdr;
+                video_payload_hdr_t video_hdr{}; // word 1 (offset) is unused here
                 format_video_header(tx_frame, i, 0, video_hdr);
 
                 check_packet_size(tx_frame->tiles[i].data_len, m_k);
 
                 int out_size;
-                char *output = m_coding_session->encode_hdr_frame((char *) video_hdr, sizeof(video_hdr),
+                char *output = with_parity
+                        ? m_coding_session->encode_hdr_frame((char *) video_hdr, sizeof(video_hdr),
+                                tx_frame->tiles[i].data, tx_frame->tiles[i].data_len, &out_size)
+                        : m_coding_session->alloc_hdr_frame((char *) video_hdr, sizeof(video_hdr),
                                 tx_frame->tiles[i].data, tx_frame->tiles[i].data_len, &out_size);
 
                 out->tiles[i].data = output;
@@ -40,14 +40,13 @@
 
 #define LDGM_MAXIMAL_SIZE_RATIO 1
 
-#include <map>
 #include <memory>
 
 #include "fec.h"
 
 #define DEFAULT_LDGM_SEED 1
 
-#define LDGM_GPU_API_VERSION 1
+#define LDGM_GPU_API_VERSION 2
 
 class LDGM_session;
 struct video_frame;
@@ -60,12 +59,16 @@ struct ldgm : public fec{
 
         struct video_frame *
         encode_video_frame(const struct video_frame *video_frame) override;
+        struct video_frame *
+        encode_video_frame_systematic(const struct video_frame *) override;
+        void encode_video_frame_parity(struct video_frame *) override;
 
         bool decode(char *in, int in_len, char **out, int *len,
-                const std::map<int, int> &packets) override;
+                const received_extents &packets) override;
 
 private:
         void init(unsigned int k, unsigned int m, unsigned int c, unsigned int seed = DEFAULT_LDGM_SEED);
+        struct video_frame *encode_frame(const struct video_frame *tx_frame, bool with_parity);
 
         std::shared_ptr<LDGM_session> m_coding_session;
         unsigned int m_k, m_m, m_c;
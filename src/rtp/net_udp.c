@@ -51,12 +51,20 @@
 #include <stdalign.h>
 #include <stdarg.h>
 #include <stdbool.h>               // for bool, false, true
+#include <stddef.h>                // for max_align_t
 #include <stdint.h>                // for uint16_t, uintmax_t
 #include <stdlib.h>                // for NULL, free, abort, calloc, malloc
 
 #ifndef _WIN32
 #include <ifaddrs.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#include <netinet/udp.h>           // for UDP_SEGMENT
+#include <sys/uio.h>               // for iovec
+#endif
+#ifdef __linux__
+#include <linux/net_tstamp.h>      // for sock_txtime
+#endif
 
 #include "compat/net.h"
 #include "compat/platform_pipe.h"
@@ -67,11 +75,11 @@
 #include "net_udp.h"
 #include "rtp.h"
 #include "tv.h" // for SEC_TO_NS, US_TO_NS, time_ns_t
-#include "utils/list.h"
 #include "utils/macros.h"
 #include "utils/misc.h"
 #include "utils/net.h"
-#include "utils/pthread.h" // for CHK_PTHR, ug_pthread_cond_reltimedwait
+#include "utils/pthread.h" // for CHK_PTHR
+#include "utils/spsc_ring.h"
 #include "utils/thread.h"
 #include "utils/windows.h"
 
@@ -80,10 +88,18 @@
 #endif
 
 #define DEFAULT_MAX_UDP_READER_QUEUE_LEN (1920/3*8*1080/1152) //< 10-bit FullHD frame divided by 1280 MTU packets (minus headers)
+#define DEFAULT_UDP_SEND_BATCH 64 ///< packets queued between udp_async_start() and udp_async_wait() before flush
+#define UDP_READER_BATCH 64 ///< max packets received by the reader thread at once (recvmmsg)
+#define UDP_SLAB_CHUNK 1024 ///< packet buffers allocated at once by the reader packet slab
 
 static unsigned get_ifindex(const char *iface);
 static int resolve_address(socket_udp *s, const char *addr, uint16_t tx_port);
 static void *udp_reader(void *arg);
+static struct udp_pkt_slab *udp_slab_init(unsigned initial_count);
+static void udp_slab_grow(struct udp_pkt_slab *slab);
+static void udp_slab_orphan(struct udp_pkt_slab *slab);
+static struct item *udp_queue_pop(struct socket_udp_local *l);
+static void udp_queue_report(struct socket_udp_local *l);
 static void     udp_leave_mcast_grp4(unsigned long addr, int fd,
                                      const char iface[]);
 
@@ -148,6 +164,33 @@ struct item {
 #define ALIGNED_SOCKADDR_STORAGE_OFF ((RTP_MAX_PACKET_LEN + alignof(struct sockaddr_storage) - 1) / alignof(struct sockaddr_storage) * alignof(struct sockaddr_storage))
 #define ALIGNED_ITEM_OFF (((ALIGNED_SOCKADDR_STORAGE_OFF + sizeof(struct sockaddr_storage)) + alignof(struct item) - 1) / alignof(struct item) * alignof(struct item))
 
+/**
+ * Packet buffers for the multithreaded receiver.
+ *
+ * Buffers are allocated in chunks of UDP_SLAB_CHUNK and recycled through the
+ * free list so that there is no per-packet allocation in a steady state. The
+ * slab grows only if all buffers are held by the consumer (eg. in the playout
+ * buffer). The buffers are returned by udp_data_free() from an arbitrary
+ * thread, so the slab is destroyed only after the socket is closed and all
+ * buffers are returned.
+ */
+struct udp_pkt_slab {
+        pthread_mutex_t lock;
+        char **chunks;
+        int chunk_count;
+        void **free_list;
+        unsigned free_count;
+        unsigned total;
+        bool orphaned; ///< owning socket was closed
+};
+
+/// header preceding each buffer returned by udp_recvfrom_data() or udp_data_alloc()
+struct udp_data_hdr {
+        struct udp_pkt_slab *slab; ///< NULL if allocated by udp_data_alloc()
+};
+#define UDP_DATA_HDR_LEN ((sizeof(struct udp_data_hdr) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t))
+#define UDP_SLAB_STRIDE ((UDP_DATA_HDR_LEN + ALIGNED_ITEM_OFF + sizeof(struct item) + 63) / 64 * 64)
+
 // OpenBSD doesn't allow setting IPV6_V6ONLY=0
 #ifdef AI_V4MAPPED
 #define V4MAPPED_SUPP 1
@@ -155,6 +198,39 @@ struct item {
 #define V4MAPPED_SUPP 0
 #endif
 
+#ifdef HAVE_SENDMMSG
+enum {
+        UDP_BATCH_MAX_PKT_IOV = 4,    ///< max iovecs of one packet passed to udp_sendv()
+        UDP_BATCH_MAX_PKTS    = 1024, ///< UIO_MAXIOV, also the sendmmsg() limit
+        UDP_GSO_MAX_SEGS      = 64,   ///< UDP_MAX_SEGMENTS of older kernels
+        UDP_GSO_MAX_BYTES     = 65000,
+};
+/// per-message control data - either UDP_SEGMENT or SCM_TXTIME
+#define UDP_BATCH_CMSG_SPACE CMSG_SPACE(sizeof(uint64_t))
+
+/**
+ * Packets queued for sendmmsg() while async mode is active (see
+ * udp_async_start()). Iovecs of the packets are stored contiguously so that
+ * a run of equally-sized packets can be passed as a single GSO datagram.
+ */
+struct udp_send_batch {
+        bool active;
+        int capacity; ///< in packets
+        int count;
+        int iov_used;
+        struct iovec *iov;
+        int *pkt_iov_start;
+        int *pkt_iov_cnt;
+        size_t *pkt_len;
+        uint64_t *pkt_txtime; ///< launch times if SO_TXTIME is enabled
+        void **dispose_udata;
+        struct mmsghdr *msgs;
+        int *msg_first_pkt;
+        char *cmsg_buf;
+        int gso; ///< -1 - not yet probed, 0 - unsupported/disabled, 1 - used
+};
+#endif
+
 /*
  * Local part of the socket
  *
@@ -171,13 +247,14 @@ struct socket_udp_local {
 
         // for multithreaded receiving
         pthread_t thread_id;
-        struct simple_linked_list *packets;
-        unsigned int max_packets;
-        pthread_mutex_t lock;
-        pthread_cond_t boss_cv;
-        pthread_cond_t reader_cv;
+        struct udp_pkt_slab *slab;
+        struct spsc_ring *queue; ///< received packets (struct item *)
+        unsigned int max_packets; ///< capacity of queue
+        /// consumer-local batch of packets popped from the queue
+        void *rx_cache[UDP_READER_BATCH];
+        unsigned int rx_cache_pos;
+        unsigned int rx_cache_cnt;
 
-        bool should_exit;
         fd_t should_exit_fd[2];
 };
 
@@ -192,6 +269,9 @@ struct _socket_udp {
         struct socket_udp_local *local;
         bool local_is_slave; // whether is the local
 
+        bool txtime;          ///< SO_TXTIME enabled
+        uint64_t next_txtime; ///< launch time of next packet (CLOCK_MONOTONIC ns)
+
 #ifdef _WIN32
         WSAOVERLAPPED *overlapped;
         WSAEVENT *overlapped_events;
@@ -199,6 +279,8 @@ struct _socket_udp {
         bool overlapping_active;
         int overlapped_max;
         int overlapped_count;
+#elif defined HAVE_SENDMMSG
+        struct udp_send_batch batch;
 #endif
 };
 
@@ -1004,7 +1086,17 @@ check_already_bound_rx_socket(socket_udp *s, uint16_t rx_port)
 
 ADD_TO_PARAM("udp-queue-len",
                 "* udp-queue-len=<l>\n"
-                "  Use different queue size than default DEFAULT_MAX_UDP_READER_QUEUE_LEN\n");
+                "  Use different queue size than default DEFAULT_MAX_UDP_READER_QUEUE_LEN (rounded up to power of 2),\n"
+                "  queue utilization is reported on exit (verbose)\n");
+#ifdef HAVE_SENDMMSG
+ADD_TO_PARAM("udp-send-batch",
+                "* udp-send-batch=<pkts>\n"
+                "  Max number of packets sent by one sendmmsg() call (default "
+                TOSTRING(DEFAULT_UDP_SEND_BATCH) ", 0 or 1 to disable batching)\n");
+ADD_TO_PARAM("udp-disable-gso",
+                "* udp-disable-gso\n"
+                "  Do not use UDP generic segmentation offload (UDP_SEGMENT) for batched send\n");
+#endif
 #ifdef _WIN32
 ADD_TO_PARAM("udp-disable-multi-socket",
                 "* udp-disable-multi-socket\n"
@@ -1033,12 +1125,11 @@ socket_udp *udp_init_if(const char *addr, const char *iface, uint16_t rx_port,
         int ret;
         socket_udp *s = (socket_udp *) calloc(1, sizeof *s);
         s->local = (struct socket_udp_local*) calloc(1, sizeof(*s->local));
-        s->local->packets = simple_linked_list_init();
         s->local->rx_fd =
                 s->local->tx_fd = INVALID_SOCKET;
-        pthread_mutex_init(&s->local->lock, NULL);
-        pthread_cond_init(&s->local->boss_cv, NULL);
-        pthread_cond_init(&s->local->reader_cv, NULL);
+#ifdef HAVE_SENDMMSG
+        s->batch.gso = -1;
+#endif
 
         s->local->mode = adjust_ip_version(force_ip_version, addr, iface);
 
@@ -1133,6 +1224,11 @@ socket_udp *udp_init_if(const char *addr, const char *iface, uint16_t rx_port,
                 } else {
                         s->local->max_packets = atoi(get_commandline_param("udp-queue-len"));
                 }
+                s->local->queue = spsc_ring_init(s->local->max_packets);
+                struct spsc_ring_stats st;
+                spsc_ring_get_stats(s->local->queue, &st);
+                s->local->max_packets = st.capacity; // rounded to power of 2
+                s->local->slab = udp_slab_init(s->local->max_packets + UDP_READER_BATCH);
                 platform_pipe_init(s->local->should_exit_fd);
                 pthread_create(&s->local->thread_id, NULL, udp_reader, s);
         }
@@ -1163,6 +1259,9 @@ socket_udp *udp_init_with_local(struct socket_udp_local *l, struct sockaddr *sa)
         struct _socket_udp *s = (socket_udp *) calloc(1, sizeof *s);
         s->local = l;
         s->local_is_slave = true;
+#ifdef HAVE_SENDMMSG
+        s->batch.gso = -1;
+#endif
 
         udp_set_receiver(s, sa);
 
@@ -1221,25 +1320,23 @@ void udp_exit(socket_udp * s)
                         char c = 0;
                         int ret = PLATFORM_PIPE_WRITE(s->local->should_exit_fd[1], &c, 1);
                         assert (ret == 1);
-                        CHK_PTHR(pthread_mutex_lock(&s->local->lock));
-                        s->local->should_exit = true;
-                        CHK_PTHR(pthread_mutex_unlock(&s->local->lock));
-                        pthread_cond_signal(&s->local->reader_cv);
+                        spsc_ring_interrupt(s->local->queue);
                         pthread_join(s->local->thread_id, NULL);
-                        while (simple_linked_list_size(s->local->packets) > 0) {
-                                struct item *item = (struct item *) simple_linked_list_pop(s->local->packets);
-                                free(item->buf);
+                        udp_queue_report(s->local);
+                        struct item *item = NULL;
+                        while ((item = udp_queue_pop(s->local)) != NULL) {
+                                udp_data_free(item->buf);
                         }
                         platform_pipe_close(s->local->should_exit_fd[1]);
+                        spsc_ring_destroy(s->local->queue);
+                }
+                if (s->local->slab != NULL) {
+                        udp_slab_orphan(s->local->slab);
                 }
                 CLOSESOCKET(s->local->rx_fd);
                 if (s->local->tx_fd != s->local->rx_fd) {
                         CLOSESOCKET(s->local->tx_fd);
                 }
-                simple_linked_list_destroy(s->local->packets);
-                CHK_PTHR(pthread_mutex_destroy(&s->local->lock));
-                pthread_cond_destroy(&s->local->boss_cv);
-                pthread_cond_destroy(&s->local->reader_cv);
                 free(s->local);
         }
 
@@ -1273,6 +1370,268 @@ int udp_sendto(socket_udp * s, char *buffer, int buflen, struct sockaddr *dst_ad
         return sendto(s->local->tx_fd, buffer, buflen, 0, dst_addr, addrlen);
 }
 
+/**
+ * Sends multiple datagrams, possibly to different destinations, with as few
+ * syscalls as possible (sendmmsg() if available). A datagram that cannot be
+ * sent is skipped and its error is stored to udp_dgram::err.
+ *
+ * @returns number of datagrams sent
+ */
+int udp_sendto_multi(socket_udp *s, struct udp_dgram *dgrams, int count)
+{
+        int sent = 0;
+#ifdef HAVE_SENDMMSG
+        enum { CHUNK = 256 };
+        struct mmsghdr msgs[CHUNK];
+        struct iovec   iov[CHUNK];
+        int i = 0;
+        while (i < count) {
+                const int n = MIN(count - i, CHUNK);
+                for (int j = 0; j < n; ++j) {
+                        struct udp_dgram *d = &dgrams[i + j];
+                        iov[j].iov_base = d->data;
+                        iov[j].iov_len  = d->len;
+                        memset(&msgs[j], 0, sizeof msgs[j]);
+                        msgs[j].msg_hdr.msg_name    = d->addr;
+                        msgs[j].msg_hdr.msg_namelen = d->addrlen;
+                        msgs[j].msg_hdr.msg_iov     = &iov[j];
+                        msgs[j].msg_hdr.msg_iovlen  = 1;
+                        d->err                      = 0;
+                }
+                const int ret = sendmmsg(s->local->tx_fd, msgs, n, 0);
+                if (ret < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        dgrams[i++].err = errno; // skip the failed one
+                        continue;
+                }
+                sent += ret;
+                i += ret;
+        }
+#else
+        for (int i = 0; i < count; ++i) {
+                const int ret = udp_sendto(s, dgrams[i].data, dgrams[i].len,
+                                           dgrams[i].addr, dgrams[i].addrlen);
+                dgrams[i].err = ret < 0 ? errno : 0;
+                sent += ret >= 0;
+        }
+#endif
+        return sent;
+}
+
+#ifdef HAVE_SENDMMSG
+static bool
+udp_gso_supported(socket_udp *s)
+{
+#ifdef UDP_SEGMENT
+        if (get_commandline_param("udp-disable-gso") != NULL) {
+                return false;
+        }
+        int       val = 0;
+        socklen_t len = sizeof val;
+        if (GETSOCKOPT(s->local->tx_fd, IPPROTO_UDP, UDP_SEGMENT,
+                       (sockopt_t) &val, &len) != 0) {
+                MSG(VERBOSE, "UDP GSO not supported by the kernel: %s\n",
+                    ug_strerror(errno));
+                return false;
+        }
+        MSG(VERBOSE, "Using UDP GSO for batched send.\n");
+        return true;
+#else
+        UNUSED(s);
+        return false;
+#endif
+}
+
+static void
+udp_batch_alloc(struct udp_send_batch *b, int capacity)
+{
+        if (capacity <= b->capacity) {
+                return;
+        }
+        b->iov = realloc(b->iov, (size_t) capacity * UDP_BATCH_MAX_PKT_IOV *
+                                     sizeof *b->iov);
+        b->pkt_iov_start = realloc(b->pkt_iov_start,
+                                   capacity * sizeof *b->pkt_iov_start);
+        b->pkt_iov_cnt =
+            realloc(b->pkt_iov_cnt, capacity * sizeof *b->pkt_iov_cnt);
+        b->pkt_len = realloc(b->pkt_len, capacity * sizeof *b->pkt_len);
+        b->pkt_txtime =
+            realloc(b->pkt_txtime, capacity * sizeof *b->pkt_txtime);
+        b->dispose_udata =
+            realloc(b->dispose_udata, capacity * sizeof *b->dispose_udata);
+        b->msgs = realloc(b->msgs, capacity * sizeof *b->msgs);
+        b->msg_first_pkt =
+            realloc(b->msg_first_pkt, capacity * sizeof *b->msg_first_pkt);
+        b->cmsg_buf = realloc(b->cmsg_buf,
+                              capacity * UDP_BATCH_CMSG_SPACE);
+        b->capacity = capacity;
+}
+
+/**
+ * Groups packets starting from first_pkt to sendmmsg() messages. If GSO is
+ * enabled, a run of packets of the same length (the last one may be shorter)
+ * is passed as a single message segmented by the kernel.
+ *
+ * @returns number of messages
+ */
+static int
+udp_batch_prepare_msgs(socket_udp *s, int first_pkt)
+{
+        struct udp_send_batch *b = &s->batch;
+        int nmsg = 0;
+        for (int i = first_pkt; i < b->count; ++nmsg) {
+                int    segs  = 1;
+                size_t total = b->pkt_len[i];
+                int    iovs  = b->pkt_iov_cnt[i];
+                if (b->gso == 1 && !s->txtime) {
+                        while (i + segs < b->count && segs < UDP_GSO_MAX_SEGS &&
+                               b->pkt_len[i + segs] <= b->pkt_len[i] &&
+                               total + b->pkt_len[i + segs] <=
+                                   UDP_GSO_MAX_BYTES) {
+                                total += b->pkt_len[i + segs];
+                                iovs += b->pkt_iov_cnt[i + segs];
+                                segs += 1;
+                                if (b->pkt_len[i + segs - 1] < b->pkt_len[i]) {
+                                        break; // only last segment can be shorter
+                                }
+                        }
+                }
+                struct msghdr *msg = &b->msgs[nmsg].msg_hdr;
+                memset(&b->msgs[nmsg], 0, sizeof b->msgs[nmsg]);
+                msg->msg_name    = (void *) &s->sock;
+                msg->msg_namelen = s->sock_len;
+                msg->msg_iov     = &b->iov[b->pkt_iov_start[i]];
+                msg->msg_iovlen  = iovs;
+                char *cbuf = b->cmsg_buf + nmsg * UDP_BATCH_CMSG_SPACE;
+#ifdef SO_TXTIME
+                if (s->txtime) {
+                        memset(cbuf, 0, UDP_BATCH_CMSG_SPACE);
+                        msg->msg_control    = cbuf;
+                        msg->msg_controllen = CMSG_SPACE(sizeof(uint64_t));
+                        struct cmsghdr *cm  = CMSG_FIRSTHDR(msg);
+                        cm->cmsg_level      = SOL_SOCKET;
+                        cm->cmsg_type       = SCM_TXTIME;
+                        cm->cmsg_len        = CMSG_LEN(sizeof(uint64_t));
+                        memcpy(CMSG_DATA(cm), &b->pkt_txtime[i],
+                               sizeof(uint64_t));
+                }
+#endif
+#ifdef UDP_SEGMENT
+                if (segs > 1) {
+                        memset(cbuf, 0, CMSG_SPACE(sizeof(uint16_t)));
+                        msg->msg_control    = cbuf;
+                        msg->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                        struct cmsghdr *cm  = CMSG_FIRSTHDR(msg);
+                        cm->cmsg_level      = IPPROTO_UDP;
+                        cm->cmsg_type       = UDP_SEGMENT;
+                        cm->cmsg_len        = CMSG_LEN(sizeof(uint16_t));
+                        const uint16_t gso_size = b->pkt_len[i];
+                        memcpy(CMSG_DATA(cm), &gso_size, sizeof gso_size);
+                }
+#endif
+                b->msg_first_pkt[nmsg] = i;
+                i += segs;
+        }
+        return nmsg;
+}
+
+static void
+udp_batch_send(socket_udp *s, int first_pkt)
+{
+        struct udp_send_batch *b = &s->batch;
+        const int nmsg = udp_batch_prepare_msgs(s, first_pkt);
+        int sent = 0;
+        while (sent < nmsg) {
+                const int rc = sendmmsg(s->local->tx_fd, b->msgs + sent,
+                                        nmsg - sent, 0);
+                if (rc > 0) {
+                        sent += rc;
+                        continue;
+                }
+                if (errno == EINTR) {
+                        continue;
+                }
+                if (b->gso == 1 && (errno == EINVAL || errno == EIO ||
+                                    errno == EMSGSIZE)) {
+                        MSG(WARNING, "UDP GSO send failed (%s), disabling "
+                                     "GSO for the socket.\n",
+                            ug_strerror(errno));
+                        b->gso = 0;
+                        udp_batch_send(s, b->msg_first_pkt[sent]);
+                        return;
+                }
+                log_msg(LOG_LEVEL_WARNING, MOD_NAME "sendmmsg: %s\n",
+                        ug_strerror(errno));
+                break;
+        }
+}
+
+static void
+udp_batch_flush(socket_udp *s)
+{
+        struct udp_send_batch *b = &s->batch;
+        if (b->count == 0) {
+                return;
+        }
+        udp_batch_send(s, 0);
+        for (int i = 0; i < b->count; ++i) {
+                free(b->dispose_udata[i]);
+        }
+        b->count    = 0;
+        b->iov_used = 0;
+}
+
+static int
+udp_batch_append(socket_udp *s, struct iovec *vector, int count, void *d)
+{
+        struct udp_send_batch *b = &s->batch;
+        assert(count <= UDP_BATCH_MAX_PKT_IOV);
+        size_t len = 0;
+        b->pkt_iov_start[b->count] = b->iov_used;
+        for (int i = 0; i < count; ++i) {
+                b->iov[b->iov_used++] = vector[i];
+                len += vector[i].iov_len;
+        }
+        b->pkt_iov_cnt[b->count]   = count;
+        b->pkt_len[b->count]       = len;
+        b->pkt_txtime[b->count]    = s->next_txtime;
+        b->dispose_udata[b->count] = d;
+        if (++b->count == b->capacity) {
+                udp_batch_flush(s);
+        }
+        return (int) len;
+}
+
+static void
+udp_batch_start(socket_udp *s, int nr_packets)
+{
+        struct udp_send_batch *b = &s->batch;
+        static int batch_size = -1;
+        if (batch_size == -1) {
+                const char *param = get_commandline_param("udp-send-batch");
+                batch_size = param != NULL ? atoi(param) : DEFAULT_UDP_SEND_BATCH;
+                batch_size = CLAMP(batch_size, 1, UDP_BATCH_MAX_PKTS);
+        }
+        if (batch_size <= 1 || nr_packets <= 1) {
+                return;
+        }
+        if (b->gso == -1) {
+                b->gso = udp_gso_supported(s) ? 1 : 0;
+        }
+        udp_batch_alloc(b, MIN(nr_packets, batch_size));
+        b->active = true;
+}
+
+static void
+udp_batch_stop(socket_udp *s)
+{
+        udp_batch_flush(s);
+        s->batch.active = false;
+}
+#endif // defined HAVE_SENDMMSG
+
 #ifdef _WIN32
 int udp_sendv(socket_udp * s, LPWSABUF vector, int count, void *d)
 {
@@ -1312,73 +1671,364 @@ int udp_sendv(socket_udp * s, struct iovec *vector, int count, void *d)
         msg.msg_controllen = 0;
         msg.msg_flags = 0;
 
+#ifdef HAVE_SENDMMSG
+        if (s->batch.active) {
+                return udp_batch_append(s, vector, count, d);
+        }
+#endif
+
+#ifdef SO_TXTIME
+        char cbuf[CMSG_SPACE(sizeof(uint64_t))] = { 0 };
+        if (s->txtime) {
+                msg.msg_control    = cbuf;
+                msg.msg_controllen = sizeof cbuf;
+                struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+                cm->cmsg_level     = SOL_SOCKET;
+                cm->cmsg_type      = SCM_TXTIME;
+                cm->cmsg_len       = CMSG_LEN(sizeof(uint64_t));
+                memcpy(CMSG_DATA(cm), &s->next_txtime, sizeof(uint64_t));
+        }
+#endif
+
         int ret = sendmsg(s->local->tx_fd, &msg, 0);
         free(d);
         return ret;
 }
 #endif // _WIN32
 
+static struct udp_pkt_slab *
+udp_slab_init(unsigned initial_count)
+{
+        struct udp_pkt_slab *slab = calloc(1, sizeof *slab);
+        CHK_PTHR(pthread_mutex_init(&slab->lock, NULL));
+        while (slab->total < initial_count) {
+                udp_slab_grow(slab);
+        }
+        return slab;
+}
+
+/// @note slab->lock must be held (or the slab not yet shared)
+static void
+udp_slab_grow(struct udp_pkt_slab *slab)
+{
+        char *chunk = malloc((size_t) UDP_SLAB_CHUNK * UDP_SLAB_STRIDE);
+        slab->chunks = realloc(slab->chunks,
+                               (slab->chunk_count + 1) * sizeof *slab->chunks);
+        slab->chunks[slab->chunk_count++] = chunk;
+        slab->total += UDP_SLAB_CHUNK;
+        slab->free_list =
+            realloc(slab->free_list, slab->total * sizeof *slab->free_list);
+        for (int i = 0; i < UDP_SLAB_CHUNK; ++i) {
+                struct udp_data_hdr *hdr =
+                    (void *) (chunk + (size_t) i * UDP_SLAB_STRIDE);
+                hdr->slab = slab;
+                slab->free_list[slab->free_count++] =
+                    (char *) hdr + UDP_DATA_HDR_LEN;
+        }
+}
+
+static void
+udp_slab_destroy(struct udp_pkt_slab *slab)
+{
+        for (int i = 0; i < slab->chunk_count; ++i) {
+                free(slab->chunks[i]);
+        }
+        free(slab->chunks);
+        free(slab->free_list);
+        CHK_PTHR(pthread_mutex_destroy(&slab->lock));
+        free(slab);
+}
+
+/**
+ * Fills bufs up to count buffers.
+ */
+static void
+udp_slab_get(struct udp_pkt_slab *slab, uint8_t **bufs, int count)
+{
+        CHK_PTHR(pthread_mutex_lock(&slab->lock));
+        for (int i = 0; i < count; ++i) {
+                if (slab->free_count == 0) {
+                        udp_slab_grow(slab);
+                        MSG(VERBOSE, "Packet slab grown to %u buffers.\n",
+                            slab->total);
+                }
+                bufs[i] = slab->free_list[--slab->free_count];
+        }
+        CHK_PTHR(pthread_mutex_unlock(&slab->lock));
+}
+
+/// returns count buffers to the slab under a single lock
+static void
+udp_slab_put(struct udp_pkt_slab *slab, void *const *bufs, int count)
+{
+        CHK_PTHR(pthread_mutex_lock(&slab->lock));
+        for (int i = 0; i < count; ++i) {
+                slab->free_list[slab->free_count++] = bufs[i];
+        }
+        const bool destroy = slab->orphaned && slab->free_count == slab->total;
+        CHK_PTHR(pthread_mutex_unlock(&slab->lock));
+        if (destroy) {
+                udp_slab_destroy(slab);
+        }
+}
+
+/// marks the slab as not owned by a socket - destroyed when last buffer returned
+static void
+udp_slab_orphan(struct udp_pkt_slab *slab)
+{
+        CHK_PTHR(pthread_mutex_lock(&slab->lock));
+        slab->orphaned = true;
+        const bool destroy = slab->free_count == slab->total;
+        CHK_PTHR(pthread_mutex_unlock(&slab->lock));
+        if (destroy) {
+                udp_slab_destroy(slab);
+        }
+}
+
+/**
+ * Allocates a buffer that can be freed by udp_data_free(), in the same way as
+ * the buffers returned by udp_recvfrom_data().
+ */
+void *
+udp_data_alloc(size_t size)
+{
+        struct udp_data_hdr *hdr = malloc(UDP_DATA_HDR_LEN + size);
+        if (hdr == NULL) {
+                return NULL;
+        }
+        hdr->slab = NULL;
+        return (char *) hdr + UDP_DATA_HDR_LEN;
+}
+
+/**
+ * Returns a packet buffer of (at least) RTP_MAX_PACKET_LEN +
+ * sizeof(struct sockaddr_storage) bytes from the packet slab of the socket,
+ * to be freed by udp_data_free(). Intended for a receiver not using the
+ * multithreaded mode so that it doesn't need to allocate per packet.
+ */
+void *
+udp_data_get(socket_udp *s)
+{
+        if (s->local->slab == NULL) {
+                s->local->slab = udp_slab_init(UDP_SLAB_CHUNK);
+        }
+        uint8_t *buf = NULL;
+        udp_slab_get(s->local->slab, &buf, 1);
+        return buf;
+}
+
+/**
+ * Frees data returned by udp_recvfrom_data() (or udp_data_alloc()). May be
+ * called from any thread, also after the socket has been closed.
+ */
+void
+udp_data_free(void *data)
+{
+        if (data == NULL) {
+                return;
+        }
+        struct udp_data_hdr *hdr =
+            (void *) ((char *) data - UDP_DATA_HDR_LEN);
+        if (hdr->slab == NULL) {
+                free(hdr);
+        } else {
+                udp_slab_put(hdr->slab, &data, 1);
+        }
+}
+
+/**
+ * Frees count buffers like udp_data_free(). Consecutive buffers from the same
+ * slab are returned under a single lock, so passing eg. all packets of a frame
+ * takes the slab lock once instead of once per packet.
+ */
+void
+udp_data_free_batch(void *const *data, int count)
+{
+        int i = 0;
+        while (i < count) {
+                if (data[i] == NULL) {
+                        i += 1;
+                        continue;
+                }
+                struct udp_data_hdr *hdr =
+                    (void *) ((char *) data[i] - UDP_DATA_HDR_LEN);
+                if (hdr->slab == NULL) {
+                        free(hdr);
+                        i += 1;
+                        continue;
+                }
+                int run = 1;
+                while (i + run < count && data[i + run] != NULL &&
+                       ((struct udp_data_hdr *) (void *) ((char *) data[i + run] -
+                                                          UDP_DATA_HDR_LEN))
+                               ->slab == hdr->slab) {
+                        run += 1;
+                }
+                udp_slab_put(hdr->slab, data + i, run);
+                i += run;
+        }
+}
+
+/**
+ * Pops a packet from the reader queue. The ring is read in batches of up to
+ * UDP_READER_BATCH packets to a consumer-local cache.
+ *
+ * @note to be called only from the (single) consumer thread
+ * @returns packet item or NULL if the queue is empty
+ */
+static struct item *
+udp_queue_pop(struct socket_udp_local *l)
+{
+        if (l->rx_cache_pos == l->rx_cache_cnt) {
+                l->rx_cache_pos = 0;
+                l->rx_cache_cnt =
+                    spsc_ring_pop(l->queue, l->rx_cache, UDP_READER_BATCH);
+                if (l->rx_cache_cnt == 0) {
+                        return NULL;
+                }
+        }
+        return l->rx_cache[l->rx_cache_pos++];
+}
+
+static void
+udp_queue_report(struct socket_udp_local *l)
+{
+        struct spsc_ring_stats st;
+        spsc_ring_get_stats(l->queue, &st);
+        log_msg(st.overflows > 0 ? LOG_LEVEL_INFO : LOG_LEVEL_VERBOSE,
+                MOD_NAME "Reader queue: %" PRIu64 " packets, max occupancy "
+                "%u/%u, full %" PRIu64 " times%s\n",
+                st.pushed, st.max_occupancy, st.capacity, st.overflows,
+                st.overflows > 0 ? " (consider increasing udp-queue-len)"
+                                 : "");
+}
+
+/**
+ * Receives up to count packets to bufs without blocking (expects the socket
+ * to be readable).
+ *
+ * @returns number of packets received
+ */
+static int
+udp_reader_recv(struct socket_udp_local *l, uint8_t **bufs, int count)
+{
+#ifdef HAVE_RECVMMSG
+        struct mmsghdr msgs[UDP_READER_BATCH];
+        struct iovec   iov[UDP_READER_BATCH];
+        for (int i = 0; i < count; ++i) {
+                iov[i].iov_base = bufs[i] + RTP_PACKET_HEADER_SIZE;
+                iov[i].iov_len  = RTP_MAX_PACKET_LEN - RTP_PACKET_HEADER_SIZE;
+                memset(&msgs[i], 0, sizeof msgs[i]);
+                msgs[i].msg_hdr.msg_name =
+                    bufs[i] + ALIGNED_SOCKADDR_STORAGE_OFF;
+                msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+                msgs[i].msg_hdr.msg_iov     = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        int ret = recvmmsg(l->rx_fd, msgs, count, MSG_DONTWAIT, NULL);
+        if (ret < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                        socket_error("recvmmsg");
+                }
+                return 0;
+        }
+        for (int i = 0; i < ret; ++i) {
+                struct item *it = (struct item *) (void *) (bufs[i] + ALIGNED_ITEM_OFF);
+                *it = (struct item){ bufs[i], (int) msgs[i].msg_len,
+                                     msgs[i].msg_hdr.msg_name,
+                                     msgs[i].msg_hdr.msg_namelen };
+        }
+        return ret;
+#else
+        UNUSED(count);
+        struct sockaddr *src_addr = (struct sockaddr *)(void *)(bufs[0] + ALIGNED_SOCKADDR_STORAGE_OFF);
+        socklen_t addrlen = sizeof(struct sockaddr_storage);
+        int size = recvfrom(l->rx_fd, (char *) bufs[0] + RTP_PACKET_HEADER_SIZE,
+                        RTP_MAX_PACKET_LEN - RTP_PACKET_HEADER_SIZE,
+                        0, src_addr, &addrlen);
+
+        if (size <= 0) {
+                /// @todo
+                /// In MSW, this block is called as often as packet is sent if
+                /// we got WSAECONNRESET error (no one is listening). This can have
+                /// negative performance impact.
+                socket_error("recvfrom");
+                return 0;
+        }
+        struct item *it = (struct item *) (void *) (bufs[0] + ALIGNED_ITEM_OFF);
+        *it = (struct item){ bufs[0], size, src_addr, addrlen };
+        return 1;
+#endif
+}
+
 /**
  * When receiving data in separate thread, this function fetches data
  * from socket and puts it in queue.
+ *
+ * The socket is drained in batches (recvmmsg() if available) into buffers
+ * taken from the packet slab.
  */
 static void *udp_reader(void *arg)
 {
         set_thread_name(__func__);
         socket_udp *s = (socket_udp *) arg;
+        struct socket_udp_local *l = s->local;
+        uint8_t *bufs[UDP_READER_BATCH];
+        int nbufs = 0;
 
         while (1) {
                 fd_set fds;
                 FD_ZERO(&fds);
-                FD_SET(s->local->rx_fd, &fds);
-                FD_SET(s->local->should_exit_fd[0], &fds);
-                int nfds = MAX(s->local->rx_fd, s->local->should_exit_fd[0]) + 1;
+                FD_SET(l->rx_fd, &fds);
+                FD_SET(l->should_exit_fd[0], &fds);
+                int nfds = MAX(l->rx_fd, l->should_exit_fd[0]) + 1;
 
                 int rc = select(nfds, &fds, NULL, NULL, NULL);
                 if (rc <= 0) {
                         socket_error("select");
                         continue;
                 }
-                if (FD_ISSET(s->local->should_exit_fd[0], &fds)) {
+                if (FD_ISSET(l->should_exit_fd[0], &fds)) {
                         break;
                 }
-                uint8_t *packet = (uint8_t *) malloc(ALIGNED_ITEM_OFF + sizeof(struct item));
-                uint8_t *buffer = ((uint8_t *) packet) + RTP_PACKET_HEADER_SIZE;
-                struct sockaddr *src_addr = (struct sockaddr *)(void *)(packet + ALIGNED_SOCKADDR_STORAGE_OFF);
-                socklen_t addrlen = sizeof(struct sockaddr_storage);
-                int size = recvfrom(s->local->rx_fd, (char *) buffer,
-                                RTP_MAX_PACKET_LEN - RTP_PACKET_HEADER_SIZE,
-                                0, src_addr, &addrlen);
-
-                if (size <= 0) {
-                        /// @todo
-                        /// In MSW, this block is called as often as packet is sent if
-                        /// we got WSAECONNRESET error (no one is listening). This can have
-                        /// negative performance impact.
-                        socket_error("recvfrom");
-                        free(packet);
-                        continue;
-                }
 
-                pthread_mutex_lock(&s->local->lock);
-                while (simple_linked_list_size(s->local->packets) >= (int) s->local->max_packets && !s->local->should_exit) {
-                        pthread_cond_wait(&s->local->reader_cv, &s->local->lock);
-                }
-                if (s->local->should_exit) {
-                        free(packet);
-                        pthread_mutex_unlock(&s->local->lock);
-                        break;
-                }
+                int received = 0;
+                int requested = 0;
+                do {
+                        if (!spsc_ring_wait_writable(l->queue, NULL)) {
+                                goto exit; // interrupted
+                        }
+                        const unsigned space =
+                            l->max_packets - spsc_ring_size(l->queue);
+                        requested = MIN((int) space, UDP_READER_BATCH);
+                        if (nbufs < requested) {
+                                udp_slab_get(l->slab, bufs + nbufs, requested - nbufs);
+                                nbufs = requested;
+                        }
+                        received = udp_reader_recv(l, bufs, requested);
+                        if (received == 0) {
+                                break;
+                        }
 
-                struct item *i = (struct item *)(void *)(packet + ALIGNED_ITEM_OFF);
-                *i = (struct item){packet, size, src_addr, addrlen};
-                simple_linked_list_append(s->local->packets, i);
+                        void *items[UDP_READER_BATCH];
+                        for (int i = 0; i < received; ++i) {
+                                items[i] = bufs[i] + ALIGNED_ITEM_OFF;
+                        }
+                        const unsigned pushed =
+                            spsc_ring_push(l->queue, items, received);
+                        assert(pushed == (unsigned) received); // single producer
+                        (void) pushed;
 
-                pthread_mutex_unlock(&s->local->lock);
-                pthread_cond_signal(&s->local->boss_cv);
+                        nbufs -= received;
+                        memmove(bufs, bufs + received, nbufs * sizeof bufs[0]);
+                } while (received == requested); // otherwise socket drained
+        }
+exit:
+        for (int i = 0; i < nbufs; ++i) {
+                udp_data_free(bufs[i]);
         }
 
-        platform_pipe_close(s->local->should_exit_fd[0]);
+        platform_pipe_close(l->should_exit_fd[0]);
 
         return NULL;
 }
@@ -1431,23 +2081,15 @@ bool udp_not_empty(socket_udp * s, struct timeval *timeout)
 {
         assert(s->local->multithreaded);
 
-        pthread_mutex_lock(&s->local->lock);
+        if (s->local->rx_cache_pos < s->local->rx_cache_cnt) {
+                return true;
+        }
         if (timeout) {
                 time_ns_t tmout =
                     SEC_TO_NS(timeout->tv_sec) + US_TO_NS(timeout->tv_usec);
-                                int rc = 0;
-                while (rc != ETIMEDOUT && simple_linked_list_size(s->local->packets) == 0) {
-                        rc = ug_pthread_cond_reltimedwait(
-                            &s->local->boss_cv, &s->local->lock, &tmout);
-                }
-        } else {
-                while (simple_linked_list_size(s->local->packets) == 0) {
-                        pthread_cond_wait(&s->local->boss_cv, &s->local->lock);
-                }
+                return spsc_ring_wait_readable(s->local->queue, &tmout);
         }
-        bool ret = simple_linked_list_size(s->local->packets) > 0;
-        pthread_mutex_unlock(&s->local->lock);
-        return ret;
+        return spsc_ring_wait_readable(s->local->queue, NULL);
 }
 
 /**
@@ -1478,7 +2120,8 @@ int udp_recvfrom(socket_udp *s, char *buffer, int buflen, struct sockaddr *src_a
  * Receives data from multithreaded socket.
  *
  * @param[in] s       UDP socket state
- * @param[out] buffer data received from socket. Must be freed by caller!
+ * @param[out] buffer data received from socket. Must be freed by caller
+ *                    with udp_data_free()!
  * @returns           length of the received datagram
  */
 int udp_recvfrom_data(socket_udp * s, char **buffer,
@@ -1487,8 +2130,8 @@ int udp_recvfrom_data(socket_udp * s, char **buffer,
         assert(s->local->multithreaded);
         int ret;
 
-        pthread_mutex_lock(&s->local->lock);
-        struct item *it = (struct item *)(simple_linked_list_pop(s->local->packets));
+        struct item *it = udp_queue_pop(s->local);
+        assert(it != NULL); // udp_not_empty() must be called first
         *buffer = (char *) it->buf;
         if(src_addr){
                 if(it->src_addr){
@@ -1500,15 +2143,22 @@ int udp_recvfrom_data(socket_udp * s, char **buffer,
         }
         ret = it->size;
 
-        pthread_mutex_unlock(&s->local->lock);
-        pthread_cond_signal(&s->local->reader_cv);
-
         return ret;
 }
 int udp_recv_data(socket_udp * s, char **buffer){
         return udp_recvfrom_data(s, buffer, NULL, NULL);
 }
 
+/**
+ * Gets occupancy and overflow counters of the queue between the reader thread
+ * and the consumer (multithreaded socket only), eg. to size udp-queue-len.
+ */
+void udp_get_rx_queue_stats(socket_udp *s, struct spsc_ring_stats *stats)
+{
+        assert(s->local->multithreaded);
+        spsc_ring_get_stats(s->local->queue, stats);
+}
+
 #ifndef _WIN32
 int udp_recvv(socket_udp * s, struct msghdr *m)
 {
@@ -1787,12 +2437,96 @@ void udp_async_start(socket_udp *s, int nr_packets)
 
         s->overlapped_count = 0;
         s->overlapping_active = true;
+#elif defined HAVE_SENDMMSG
+        udp_batch_start(s, nr_packets);
 #else
         UNUSED(nr_packets);
         UNUSED(s);
 #endif
 }
 
+/**
+ * Sends immediately the packets queued since udp_async_start(), if the
+ * platform queues them (Linux sendmmsg batching). Data passed to the
+ * udp_sendv() calls must be kept intact up to udp_async_wait() anyways.
+ */
+void udp_async_flush(socket_udp *s)
+{
+#ifdef HAVE_SENDMMSG
+        if (s->batch.active) {
+                udp_batch_flush(s);
+        }
+#else
+        UNUSED(s);
+#endif
+}
+
+/**
+ * @returns number of packets that can be queued by udp_sendv() before sending
+ * when in async mode (1 if not batching)
+ */
+int udp_async_batch_size(socket_udp *s)
+{
+#ifdef HAVE_SENDMMSG
+        return s->batch.active ? s->batch.capacity : 1;
+#else
+        UNUSED(s);
+        return 1;
+#endif
+}
+
+/**
+ * Sets maximal pacing rate of the socket (SO_MAX_PACING_RATE), enforced by
+ * the fq qdisc (or TCP internal pacing).
+ *
+ * @param bytes_per_sec rate in bytes per second, UINT64_MAX to unset
+ * @retval false  if not supported by the platform or kernel
+ */
+bool udp_set_pacing_rate(socket_udp *s, uint64_t bytes_per_sec)
+{
+#ifdef SO_MAX_PACING_RATE
+        if (SETSOCKOPT(s->local->tx_fd, SOL_SOCKET, SO_MAX_PACING_RATE,
+                       (char *) &bytes_per_sec, sizeof bytes_per_sec) != 0) {
+                socket_error("setsockopt(SO_MAX_PACING_RATE)");
+                return false;
+        }
+        return true;
+#else
+        UNUSED(s), UNUSED(bytes_per_sec);
+        return false;
+#endif
+}
+
+/**
+ * Enables SO_TXTIME - each packet then carries a launch time set by
+ * udp_set_next_txtime() (CLOCK_MONOTONIC, needs fq or etf qdisc to take
+ * effect).
+ *
+ * @retval false  if not supported by the platform or kernel
+ */
+bool udp_set_txtime(socket_udp *s, bool enable)
+{
+#ifdef SO_TXTIME
+        struct sock_txtime cfg = { .clockid = CLOCK_MONOTONIC, .flags = 0 };
+        if (enable && SETSOCKOPT(s->local->tx_fd, SOL_SOCKET, SO_TXTIME,
+                                 (char *) &cfg, sizeof cfg) != 0) {
+                socket_error("setsockopt(SO_TXTIME)");
+                return false;
+        }
+        s->txtime = enable;
+        return true;
+#else
+        UNUSED(s);
+        return !enable;
+#endif
+}
+
+/// sets launch time (CLOCK_MONOTONIC ns) of subsequent udp_sendv() packets
+void udp_set_next_txtime(socket_udp *s, uint64_t launch_time_ns)
+{
+        s->next_txtime = launch_time_ns;
+}
+
 void udp_async_wait(socket_udp *s)
 {
 #ifdef _WIN32
@@ -1815,6 +2549,10 @@ void udp_async_wait(socket_udp *s)
                 free(s->dispose_udata[i]);
         }
         s->overlapping_active = false;
+#elif defined HAVE_SENDMMSG
+        if (s->batch.active) {
+                udp_batch_stop(s);
+        }
 #else
         UNUSED(s);
 #endif
@@ -1829,6 +2567,18 @@ static void udp_clean_async_state(socket_udp *s)
         free(s->overlapped);
         free(s->overlapped_events);
         free(s->dispose_udata);
+#elif defined HAVE_SENDMMSG
+        struct udp_send_batch *b = &s->batch;
+        udp_batch_flush(s);
+        free(b->iov);
+        free(b->pkt_iov_start);
+        free(b->pkt_iov_cnt);
+        free(b->pkt_len);
+        free(b->pkt_txtime);
+        free(b->dispose_udata);
+        free(b->msgs);
+        free(b->msg_first_pkt);
+        free(b->cmsg_buf);
 #else
         UNUSED(s);
 #endif
@@ -1962,10 +2712,11 @@ int udp_recvfrom_timeout(socket_udp *s, char *buffer, int buflen,
                 if (udp_not_empty(s, timeout)) {
                         char *data = NULL;
                         len = udp_recvfrom_data(s, (char **) &data, src_addr, addrlen);
+                        len = MIN(len, buflen);
                         if (len > 0) {
-                                memcpy(buffer, data, len);
+                                memcpy(buffer, data + RTP_PACKET_HEADER_SIZE, len);
                         }
-                        free(data);
+                        udp_data_free(data);
                 }
         } else {
                 udp_fd_zero_r(&fd);
@@ -1982,6 +2733,73 @@ int udp_recvfrom_timeout(socket_udp *s, char *buffer, int buflen,
         return len;
 }
 
+/**
+ * Receives up to count datagrams, waits at most timeout for the first one.
+ * Remaining datagrams are received only if already queued in the socket
+ * (with a single recvmmsg() call if available).
+ *
+ * On input, udp_dgram::len is the buffer size and udp_dgram::addrlen the
+ * size of udp_dgram::addr (which may be NULL), both are set to the received
+ * values.
+ *
+ * @returns number of received datagrams, 0 on timeout, -1 on error
+ */
+int udp_recvfrom_multi_timeout(socket_udp *s, struct udp_dgram *dgrams,
+                               int count, struct timeval *timeout)
+{
+        if (count <= 0) {
+                return 0;
+        }
+#ifdef HAVE_RECVMMSG
+        if (!s->local->multithreaded) {
+                struct udp_fd_r fd;
+                udp_fd_zero_r(&fd);
+                udp_fd_set_r(s, &fd);
+                if (udp_select_r(timeout, &fd) <= 0) {
+                        return 0;
+                }
+                enum { CHUNK = 256 };
+                struct mmsghdr msgs[CHUNK];
+                struct iovec   iov[CHUNK];
+                const int      n = MIN(count, CHUNK);
+                for (int i = 0; i < n; ++i) {
+                        iov[i].iov_base = dgrams[i].data;
+                        iov[i].iov_len  = dgrams[i].len;
+                        memset(&msgs[i], 0, sizeof msgs[i]);
+                        msgs[i].msg_hdr.msg_name    = dgrams[i].addr;
+                        msgs[i].msg_hdr.msg_namelen =
+                            dgrams[i].addr ? dgrams[i].addrlen : 0;
+                        msgs[i].msg_hdr.msg_iov    = &iov[i];
+                        msgs[i].msg_hdr.msg_iovlen = 1;
+                }
+                const int ret =
+                    recvmmsg(s->local->rx_fd, msgs, n, MSG_DONTWAIT, NULL);
+                if (ret < 0) {
+                        return errno == EAGAIN || errno == EWOULDBLOCK ||
+                                       errno == EINTR
+                                   ? 0
+                                   : -1;
+                }
+                for (int i = 0; i < ret; ++i) {
+                        dgrams[i].len     = (int) msgs[i].msg_len;
+                        dgrams[i].addrlen = msgs[i].msg_hdr.msg_namelen;
+                        dgrams[i].err     = 0;
+                }
+                return ret;
+        }
+#endif
+        const int len = udp_recvfrom_timeout(s, dgrams[0].data, dgrams[0].len,
+                                             timeout, dgrams[0].addr,
+                                             dgrams[0].addr ? &dgrams[0].addrlen
+                                                            : NULL);
+        if (len <= 0) {
+                return 0;
+        }
+        dgrams[0].len = len;
+        dgrams[0].err = 0;
+        return 1;
+}
+
 int udp_recv_timeout(socket_udp *s, char *buffer, int buflen, struct timeval *timeout)
 {
         return udp_recvfrom_timeout(s, buffer, buflen, timeout, NULL, NULL);
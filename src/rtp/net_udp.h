@@ -59,6 +59,8 @@ typedef struct _socket_udp socket_udp;
 struct iovec;
 struct timeval;
 struct socket_udp_local;
+struct spsc_ring_stats;
+struct udp_dgram;
 
 #if defined(__cplusplus)
 #include <memory>
@@ -80,11 +82,19 @@ int         udp_recvfrom_timeout(socket_udp *s, char *buffer, int buflen,
                 struct timeval *timeout,
                 struct sockaddr *src_addr, socklen_t *addrlen);
 int         udp_recvfrom(socket_udp *s, char *buffer, int buflen, struct sockaddr *src_addr, socklen_t *addrlen);
+int         udp_recvfrom_multi_timeout(socket_udp *s, struct udp_dgram *dgrams,
+                int count, struct timeval *timeout);
 int         udp_send(socket_udp *s, char *buffer, int buflen);
 int         udp_sendto(socket_udp *s, char *buffer, int buflen, struct sockaddr *dst_addr, socklen_t addrlen);
+int         udp_sendto_multi(socket_udp *s, struct udp_dgram *dgrams, int count);
 
 void        udp_async_start(socket_udp *s, int nr_packets);
 void        udp_async_wait(socket_udp *s);
+void        udp_async_flush(socket_udp *s);
+int         udp_async_batch_size(socket_udp *s);
+bool        udp_set_pacing_rate(socket_udp *s, uint64_t bytes_per_sec);
+bool        udp_set_txtime(socket_udp *s, bool enable);
+void        udp_set_next_txtime(socket_udp *s, uint64_t launch_time_ns);
 #ifdef _WIN32
 int         udp_sendv(socket_udp *s, LPWSABUF vector, int count, void *d);
 #else
@@ -105,6 +115,15 @@ bool        udp_set_recv_buf(socket_udp *s, int size);
 bool        udp_set_send_buf(socket_udp *s, int size);
 void        udp_flush_recv_buf(socket_udp *s);
 
+/// datagram for udp_sendto_multi() and udp_recvfrom_multi_timeout()
+struct udp_dgram {
+        char            *data;
+        int              len; ///< data length (buffer size for receive)
+        struct sockaddr *addr;
+        socklen_t        addrlen;
+        int              err; ///< [out] errno if not sent, 0 otherwise
+};
+
 struct udp_fd_r {
         fd_set rfd;
         fd_t max_fd;
@@ -116,8 +135,13 @@ void        udp_fd_set_r(socket_udp *s, struct udp_fd_r *);
 int         udp_fd_isset_r(socket_udp *s, struct udp_fd_r *);
 
 int         udp_recv_data(socket_udp * s, char **buffer);
+void        udp_get_rx_queue_stats(socket_udp *s, struct spsc_ring_stats *stats);
 int         udp_recvfrom_data(socket_udp * s, char **buffer,
                 struct sockaddr *src_addr, socklen_t *addrlen);
+void       *udp_data_alloc(size_t size);
+void       *udp_data_get(socket_udp *s);
+void        udp_data_free(void *data);
+void        udp_data_free_batch(void *const *data, int count);
 bool        udp_not_empty(socket_udp *s, struct timeval *timeout);
 int         udp_port_pair_is_free(int force_ip_version, int even_port);
 bool        udp_is_ipv6(socket_udp *s);
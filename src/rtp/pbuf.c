@@ -65,8 +65,11 @@
 #include <stdlib.h>           // for free, calloc, malloc, abs
 #include <string.h>           // for strlen
 
+#include "compat/net.h"    // for ntohl
 #include "debug.h"
+#include "host.h"
 #include "rtp/rtp.h"
+#include "rtp/rtp_types.h"
 #include "tv.h"
 #include "utils/color_out.h"
 #include "utils/macros.h"
@@ -77,25 +80,93 @@ enum {
         DEFAULT_STATS_INTERVAL = 128,
         STAT_INT_MIN_DIVISOR   = sizeof(unsigned long long) * CHAR_BIT,
         WRAPAROUND_THRESHOLD   = 900000, // 10 sec with 90 kHz clock
+        PBUF_POOL_CHUNK        = 256,    ///< objects allocated at once by pbuf_pool
+        FRAME_MIN_PKTS         = 256,    ///< initial capacity of pbuf_node::pkts
+        PBUF_FREE_BATCH        = 256,    ///< packets returned to the slab at once
+        FRAME_MAX_SEQ_RANGE    = 1 << 15,
+        FRAME_TABLE_BITS       = 6,
+        FEC_MAX_TILES          = 16,     ///< substreams tracked for early FEC decode
+        FEC_MAX_SYMBOLS        = 256,    ///< RS symbols per tile (GF(2^8))
+        NACK_MAX_PENDING       = 1024,   ///< missing packets tracked for NACKs
+        NACK_MAX_GAP           = 512,    ///< longer gaps are not requested
+        NACK_MAX_TRIES         = 3,
 };
+#define NACK_RETRY_NS     MS_TO_NS(10)
+#define NACK_MIN_SLACK_NS MS_TO_NS(2) ///< retransmission must fit before playout
 static_assert(DEFAULT_STATS_INTERVAL % STAT_INT_MIN_DIVISOR == 0,
                 "STATS_INTERVAL must be divisible by (sizeof(ull) * CHAR_BIT)");
 #define MOD_NAME "[Pbuf] "
 
+ADD_TO_PARAM("pbuf-early-fec", "* pbuf-early-fec\n"
+                "  pass RS/LDGM protected frames to the decoder as soon as every tile\n"
+                "  can be decoded, surplus parity is then discarded on arrival\n");
+
+/**
+ * Received symbols of one FEC-protected tile (substream) of a frame, used to
+ * detect that the tile is decodable before the remaining parity arrives.
+ */
+struct pbuf_fec_tile {
+        uint32_t data_len;         ///< encoded tile length (k + m symbols)
+        uint32_t symbol_size;
+        uint32_t k;
+        uint32_t symbols;          ///< complete symbols received (RS)
+        uint32_t sys_bytes;        ///< bytes of systematic symbols received (LDGM)
+        bool got_first;            ///< to ignore the duplicated first packet
+        /// received bytes of individual symbols (RS)
+        uint32_t sym_bytes[FEC_MAX_SYMBOLS];
+};
+
 struct pbuf_node {
         struct pbuf_node *nxt;
         struct pbuf_node *prv;
+        struct pbuf_node *ts_nxt;  /* Next frame in the frame table bucket  */
         uint32_t rtp_timestamp; /* RTP timestamp for the frame           */
         time_ns_t arrival_time;    /* Arrival time of first packet in frame */
         time_ns_t playout_time;    /* Playout time for the frame            */
         time_ns_t deletion_time;   /* Deletion time for the frame            */
-        struct coded_data *cdata;       /*                                       */
+        struct coded_data *cdata;  /* Descending seqno list, see link_cdata() */
+        bool cdata_linked;         /* cdata reflects all packets in pkts    */
         int decoded;            /* Non-zero if we've decoded this frame  */
         int mbit;               /* determines if mbit of frame had been seen */
         uint32_t magic;         /* For debugging                         */
         bool completed;
+
+        /// packets of the frame indexed by seqno & (pkts_cap - 1), valid
+        /// for [min_seq, max_seq]; kept when the node is returned to the pool
+        struct coded_data **pkts;
+        unsigned pkts_cap;
+        uint16_t min_seq;
+        uint16_t max_seq;
+
+        /// FEC tile state, valid for bits set in fec_seen; kept when the node
+        /// is returned to the pool
+        struct pbuf_fec_tile *fec_tiles;
+        uint32_t fec_seen;         ///< tiles (substreams) with a packet received
+        uint32_t fec_ready;        ///< tiles with enough symbols to be decoded
+        bool fec_untracked;        ///< unsupported packet seen, wait for completion
+        bool fec_complete;         ///< all tiles decodable, see pbuf_fec_account()
 };
 
+/**
+ * Pool of fixed-size objects (pbuf nodes and coded_data).
+ *
+ * Objects are carved from chunks of PBUF_POOL_CHUNK items and recycled
+ * through an intrusive free list linked by the first pointer of the object,
+ * so that there is no per-packet allocation in a steady state. Chunks are
+ * freed only by pbuf_destroy().
+ */
+struct pbuf_pool {
+        void *free_list;
+        char **chunks;
+        int chunk_count;
+        size_t obj_size;
+        int in_use;
+        int high_water;
+};
+// free lists are linked through the nxt member
+static_assert(offsetof(struct pbuf_node, nxt) == 0, "nxt must be first");
+static_assert(offsetof(struct coded_data, nxt) == 0, "nxt must be first");
+
 struct pbuf {
         struct pbuf_node *frst;
         struct pbuf_node *last;
@@ -115,13 +186,100 @@ struct pbuf {
         int max_out_of_order_dist;
         int dups; // duplicite packets
         char stream_identifier[STR_LEN];
+
+        // loss since last pbuf_get_loss_report()
+        struct pbuf_loss_report loss_report;
+        int loss_run; // length of the loss burst in progress
+
+        struct pbuf_pool node_pool;
+        struct pbuf_pool cdata_pool;
+        /// frames hashed by RTP timestamp, chained by pbuf_node::ts_nxt
+        struct pbuf_node *frame_table[1 << FRAME_TABLE_BITS];
+
+        bool early_fec;            ///< pbuf-early-fec enabled
+        int fec_tile_count;        ///< tiles per frame learnt from previous frame
+
+        /// missing packets to be requested, see pbuf_get_nacks()
+        struct pbuf_nack {
+                uint16_t seq;
+                int tries;
+                time_ns_t due;      ///< time of the next request
+                time_ns_t deadline; ///< playout time of the frame
+        } *nacks;
+        int nack_count;
+        uint16_t nack_max_seq;     ///< highest seqno received
+        bool nack_seq_valid;
+        unsigned long long nack_pending[(1 << 16) / STAT_INT_MIN_DIVISOR];
 };
 
-static void free_cdata(struct coded_data *head);
+static void free_cdata(struct pbuf *playout_buf, struct pbuf_node *node);
 static int frame_complete(struct pbuf_node *frame);
 
 /*********************************************************************************/
 
+static void pbuf_pool_init(struct pbuf_pool *pool, size_t obj_size)
+{
+        memset(pool, 0, sizeof *pool);
+        pool->obj_size = obj_size;
+}
+
+static void pbuf_pool_destroy(struct pbuf_pool *pool)
+{
+        for (int i = 0; i < pool->chunk_count; ++i) {
+                free(pool->chunks[i]);
+        }
+        free(pool->chunks);
+}
+
+/// @note objects are zeroed until the first use
+static bool pbuf_pool_grow(struct pbuf_pool *pool)
+{
+        char **chunks = realloc(pool->chunks, (pool->chunk_count + 1) * sizeof *chunks);
+        if (chunks == NULL) {
+                return false;
+        }
+        pool->chunks = chunks;
+        char *chunk = calloc(PBUF_POOL_CHUNK, pool->obj_size);
+        if (chunk == NULL) {
+                return false;
+        }
+        pool->chunks[pool->chunk_count++] = chunk;
+        for (int i = PBUF_POOL_CHUNK - 1; i >= 0; --i) {
+                void **obj = (void **)(void *) (chunk + i * pool->obj_size);
+                *obj = pool->free_list;
+                pool->free_list = obj;
+        }
+        return true;
+}
+
+static void *pbuf_pool_get(struct pbuf_pool *pool)
+{
+        if (pool->free_list == NULL && !pbuf_pool_grow(pool)) {
+                return NULL;
+        }
+        void **obj = pool->free_list;
+        pool->free_list = *obj;
+        pool->in_use += 1;
+        pool->high_water = MAX(pool->high_water, pool->in_use);
+        return obj;
+}
+
+/**
+ * Returns a list of count objects linked through the first pointer (head to
+ * tail) to the pool at once.
+ */
+static void pbuf_pool_put_list(struct pbuf_pool *pool, void *head, void *tail, int count)
+{
+        *(void **) tail = pool->free_list;
+        pool->free_list = head;
+        pool->in_use -= count;
+}
+
+static void pbuf_pool_put(struct pbuf_pool *pool, void *obj)
+{
+        pbuf_pool_put_list(pool, obj, obj, 1);
+}
+
 static void pbuf_validate(struct pbuf *playout_buf)
 {
         /* Run through the entire playout buffer, checking pointers, etc.  */
@@ -192,12 +350,58 @@ pbuf_init(const char *stream_id, volatile int *delay_ms)
                 playout_buf->last_report_seq = -1;
                 playout_buf->stats_interval = DEFAULT_STATS_INTERVAL;
                 snprintf_ch(playout_buf->stream_identifier, "%s", stream_id);
+                pbuf_pool_init(&playout_buf->node_pool, sizeof(struct pbuf_node));
+                pbuf_pool_init(&playout_buf->cdata_pool, sizeof(struct coded_data));
+                playout_buf->early_fec = get_commandline_param("pbuf-early-fec") != NULL;
         } else {
                 debug_msg("Failed to allocate memory for playout buffer\n");
         }
         return playout_buf;
 }
 
+static unsigned frame_table_idx(uint32_t rtp_timestamp)
+{
+        return (rtp_timestamp * 2654435761U) >> (32 - FRAME_TABLE_BITS);
+}
+
+static struct pbuf_node *frame_table_find(struct pbuf *playout_buf, uint32_t rtp_timestamp)
+{
+        struct pbuf_node *node = playout_buf->frame_table[frame_table_idx(rtp_timestamp)];
+        while (node != NULL && node->rtp_timestamp != rtp_timestamp) {
+                node = node->ts_nxt;
+        }
+        return node;
+}
+
+static void frame_table_remove(struct pbuf *playout_buf, struct pbuf_node *node)
+{
+        struct pbuf_node **link = &playout_buf->frame_table[frame_table_idx(node->rtp_timestamp)];
+        while (*link != node) {
+                link = &(*link)->ts_nxt;
+        }
+        *link = node->ts_nxt;
+}
+
+/// unlinks the node from the playout buffer and returns it to the pool
+static void pbuf_drop_node(struct pbuf *playout_buf, struct pbuf_node *curr)
+{
+        if (curr == playout_buf->frst) {
+                playout_buf->frst = curr->nxt;
+        }
+        if (curr == playout_buf->last) {
+                playout_buf->last = curr->prv;
+        }
+        if (curr->nxt != NULL) {
+                curr->nxt->prv = curr->prv;
+        }
+        if (curr->prv != NULL) {
+                curr->prv->nxt = curr->nxt;
+        }
+        frame_table_remove(playout_buf, curr);
+        free_cdata(playout_buf, curr);
+        pbuf_pool_put(&playout_buf->node_pool, curr);
+}
+
 void pbuf_destroy(struct pbuf *playout_buf) {
         if (playout_buf) {
                 pbuf_validate(playout_buf);
@@ -209,84 +413,276 @@ void pbuf_destroy(struct pbuf *playout_buf) {
                                         playout_buf->expected_pkts_cum,
                                         (double) playout_buf->received_pkts_cum /
                                         playout_buf->expected_pkts_cum * 100.0);
+                        MSG(VERBOSE, "Pool high-water mark: %d frames, %d packets.\n",
+                            playout_buf->node_pool.high_water,
+                            playout_buf->cdata_pool.high_water);
                 }
 
-                struct pbuf_node *curr = playout_buf->frst;
-                while (curr != NULL) {
-                        struct pbuf_node *temp = curr->nxt;
-                        if (curr == playout_buf->frst) {
-                                playout_buf->frst = curr->nxt;
+                while (playout_buf->frst != NULL) {
+                        pbuf_drop_node(playout_buf, playout_buf->frst);
+                }
+                // packet indices are kept by the pooled nodes (NULL if never used)
+                struct pbuf_pool *pool = &playout_buf->node_pool;
+                for (int i = 0; i < pool->chunk_count; ++i) {
+                        struct pbuf_node *nodes = (void *) pool->chunks[i];
+                        for (int j = 0; j < PBUF_POOL_CHUNK; ++j) {
+                                free(nodes[j].pkts);
+                                free(nodes[j].fec_tiles);
                         }
-                        if (curr == playout_buf->last) {
-                                playout_buf->last = curr->prv;
+                }
+                pbuf_pool_destroy(&playout_buf->node_pool);
+                pbuf_pool_destroy(&playout_buf->cdata_pool);
+                free(playout_buf->nacks);
+                free(playout_buf);
+        }
+}
+
+/**
+ * Enlarges the packet index of the node to hold at least seq_range packets.
+ */
+static bool pnode_grow_pkts(struct pbuf_node *node, unsigned seq_range)
+{
+        unsigned new_cap = MAX(node->pkts_cap, FRAME_MIN_PKTS);
+        while (new_cap < seq_range) {
+                new_cap *= 2;
+        }
+        struct coded_data **pkts = calloc(new_cap, sizeof *pkts);
+        if (pkts == NULL) {
+                return false;
+        }
+        if (node->pkts_cap > 0) {
+                for (uint16_t seq = node->min_seq;; ++seq) {
+                        pkts[seq & (new_cap - 1)] = node->pkts[seq & (node->pkts_cap - 1)];
+                        if (seq == node->max_seq) {
+                                break;
                         }
-                        if (curr->nxt != NULL) {
-                                curr->nxt->prv = curr->prv;
+                }
+        }
+        free(node->pkts);
+        node->pkts = pkts;
+        node->pkts_cap = new_cap;
+        return true;
+}
+
+/**
+ * @returns true if pkt belongs to a FEC tile that is already decodable (or
+ * to a frame passed to the decoder because of that) so it can be discarded
+ */
+static bool pbuf_fec_surplus(struct pbuf_node *node, rtp_packet *pkt)
+{
+        if (node->fec_complete) {
+                return true;
+        }
+        if (node->fec_ready == 0 || (pkt->pt != PT_VIDEO_RS && pkt->pt != PT_VIDEO_LDGM)) {
+                return false;
+        }
+        const uint32_t substream = ntohl(((uint32_t *)(void *) pkt->data)[0]) >> 22;
+        return substream < FEC_MAX_TILES && (node->fec_ready & (1U << substream)) != 0;
+}
+
+/**
+ * Accounts symbols of a FEC-protected packet to its tile. A RS tile is
+ * decodable once k symbols (systematic or parity) are complete, a LDGM tile
+ * once all k systematic symbols are received - LDGM decoding is not
+ * guaranteed for any lower count. The frame is considered complete when all
+ * tiles are decodable, tile count is taken from the previous frame.
+ *
+ * Encrypted FEC packets are not tracked since the payload length includes
+ * the cipher overhead.
+ */
+static void pbuf_fec_account(struct pbuf *playout_buf, struct pbuf_node *node, rtp_packet *pkt)
+{
+        if (node->fec_untracked) {
+                return;
+        }
+        if ((pkt->pt != PT_VIDEO_RS && pkt->pt != PT_VIDEO_LDGM) ||
+            pkt->data_len <= (int) sizeof(fec_payload_hdr_t)) {
+                node->fec_untracked = true;
+                return;
+        }
+        const uint32_t *hdr = (uint32_t *)(void *) pkt->data;
+        const uint32_t substream = ntohl(hdr[0]) >> 22;
+        const uint32_t offset = ntohl(hdr[1]);
+        const uint32_t data_len = ntohl(hdr[2]);
+        const uint32_t fec_desc = ntohl(hdr[3]);
+        const uint32_t k = fec_desc >> 19;
+        const uint32_t m = (fec_desc >> 6) & 0x1FFF;
+        const uint32_t len = pkt->data_len - sizeof(fec_payload_hdr_t);
+        if (substream >= FEC_MAX_TILES || k == 0 || data_len / (k + m) == 0 ||
+            (pkt->pt == PT_VIDEO_RS && k + m > FEC_MAX_SYMBOLS)) {
+                node->fec_untracked = true;
+                return;
+        }
+        if (node->fec_tiles == NULL) {
+                node->fec_tiles = malloc(FEC_MAX_TILES * sizeof *node->fec_tiles);
+                if (node->fec_tiles == NULL) {
+                        node->fec_untracked = true;
+                        return;
+                }
+        }
+
+        struct pbuf_fec_tile *tile = &node->fec_tiles[substream];
+        const uint32_t bit = 1U << substream;
+        if ((node->fec_seen & bit) == 0) {
+                node->fec_seen |= bit;
+                tile->data_len = data_len;
+                tile->symbol_size = data_len / (k + m);
+                tile->k = k;
+                tile->symbols = tile->sys_bytes = 0;
+                tile->got_first = false;
+                if (pkt->pt == PT_VIDEO_RS) {
+                        memset(tile->sym_bytes, 0, (k + m) * sizeof tile->sym_bytes[0]);
+                }
+        } else if (tile->data_len != data_len || tile->k != k) {
+                node->fec_untracked = true;
+                return;
+        }
+        if (offset == 0) {
+                if (tile->got_first) { // duplicated first packet
+                        return;
+                }
+                tile->got_first = true;
+        }
+        const uint32_t ss = tile->symbol_size;
+        if (offset >= data_len || len > data_len - offset) {
+                node->fec_untracked = true;
+                return;
+        }
+
+        bool ready = false;
+        if (pkt->pt == PT_VIDEO_RS) {
+                for (uint32_t pos = offset; pos < offset + len;) {
+                        const uint32_t idx = pos / ss;
+                        if (idx >= k + m) { // padding after the last symbol
+                                break;
                         }
-                        if (curr->prv != NULL) {
-                                curr->prv->nxt = curr->nxt;
+                        const uint32_t end = MIN((idx + 1) * ss, offset + len);
+                        tile->sym_bytes[idx] += end - pos;
+                        if (tile->sym_bytes[idx] == ss) {
+                                tile->symbols += 1;
                         }
-                        free_cdata(curr->cdata);
-                        free(curr);
-                        curr = temp;
+                        pos = end;
                 }
-                free(playout_buf);
+                ready = tile->symbols >= k;
+        } else {
+                const uint32_t sys_end = k * ss;
+                if (offset < sys_end) {
+                        tile->sys_bytes += MIN(offset + len, sys_end) - offset;
+                }
+                ready = tile->sys_bytes == sys_end;
+        }
+        if (!ready) {
+                return;
+        }
+        node->fec_ready |= bit;
+        const int tile_count = playout_buf->fec_tile_count;
+        if (tile_count > 0 && node->fec_seen == node->fec_ready &&
+            node->fec_ready == (1U << tile_count) - 1) {
+                node->fec_complete = true;
         }
 }
 
 /** Add "pkt" to the frame represented by "node". The "node" has
  * previously been created, and has some coded data already...
  *
- * New arrivals are filed to the list in descending sequence number order
+ * The packet is stored to the slot indexed by its sequence number so the
+ * insertion takes constant time regardless of reordering. The list of
+ * coded_data is linked lazily by link_cdata().
  */
-static void add_coded_unit(struct pbuf_node *node, rtp_packet * pkt)
+static void add_coded_unit(struct pbuf *playout_buf, struct pbuf_node *node, rtp_packet * pkt)
 {
         assert(node->rtp_timestamp == pkt->ts);
         assert(node->cdata != NULL);
 
-        struct coded_data *tmp = (struct coded_data *) malloc(sizeof(struct coded_data));
+        if (pbuf_fec_surplus(node, pkt)) {
+                node->mbit |= pkt->m;
+                rtp_free_packet(pkt);
+                return;
+        }
+
+        const uint16_t min_seq = (int16_t)(pkt->seq - node->min_seq) < 0 ? pkt->seq : node->min_seq;
+        const uint16_t max_seq = (int16_t)(pkt->seq - node->max_seq) > 0 ? pkt->seq : node->max_seq;
+        const unsigned seq_range = (uint16_t)(max_seq - min_seq) + 1U;
+        if (seq_range > FRAME_MAX_SEQ_RANGE ||
+            (seq_range > node->pkts_cap && !pnode_grow_pkts(node, seq_range))) {
+                rtp_free_packet(pkt);
+                return;
+        }
+        struct coded_data **slot = &node->pkts[pkt->seq & (node->pkts_cap - 1)];
+        if (*slot != NULL) {
+                /* duplicate packet */
+                rtp_free_packet(pkt);
+                return;
+        }
+
+        struct coded_data *tmp = pbuf_pool_get(&playout_buf->cdata_pool);
         if (tmp == NULL) {
                 /* this is bad, out of memory, drop the packet... */
-                free(pkt);
+                rtp_free_packet(pkt);
                 return;
         }
 
         tmp->seqno = pkt->seq;
         tmp->data = pkt;
         node->mbit |= pkt->m;
-        if((int16_t)(tmp->seqno - node->cdata->seqno) > 0){
+        node->min_seq = min_seq;
+        node->max_seq = max_seq;
+        *slot = tmp;
+        if (pkt->seq == max_seq && node->cdata_linked) {
+                /* in-order arrival - just prepend to the list */
                 tmp->prv = NULL;
                 tmp->nxt = node->cdata;
                 node->cdata->prv = tmp;
                 node->cdata = tmp;
         } else {
-                struct coded_data *curr = node->cdata;
-                struct coded_data *prv = NULL;
-                while (curr != NULL &&  ((int16_t)(tmp->seqno - curr->seqno) < 0)){
-                        prv = curr;
-                        curr = curr->nxt;
-                }
-                if (curr == NULL) {
-                        tmp->nxt = NULL;
-                        tmp->prv = prv;
-                        prv->nxt = tmp;
-                }else if ((int16_t)(tmp->seqno - curr->seqno) > 0){
-                        tmp->nxt = curr;
-                        tmp->prv = curr->prv;
-                        tmp->prv->nxt = tmp;
-                        curr->prv = tmp;
-                } else {
-                        /* this is bad, something went terribly wrong... */
-                        free(pkt);
-                        free(tmp);
+                node->cdata_linked = false;
+        }
+        if (playout_buf->early_fec) {
+                pbuf_fec_account(playout_buf, node, pkt);
+        }
+}
+
+/**
+ * Links node->cdata list from the packet index in descending sequence number
+ * order.
+ */
+static void link_cdata(struct pbuf_node *node)
+{
+        if (node->cdata_linked) {
+                return;
+        }
+        struct coded_data *prv = NULL;
+        for (uint16_t seq = node->max_seq;; --seq) {
+                struct coded_data *cd = node->pkts[seq & (node->pkts_cap - 1)];
+                if (cd != NULL) {
+                        cd->prv = prv;
+                        cd->nxt = NULL;
+                        if (prv != NULL) {
+                                prv->nxt = cd;
+                        } else {
+                                node->cdata = cd;
+                        }
+                        prv = cd;
+                }
+                if (seq == node->min_seq) {
+                        break;
                 }
         }
+        node->cdata_linked = true;
 }
 
-static struct pbuf_node *create_new_pnode(rtp_packet * pkt, long long playout_delay_us)
+static struct pbuf_node *create_new_pnode(struct pbuf *playout_buf, rtp_packet * pkt, long long playout_delay_us)
 {
-        struct pbuf_node *tmp = calloc(1, sizeof(struct pbuf_node));
+        struct pbuf_node *tmp = pbuf_pool_get(&playout_buf->node_pool);
         if (tmp != NULL) {
+                // keep the packet index of a recycled node
+                struct coded_data **pkts = tmp->pkts;
+                const unsigned pkts_cap = tmp->pkts_cap;
+                struct pbuf_fec_tile *fec_tiles = tmp->fec_tiles;
+                memset(tmp, 0, sizeof *tmp);
+                tmp->pkts = pkts;
+                tmp->pkts_cap = pkts_cap;
+                tmp->fec_tiles = fec_tiles;
                 tmp->magic = PBUF_MAGIC;
                 tmp->rtp_timestamp = pkt->ts;
                 tmp->mbit = pkt->m;
@@ -294,20 +690,34 @@ static struct pbuf_node *create_new_pnode(rtp_packet * pkt, long long playout_de
                         tmp->arrival_time = get_time_in_ns();
                 tmp->playout_time += playout_delay_us * 1000;
                 tmp->deletion_time = tmp->playout_time + playout_delay_us * 1000;
+                tmp->min_seq = tmp->max_seq = pkt->seq;
 
-                tmp->cdata = (struct coded_data *) malloc(sizeof(struct coded_data));
+                if (tmp->pkts_cap == 0 && !pnode_grow_pkts(tmp, 1)) {
+                        rtp_free_packet(pkt);
+                        pbuf_pool_put(&playout_buf->node_pool, tmp);
+                        return NULL;
+                }
+                tmp->cdata = pbuf_pool_get(&playout_buf->cdata_pool);
                 if (tmp->cdata != NULL) {
                         tmp->cdata->nxt = NULL;
                         tmp->cdata->prv = NULL;
                         tmp->cdata->seqno = pkt->seq;
                         tmp->cdata->data = pkt;
+                        tmp->pkts[pkt->seq & (tmp->pkts_cap - 1)] = tmp->cdata;
+                        tmp->cdata_linked = true;
                 } else {
-                        free(pkt);
-                        free(tmp);
+                        rtp_free_packet(pkt);
+                        pbuf_pool_put(&playout_buf->node_pool, tmp);
                         return NULL;
                 }
+                const unsigned idx = frame_table_idx(pkt->ts);
+                tmp->ts_nxt = playout_buf->frame_table[idx];
+                playout_buf->frame_table[idx] = tmp;
+                if (playout_buf->early_fec) {
+                        pbuf_fec_account(playout_buf, tmp, pkt);
+                }
         } else {
-                free(pkt);
+                rtp_free_packet(pkt);
         }
         return tmp;
 }
@@ -348,6 +758,26 @@ static void compute_longest_gap(int *longest_gap, int *accumulated_loss, unsigne
         }
 }
 
+/**
+ * Records loss bursts (runs of zeros) in packets to the histogram. Bursts
+ * continuing past the word are carried over in *run.
+ */
+static void record_loss_bursts(uint32_t *bursts, int *run, unsigned long long int packets)
+{
+        if (packets == ULLONG_MAX && *run == 0) {
+                return;
+        }
+        for (int i = 0; i < NUMBER_WORD_BITS; ++i) {
+                if ((packets & (1ULL << i)) == 0) {
+                        *run += 1;
+                } else if (*run > 0) {
+                        const int bucket = 31 - __builtin_clz(*run);
+                        bursts[MIN(bucket, PBUF_LOSS_BURST_BUCKETS - 1)] += 1;
+                        *run = 0;
+                }
+        }
+}
+
 static inline void pbuf_process_stats(struct pbuf *playout_buf, rtp_packet * pkt)
 {
         // collect statistics
@@ -380,6 +810,10 @@ static inline void pbuf_process_stats(struct pbuf *playout_buf, rtp_packet * pkt
                         playout_buf->expected_pkts += NUMBER_WORD_BITS;
                         playout_buf->received_pkts += __builtin_popcountll(playout_buf->packets[i / NUMBER_WORD_BITS]);
                         compute_longest_gap(&playout_buf->longest_gap, &accumulated_loss,  playout_buf->packets[i / NUMBER_WORD_BITS]);
+                        playout_buf->loss_report.expected += NUMBER_WORD_BITS;
+                        playout_buf->loss_report.received += __builtin_popcountll(playout_buf->packets[i / NUMBER_WORD_BITS]);
+                        record_loss_bursts(playout_buf->loss_report.bursts, &playout_buf->loss_run,
+                                        playout_buf->packets[i / NUMBER_WORD_BITS]);
                         playout_buf->packets[i / NUMBER_WORD_BITS] = 0;
                 }
 
@@ -407,6 +841,11 @@ static inline void pbuf_process_stats(struct pbuf *playout_buf, rtp_packet * pkt
                 char ssrc_str[STR_LEN];
                 if (log_level >= LOG_LEVEL_VERBOSE) {
                         snprintf_ch(ssrc_str, " %08" PRIx32, pkt->ssrc);
+                        snprintf(oo_dups_str + strlen(oo_dups_str),
+                                 sizeof oo_dups_str - strlen(oo_dups_str),
+                                 ", pool peak %d frames/%d pkts",
+                                 playout_buf->node_pool.high_water,
+                                 playout_buf->cdata_pool.high_water);
                 } else {
                         ssrc_str[0] = '\0';
                 }
@@ -435,33 +874,94 @@ static inline void pbuf_process_stats(struct pbuf *playout_buf, rtp_packet * pkt
         }
 }
 
+static bool nack_is_pending(const struct pbuf *playout_buf, uint16_t seq)
+{
+        return playout_buf->nack_pending[seq / STAT_INT_MIN_DIVISOR] &
+               (1ULL << (seq % STAT_INT_MIN_DIVISOR));
+}
+
+static void nack_set_pending(struct pbuf *playout_buf, uint16_t seq, bool pending)
+{
+        const unsigned long long bit = 1ULL << (seq % STAT_INT_MIN_DIVISOR);
+        if (pending) {
+                playout_buf->nack_pending[seq / STAT_INT_MIN_DIVISOR] |= bit;
+        } else {
+                playout_buf->nack_pending[seq / STAT_INT_MIN_DIVISOR] &= ~bit;
+        }
+}
+
+/**
+ * Records the packets missing before pkt to be requested by pbuf_get_nacks().
+ * The deadline is the playout time of the last frame, which is the earliest
+ * frame the missing packets can belong to.
+ */
+static void pbuf_track_gaps(struct pbuf *playout_buf, const rtp_packet *pkt)
+{
+        if (nack_is_pending(playout_buf, pkt->seq)) {
+                nack_set_pending(playout_buf, pkt->seq, false);
+        }
+        if (!playout_buf->nack_seq_valid) {
+                playout_buf->nack_max_seq = pkt->seq;
+                playout_buf->nack_seq_valid = true;
+                return;
+        }
+        const uint16_t dist = pkt->seq - playout_buf->nack_max_seq;
+        if (dist == 0 || dist >= 1U << 15U) { // duplicate, reordered or retransmitted
+                return;
+        }
+        if (dist > 1 && dist <= NACK_MAX_GAP && playout_buf->last != NULL) {
+                for (uint16_t seq = playout_buf->nack_max_seq + 1; seq != pkt->seq; ++seq) {
+                        if (playout_buf->nack_count == NACK_MAX_PENDING) {
+                                break;
+                        }
+                        playout_buf->nacks[playout_buf->nack_count++] = (struct pbuf_nack){
+                                .seq = seq,
+                                .deadline = playout_buf->last->playout_time,
+                        };
+                        nack_set_pending(playout_buf, seq, true);
+                }
+        }
+        playout_buf->nack_max_seq = pkt->seq;
+}
+
 void pbuf_insert(struct pbuf *playout_buf, rtp_packet * pkt)
 {
         struct pbuf_node *tmp;
 
         pbuf_validate(playout_buf);
         pbuf_process_stats(playout_buf, pkt);
+        if (playout_buf->nacks != NULL) {
+                pbuf_track_gaps(playout_buf, pkt);
+        }
 
         if (playout_buf->frst == NULL && playout_buf->last == NULL) {
                 /* playout buffer is empty - add new frame */
-                playout_buf->frst = create_new_pnode(pkt, playout_buf->playout_delay_us + 1000 * (playout_buf->offset_ms ? *playout_buf->offset_ms : 0));
+                playout_buf->frst = create_new_pnode(playout_buf, pkt, playout_buf->playout_delay_us + 1000 * (playout_buf->offset_ms ? *playout_buf->offset_ms : 0));
                 playout_buf->last = playout_buf->frst;
                 return;
         }
 
         if (playout_buf->last->rtp_timestamp == pkt->ts) {
-                if (playout_buf->last->decoded) {
+                if (playout_buf->last->decoded && !playout_buf->last->fec_complete) {
                         log_msg(LOG_LEVEL_VERBOSE, MOD_NAME "Late data for already decoded frame!\n");
                 }
                 /* Packet belongs to last frame in playout_buf this is the */
                 /* most likely scenario - although...                      */
-                add_coded_unit(playout_buf->last, pkt);
+                add_coded_unit(playout_buf, playout_buf->last, pkt);
         } else {
                 if (playout_buf->last->rtp_timestamp < pkt->ts ||
                     playout_buf->last->rtp_timestamp - pkt->ts >
                         UINT32_MAX - WRAPAROUND_THRESHOLD) {
                         /* Packet belongs to a new frame... */
-                        tmp = create_new_pnode(pkt, playout_buf->playout_delay_us + 1000 * (playout_buf->offset_ms ? *playout_buf->offset_ms : 0));
+                        if (playout_buf->last->fec_seen != 0) {
+                                playout_buf->fec_tile_count =
+                                        playout_buf->last->fec_untracked ? 0 :
+                                        32 - __builtin_clz(playout_buf->last->fec_seen);
+                        }
+                        tmp = create_new_pnode(playout_buf, pkt, playout_buf->playout_delay_us + 1000 * (playout_buf->offset_ms ? *playout_buf->offset_ms : 0));
+                        if (tmp == NULL) {
+                                return;
+                        }
                         playout_buf->last->nxt = tmp;
                         playout_buf->last->completed = true;
                         tmp->prv = playout_buf->last;
@@ -477,13 +977,10 @@ void pbuf_insert(struct pbuf *playout_buf, rtp_packet * pkt)
                         } else {
                                 debug_msg
                                     ("A packet for a previous frame, but might still be useful\n");
-                                struct pbuf_node *curr = playout_buf->last;
-                                while(curr != playout_buf->frst && curr->rtp_timestamp > pkt->ts){
-                                        curr = curr->prv;
-                                }
-                                if (curr->rtp_timestamp == pkt->ts) {
+                                struct pbuf_node *curr = frame_table_find(playout_buf, pkt->ts);
+                                if (curr != NULL) {
                                         /* Packet belongs to a previous existing frame... */
-                                        add_coded_unit(curr, pkt);
+                                        add_coded_unit(playout_buf, curr, pkt);
                                 } else {
                                         /* Packet belongs to a frame that is not present */
                                         discard_pkt = true;
@@ -494,22 +991,44 @@ void pbuf_insert(struct pbuf *playout_buf, rtp_packet * pkt)
                                         debug_msg
                                                 ("Oops... dropped packet with M bit set\n");
                                 }
-                                free(pkt);
+                                rtp_free_packet(pkt);
                         }
                 }
         }
         pbuf_validate(playout_buf);
 }
 
-static void free_cdata(struct coded_data *head)
+/// returns packets of a frame and its whole coded_data list to the pool
+static void free_cdata(struct pbuf *playout_buf, struct pbuf_node *node)
 {
-        struct coded_data *tmp;
-
-        while (head != NULL) {
-                free(head->data);
-                tmp = head;
-                head = head->nxt;
-                free(tmp);
+        struct coded_data *head = NULL;
+        struct coded_data *tail = NULL;
+        int count = 0;
+        void *pkts[PBUF_FREE_BATCH];
+        int pkt_count = 0;
+        for (uint16_t seq = node->min_seq;; ++seq) {
+                struct coded_data **slot = &node->pkts[seq & (node->pkts_cap - 1)];
+                if (*slot != NULL) {
+                        if (pkt_count == PBUF_FREE_BATCH) {
+                                rtp_free_packets(pkts, pkt_count);
+                                pkt_count = 0;
+                        }
+                        pkts[pkt_count++] = (*slot)->data;
+                        (*slot)->nxt = head;
+                        head = *slot;
+                        if (tail == NULL) {
+                                tail = head;
+                        }
+                        count += 1;
+                        *slot = NULL;
+                }
+                if (seq == node->max_seq) {
+                        break;
+                }
+        }
+        rtp_free_packets(pkts, pkt_count);
+        if (head != NULL) {
+                pbuf_pool_put_list(&playout_buf->cdata_pool, head, tail, count);
         }
 }
 
@@ -519,28 +1038,12 @@ void pbuf_remove(struct pbuf *playout_buf, time_ns_t curr_time)
         /* time from the playout buffer. Incomplete frames that have passed */
         /* their playout time are also discarded.                           */
 
-        struct pbuf_node *curr, *temp;
-
         pbuf_validate(playout_buf);
 
-        curr = playout_buf->frst;
-        while (curr != NULL) {
-                temp = curr->nxt;
+        while (playout_buf->frst != NULL) {
+                struct pbuf_node *curr = playout_buf->frst;
                 if (curr_time > curr->deletion_time && frame_complete(curr)) {
-                        if (curr == playout_buf->frst) {
-                                playout_buf->frst = curr->nxt;
-                        }
-                        if (curr == playout_buf->last) {
-                                playout_buf->last = curr->prv;
-                        }
-                        if (curr->nxt != NULL) {
-                                curr->nxt->prv = curr->prv;
-                        }
-                        if (curr->prv != NULL) {
-                                curr->prv->nxt = curr->nxt;
-                        }
-                        free_cdata(curr->cdata);
-                        free(curr);
+                        pbuf_drop_node(playout_buf, curr);
                 } else {
                         /* The playout buffer is stored in order, so once  */
                         /* we see one packet that has not yet reached it's */
@@ -548,7 +1051,6 @@ void pbuf_remove(struct pbuf *playout_buf, time_ns_t curr_time)
                         /* will have done so...                            */
                         break;
                 }
-                curr = temp;
         }
 
         pbuf_validate(playout_buf);
@@ -565,7 +1067,8 @@ static int frame_complete(struct pbuf_node *frame)
         /* the packets of a frame being present - perhaps we should  */
         /* keep a bit vector in pbuf_node? LG.  */
 
-        return (frame->mbit == 1 || frame->completed == true);
+        return (frame->mbit == 1 || frame->completed == true ||
+                frame->fec_complete);
 }
 
 int pbuf_is_empty(struct pbuf *playout_buf)
@@ -592,6 +1095,7 @@ pbuf_decode(struct pbuf *playout_buf, time_ns_t curr_time,
                         if (frame_complete(curr)) {
                                 struct pbuf_stats stats = { playout_buf->received_pkts_cum,
                                         playout_buf->expected_pkts_cum };
+                                link_cdata(curr);
                                 int ret = decode_func(curr->cdata, data, &stats);
                                 curr->decoded = 1;
                                 return ret;
@@ -614,3 +1118,61 @@ void pbuf_set_playout_delay(struct pbuf *playout_buf, double playout_delay)
         playout_buf->playout_delay_us = playout_delay * 1000 * 1000;
 }
 
+/**
+ * Adds packet loss statistics gathered since the last call to report and
+ * resets them.
+ */
+void pbuf_get_loss_report(struct pbuf *playout_buf, struct pbuf_loss_report *report)
+{
+        struct pbuf_loss_report *r = &playout_buf->loss_report;
+        report->expected += r->expected;
+        report->received += r->received;
+        for (int i = 0; i < PBUF_LOSS_BURST_BUCKETS; ++i) {
+                report->bursts[i] += r->bursts[i];
+        }
+        memset(r, 0, sizeof *r);
+}
+
+/**
+ * Returns sequence numbers of missing packets whose retransmission should be
+ * requested now (see rtp_send_nack()). A packet is requested again after
+ * NACK_RETRY_NS if it still has not arrived, as long as it can arrive before
+ * the playout time of its frame.
+ *
+ * Gap tracking starts with the first call, so that streams that do not use
+ * NACKs (eg. audio) are not affected.
+ *
+ * @param seqs  output array of max items, ascending (modulo 2^16)
+ * @returns     number of items written to seqs
+ */
+int pbuf_get_nacks(struct pbuf *playout_buf, time_ns_t curr_time,
+                   uint16_t *seqs, int max)
+{
+        if (playout_buf->nacks == NULL) {
+                playout_buf->nacks =
+                    malloc(NACK_MAX_PENDING * sizeof playout_buf->nacks[0]);
+                return 0;
+        }
+
+        int count = 0;
+        int kept = 0;
+        for (int i = 0; i < playout_buf->nack_count; ++i) {
+                struct pbuf_nack n = playout_buf->nacks[i];
+                if (!nack_is_pending(playout_buf, n.seq)) { // arrived
+                        continue;
+                }
+                if (n.tries == NACK_MAX_TRIES ||
+                    curr_time + NACK_MIN_SLACK_NS > n.deadline) {
+                        nack_set_pending(playout_buf, n.seq, false);
+                        continue;
+                }
+                if (n.due <= curr_time && count < max) {
+                        seqs[count++] = n.seq;
+                        n.tries += 1;
+                        n.due = curr_time + NACK_RETRY_NS;
+                }
+                playout_buf->nacks[kept++] = n;
+        }
+        playout_buf->nack_count = kept;
+        return count;
+}
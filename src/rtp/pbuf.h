@@ -92,6 +92,19 @@ struct pbuf_stats {
         long long int expected_pkts_cum;
 };
 
+enum { PBUF_LOSS_BURST_BUCKETS = 6 };
+
+/**
+ * Packet loss seen by the playout buffer, reported back to the sender by
+ * rtp_loss_report_app().
+ */
+struct pbuf_loss_report {
+        uint32_t expected;
+        uint32_t received;
+        /// count of loss bursts of length 1, 2-3, 4-7, 8-15, 16-31 and 32+
+        uint32_t bursts[PBUF_LOSS_BURST_BUCKETS];
+};
+
 /* The playout buffer */
 struct pbuf;
 
@@ -130,6 +143,9 @@ int 	 	 pbuf_decode(struct pbuf *playout_buf, time_ns_t curr_time,
                              //struct video_frame *framebuffer, int i, struct state_decoder *decoder);
 void		 pbuf_remove(struct pbuf *playout_buf, time_ns_t curr_time);
 void		 pbuf_set_playout_delay(struct pbuf *playout_buf, double playout_delay);
+void             pbuf_get_loss_report(struct pbuf *playout_buf, struct pbuf_loss_report *report);
+int              pbuf_get_nacks(struct pbuf *playout_buf, time_ns_t curr_time,
+                                uint16_t *seqs, int max);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,166 @@
+/**
+ * @file   rtp/received_extents.hpp
+ * @brief  bookkeeping of received byte ranges of a frame buffer
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RTP_RECEIVED_EXTENTS_HPP_5B0E9C3A_7D61_4F0B_9E27_C1A4D2F8E613
+#define RTP_RECEIVED_EXTENTS_HPP_5B0E9C3A_7D61_4F0B_9E27_C1A4D2F8E613
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * List of disjoint received byte ranges ("extents") of a buffer with a
+ * counter of received bytes.
+ *
+ * Packets arriving in order just extend the last extent, which is O(1)
+ * without any allocation once the capacity is reserved. Out-of-order packets
+ * are appended as well and the list is sorted and merged lazily by the first
+ * query, so adding stays O(1) and a frame with reordered packets is
+ * normalized only once, in O(n log n). Overlapping or duplicate packets are
+ * counted only once.
+ *
+ * @note Queries may modify the internal state so even const access must not
+ * be concurrent.
+ */
+class received_extents {
+public:
+        struct extent {
+                int start;
+                int end; ///< one past the last received byte
+        };
+
+        void reserve(size_t count) { m_extents.reserve(count); }
+        /// forgets received data, keeps the allocated capacity
+        void clear() {
+                m_extents.clear();
+                m_bytes = 0;
+                m_sorted = true;
+        }
+
+        /// records that len bytes starting at start were received
+        void add(int start, int len) {
+                if (len <= 0) {
+                        return;
+                }
+                const int end = start + len;
+                if (!m_extents.empty()) {
+                        extent &last = m_extents.back();
+                        if (start >= last.start && start <= last.end) {
+                                // extends (or overlaps) the last one
+                                if (end > last.end) {
+                                        m_bytes += end - last.end;
+                                        last.end = end;
+                                }
+                                return;
+                        }
+                        if (start < last.start) {
+                                m_sorted = false; // merged by normalize()
+                        }
+                }
+                m_extents.push_back({ start, end });
+                m_bytes += len;
+        }
+
+        /// @returns true if the whole range [start, start + len) was received
+        bool contains(int start, int len) const {
+                normalize();
+                auto it = std::upper_bound(
+                    m_extents.begin(), m_extents.end(), start,
+                    [](int val, const extent &e) { return val < e.start; });
+                if (it == m_extents.begin()) {
+                        return len <= 0;
+                }
+                --it;
+                return it->end >= start + len;
+        }
+
+        /// @returns number of distinct received bytes
+        int received_bytes() const {
+                normalize();
+                return m_bytes;
+        }
+        bool empty() const { return m_extents.empty(); }
+        size_t size() const {
+                normalize();
+                return m_extents.size();
+        }
+        const extent &operator[](size_t i) const {
+                normalize();
+                return m_extents[i];
+        }
+        std::vector<extent>::const_iterator begin() const {
+                normalize();
+                return m_extents.begin();
+        }
+        std::vector<extent>::const_iterator end() const {
+                normalize();
+                return m_extents.end();
+        }
+
+private:
+        /// sorts the extents and merges overlapping or adjacent ones
+        void normalize() const {
+                if (m_sorted) {
+                        return;
+                }
+                std::sort(m_extents.begin(), m_extents.end(),
+                          [](const extent &a, const extent &b) {
+                                  return a.start < b.start;
+                          });
+                size_t out = 0;
+                m_bytes = 0;
+                for (size_t i = 1; i < m_extents.size(); ++i) {
+                        if (m_extents[i].start <= m_extents[out].end) {
+                                m_extents[out].end = std::max(
+                                    m_extents[out].end, m_extents[i].end);
+                        } else {
+                                m_bytes += m_extents[out].end -
+                                           m_extents[out].start;
+                                m_extents[++out] = m_extents[i];
+                        }
+                }
+                m_bytes += m_extents[out].end - m_extents[out].start;
+                m_extents.resize(out + 1);
+                m_sorted = true;
+        }
+
+        mutable std::vector<extent> m_extents;
+        mutable int m_bytes = 0;
+        mutable bool m_sorted = true;
+};
+
+#endif // defined RTP_RECEIVED_EXTENTS_HPP_5B0E9C3A_7D61_4F0B_9E27_C1A4D2F8E613
@@ -40,18 +40,19 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
-#include <stdexcept>
 
 #include "config.h"
 #include "debug.h"
+#include "host.h"
+#include "rtp/received_extents.hpp"
 #include "rtp/rs.h"
+#include "rtp/rs_simd.h"
 #include "rtp/rtp_types.h"
 #include "transmit.h"
 #include "utils/color_out.h"
+#include "utils/misc.h"
 #include "utils/text.h"
-#ifdef HAVE_ZFEC
-#include "video_frame.h" // IWYU prag
-#endif
+#include "video_frame.h"
 
 enum {
         DEFAULT_K_AUDIO = 160,
@@ -64,22 +65,15 @@ enum {
 
 #define MOD_NAME "[fec/rs] "
 
-#ifdef HAVE_ZFEC
-extern "C" {
-#ifndef _MSC_VER
-#define restrict __restrict
-#endif
-#include <fec.h>
-}
-#endif
-
 static void usage();
 
 using std::shared_ptr;
 
+ADD_TO_PARAM("rs-threads", "* rs-threads=<n>|auto\n"
+                "  number of threads used for Reed-Solomon coding (default auto)\n");
+
 /**
- * Constructs RS state. Since this constructor is currently used only for the decoder,
- * it allows creation of dummy state even if zfec was not compiled in.
+ * Constructs RS state (used by the decoder).
  */
 rs::rs(unsigned int k, unsigned int n)
         : m_k(k), m_n(n)
@@ -87,12 +81,7 @@ rs::rs(unsigned int k, unsigned int n)
         assert (k <= MAX_K);
         assert (n <= MAX_N);
         assert (m_k <= m_n);
-#ifdef HAVE_ZFEC
-        state = fec_new(m_k, m_n);
-        assert(state != NULL);
-#else
-        LOG(LOG_LEVEL_ERROR) << "zfec support is not compiled in, error correction is disabled\n";
-#endif
+        init_state();
 }
 
 rs::rs(const char *c_cfg, bool is_audio)
@@ -124,28 +113,30 @@ rs::rs(const char *c_cfg, bool is_audio)
                 throw 1;
         }
 
-#ifdef HAVE_ZFEC
-        state = fec_new(m_k, m_n);
-        assert(state != NULL);
-        MSG(INFO, "Using Reed-Solomon with k=%u n=%u\n", m_k, m_n);
-#else
-        throw std::runtime_error("zfec support is not compiled in");
-#endif
+        init_state();
+        MSG(INFO, "Using Reed-Solomon with k=%u n=%u (%s)\n", m_k, m_n,
+            gf256_best_isa());
+}
+
+void rs::init_state()
+{
+        state = rs_code_new(m_k, m_n);
+        assert(state != nullptr);
+        const char *threads = get_commandline_param("rs-threads");
+        rs_code_set_threads(state, threads == nullptr || strcmp(threads, "auto") == 0
+                                           ? get_cpu_core_count()
+                                           : atoi(threads));
 }
 
 rs::~rs()
 {
-#ifdef HAVE_ZFEC
-        if (state != nullptr) {
-                fec_free((fec_t *) state);
-        }
-#endif
+        rs_code_destroy(state);
 }
 
 /**
  * Returns symbol size (?) for given headers len and with configured m_k
  */
-[[maybe_unused]] static unsigned
+static unsigned
 get_ss(int hdr_len, int len, int k)
 {
         return ((sizeof(uint32_t) + hdr_len + len) + k - 1) / k;
@@ -154,10 +145,17 @@ get_ss(int hdr_len, int len, int k)
 struct video_frame *
 rs::encode_video_frame(const struct video_frame *in)
 {
-#ifdef HAVE_ZFEC
+        struct video_frame *out = encode_video_frame_systematic(in);
+        encode_video_frame_parity(out);
+        return out;
+}
+
+struct video_frame *
+rs::encode_video_frame_systematic(const struct video_frame *in)
+{
         assert(state != nullptr);
 
-        video_payload_hdr_t hdr;
+        video_payload_hdr_t hdr{}; // word 1 (offset) is unused here
         format_video_header(in, 0, 0, hdr);
         const size_t hdr_len = sizeof(hdr);
 
@@ -168,7 +166,6 @@ rs::encode_video_frame(const struct video_frame *in)
         for (unsigned i = 0; i < in->tile_count; ++i) {
                 size_t len = in->tiles[i].data_len;
                 char *data = in->tiles[i].data;
-                //int encode(char *hdr, int hdr_len, char *in, int len, char **out) {
                 unsigned ss = get_ss(hdr_len, len, m_k);
                 int buffer_len = ss * m_n;
                 char *out_data;
@@ -179,31 +176,6 @@ rs::encode_video_frame(const struct video_frame *in)
                 memcpy(out_data + sizeof(len32) + hdr_len, data, len);
                 memset(out_data + sizeof(len32) + hdr_len + len, 0, ss * m_k - (sizeof(len32) + hdr_len + len));
 
-#if 0
-                void *src[MAX_K];
-                for (int k = 0; k < m_k; ++k) {
-                        src[k] = *out + ss * k;
-                }
-
-                for (int m = 0; m < m_n - m_k; ++m) {
-                        fec_encode(state, src, *out + ss * (m_k + m), m, ss);
-                }
-#else
-                void *src[MAX_K];
-                for (unsigned int k = 0; k < m_k; ++k) {
-                        src[k] = out_data + ss * k;
-                }
-                void *dst[MAX_N];
-                unsigned int dst_idx[MAX_N];
-                for (unsigned int m = 0; m < m_n-m_k; ++m) {
-                        dst[m] = out_data + ss * (m_k + m);
-                        dst_idx[m] = m_k + m;
-                }
-
-                fec_encode((const fec_t *)state, (gf **) src,
-                                (gf **) dst, dst_idx, m_n-m_k, ss);
-#endif
-
                 out->tiles[i].data_len = buffer_len;
                 out->fec_params        = fec_desc{ .type        = FEC_RS,
                                                    .k           = m_k,
@@ -214,15 +186,32 @@ rs::encode_video_frame(const struct video_frame *in)
         }
 
         return out;
-#else
-        (void) in;
-        return {};
-#endif // defined HAVE_ZFEC
+}
+
+void
+rs::encode_video_frame_parity(struct video_frame *out)
+{
+        for (unsigned i = 0; i < out->tile_count; ++i) {
+                char *out_data = out->tiles[i].data;
+                const unsigned ss = out->tiles[i].data_len / m_n;
+
+                const uint8_t *src[MAX_K];
+                for (unsigned int k = 0; k < m_k; ++k) {
+                        src[k] = (uint8_t *) out_data + ss * k;
+                }
+                uint8_t *dst[MAX_N];
+                unsigned int dst_idx[MAX_N];
+                for (unsigned int m = 0; m < m_n-m_k; ++m) {
+                        dst[m] = (uint8_t *) out_data + ss * (m_k + m);
+                        dst_idx[m] = m_k + m;
+                }
+
+                rs_code_encode(state, src, dst, dst_idx, m_n - m_k, ss);
+        }
 }
 
 audio_frame2 rs::encode(const audio_frame2 &in)
 {
-#ifdef HAVE_ZFEC
         audio_frame2 out;
         out.init(in.get_channel_count(), in.get_codec(), in.get_bps(), in.get_sample_rate());
         out.reserve(3 * in.get_data_len() / in.get_channel_count()); // just an estimate
@@ -250,35 +239,30 @@ audio_frame2 rs::encode(const audio_frame2 &in)
                                                 .seed        = 0,
                                                 .symbol_size = ss });
 
-                void *src[MAX_K];
+                const uint8_t *src[MAX_K];
                 for (unsigned int k = 0; k < m_k; ++k) {
-                        src[k] = out.get_data(i) + ss * k;
+                        src[k] = (uint8_t *) out.get_data(i) + ss * k;
                 }
 
-                void *dst[MAX_N];
+                uint8_t *dst[MAX_N];
                 unsigned int dst_idx[MAX_N];
                 for (unsigned int m = 0; m < m_n-m_k; ++m) {
-                        dst[m] = out.get_data(i) + ss * (m_k + m);
+                        dst[m] = (uint8_t *) out.get_data(i) + ss * (m_k + m);
                         dst_idx[m] = m_k + m;
                 }
 
-                fec_encode((const fec_t *)state, (gf **) src,
-                                (gf **) dst, dst_idx, m_n-m_k, ss);
+                rs_code_encode(state, src, dst, dst_idx, m_n - m_k, ss);
         }
 
         return out;
-#else
-        (void) in;
-        return {};
-#endif // defined HAVE_ZFEC
 }
 
 /**
  * @returns stored buffer data length or 0 if first packet (header) is missing
  */
-uint32_t rs::get_buf_len(const char *buf, std::map<int, int> const & c_m)
+uint32_t rs::get_buf_len(const char *buf, received_extents const & packets)
 {
-        if (auto it = c_m.find(0); it != c_m.end() && it->second >= 4) {
+        if (packets.contains(0, sizeof(uint32_t))) {
                 uint32_t out_sz;
                 memcpy(&out_sz, buf, sizeof(out_sz));
                 return out_sz;
@@ -287,97 +271,36 @@ uint32_t rs::get_buf_len(const char *buf, std::map<int, int> const & c_m)
 }
 
 bool rs::decode(char *in, int in_len, char **out, int *len,
-                std::map<int, int> const & c_m)
+                received_extents const & m)
 {
-        std::map<int, int> m = c_m; // make private copy
         unsigned int ss = in_len / m_n;
 
-        // compact neighbouring segments
-        for (auto it = m.begin(); it != m.end(); ++it) {
-                int start = it->first;
-                int size = it->second;
-
-                auto neighbour = m.end();
-                while ((neighbour = m.find(start + size)) != m.end()) {
-                        it->second += neighbour->second;
-                        size = it->second;
-                        m.erase(neighbour);
-                }
-        }
-
-        if (state == nullptr) { // zfec was not compiled in - dummy mode
-                *len = get_buf_len(in, c_m);
-                *out = (char *) in + sizeof(uint32_t);
-                auto fst_sgmt = m.find(0);
-                return fst_sgmt != m.end() && (unsigned) fst_sgmt->second >= ss * m_k;
-        }
-
-#ifdef HAVE_ZFEC
+        // received extents are already compacted (neighbouring segments merged)
         assert(m_n <= MAX_N);
-        void *pkt[MAX_N];
+        const uint8_t *pkt[MAX_N];
         unsigned int index[MAX_N];
         unsigned int i = 0;
-#if 0
-
-        ///fprintf(stderr, "%d\n\n%d\n%d\n", in_len, malloc_usable_size((void *)in), sizeof(short));
-
-
-        for (auto it = m.begin(); it != m.end(); ++it) {
-                int start = it->first;
-                int offset = it->second;
-
-                int first_symbol_start = (start + ss - 1) / ss * ss;
-                int last_symbol_end = (start + offset) / ss * ss;
-                //fprintf(stderr, "%d %d %d\n", first_symbol_start, last_symbol_end, start);
-                for (int j = first_symbol_start; j < last_symbol_end; j += ss) {
-                        //fprintf(stderr, "%d\n", j);
-                        pkt[i] = (void *) (in + j);
-                        index[i] = j / ss;
-                        i++;
-                        if (i == m_k) break;
-                }
-                if (i == m_k) break;
-        }
-
-        if (i != m_k) {
-                *len = 0;
-                return;
-        }
-
-        assert (i == m_k);
-
-        int ret = fec_decode(state, pkt, index, ss);
-        if (ret != 0) {
-                *len = 0;
-                return;
-        }
-        uint32_t out_sz;
-        memcpy(&out_sz,  pkt[0], sizeof(out_sz));
-        fprintf(stderr, "%d %d\n\n", out_sz, index[0]);
-        *len = out_sz;
-        *out = (char *) in + 4;
-#else
         //const unsigned int bitset_size = m_k;
 
         std::bitset<MAX_K> empty_slots;
         std::bitset<MAX_K> repaired_slots;
 
         for (auto it = m.begin(); it != m.end(); ++it) {
-                int start = it->first;
-                int size = it->second;
+                int start = it->start;
+                int size = it->end - it->start;
 
                 unsigned int first_symbol_start = (start + ss - 1) / ss * ss;
                 unsigned int last_symbol_end = (start + size) / ss * ss;
                 for (unsigned int j = first_symbol_start; j < last_symbol_end; j += ss) {
                         if (j/ss < m_k) {
-                                pkt[j/ss] = in + j;
+                                pkt[j/ss] = (uint8_t *) in + j;
                                 index[j/ss] = j/ss;
                                 empty_slots.set(j/ss);
                                 //fprintf(stderr, "%d\n", j/ss);
                         } else {
                                 for (unsigned int k = 0; k < m_k; ++k) {
                                         if (!empty_slots.test(k)) {
-                                                pkt[k] = in + j;
+                                                pkt[k] = (uint8_t *) in + j;
                                                 index[k] = j/ss;
                                                 //fprintf(stderr, "%d\n", j/ss);
                                                 empty_slots.set(k);
@@ -397,39 +320,32 @@ bool rs::decode(char *in, int in_len, char **out, int *len,
         //fprintf(stderr, "       %d\n", i);
 
         if (i != m_k) {
-                *len = get_buf_len(in, c_m);
+                *len = get_buf_len(in, m);
                 *out = (char *) in + sizeof(uint32_t);
                 return false;
         }
 
-        char **output = (char **) malloc(m_k * sizeof(char *));
-        for (unsigned int i = 0; i < m_k; ++i) {
-                output[i] = (char *) malloc(ss);
-        }
-
-        fec_decode((const fec_t *) state, (const gf *const *) pkt,
-                        (gf *const *) output, index, ss);
-
+        // missing primary symbols are reconstructed directly in place - their
+        // slots are not used as an input (parity symbols are)
+        uint8_t *output[MAX_K];
         i = 0;
         for (unsigned int j = 0; j < m_k; ++j) {
                 if (repaired_slots.test(j)) {
-                        memcpy((void *) (in + j * ss), output[i], ss);
-                        i++;
+                        output[i++] = (uint8_t *) in + j * ss;
                 }
         }
 
-        for (unsigned int i = 0; i < m_k; ++i) {
-                free(output[i]);
+        if (!rs_code_decode(state, pkt, output, index, ss)) {
+                *len = get_buf_len(in, m);
+                *out = (char *) in + sizeof(uint32_t);
+                return false;
         }
-        free(output);
 
         uint32_t out_sz;
         memcpy(&out_sz, in, sizeof(out_sz));
         //fprintf(stderr, "       %d\n", out_sz);
         *len = out_sz;
         *out = (char *) in + sizeof(uint32_t);
-#endif
-#endif // defined HAVE_ZFEC
 
         return true;
 }
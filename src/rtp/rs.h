@@ -39,11 +39,11 @@
 #define __RS_H__
 
 #include <cstdint>
-#include <map>
 #include <memory>
 
 #include "fec.h"
 
+struct rs_code;
 struct video_frame;
 
 struct rs : public fec {
@@ -53,14 +53,18 @@ struct rs : public fec {
 
         struct video_frame *
         encode_video_frame(const struct video_frame *video_frame) override;
+        struct video_frame *
+        encode_video_frame_systematic(const struct video_frame *) override;
+        void encode_video_frame_parity(struct video_frame *) override;
 
         virtual audio_frame2 encode(audio_frame2 const &) override;
         bool decode(char *in, int in_len, char **out, int *len,
-                const std::map<int, int> &) override;
+                const received_extents &) override;
 
 private:
-        uint32_t get_buf_len(const char *buf, std::map<int, int> const & c_m);
-        void *state = nullptr;
+        void init_state();
+        uint32_t get_buf_len(const char *buf, received_extents const & packets);
+        struct rs_code *state = nullptr;
         unsigned int m_k, m_n;
 };
 
@@ -0,0 +1,314 @@
+/**
+ * @file   rtp/rs_bench.c
+ * @brief  Throughput benchmark of Reed-Solomon coding
+ *
+ * Measures encoding and decoding (with n-k lost primary symbols) for the
+ * kernels of the in-tree engine and for zfec if it was compiled in.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rtp/rs_simd.h"
+#include "tv.h"
+#include "utils/macros.h"
+#include "utils/misc.h" // for get_cpu_core_count
+
+#ifdef HAVE_ZFEC
+#include <fec.h>
+#endif
+
+enum {
+        MAX_ITEMS = 16,
+        MAX_N     = 255,
+};
+
+struct kn {
+        unsigned k, n;
+};
+
+static void
+usage(const char *progname)
+{
+        printf("Usage:\n\t%s [-c <k:n>[,...]] [-s <symbol_size>[,...]] "
+               "[-t <threads>[,...]] [-n <iter>]\n\n",
+               progname);
+        printf("\t-c - code parameters (default 200:240,160:240)\n"
+               "\t-s - symbol sizes in bytes, suffix k allowed (default "
+               "1k,8k,80k)\n"
+               "\t-t - thread counts, 0 means all cores (default 1,0)\n"
+               "\t-n - iterations per combination (default 20)\n");
+}
+
+static int
+parse_list(const char *str, long *out, bool allow_k)
+{
+        char *copy = strdup(str);
+        char *save_ptr = NULL;
+        int   count    = 0;
+        for (char *item = strtok_r(copy, ",", &save_ptr);
+             item != NULL && count < MAX_ITEMS;
+             item = strtok_r(NULL, ",", &save_ptr)) {
+                char *end    = NULL;
+                out[count] = strtol(item, &end, 10);
+                if (allow_k && (*end == 'k' || *end == 'K')) {
+                        out[count] *= 1000;
+                }
+                count++;
+        }
+        free(copy);
+        return count;
+}
+
+/// @returns throughput in GB/s of the source data
+static double
+gbps(size_t bytes, int iterations, time_ns_t dur)
+{
+        return (double) bytes * iterations / (double) MAX(dur, 1);
+}
+
+struct bench_buffers {
+        uint8_t       *data;
+        const uint8_t *src[MAX_N];
+        uint8_t       *parity[MAX_N];
+        unsigned       parity_idx[MAX_N];
+        const uint8_t *in[MAX_N];
+        unsigned       index[MAX_N];
+        uint8_t       *out[MAX_N];
+        int            lost;
+};
+
+/**
+ * Prepares encoder pointers and decoder inputs - first min(k, n-k)
+ * primary symbols are replaced by parity.
+ */
+static void
+bench_buffers_init(struct bench_buffers *b, struct kn p, size_t ss)
+{
+        b->data = malloc((p.n + p.k) * ss);
+        for (size_t i = 0; i < p.k * ss; ++i) {
+                b->data[i] = rand();
+        }
+        for (unsigned i = 0; i < p.k; ++i) {
+                b->src[i] = b->data + i * ss;
+        }
+        for (unsigned i = 0; i < p.n - p.k; ++i) {
+                b->parity[i]     = b->data + (p.k + i) * ss;
+                b->parity_idx[i] = p.k + i;
+        }
+        b->lost = 0;
+        for (unsigned i = 0; i < p.k; ++i) {
+                if (i < p.n - p.k) {
+                        b->in[i]    = b->parity[i];
+                        b->index[i] = p.k + i;
+                        b->out[b->lost++] = b->data + (p.n + i) * ss;
+                } else {
+                        b->in[i]    = b->src[i];
+                        b->index[i] = i;
+                }
+        }
+}
+
+static bool
+verify(const struct bench_buffers *b, size_t ss)
+{
+        for (int i = 0; i < b->lost; ++i) {
+                if (memcmp(b->out[i], b->src[i], ss) != 0) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+static void
+print_row(struct kn p, size_t ss, int threads, const char *impl, double enc,
+          double dec, bool ok)
+{
+        char kn_str[16];
+        snprintf(kn_str, sizeof kn_str, "%u:%u", p.k, p.n);
+        printf("%8s %8zu %4d %8s %12.2f %12.2f %4s\n", kn_str, ss, threads,
+               impl, enc, dec, ok ? "ok" : "FAIL");
+        fflush(stdout);
+}
+
+static void
+bench_engine(struct kn p, size_t ss, int threads, const char *isa,
+             int iterations)
+{
+        struct rs_code *code = rs_code_new(p.k, p.n);
+        if (!rs_code_set_isa(code, isa)) {
+                rs_code_destroy(code);
+                return;
+        }
+        rs_code_set_threads(code, threads);
+        struct bench_buffers b;
+        bench_buffers_init(&b, p, ss);
+
+        time_ns_t t0 = get_time_in_ns();
+        for (int i = 0; i < iterations; ++i) {
+                rs_code_encode(code, b.src, b.parity, b.parity_idx,
+                               p.n - p.k, ss);
+        }
+        const double enc = gbps(p.k * ss, iterations, get_time_in_ns() - t0);
+        bool ok = true;
+        t0 = get_time_in_ns();
+        for (int i = 0; i < iterations; ++i) {
+                ok = rs_code_decode(code, b.in, b.out, b.index, ss) && ok;
+        }
+        const double dec = gbps(p.k * ss, iterations, get_time_in_ns() - t0);
+        print_row(p, ss, threads, isa, enc, dec, ok && verify(&b, ss));
+        free(b.data);
+        rs_code_destroy(code);
+}
+
+#ifdef HAVE_ZFEC
+static void
+bench_zfec(struct kn p, size_t ss, int iterations)
+{
+#ifdef HAVE_FEC_INIT
+        fec_init();
+#endif
+        fec_t *code = fec_new(p.k, p.n);
+        struct bench_buffers b;
+        bench_buffers_init(&b, p, ss);
+
+        time_ns_t t0 = get_time_in_ns();
+        for (int i = 0; i < iterations; ++i) {
+                fec_encode(code, (const gf *const *) b.src,
+                           (gf *const *) b.parity, b.parity_idx, p.n - p.k,
+                           ss);
+        }
+        const double enc = gbps(p.k * ss, iterations, get_time_in_ns() - t0);
+        t0 = get_time_in_ns();
+        for (int i = 0; i < iterations; ++i) {
+                fec_decode(code, (const gf *const *) b.in,
+                           (gf *const *) b.out, b.index, ss);
+        }
+        const double dec = gbps(p.k * ss, iterations, get_time_in_ns() - t0);
+        print_row(p, ss, 1, "zfec", enc, dec, verify(&b, ss));
+        free(b.data);
+        fec_free(code);
+}
+#endif // defined HAVE_ZFEC
+
+int
+main(int argc, char *argv[])
+{
+        struct kn params[MAX_ITEMS] = { { 200, 240 }, { 160, 240 } };
+        int       param_count       = 2;
+        long      sizes[MAX_ITEMS]  = { 1000, 8000, 80000 };
+        int       size_count        = 3;
+        long      threads[MAX_ITEMS] = { 1, 0 };
+        int       thread_count       = 2;
+        int       iterations         = 20;
+
+        int opt = 0;
+        while ((opt = getopt(argc, argv, "c:hn:s:t:")) != -1) {
+                switch (opt) {
+                case 'c': {
+                        param_count = 0;
+                        char *copy = strdup(optarg);
+                        char *save_ptr = NULL;
+                        for (char *item = strtok_r(copy, ",", &save_ptr);
+                             item != NULL && param_count < MAX_ITEMS;
+                             item = strtok_r(NULL, ",", &save_ptr)) {
+                                struct kn p = { 0 };
+                                if (sscanf(item, "%u:%u", &p.k, &p.n) != 2 ||
+                                    p.k == 0 || p.k >= p.n || p.n > MAX_N) {
+                                        fprintf(stderr, "Wrong code: %s\n", item);
+                                        free(copy);
+                                        return 1;
+                                }
+                                params[param_count++] = p;
+                        }
+                        free(copy);
+                        break;
+                }
+                case 'n':
+                        iterations = atoi(optarg);
+                        break;
+                case 's':
+                        size_count = parse_list(optarg, sizes, true);
+                        break;
+                case 't':
+                        thread_count = parse_list(optarg, threads, false);
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return 0;
+                default:
+                        usage(argv[0]);
+                        return 1;
+                }
+        }
+        if (iterations <= 0) {
+                usage(argv[0]);
+                return 1;
+        }
+
+        printf("best kernel: %s, throughput of source data in GB/s, decoding "
+               "recovers n-k primary symbols\n\n", gf256_best_isa());
+        printf("%8s %8s %4s %8s %12s %12s %4s\n", "k:n", "symbol", "thr",
+               "impl", "enc [GB/s]", "dec [GB/s]", "");
+        for (int c = 0; c < param_count; ++c) {
+                for (int s = 0; s < size_count; ++s) {
+                        if (sizes[s] <= 0) {
+                                continue;
+                        }
+#ifdef HAVE_ZFEC
+                        bench_zfec(params[c], sizes[s], iterations);
+#endif
+                        for (int t = 0; t < thread_count; ++t) {
+                                const int thr = threads[t] <= 0
+                                                    ? get_cpu_core_count()
+                                                    : (int) threads[t];
+                                for (int i = 0; i < 3; ++i) {
+                                        const char *isa = (const char *[]){
+                                                "scalar", "ssse3", "avx2" }[i];
+                                        bench_engine(params[c], sizes[s], thr,
+                                                     isa, iterations);
+                                }
+                        }
+                }
+        }
+        return 0;
+}
@@ -0,0 +1,550 @@
+/**
+ * @file   rtp/rs_simd.c
+ * @brief  Reed-Solomon erasure code over GF(2^8) with SIMD kernels
+ *
+ * Multiplication by a constant uses split-nibble lookups: c*x equals
+ * lo[c][x & 0xf] ^ hi[c][x >> 4], so 16-entry tables fit into a vector
+ * register and PSHUFB performs 16 (SSSE3) or 32 (AVX2) lookups at once.
+ * The kernels compute a whole row of the coding matrix (a dot product of
+ * coefficients and source symbols) with the accumulator kept in registers.
+ *
+ * The encoding matrix is built the same way as in zfec (Vandermonde rows
+ * made systematic by multiplying with the inverse of the top square), so
+ * the parity symbols are bit-exact with it.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp/rs_simd.h"
+#include "utils/macros.h" // for MAX_CPU_CORES
+#include "utils/worker.h"
+
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define GF256_X86 1
+#include <immintrin.h>
+#endif
+
+enum {
+        GF_POLY      = 0x11d, ///< x^8 + x^4 + x^3 + x^2 + 1 (same as zfec)
+        /// column stripe processed for all rows before moving on, so that
+        /// the source stripes stay in cache
+        STRIPE_LEN   = 2048,
+        /// minimal amount of source data read per worker
+        MIN_WORK_PER_WORKER = 256 * 1024,
+        VEC_ALIGN    = 64,
+};
+
+static uint8_t gf_exp[2 * 255];
+static uint8_t gf_log[256];
+static uint8_t gf_mul_table[256][256];
+/// [c][0][x] = c * x, [c][1][x] = c * (x << 4)
+static _Alignas(16) uint8_t gf_nib[256][2][16];
+static pthread_once_t gf_init_once = PTHREAD_ONCE_INIT;
+
+struct rs_code {
+        unsigned         k;
+        unsigned         n;
+        uint8_t         *enc_matrix; ///< n x k, top k rows are identity
+        gf256_dot_func_t dot;
+        int              threads;
+};
+
+static void
+gf_init(void)
+{
+        unsigned x = 1;
+        for (int i = 0; i < 255; ++i) {
+                gf_exp[i] = gf_exp[i + 255] = x;
+                gf_log[x] = i;
+                x <<= 1;
+                if (x & 0x100) {
+                        x ^= GF_POLY;
+                }
+        }
+        for (int a = 0; a < 256; ++a) {
+                for (int b = 0; b < 256; ++b) {
+                        gf_mul_table[a][b] =
+                            a == 0 || b == 0
+                                ? 0
+                                : gf_exp[gf_log[a] + gf_log[b]];
+                }
+                for (int i = 0; i < 16; ++i) {
+                        gf_nib[a][0][i] = gf_mul_table[a][i];
+                        gf_nib[a][1][i] = gf_mul_table[a][i << 4];
+                }
+        }
+}
+
+static inline uint8_t
+gf_mul(uint8_t a, uint8_t b)
+{
+        return gf_mul_table[a][b];
+}
+
+static inline uint8_t
+gf_inv(uint8_t a)
+{
+        assert(a != 0);
+        return gf_exp[255 - gf_log[a]];
+}
+
+/*
+ * Kernels. dst may be identical to src[j] (in-place row update), which is
+ * why every variant reads all sources of a block before storing it.
+ */
+
+static void
+gf256_dot_scalar(uint8_t *dst, const uint8_t *const *src, const uint8_t *coefs,
+                 int count, size_t off, size_t len)
+{
+        uint8_t acc[VEC_ALIGN];
+        for (size_t i = 0; i < len; i += sizeof acc) {
+                const size_t block = MIN(sizeof acc, len - i);
+                memset(acc, 0, block);
+                for (int j = 0; j < count; ++j) {
+                        const uint8_t *mul = gf_mul_table[coefs[j]];
+                        const uint8_t *s   = src[j] + off + i;
+                        for (size_t b = 0; b < block; ++b) {
+                                acc[b] ^= mul[s[b]];
+                        }
+                }
+                memcpy(dst + off + i, acc, block);
+        }
+}
+
+#ifdef GF256_X86
+__attribute__((target("ssse3"))) static void
+gf256_dot_ssse3(uint8_t *dst, const uint8_t *const *src, const uint8_t *coefs,
+                int count, size_t off, size_t len)
+{
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        size_t        i    = 0;
+        for (; i + 32 <= len; i += 32) {
+                __m128i acc0 = _mm_setzero_si128();
+                __m128i acc1 = _mm_setzero_si128();
+                for (int j = 0; j < count; ++j) {
+                        const uint8_t *s = src[j] + off + i;
+                        const __m128i tlo =
+                            _mm_load_si128((const __m128i *) gf_nib[coefs[j]][0]);
+                        const __m128i thi =
+                            _mm_load_si128((const __m128i *) gf_nib[coefs[j]][1]);
+                        const __m128i x0 = _mm_loadu_si128((const __m128i *) s);
+                        const __m128i x1 =
+                            _mm_loadu_si128((const __m128i *) (s + 16));
+                        acc0 = _mm_xor_si128(
+                            acc0, _mm_xor_si128(
+                                      _mm_shuffle_epi8(tlo, _mm_and_si128(x0, mask)),
+                                      _mm_shuffle_epi8(
+                                          thi, _mm_and_si128(_mm_srli_epi16(x0, 4),
+                                                             mask))));
+                        acc1 = _mm_xor_si128(
+                            acc1, _mm_xor_si128(
+                                      _mm_shuffle_epi8(tlo, _mm_and_si128(x1, mask)),
+                                      _mm_shuffle_epi8(
+                                          thi, _mm_and_si128(_mm_srli_epi16(x1, 4),
+                                                             mask))));
+                }
+                _mm_storeu_si128((__m128i *) (dst + off + i), acc0);
+                _mm_storeu_si128((__m128i *) (dst + off + i + 16), acc1);
+        }
+        gf256_dot_scalar(dst, src, coefs, count, off + i, len - i);
+}
+
+__attribute__((target("avx2"))) static void
+gf256_dot_avx2(uint8_t *dst, const uint8_t *const *src, const uint8_t *coefs,
+               int count, size_t off, size_t len)
+{
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+        size_t        i    = 0;
+        for (; i + 64 <= len; i += 64) {
+                __m256i acc0 = _mm256_setzero_si256();
+                __m256i acc1 = _mm256_setzero_si256();
+                for (int j = 0; j < count; ++j) {
+                        const uint8_t *s   = src[j] + off + i;
+                        const __m256i  tlo = _mm256_broadcastsi128_si256(
+                            _mm_load_si128((const __m128i *) gf_nib[coefs[j]][0]));
+                        const __m256i thi = _mm256_broadcastsi128_si256(
+                            _mm_load_si128((const __m128i *) gf_nib[coefs[j]][1]));
+                        const __m256i x0 =
+                            _mm256_loadu_si256((const __m256i *) s);
+                        const __m256i x1 =
+                            _mm256_loadu_si256((const __m256i *) (s + 32));
+                        acc0 = _mm256_xor_si256(
+                            acc0,
+                            _mm256_xor_si256(
+                                _mm256_shuffle_epi8(tlo, _mm256_and_si256(x0, mask)),
+                                _mm256_shuffle_epi8(
+                                    thi, _mm256_and_si256(_mm256_srli_epi16(x0, 4),
+                                                          mask))));
+                        acc1 = _mm256_xor_si256(
+                            acc1,
+                            _mm256_xor_si256(
+                                _mm256_shuffle_epi8(tlo, _mm256_and_si256(x1, mask)),
+                                _mm256_shuffle_epi8(
+                                    thi, _mm256_and_si256(_mm256_srli_epi16(x1, 4),
+                                                          mask))));
+                }
+                _mm256_storeu_si256((__m256i *) (dst + off + i), acc0);
+                _mm256_storeu_si256((__m256i *) (dst + off + i + 32), acc1);
+        }
+        gf256_dot_ssse3(dst, src, coefs, count, off + i, len - i);
+}
+#endif // defined GF256_X86
+
+/**
+ * @returns kernel for the given instruction set ("avx2", "ssse3" or "scalar")
+ * or the best one supported by the CPU if isa is NULL; NULL if the ISA is
+ * unknown or unsupported
+ */
+gf256_dot_func_t
+gf256_dot_get(const char *isa)
+{
+        pthread_once(&gf_init_once, gf_init);
+        if (isa == NULL) {
+                isa = gf256_best_isa();
+        }
+        if (strcmp(isa, "scalar") == 0) {
+                return gf256_dot_scalar;
+        }
+#ifdef GF256_X86
+        __builtin_cpu_init();
+        if (strcmp(isa, "ssse3") == 0 && __builtin_cpu_supports("ssse3")) {
+                return gf256_dot_ssse3;
+        }
+        if (strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+                return gf256_dot_avx2;
+        }
+#endif
+        return NULL;
+}
+
+const char *
+gf256_best_isa(void)
+{
+#ifdef GF256_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+                return "avx2";
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+                return "ssse3";
+        }
+#endif
+        return "scalar";
+}
+
+/**
+ * Inverts k x k matrix in place by Gauss-Jordan elimination.
+ * @retval false if the matrix is singular
+ */
+static bool
+gf_invert(gf256_dot_func_t dot, uint8_t *m, int k)
+{
+        // augmented [m | I], rows are updated with the dot kernel as
+        // row_r = 1 * row_r + f * row_col
+        const int w   = 2 * k;
+        uint8_t  *aug = calloc((size_t) k * w, 1);
+        for (int r = 0; r < k; ++r) {
+                memcpy(aug + r * w, m + r * k, k);
+                aug[r * w + k + r] = 1;
+        }
+        bool ret = true;
+        for (int col = 0; col < k && ret; ++col) {
+                int piv = col;
+                while (piv < k && aug[piv * w + col] == 0) {
+                        piv++;
+                }
+                if (piv == k) {
+                        ret = false;
+                        break;
+                }
+                uint8_t *prow = aug + col * w;
+                if (piv != col) {
+                        for (int c = 0; c < w; ++c) {
+                                const uint8_t tmp = prow[c];
+                                prow[c]           = aug[piv * w + c];
+                                aug[piv * w + c]  = tmp;
+                        }
+                }
+                const uint8_t scale = gf_inv(prow[col]);
+                const uint8_t *src[] = { prow };
+                dot(prow, src, &scale, 1, 0, w);
+                for (int r = 0; r < k; ++r) {
+                        uint8_t *row = aug + r * w;
+                        if (r == col || row[col] == 0) {
+                                continue;
+                        }
+                        const uint8_t *rsrc[]   = { row, prow };
+                        const uint8_t  coefs[] = { 1, row[col] };
+                        dot(row, rsrc, coefs, 2, 0, w);
+                }
+        }
+        for (int r = 0; r < k && ret; ++r) {
+                memcpy(m + r * k, aug + r * w + k, k);
+        }
+        free(aug);
+        return ret;
+}
+
+struct rs_code *
+rs_code_new(unsigned k, unsigned n)
+{
+        if (k == 0 || k > n || n > 256) {
+                return NULL;
+        }
+        struct rs_code *code = calloc(1, sizeof *code);
+        code->k              = k;
+        code->n              = n;
+        code->dot            = gf256_dot_get(NULL);
+        code->threads        = 1;
+        code->enc_matrix     = calloc((size_t) n * k, 1);
+
+        // Vandermonde matrix as in zfec - first row is (1, 0, ..., 0), row r
+        // is made of powers alpha^((r-1)*col)
+        uint8_t *vdm = calloc((size_t) n * k, 1);
+        vdm[0]       = 1;
+        for (unsigned row = 1; row < n; ++row) {
+                for (unsigned col = 0; col < k; ++col) {
+                        vdm[row * k + col] = gf_exp[((row - 1) * col) % 255];
+                }
+        }
+        // systematic form - bottom rows multiplied by inverse of the top
+        bool ok = gf_invert(code->dot, vdm, k);
+        assert(ok);
+        (void) ok;
+        for (unsigned i = 0; i < k; ++i) {
+                code->enc_matrix[i * k + i] = 1;
+        }
+        for (unsigned row = k; row < n; ++row) {
+                for (unsigned col = 0; col < k; ++col) {
+                        uint8_t acc = 0;
+                        for (unsigned i = 0; i < k; ++i) {
+                                acc ^= gf_mul(vdm[row * k + i],
+                                              vdm[i * k + col]);
+                        }
+                        code->enc_matrix[row * k + col] = acc;
+                }
+        }
+        free(vdm);
+        return code;
+}
+
+void
+rs_code_destroy(struct rs_code *code)
+{
+        if (code == NULL) {
+                return;
+        }
+        free(code->enc_matrix);
+        free(code);
+}
+
+/// maximal number of threads used to process a single encode/decode call
+void
+rs_code_set_threads(struct rs_code *code, int threads)
+{
+        code->threads = CLAMP(threads, 1, MAX_CPU_CORES);
+}
+
+/// forces kernel for given ISA (see gf256_dot_get())
+bool
+rs_code_set_isa(struct rs_code *code, const char *isa)
+{
+        gf256_dot_func_t dot = gf256_dot_get(isa);
+        if (dot == NULL) {
+                return false;
+        }
+        code->dot = dot;
+        return true;
+}
+
+struct rs_dot_job {
+        gf256_dot_func_t      dot;
+        uint8_t *const       *dst;
+        const uint8_t *const *src;
+        const uint8_t        *coefs; ///< rows x count
+        int                   rows;
+        int                   count;
+        size_t                begin;
+        size_t                end;
+};
+
+static void *
+rs_dot_worker(void *arg)
+{
+        const struct rs_dot_job *job = arg;
+        for (size_t off = job->begin; off < job->end; off += STRIPE_LEN) {
+                const size_t len = MIN((size_t) STRIPE_LEN, job->end - off);
+                for (int r = 0; r < job->rows; ++r) {
+                        job->dot(job->dst[r], job->src,
+                                 job->coefs + (size_t) r * job->count,
+                                 job->count, off, len);
+                }
+        }
+        return NULL;
+}
+
+/**
+ * Computes rows of output symbols, the symbol columns are split among
+ * workers.
+ */
+static void
+rs_dot_parallel(const struct rs_code *code, uint8_t *const *dst,
+                const uint8_t *const *src, const uint8_t *coefs, int rows,
+                int count, size_t sz)
+{
+        if (rows == 0 || sz == 0) {
+                return;
+        }
+        const size_t work    = sz * count;
+        int          workers = (int) MIN((size_t) code->threads,
+                                         MAX(work / MIN_WORK_PER_WORKER, 1));
+        const size_t chunk   = ((sz + workers - 1) / workers + VEC_ALIGN - 1) /
+                             VEC_ALIGN * VEC_ALIGN;
+        workers              = (int) ((sz + chunk - 1) / chunk);
+
+        struct rs_dot_job jobs[MAX_CPU_CORES];
+        for (int i = 0; i < workers; ++i) {
+                jobs[i] = (struct rs_dot_job){ .dot   = code->dot,
+                                               .dst   = dst,
+                                               .src   = src,
+                                               .coefs = coefs,
+                                               .rows  = rows,
+                                               .count = count,
+                                               .begin = i * chunk,
+                                               .end = MIN((i + 1) * chunk, sz) };
+        }
+        task_run_parallel(rs_dot_worker, MAX(workers, 1), jobs, sizeof jobs[0],
+                          NULL);
+}
+
+/**
+ * Same semantics as zfec fec_encode() - computes blocks block_nums (k <= block
+ * number < n; primary blocks are just copied) from k source blocks of size sz.
+ */
+void
+rs_code_encode(const struct rs_code *code, const uint8_t *const *src,
+               uint8_t *const *fecs, const unsigned *block_nums,
+               unsigned num_block_nums, size_t sz)
+{
+        const unsigned k     = code->k;
+        uint8_t       *coefs = malloc((size_t) num_block_nums * k);
+        uint8_t      **dst   = malloc(num_block_nums * sizeof *dst);
+        int            rows  = 0;
+        for (unsigned i = 0; i < num_block_nums; ++i) {
+                assert(block_nums[i] < code->n);
+                if (block_nums[i] < k) {
+                        memcpy(fecs[i], src[block_nums[i]], sz);
+                        continue;
+                }
+                memcpy(coefs + (size_t) rows * k,
+                       code->enc_matrix + (size_t) block_nums[i] * k, k);
+                dst[rows++] = fecs[i];
+        }
+        rs_dot_parallel(code, dst, src, coefs, rows, (int) k, sz);
+        free(dst);
+        free(coefs);
+}
+
+/**
+ * Same semantics as zfec fec_decode() - inpkts holds k received blocks,
+ * index their block numbers, primary block i must be at position i. Missing
+ * primary blocks (those at positions holding a parity block) are written to
+ * outpkts in ascending order. Output buffers must not overlap inputs.
+ *
+ * Only the e x e submatrix of the parity rows restricted to the missing
+ * columns is inverted, so decoding few losses is cheap regardless of k.
+ *
+ * @retval false if index is malformed
+ */
+bool
+rs_code_decode(const struct rs_code *code, const uint8_t *const *inpkts,
+               uint8_t *const *outpkts, const unsigned *index, size_t sz)
+{
+        const unsigned k = code->k;
+        bool           seen[256] = { false };
+        unsigned       missing[256];
+        unsigned       e = 0;
+        for (unsigned i = 0; i < k; ++i) {
+                if (index[i] >= code->n || seen[index[i]] ||
+                    (index[i] < k && index[i] != i)) {
+                        return false;
+                }
+                seen[index[i]] = true;
+                if (index[i] >= k) {
+                        missing[e++] = i;
+                }
+        }
+        if (e == 0) {
+                return true;
+        }
+
+        // sub[a][b] - coefficient of missing block b in parity block a
+        uint8_t *sub = malloc((size_t) e * e);
+        for (unsigned a = 0; a < e; ++a) {
+                const uint8_t *row =
+                    code->enc_matrix + (size_t) index[missing[a]] * k;
+                for (unsigned b = 0; b < e; ++b) {
+                        sub[a * e + b] = row[missing[b]];
+                }
+        }
+        if (!gf_invert(code->dot, sub, (int) e)) {
+                free(sub);
+                return false;
+        }
+        // missing_b = sum_a inv[b][a] * (parity_a + sum_j enc[a][j] * primary_j)
+        uint8_t *coefs = calloc((size_t) e * k, 1);
+        for (unsigned b = 0; b < e; ++b) {
+                uint8_t *out = coefs + (size_t) b * k;
+                for (unsigned a = 0; a < e; ++a) {
+                        const uint8_t  f = sub[b * e + a];
+                        const uint8_t *row =
+                            code->enc_matrix + (size_t) index[missing[a]] * k;
+                        out[missing[a]] = f;
+                        for (unsigned j = 0; j < k; ++j) {
+                                if (index[j] < k) {
+                                        out[j] ^= gf_mul(f, row[j]);
+                                }
+                        }
+                }
+        }
+        rs_dot_parallel(code, outpkts, inpkts, coefs, (int) e, (int) k, sz);
+        free(coefs);
+        free(sub);
+        return true;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file   rtp/rs_simd.h
+ * @brief  Reed-Solomon erasure code over GF(2^8) with SIMD kernels
+ *
+ * The code is compatible with zfec (systematic Vandermonde matrix over
+ * GF(2^8) with polynomial 0x11d), so frames encoded by either can be
+ * decoded by the other one.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RTP_RS_SIMD_H_
+#define RTP_RS_SIMD_H_
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#else
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#endif
+
+/**
+ * Computes dst[off..off+len) = sum of coefs[j] * src[j][off..off+len)
+ * for j < count in GF(2^8). Buffers needn't be aligned.
+ */
+typedef void (*gf256_dot_func_t)(uint8_t *dst, const uint8_t *const *src,
+                                 const uint8_t *coefs, int count, size_t off,
+                                 size_t len);
+
+gf256_dot_func_t gf256_dot_get(const char *isa);
+const char      *gf256_best_isa(void);
+
+struct rs_code;
+
+struct rs_code *rs_code_new(unsigned k, unsigned n);
+void            rs_code_destroy(struct rs_code *code);
+void            rs_code_set_threads(struct rs_code *code, int threads);
+bool            rs_code_set_isa(struct rs_code *code, const char *isa);
+void rs_code_encode(const struct rs_code *code, const uint8_t *const *src,
+                    uint8_t *const *fecs, const unsigned *block_nums,
+                    unsigned num_block_nums, size_t sz);
+bool rs_code_decode(const struct rs_code *code, const uint8_t *const *inpkts,
+                    uint8_t *const *outpkts, const unsigned *index, size_t sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // defined RTP_RS_SIMD_H_
@@ -78,6 +78,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -123,6 +124,8 @@ static int des_encrypt(struct rtp *session, unsigned char *data,
                        unsigned int size, unsigned char *initVec);
 static void rtp_process_data(struct rtp *session, uint32_t curr_rtp_ts,
                uint8_t *buffer, rtp_packet *packet, int buflen);
+struct rtp_rtx;
+static void rtx_done(struct rtp_rtx *rtx);
 
 #define MAX_DROPOUT    3000
 #define MAX_MISORDER   100
@@ -143,6 +146,10 @@ static void rtp_process_data(struct rtp *session, uint32_t curr_rtp_ts,
 #define RTCP_BYE  203
 #define RTCP_APP  204
 #define RTCP_RX   205
+#define RTCP_RTPFB 205  /* RFC 4585, shares the PT with (unused) TFRC RX */
+
+#define RTCP_FB_NACK 1  /* FMT of a generic NACK (RFC 4585, section 6.2.1) */
+#define RTCP_NACK_MAX_FCI 256
 
 typedef struct {
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -188,6 +195,11 @@ typedef struct {
                         uint8_t name[4];
                         uint8_t data[1];
                 } app;
+                struct {
+                        uint32_t ssrc;          /* source this RTCP packet is coming from */
+                        uint32_t media_ssrc;    /* source the feedback refers to */
+                        uint32_t fci[1];        /* PID << 16 | BLP, variable-length list */
+                } fb;
         } r;
 } rtcp_t;
 
@@ -268,6 +280,30 @@ typedef int (*rtp_encrypt_func) (struct rtp *, unsigned char *data,
 typedef bool (*rtp_decrypt_func) (struct rtp *, unsigned char *data,
                                  unsigned int size, unsigned char *initvec);
 
+/*
+ * Retransmission buffer, see rtp_rtx_init().
+ */
+struct rtp_rtx_slot {
+        uint16_t seq;
+        bool valid;
+        bool zero_copy;         /* payload referenced by data, see rtp_rtx_release() */
+        uint8_t *buf;           /* RTP header + payload header (+ payload if copied) */
+        int buf_size;
+        int len;
+        const char *data;
+        int data_len;
+};
+
+struct rtp_rtx {
+        pthread_mutex_t lock;
+        struct rtp_rtx_slot *slots;
+        unsigned mask;
+        bool copy;              /* payload must be copied, see rtp_rtx_set_copy() */
+        uint16_t zc_valid_from; /* oldest packet whose payload is still referenced */
+        long long requested;
+        long long retransmitted;
+};
+
 /*
  * The "struct rtp" defines an RTP session.
  */
@@ -311,6 +347,7 @@ struct rtp {
         uint32_t rtp_pcount;
         uint32_t rtp_bcount;
         uint64_t rtp_bytes_sent;
+        struct rtp_rtx *rtx;    /* NULL unless rtp_rtx_init() was called */
         int tfrc_on;            /* indicates TFRC congestion control */
         /* tfrc sender variables */
         uint32_t cmp_rtt;       /* rtt as computed by the sender */
@@ -1557,7 +1594,7 @@ static int rtp_recv_data(struct rtp *session, uint32_t curr_rtp_ts)
                 buffer = ((uint8_t *) packet) + RTP_PACKET_HEADER_SIZE;
         } else {
                 if (!session->opt->reuse_bufs || (packet == NULL)) {
-                        packet = (rtp_packet *) malloc(RTP_MAX_PACKET_LEN + (session->opt->record_source ? sizeof(struct sockaddr_storage) : 0));
+                        packet = (rtp_packet *) udp_data_get(session->rtp_socket);
                         buffer = ((uint8_t *) packet) + RTP_PACKET_HEADER_SIZE;
                 }
                 struct sockaddr_storage *sin = NULL;
@@ -1571,7 +1608,7 @@ static int rtp_recv_data(struct rtp *session, uint32_t curr_rtp_ts)
                                         RTP_MAX_PACKET_LEN - RTP_PACKET_HEADER_SIZE,
                                         (struct sockaddr *) sin, sin ? &addrlen : 0);
                 if (buflen <= 0) {
-                        free(packet);
+                        rtp_free_packet(packet);
                 }
         }
 
@@ -1692,7 +1729,7 @@ static void rtp_process_data(struct rtp *session, uint32_t curr_rtp_ts,
         }
 
         if (!session->opt->reuse_bufs) {
-                free(packet);
+                rtp_free_packet(packet);
         }
 }
 
@@ -2145,6 +2182,61 @@ static void process_rtcp_app(struct rtp *session, rtcp_t * packet)
         }
 }
 
+/**
+ * Sends the packet again from the retransmission buffer. The packet is sent
+ * immediately (bypassing the async batching), so this may be called
+ * concurrently with rtp_send_data_hdr().
+ */
+static void rtx_resend(struct rtp *session, uint16_t seq)
+{
+        struct rtp_rtx *rtx = session->rtx;
+        char pkt[RTP_MAX_PACKET_LEN];
+        int len = 0;
+
+        pthread_mutex_lock(&rtx->lock);
+        rtx->requested += 1;
+        struct rtp_rtx_slot *slot = &rtx->slots[seq & rtx->mask];
+        if (slot->valid && slot->seq == seq &&
+            slot->len + slot->data_len <= (int) sizeof pkt) {
+                memcpy(pkt, slot->buf, slot->len);
+                if (slot->zero_copy) {
+                        memcpy(pkt + slot->len, slot->data, slot->data_len);
+                }
+                len = slot->len + slot->data_len;
+                rtx->retransmitted += 1;
+        }
+        pthread_mutex_unlock(&rtx->lock);
+
+        if (len == 0) {
+                debug_msg("Packet %" PRIu16 " no longer available for retransmission\n", seq);
+                return;
+        }
+        if (udp_send(session->rtp_socket, pkt, len) == -1) {
+                log_msg(LOG_LEVEL_WARNING, "retransmitting RTP packet: %s\n",
+                        ug_strerror(errno));
+        }
+}
+
+static void process_rtcp_nack(struct rtp *session, rtcp_t * packet)
+{
+        if (session->rtx == NULL ||
+            ntohl(packet->r.fb.media_ssrc) != session->my_ssrc) {
+                return;
+        }
+        int fci_count = ntohs(packet->common.length) - 2;
+        for (int i = 0; i < fci_count; ++i) {
+                uint32_t fci = ntohl(packet->r.fb.fci[i]);
+                uint16_t pid = fci >> 16;
+                uint16_t blp = fci & 0xFFFF;
+                rtx_resend(session, pid);
+                for (int b = 0; b < 16; ++b) {
+                        if (blp & (1U << b)) {
+                                rtx_resend(session, pid + b + 1);
+                        }
+                }
+        }
+}
+
 static
 uint32_t compute_rtt(struct rtp *session, rtcp_rx * rrx)
 {
@@ -2206,6 +2298,11 @@ static void rtp_process_ctrl(struct rtp *session, uint8_t * buffer, int buflen)
                                         process_rtcp_rr(session, packet);
                                         break;
                                 case RTCP_RX:
+                                        if (!session->tfrc_on &&
+                                            packet->common.count == RTCP_FB_NACK) {
+                                                process_rtcp_nack(session, packet);
+                                                break;
+                                        }
                                         /* am not sending up a RX_RTCP_START... */
                                         process_rtcp_rx(session, packet);
                                         if (session->tfrc_on) {
@@ -2777,6 +2874,38 @@ int rtp_send_data(struct rtp *session, uint32_t rtp_ts, char pt, int m,
                                  data, data_len, extn, extn_len, extn_type);
 }
 
+/**
+ * Stores the packet being sent to the retransmission buffer. The headers are
+ * always copied, the payload only if rtp_rtx::copy is set.
+ */
+static void rtx_store(struct rtp_rtx *rtx, uint16_t seq, const uint8_t *hdr,
+                      int hdr_len, const char *phdr, int phdr_len,
+                      const char *data, int data_len)
+{
+        pthread_mutex_lock(&rtx->lock);
+        struct rtp_rtx_slot *slot = &rtx->slots[seq & rtx->mask];
+        const int len = hdr_len + phdr_len + (rtx->copy ? data_len : 0);
+        if (slot->buf_size < len) {
+                free(slot->buf);
+                slot->buf = malloc(len);
+                slot->buf_size = len;
+        }
+        memcpy(slot->buf, hdr, hdr_len);
+        if (phdr_len > 0) {
+                memcpy(slot->buf + hdr_len, phdr, phdr_len);
+        }
+        if (rtx->copy && data_len > 0) {
+                memcpy(slot->buf + hdr_len + phdr_len, data, data_len);
+        }
+        slot->seq = seq;
+        slot->valid = true;
+        slot->zero_copy = !rtx->copy && data_len > 0;
+        slot->len = len;
+        slot->data = slot->zero_copy ? data : NULL;
+        slot->data_len = slot->zero_copy ? data_len : 0;
+        pthread_mutex_unlock(&rtx->lock);
+}
+
 int
 rtp_send_data_hdr(struct rtp *session,
                   uint32_t rtp_ts, char pt, int m,
@@ -2877,7 +3006,8 @@ rtp_send_data_hdr(struct rtp *session,
         packet->cc = cc;
         packet->m = m;
         packet->pt = pt;
-        packet->seq = htons(session->rtp_seq++);
+        const uint16_t seq = session->rtp_seq++;
+        packet->seq = htons(seq);
         packet->ts = htonl(rtp_ts);
         packet->ssrc = htonl(session->my_ssrc);
 
@@ -2945,6 +3075,11 @@ rtp_send_data_hdr(struct rtp *session,
                                          buffer_len, initVec);
         }
 
+        if (session->rtx != NULL) {
+                rtx_store(session->rtx, seq, buffer + RTP_PACKET_HEADER_SIZE,
+                          buffer_len, phdr, phdr_len, data, data_len);
+        }
+
         rc = udp_sendv(session->rtp_socket, send_vector, send_vector_len, d);
         if (rc == -1) {
                 log_msg(LOG_LEVEL_WARNING, "sending RTP packet: %s\n",
@@ -3311,6 +3446,9 @@ static void rtcp_udp_send(struct rtp *session, int len, char *buffer)
         }
 }
 
+static uint8_t *encrypt_and_send_rtcp(struct rtp *session, uint8_t *buffer,
+                                      uint8_t *ptr, uint8_t *lpt);
+
 static void send_rtcp(struct rtp *session, uint32_t rtp_ts,
                       rtcp_app_callback appcallback)
 {
@@ -3322,7 +3460,6 @@ static void send_rtcp(struct rtp *session, uint32_t rtp_ts,
         uint8_t *old_ptr;
         uint8_t *lpt;           /* the last packet in the compound */
         rtcp_app *app;
-        uint8_t initVec[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
         check_database(session);
         /* If encryption is enabled, add a 32 bit random prefix to the packet */
@@ -3388,6 +3525,26 @@ static void send_rtcp(struct rtp *session, uint32_t rtp_ts,
                 }
         }
 
+        ptr = encrypt_and_send_rtcp(session, buffer, ptr, lpt);
+        /* Loop the data back to ourselves so local participant can */
+        /* query own stats when using unicast or multicast with no  */
+        /* loopback.                                                */
+        rtp_process_ctrl(session, buffer, ptr - buffer);
+        check_database(session);
+}
+
+/**
+ * Pads and encrypts (if enabled) the compound RTCP packet in buffer and sends
+ * it.
+ *
+ * @param lpt  the last packet in the compound
+ * @returns    end of the sent data
+ */
+static uint8_t *encrypt_and_send_rtcp(struct rtp *session, uint8_t *buffer,
+                                      uint8_t *ptr, uint8_t *lpt)
+{
+        uint8_t initVec[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
         /* And encrypt if desired... */
         if (session->encryption_enabled) {
                 if (((ptr - buffer) % session->encryption_pad_length) != 0) {
@@ -3416,11 +3573,7 @@ static void send_rtcp(struct rtp *session, uint32_t rtp_ts,
         }
 
         rtcp_udp_send(session, ptr - buffer, (char *)buffer);
-        /* Loop the data back to ourselves so local participant can */
-        /* query own stats when using unicast or multicast with no  */
-        /* loopback.                                                */
-        rtp_process_ctrl(session, buffer, ptr - buffer);
-        check_database(session);
+        return ptr;
 }
 
 /**
@@ -3473,6 +3626,68 @@ void rtp_send_ctrl(struct rtp *session, uint32_t rtp_ts,
         check_database(session);
 }
 
+/**
+ * rtp_send_nack:
+ * @session: the session pointer (returned by rtp_init())
+ * @media_ssrc: the SSRC of the sender whose packets are missing
+ * @seqs: sequence numbers of the missing packets (preferably ascending)
+ * @count: number of items in @seqs
+ *
+ * Immediately sends a generic NACK (RFC 4585) requesting retransmission of the
+ * packets. Consecutive sequence numbers are packed into a single FCI entry
+ * (PID + 16 bit BLP mask). The NACK is preceded by an empty RR to form a valid
+ * compound packet, the RTCP timer is not affected.
+ */
+void rtp_send_nack(struct rtp *session, uint32_t media_ssrc,
+                   const uint16_t *seqs, int count)
+{
+        uint8_t buffer[RTP_MAX_PACKET_LEN + MAX_ENCRYPTION_PAD];
+        uint8_t *ptr = buffer;
+
+        if (count <= 0) {
+                return;
+        }
+        if (session->encryption_enabled) {
+                *((uint32_t *)(void *) ptr) = ug_rand();
+                ptr += 4;
+        }
+
+        rtcp_t *rr = (rtcp_t *)(void *) ptr;
+        rr->common.version = 2;
+        rr->common.p = 0;
+        rr->common.count = 0;
+        rr->common.pt = RTCP_RR;
+        rr->common.length = htons(1);
+        rr->r.rr.ssrc = htonl(rtp_my_ssrc(session));
+        ptr += 8;
+
+        rtcp_t *fb = (rtcp_t *)(void *) ptr;
+        fb->common.version = 2;
+        fb->common.p = 0;
+        fb->common.count = RTCP_FB_NACK;
+        fb->common.pt = RTCP_RTPFB;
+        fb->r.fb.ssrc = htonl(rtp_my_ssrc(session));
+        fb->r.fb.media_ssrc = htonl(media_ssrc);
+        int fci_count = 0;
+        for (int i = 0; i < count && fci_count < RTCP_NACK_MAX_FCI;) {
+                const uint16_t pid = seqs[i++];
+                uint16_t blp = 0;
+                while (i < count) {
+                        const uint16_t dist = seqs[i] - pid;
+                        if (dist == 0 || dist > 16) {
+                                break;
+                        }
+                        blp |= 1U << (dist - 1);
+                        i++;
+                }
+                fb->r.fb.fci[fci_count++] = htonl((uint32_t) pid << 16 | blp);
+        }
+        fb->common.length = htons(2 + fci_count);
+        ptr += 12 + 4 * fci_count;
+
+        encrypt_and_send_rtcp(session, buffer, ptr, (uint8_t *) fb);
+}
+
 /**
  * rtp_update:
  * @session: the session pointer (returned by rtp_init())
@@ -3734,6 +3949,7 @@ void rtp_done(struct rtp *session)
 
         udp_exit(session->rtp_socket);
         udp_exit(session->rtcp_socket);
+        rtx_done(session->rtx);
         free(session->opt);
         free(session);
 }
@@ -4057,16 +4273,161 @@ bool rtp_is_ipv6(struct rtp *session)
         return udp_is_ipv6(session->rtp_socket);
 }
 
+/**
+ * Frees the packet passed to the RX_RTP callback.
+ */
+void rtp_free_packet(rtp_packet *packet)
+{
+        udp_data_free(packet);
+}
+
+/**
+ * Frees count packets (rtp_packet pointers) passed to the RX_RTP callback at
+ * once, which is cheaper than calling rtp_free_packet() for each.
+ */
+void rtp_free_packets(void *const *packets, int count)
+{
+        udp_data_free_batch(packets, count);
+}
+
 void rtp_async_start(struct rtp *session, int nr_packets)
 {
        udp_async_start(session->rtp_socket, nr_packets);
 }
 
+void rtp_async_flush(struct rtp *session)
+{
+       udp_async_flush(session->rtp_socket);
+}
+
+int rtp_async_batch_size(struct rtp *session)
+{
+       return udp_async_batch_size(session->rtp_socket);
+}
+
 void rtp_async_wait(struct rtp *session)
 {
        udp_async_wait(session->rtp_socket);
 }
 
+/**
+ * Enables retransmission of sent packets requested by generic NACKs (see
+ * rtp_send_nack()). The last nr_packets packets are kept in a ring indexed by
+ * the sequence number.
+ *
+ * Only the headers are copied by default, the payload is referenced where it
+ * was passed to rtp_send_data_hdr() and the caller must keep it intact until
+ * it calls rtp_rtx_release(). If the payload buffer is reused right after the
+ * packet is sent (eg. encrypted or FEC-encoded data), use rtp_rtx_set_copy().
+ *
+ * @param nr_packets  ring size, rounded up to a power of 2
+ */
+bool rtp_rtx_init(struct rtp *session, int nr_packets)
+{
+        if (session->rtx != NULL || nr_packets <= 0) {
+                return false;
+        }
+        unsigned size = 1;
+        while (size < (unsigned) nr_packets && size < RTP_SEQ_MOD) {
+                size <<= 1;
+        }
+        struct rtp_rtx *rtx = calloc(1, sizeof *rtx);
+        rtx->slots = calloc(size, sizeof rtx->slots[0]);
+        rtx->mask = size - 1;
+        rtx->zc_valid_from = session->rtp_seq;
+        pthread_mutex_init(&rtx->lock, NULL);
+        session->rtx = rtx;
+        MSG(VERBOSE, "Retransmission buffer of %u packets enabled.\n", size);
+        return true;
+}
+
+/**
+ * Sets whether payload of the subsequently sent packets is copied to the
+ * retransmission buffer.
+ */
+void rtp_rtx_set_copy(struct rtp *session, bool copy)
+{
+        if (session->rtx == NULL) {
+                return;
+        }
+        pthread_mutex_lock(&session->rtx->lock);
+        session->rtx->copy = copy;
+        pthread_mutex_unlock(&session->rtx->lock);
+}
+
+/**
+ * Invalidates referenced (not copied) payload of packets sent before the
+ * packet with sequence number end. After the call returns, the payload is no
+ * longer accessed and may be freed.
+ *
+ * @param end  rtp_get_next_seq() after the last packet referencing the data
+ */
+void rtp_rtx_release(struct rtp *session, uint16_t end)
+{
+        struct rtp_rtx *rtx = session->rtx;
+        if (rtx == NULL) {
+                return;
+        }
+        pthread_mutex_lock(&rtx->lock);
+        for (uint16_t seq = rtx->zc_valid_from; seq != end; ++seq) {
+                struct rtp_rtx_slot *slot = &rtx->slots[seq & rtx->mask];
+                if (slot->seq == seq && slot->zero_copy) {
+                        slot->valid = false;
+                }
+        }
+        rtx->zc_valid_from = end;
+        pthread_mutex_unlock(&rtx->lock);
+}
+
+/// @returns sequence number of the next RTP packet to be sent
+uint16_t rtp_get_next_seq(struct rtp *session)
+{
+        return session->rtp_seq;
+}
+
+static void rtx_done(struct rtp_rtx *rtx)
+{
+        if (rtx == NULL) {
+                return;
+        }
+        if (rtx->requested > 0) {
+                MSG(INFO, "Retransmitted %lld of %lld requested packets.\n",
+                    rtx->retransmitted, rtx->requested);
+        }
+        for (unsigned i = 0; i <= rtx->mask; ++i) {
+                free(rtx->slots[i].buf);
+        }
+        free(rtx->slots);
+        pthread_mutex_destroy(&rtx->lock);
+        free(rtx);
+}
+
+/**
+ * Offloads pacing to the kernel (fq qdisc) - sets max pacing rate of the
+ * RTP socket.
+ *
+ * @param bytes_per_sec  UINT64_MAX to unset
+ */
+bool rtp_set_pacing_rate(struct rtp *session, uint64_t bytes_per_sec)
+{
+        return udp_set_pacing_rate(session->rtp_socket, bytes_per_sec);
+}
+
+/**
+ * Enables per-packet launch times (SO_TXTIME) on the RTP socket. The launch
+ * time of subsequently sent packets is set by rtp_set_next_txtime().
+ */
+bool rtp_set_txtime(struct rtp *session, bool enable)
+{
+        return udp_set_txtime(session->rtp_socket, enable);
+}
+
+/// @param launch_time_ns  CLOCK_MONOTONIC time in nanoseconds
+void rtp_set_next_txtime(struct rtp *session, uint64_t launch_time_ns)
+{
+        udp_set_next_txtime(session->rtp_socket, launch_time_ns);
+}
+
 /**
  * @returns the socket state to be passed to rtp_init_with_udp_socket()
  */
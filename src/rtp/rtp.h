@@ -285,6 +285,8 @@ int 		 rtp_send_data_hdr(struct rtp *session,
 void 		 rtp_send_ctrl(struct rtp *session, uint32_t rtp_ts, 
 			       rtcp_app_callback appcallback, time_ns_t curr_time);
 void 		 rtp_update(struct rtp *session, time_ns_t curr_time);
+void             rtp_send_nack(struct rtp *session, uint32_t media_ssrc,
+                               const uint16_t *seqs, int count);
 
 uint32_t	 rtp_my_ssrc(struct rtp *session);
 bool             rtp_add_csrc(struct rtp *session, uint32_t csrc);
@@ -314,9 +316,11 @@ uint64_t         rtp_get_bytes_sent(struct rtp *session);
 int              rtp_compute_fract_lost(struct rtp *session, uint32_t ssrc);
 bool             rtp_is_ipv6(struct rtp *session);
 bool             rtp_has_receiver(struct rtp *session);
+void             rtp_free_packet(rtp_packet *packet);
+void             rtp_free_packets(void *const *packets, int count);
 
 /*
- * Async API - MSW specific
+ * Async API - MSW overlapped I/O, sendmmsg() batching elsewhere (if available)
  *
  * Using async API hugely improves performance.
  * Usage is simple - prior to sending a bulk of packets (eg. video frame), rtp_async_start()
@@ -324,9 +328,26 @@ bool             rtp_has_receiver(struct rtp *session);
  * be altered up to rtp_async_wait() call, which waits upon completion of async operations
  * started after rtp_async_start(). Caller is responsible that rtp_send_data_hdr() is not called
  * more than nr_packet times.
+ *
+ * With batching, packets are queued and sent when rtp_async_batch_size() packets are
+ * accumulated, by rtp_async_flush() or by rtp_async_wait(). Paced senders should call
+ * rtp_async_flush() at the burst boundaries.
  */
 void             rtp_async_start(struct rtp *session, int nr_packets);
+void             rtp_async_flush(struct rtp *session);
+int              rtp_async_batch_size(struct rtp *session);
 void             rtp_async_wait(struct rtp *session);
+bool             rtp_set_pacing_rate(struct rtp *session, uint64_t bytes_per_sec);
+bool             rtp_set_txtime(struct rtp *session, bool enable);
+void             rtp_set_next_txtime(struct rtp *session, uint64_t launch_time_ns);
+
+/*
+ * Retransmission of packets requested by generic NACKs, see rtp_rtx_init()
+ */
+bool             rtp_rtx_init(struct rtp *session, int nr_packets);
+void             rtp_rtx_set_copy(struct rtp *session, bool copy);
+void             rtp_rtx_release(struct rtp *session, uint16_t end);
+uint16_t         rtp_get_next_seq(struct rtp *session);
 
 struct socket_udp_local *rtp_get_udp_local_socket(struct rtp *session);
 
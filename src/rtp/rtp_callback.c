@@ -60,16 +60,20 @@
 #include <assert.h>      // for assert
 #include <inttypes.h>    // for uint32_t, PRIx32
 #include <stdio.h>       // for printf
+#include <stddef.h>      // for offsetof
 #include <stdlib.h>      // for free, NULL, calloc
 #include <string.h>      // for strncmp, strncpy
 
+#include "compat/net.h"  // for htonl, ntohl
 #include "debug.h"       // for debug_msg, log_msg, LOG_LEVEL_INFO
+#include "host.h"        // for ADD_TO_PARAM, get_commandline_param
 #include "ntp.h"         // for ntp64_time, ntp64_to_ntp32
 #include "pdb.h"         // for pdb_e, pdb_get, pdb_add, pdb_destroy_item
 #include "rtp/pbuf.h"    // for pbuf_insert
 #include "rtp/rtp.h"     // for rtp_my_ssrc, rtcp_rr, rtcp_app, rtcp_sdes_item
 #include "tfrc.h"        // for tfrc_recv_data
 #include "tv.h"          // for get_time_in_ns
+#include "utils/random.h" // for ug_drand
 
 struct pdb;
 struct rtp;
@@ -82,6 +86,118 @@ char hdr_buf[100];
 
 extern uint32_t RTT;
 
+#define LOSS_REPORT_APP_NAME "UGLR"
+#define SIM_LOSS_PARAM "rtp-sim-loss"
+ADD_TO_PARAM(SIM_LOSS_PARAM, "* " SIM_LOSS_PARAM "=<pct>[:<burst>]\n"
+                "  drop <pct> percent of received RTP packets in bursts of mean length\n"
+                "  <burst> packets (default 1), for testing FEC and loss reporting\n");
+
+/// loss report carried by RTCP APP LOSS_REPORT_APP_NAME (network byte order)
+struct loss_report_app_data {
+        uint32_t expected;
+        uint32_t received;
+        uint32_t bursts[PBUF_LOSS_BURST_BUCKETS];
+};
+
+/**
+ * Packet loss simulation for SIM_LOSS_PARAM by a two-state (Gilbert) model -
+ * all packets are dropped in the bad state.
+ */
+static bool sim_loss_drop(void)
+{
+        _Thread_local static struct {
+                bool init;
+                double p_enter_bad; ///< good->bad transition probability
+                double p_leave_bad; ///< bad->good transition probability
+                bool bad;
+        } s;
+        if (!s.init) {
+                s.init = true;
+                const char *cfg = get_commandline_param(SIM_LOSS_PARAM);
+                if (cfg != NULL) {
+                        const double loss = atof(cfg) / 100.0;
+                        const double burst = strchr(cfg, ':') != NULL ? atof(strchr(cfg, ':') + 1) : 1.0;
+                        if (loss > 0.0 && loss < 1.0 && burst >= 1.0) {
+                                s.p_leave_bad = 1.0 / burst;
+                                s.p_enter_bad = loss * s.p_leave_bad / (1.0 - loss);
+                                log_msg(LOG_LEVEL_WARNING, "Simulating %.2f%% packet loss "
+                                                "(mean burst %.1f pkts)!\n", loss * 100.0, burst);
+                        } else {
+                                log_msg(LOG_LEVEL_ERROR, "Wrong " SIM_LOSS_PARAM " value: %s\n", cfg);
+                        }
+                }
+        }
+        if (s.p_enter_bad == 0.0) {
+                return false;
+        }
+        s.bad = ug_drand() < (s.bad ? 1.0 - s.p_leave_bad : s.p_enter_bad);
+        return s.bad;
+}
+
+/**
+ * RTCP APP callback (see rtp_send_ctrl()) reporting the packet loss seen by
+ * the playout buffers of the session participants to the sender, where it
+ * is collected by pdb_add_loss_report(). Must be called from the thread that
+ * receives the RTP data.
+ */
+rtcp_app *rtp_loss_report_app(struct rtp *session, uint32_t rtp_ts, int max_size)
+{
+        (void) rtp_ts;
+        _Thread_local static bool emitted; // the callback is called until NULL is returned
+        _Thread_local static union {
+                rtcp_app app;
+                char buf[offsetof(rtcp_app, data) + sizeof(struct loss_report_app_data)];
+        } u;
+        if (emitted) {
+                emitted = false;
+                return NULL;
+        }
+        if (max_size < (int) sizeof u.buf) {
+                return NULL;
+        }
+
+        struct pbuf_loss_report report = { 0 };
+        struct pdb *participants = (struct pdb *) rtp_get_userdata(session);
+        pdb_iter_t it;
+        for (struct pdb_e *cp = pdb_iter_init(participants, &it); cp != NULL;
+             cp = pdb_iter_next(&it)) {
+                pbuf_get_loss_report(cp->playout_buffer, &report);
+        }
+        pdb_iter_done(&it);
+        if (report.expected == 0) {
+                return NULL;
+        }
+
+        struct loss_report_app_data data = { htonl(report.expected), htonl(report.received), { 0 } };
+        for (int i = 0; i < PBUF_LOSS_BURST_BUCKETS; ++i) {
+                data.bursts[i] = htonl(report.bursts[i]);
+        }
+        u.app.p = 0;
+        u.app.subtype = 0;
+        u.app.length = sizeof u.buf / 4 - 1;
+        memcpy(u.app.name, LOSS_REPORT_APP_NAME, 4);
+        memcpy(u.app.data, &data, sizeof data);
+        emitted = true;
+        return &u.app;
+}
+
+static void process_loss_report(struct pdb *participants, const rtcp_app *app)
+{
+        struct loss_report_app_data data;
+        if ((app->length - 2) * 4 < (int) sizeof data) {
+                debug_msg("Short loss report from 0x%08x\n", app->ssrc);
+                return;
+        }
+        memcpy(&data, app->data, sizeof data);
+        struct pbuf_loss_report report = { ntohl(data.expected), ntohl(data.received), { 0 } };
+        for (int i = 0; i < PBUF_LOSS_BURST_BUCKETS; ++i) {
+                report.bursts[i] = ntohl(data.bursts[i]);
+        }
+        debug_msg("Loss report of 0x%08x: %u/%u packets received\n", app->ssrc,
+                  report.received, report.expected);
+        pdb_add_loss_report(participants, &report);
+}
+
 static void process_rr(struct rtp *session, rtp_event * e)
 {
         float fract_lost, tmp;
@@ -220,8 +336,12 @@ void rtp_recv_callback(struct rtp *session, rtp_event * e)
         case RX_RTP:
                 tfrc_recv_data(state->tfrc_state, get_time_in_ns(), pckt_rtp->seq,
                                pckt_rtp->data_len + 40);
-                if (pckt_rtp->data_len > 0) {   /* Only process packets that contain data... */
+                if (sim_loss_drop()) {
+                        rtp_free_packet(pckt_rtp);
+                } else if (pckt_rtp->data_len > 0) {   /* Only process packets that contain data... */
                         pbuf_insert(state->playout_buffer, pckt_rtp);
+                } else {
+                        rtp_free_packet(pckt_rtp);
                 }
                 break;
         case RX_TFRC_RX:
@@ -246,7 +366,10 @@ void rtp_recv_callback(struct rtp *session, rtp_event * e)
                         assert(pckt_app->length == 3);
                         assert(pckt_app->subtype == 0);
 //                      tfrc_recv_rtt(state->tfrc_state, get_time_in_ns(), ntohl(*((int *) pckt_app->data)));
+                } else if (strncmp(pckt_app->name, LOSS_REPORT_APP_NAME, 4) == 0) {
+                        process_loss_report(participants, pckt_app);
                 }
+                free(pckt_app);
                 break;
         case RX_BYE:
                 break;
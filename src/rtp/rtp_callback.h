@@ -48,6 +48,7 @@ extern "C" {
 #endif
 
 void rtp_recv_callback(struct rtp *session, rtp_event *e);
+rtcp_app *rtp_loss_report_app(struct rtp *session, uint32_t rtp_ts, int max_size);
 int handle_with_buffer(struct rtp *session,rtp_event *e);
 int check_for_frame_completion(struct rtp *);
 void process_packet_for_display(char *);
@@ -99,11 +99,10 @@
 #include <chrono>                      // for duration, steady_clock, durati...
 #include <cstdlib>                     // for free, malloc, calloc
 #include <cstring>                     // for NULL, memcpy, size_t, memset
-#include <algorithm>                   // for find, max, sort
+#include <algorithm>                   // for clamp, find, max, sort
 #include <atomic>                      // for __atomic_base, atomic_ulong
 #include <condition_variable>          // for condition_variable
 #include <iterator>                    // for end
-#include <map>                         // for map, operator!=, _Rb_tree_cons...
 #include <memory>                      // for unique_ptr, allocator
 #include <mutex>                       // for mutex, unique_lock
 #include <set>                         // for set
@@ -124,8 +123,10 @@
 #include "messaging.h"
 #include "module.h"
 #include "pixfmt_conv.h"
+#include "pixfmt_conv_plan.h"
 #include "rtp/fec.h"
 #include "rtp/pbuf.h"
+#include "rtp/received_extents.hpp"
 #include "rtp/rtp.h"
 #include "rtp/rtp_types.h" // for video_payload_hdr_t, PT_ENCRYP...
 #include "tv.h"            // for NS_IN_SEC
@@ -159,8 +160,8 @@ using std::chrono::nanoseconds;
 using std::chrono::seconds;
 using std::chrono::steady_clock;
 using std::atomic_ulong;
+using std::clamp;
 using std::condition_variable;
-using std::map;
 using std::max;
 using std::mutex;
 using std::ostringstream;
@@ -184,6 +185,7 @@ using change_il_t = void (*)(char *dst, char *src, int linesize, int height, voi
 static bool reconfigure_decoder(struct state_video_decoder *decoder,
                 struct video_desc desc, struct pixfmt_desc comp_int_desc);
 static void check_for_mode_change(struct state_video_decoder *decoder, const uint32_t *hdr);
+static void place_packets_parallel(struct state_video_decoder *decoder);
 static void wait_for_framebuffer_swap(struct state_video_decoder *decoder);
 static void *fec_thread(void *args);
 static void *decompress_thread(void *args);
@@ -192,14 +194,6 @@ static void decoder_process_message(struct module *);
 static bool  video_decoder_register_display(struct state_video_decoder *decoder,
                                             struct display             *display);
 
-static int sum_map(const map<int, int>& m) {
-        int ret = 0;
-        for (auto [pos, len] : m) {
-                ret += len;
-        }
-        return ret;
-}
-
 namespace {
 /**
  * Enumerates 2 possibilities how to decode arriving data.
@@ -220,11 +214,40 @@ struct line_decoder {
         long                 conv_den;     ///< in->out bpp conv denominator
         int                  shifts[3];    ///< requested red,green and blue shift (in bits)
         decoder_t            decode_line;  ///< actual decoding function
+        struct pixfmt_conv_chain *conv_chain; ///< used instead of decode_line if not NULL
         unsigned int         dst_linesize; ///< destination linesize
         unsigned int         dst_pitch;    ///< framebuffer pitch - it can be larger if SDL resolution is larger than data
         unsigned int         src_linesize; ///< source linesize
 };
 
+/// decodes (a part of) a line with the line decoder or its conversion chain
+static void line_decoder_decode(const struct line_decoder *ld,
+                                unsigned char *dst, const unsigned char *src,
+                                int len)
+{
+        if (ld->conv_chain != nullptr) {
+                pixfmt_conv_chain_line_part(ld->conv_chain, dst, src, len,
+                                            ld->shifts[0], ld->shifts[1],
+                                            ld->shifts[2]);
+        } else {
+                ld->decode_line(dst, src, len, ld->shifts[0], ld->shifts[1],
+                                ld->shifts[2]);
+        }
+}
+
+/**
+ * Payload of a received packet to be placed to the frame, used if the
+ * placement is distributed over workers (see decoder-placement-threads).
+ * The data point to the packet held by the playout buffer.
+ */
+struct packet_placement {
+        struct tile         *tile;         ///< destination tile
+        struct line_decoder *line_decoder; ///< NULL - plain copy to tile
+        uint32_t             data_pos;
+        const char          *data;
+        int                  len;
+};
+
 struct reported_statistics_cumul {
         ~reported_statistics_cumul() {
                 print();
@@ -282,7 +305,7 @@ struct frame_msg {
                 if (recv_frame) {
                         int received_bytes = 0;
                         for (unsigned int i = 0; i < recv_frame->tile_count; ++i) {
-                                received_bytes += sum_map(pckt_list[i]);
+                                received_bytes += pckt_list[i].received_bytes();
                         }
                         int expected_bytes = vf_get_data_len(recv_frame);
                         if (recv_frame->fec_params.type != FEC_NONE) {
@@ -307,7 +330,7 @@ struct frame_msg {
         vector <uint32_t> buffer_num;
         struct video_frame *recv_frame; ///< received frame with FEC and/or compression
         struct video_frame *nofec_frame; ///< frame without FEC
-        unique_ptr<map<int, int>[]> pckt_list;
+        unique_ptr<received_extents[]> pckt_list;
         unsigned long long int received_pkts_cum, expected_pkts_cum;
         struct reported_statistics_cumul &stats;
         bool is_corrupted = false;
@@ -376,6 +399,7 @@ struct state_video_decoder
         enum decoder_type_t decoder_type = {};  ///< how will the video data be decoded
         struct line_decoder *line_decoder = NULL; ///< if the video is uncompressed and only pixelformat change
                                            ///< is needed, use this structure
+        struct pixfmt_conv_chain *line_conv_chain = NULL; ///< multi-hop conversion for line_decoder, if needed
         vector<struct state_decompress *> decompress_state; ///< state of the decompress (for every substream)
         bool accepts_corrupted_frame = false;     ///< whether we should pass corrupted frame to decompress
         bool buffer_swapped = true; /**< variable indicating that display buffer
@@ -399,6 +423,9 @@ struct state_video_decoder
         const struct openssl_decrypt_info *dec_funcs = NULL; ///< decrypt state
         struct openssl_decrypt      *decrypt = NULL; ///< decrypt state
 
+        int placement_workers = 1; ///< workers placing packet data to the frame
+        vector<packet_placement> placements; ///< packets of the currently decoded frame
+
         struct reported_statistics_cumul stats = {}; ///< stats to be reported through control socket
 };
 
@@ -466,11 +493,11 @@ static void *fec_thread(void *args) {
                                 char *fec_out_buffer = NULL;
                                 int fec_out_len = 0;
 
-                                if (data->recv_frame->tiles[pos].data_len != (unsigned int) sum_map(data->pckt_list[pos])) {
+                                if (data->recv_frame->tiles[pos].data_len != (unsigned int) data->pckt_list[pos].received_bytes()) {
                                         debug_msg("Frame incomplete - substream %d, buffer %d: expected %u bytes, got %u.\n", pos,
                                                         (unsigned int) data->buffer_num[pos],
                                                         data->recv_frame->tiles[pos].data_len,
-                                                        (unsigned int) sum_map(data->pckt_list[pos]));
+                                                        (unsigned int) data->pckt_list[pos].received_bytes());
                                 }
 
                                 bool ret = fec_state->decode(data->recv_frame->tiles[pos].data,
@@ -534,10 +561,8 @@ static void *fec_thread(void *args) {
                                         char *src = fec_out_buffer;
                                         char *dst = tile->data + line_decoder->base_offset;
                                         while(data_pos < (int) fec_out_len) {
-                                                line_decoder->decode_line((unsigned char*)dst, (unsigned char *) src, line_decoder->dst_linesize,
-                                                                line_decoder->shifts[0],
-                                                                line_decoder->shifts[1],
-                                                                line_decoder->shifts[2]);
+                                                line_decoder_decode(line_decoder, (unsigned char *) dst,
+                                                                (unsigned char *) src, line_decoder->dst_linesize);
                                                 src += line_decoder->src_linesize;
                                                 dst += vc_get_linesize(tile->width ,frame->color_spec);
                                                 data_pos += line_decoder->src_linesize;
@@ -549,11 +574,11 @@ static void *fec_thread(void *args) {
                                 data->nofec_frame->tiles[i].data_len = data->recv_frame->tiles[i].data_len;
                                 data->nofec_frame->tiles[i].data = data->recv_frame->tiles[i].data;
 
-                                if (data->recv_frame->tiles[i].data_len != (unsigned int) sum_map(data->pckt_list[i])) {
+                                if (data->recv_frame->tiles[i].data_len != (unsigned int) data->pckt_list[i].received_bytes()) {
                                         debug_msg("Frame incomplete - substream %d, buffer %d: expected %u bytes, got %u.%s\n", i,
                                                         (unsigned int) data->buffer_num[i],
                                                         data->recv_frame->tiles[i].data_len,
-                                                        (unsigned int) sum_map(data->pckt_list[i]),
+                                                        (unsigned int) data->pckt_list[i].received_bytes(),
                                                         decoder->decoder_type == EXTERNAL_DECODER && !decoder->accepts_corrupted_frame ? " dropped.\n" : "");
                                         data->is_corrupted = true;
                                         if(decoder->decoder_type == EXTERNAL_DECODER && !decoder->accepts_corrupted_frame) {
@@ -753,6 +778,10 @@ static void decoder_set_video_mode(struct state_video_decoder *decoder, enum vid
                         * get_video_mode_tiles_y(decoder->video_mode);
 }
 
+ADD_TO_PARAM("decoder-placement-threads",
+                "* decoder-placement-threads=<n>|auto\n"
+                "  Distribute placement (copy/pixel format conversion) of received packets\n"
+                "  to the framebuffer over <n> workers (default 1 - receiving thread only).\n");
 /**
  * @brief Initializes video decompress state.
  * @param video_mode  video_mode expected to be received from network
@@ -787,6 +816,16 @@ struct state_video_decoder *video_decoder_init(struct module *parent,
                 }
         }
 
+        if (const char *workers = get_commandline_param("decoder-placement-threads")) {
+                s->placement_workers = strcmp(workers, "auto") == 0
+                                           ? get_cpu_core_count()
+                                           : atoi(workers);
+                s->placement_workers =
+                    clamp<int>(s->placement_workers, 1, MAX_CPU_CORES);
+                MSG(INFO, "Using %d packet placement workers.\n",
+                    s->placement_workers);
+        }
+
         decoder_set_video_mode(s, video_mode);
 
         if(!video_decoder_register_display(s, display)) {
@@ -978,6 +1017,8 @@ static void cleanup(struct state_video_decoder *decoder)
                 free(decoder->line_decoder);
                 decoder->line_decoder = NULL;
         }
+        pixfmt_conv_chain_destroy(decoder->line_conv_chain);
+        decoder->line_conv_chain = NULL;
 
         for (auto && item : decoder->change_il_state) {
                 free(item);
@@ -1077,6 +1118,47 @@ static vector<pair<struct pixfmt_desc, codec_t>> video_decoder_order_output_code
         return ret;
 }
 
+static bool pixfmt_degrades(codec_t in, codec_t out)
+{
+        const struct pixfmt_desc src = get_pixfmt_desc(in);
+        const struct pixfmt_desc dst = get_pixfmt_desc(out);
+        return dst.depth < src.depth || dst.subsampling < src.subsampling;
+}
+
+/**
+ * Tries a conversion over intermediate pixel formats if there is no direct
+ * line decoder or the direct one degrades the source. If the planner finds
+ * a better one, it is set to decoder->line_conv_chain and decode_line is
+ * reset (the chain replaces it).
+ */
+static void try_conv_chain(struct state_video_decoder *decoder,
+                           struct video_desc desc, const codec_t *candidates,
+                           decoder_t *decode_line, codec_t *out_codec)
+{
+        codec_t chain_codec = VIDEO_CODEC_NONE;
+        struct pixfmt_conv_chain *chain = pixfmt_conv_chain_create(
+            desc.color_spec, candidates, &chain_codec, desc.width);
+        if (chain == NULL) {
+                return;
+        }
+        codec_t path[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        const struct pixfmt_desc src_desc = get_pixfmt_desc(desc.color_spec);
+        const struct pixfmt_desc chain_desc = get_pixfmt_desc(chain_codec);
+        const struct pixfmt_desc direct_desc = get_pixfmt_desc(*out_codec);
+        if (pixfmt_conv_chain_get_path(chain, path) == 1 ||
+            (*decode_line != NULL &&
+             compare_pixdesc(&chain_desc, &direct_desc, &src_desc) >= 0)) {
+                pixfmt_conv_chain_destroy(chain);
+                return;
+        }
+        LOG(LOG_LEVEL_VERBOSE) << MOD_NAME "Using multi-hop conversion from "
+                               << get_codec_name(desc.color_spec) << " to "
+                               << get_codec_name(chain_codec) << "\n";
+        decoder->line_conv_chain = chain;
+        *decode_line = NULL;
+        *out_codec = chain_codec;
+}
+
 /**
  * This function selects, according to given video description, appropriate
  *
@@ -1116,8 +1198,13 @@ static codec_t choose_codec_and_decoder(struct state_video_decoder *decoder, str
                 vector<codec_t> native_codecs_copy = decoder->native_codecs;
                 native_codecs_copy.push_back(VIDEO_CODEC_NONE); // this needs to be NULL-terminated
                 *decode_line = get_best_decoder_from(desc.color_spec, native_codecs_copy.data(), &out_codec);
-                if (*decode_line) {
+                if (*decode_line == NULL || pixfmt_degrades(desc.color_spec, out_codec)) {
+                        try_conv_chain(decoder, desc, native_codecs_copy.data(), decode_line, &out_codec);
+                }
+                if (*decode_line || decoder->line_conv_chain) {
                         decoder->decoder_type = LINE_DECODER;
+                        watch_pixfmt_degrade(MOD_NAME, get_pixfmt_desc(desc.color_spec),
+                                        get_pixfmt_desc(out_codec));
                         goto after_linedecoder_lookup;
                 }
         }
@@ -1125,7 +1212,7 @@ static codec_t choose_codec_and_decoder(struct state_video_decoder *decoder, str
 after_linedecoder_lookup:
 
         /* we didn't find line decoder. So try now regular (aka DXT) decoder */
-        if(*decode_line == NULL) {
+        if (*decode_line == NULL && decoder->line_conv_chain == NULL) {
                 decoder->decompress_state.resize(decoder->max_substreams);
 
                 // try to probe video format
@@ -1326,6 +1413,7 @@ static bool reconfigure_decoder(struct state_video_decoder *decoder,
                         memcpy(out->shifts, display_requested_rgb_shift, 3 * sizeof(int));
 
                         out->decode_line = decode_line;
+                        out->conv_chain = decoder->line_conv_chain;
                         out->dst_pitch = decoder->pitch;
                         out->src_linesize = vc_get_linesize(desc.width, desc.color_spec);
                         out->dst_linesize = vc_get_linesize(desc.width, out_codec);
@@ -1347,6 +1435,7 @@ static bool reconfigure_decoder(struct state_video_decoder *decoder,
                                                         3 * sizeof(int));
 
                                         out->decode_line = decode_line;
+                                        out->conv_chain = decoder->line_conv_chain;
 
                                         out->dst_pitch = decoder->pitch;
                                         out->src_linesize =
@@ -1369,6 +1458,7 @@ static bool reconfigure_decoder(struct state_video_decoder *decoder,
                                                         3 * sizeof(int));
 
                                         out->decode_line = decode_line;
+                                        out->conv_chain = decoder->line_conv_chain;
                                         out->src_linesize =
                                                 vc_get_linesize(desc.width, desc.color_spec);
                                         out->dst_pitch =
@@ -1507,12 +1597,165 @@ static void check_for_mode_change(struct state_video_decoder *decoder,
         report += desc;
         control_report_stats(decoder->control, report.c_str());
 
+        // deferred placements point to the frame and line decoders that are
+        // going to be reconfigured, so place them now
+        if (!decoder->placements.empty()) {
+                place_packets_parallel(decoder);
+        }
         reconfigure_helper(decoder, network_desc, {});
 }
 
 #define ERROR_GOTO_CLEANUP ret = false; goto cleanup;
 #define max(a, b)       (((a) > (b))? (a): (b))
 
+/**
+ * Places (decodes) the packet payload to the tile with the line decoder.
+ *
+ * @param prints number of previously printed warnings (for rate-limiting)
+ * @returns      number of new warnings (0 or 1)
+ */
+static int place_packet_line(struct tile *tile,
+                             const struct line_decoder *line_decoder,
+                             uint32_t data_pos, const char *data, int len,
+                             int prints)
+{
+        const int prints_orig = prints;
+        /* MAGIC, don't touch it, you definitely break it
+         *  *source* is data from network, *destination* is frame buffer
+         */
+
+        /* compute Y pos in source frame and convert it to
+         * byte offset in the destination frame
+         */
+        int y = (data_pos / line_decoder->src_linesize) * line_decoder->dst_pitch;
+
+        /* compute X pos in source frame */
+        int s_x = data_pos % line_decoder->src_linesize;
+
+        /* convert X pos from source frame into the destination frame.
+         * it is byte offset from the beginning of a line.
+         */
+        int d_x = s_x * line_decoder->conv_num / line_decoder->conv_den;
+
+        /* pointer to data payload in packet */
+        auto *source = (const unsigned char *)(data);
+
+        /* copy whole packet that can span several lines.
+         * we need to clip data (v210 case) or center data (RGBA, R10k cases)
+         */
+        while (len > 0) {
+                /* len id payload length in source BPP
+                 * decoder needs len in destination BPP, so convert it
+                 */
+                int l = len * line_decoder->conv_num / line_decoder->conv_den;
+
+                /* do not copy multiple lines, we need to
+                 * copy (& clip, center) line by line
+                 */
+                if (l + d_x > (int) line_decoder->dst_linesize) {
+                        l = line_decoder->dst_linesize - d_x;
+                }
+
+                /* compute byte offset in destination frame */
+                const uint32_t offset = y + d_x;
+
+                /* watch the SEGV */
+                if (l + line_decoder->base_offset + offset <= tile->data_len) {
+                        /*decode frame:
+                         * we have offset for destination
+                         * we update source contiguously
+                         * we pass {r,g,b}shifts */
+                        line_decoder_decode(line_decoder, (unsigned char *) tile->data + line_decoder->base_offset + offset,
+                                        source, l);
+                        /* we decoded one line (or a part of one line) to the end of the line
+                         * so decrease *source* len by 1 line (or that part of the line */
+                        len -= line_decoder->src_linesize - s_x;
+                        /* jump in source by the same amount */
+                        source += line_decoder->src_linesize - s_x;
+                } else {
+                        /* this should not ever happen as we call reconfigure before each packet
+                         * iff reconfigure is needed. But if it still happens, something is terribly wrong
+                         * say it loudly
+                         */
+                        if((prints % 100) == 0) {
+                                log_msg(LOG_LEVEL_ERROR, "WARNING!! Discarding input data as frame buffer is too small.\n"
+                                                "Well this should not happened. Expect troubles pretty soon.\n");
+                        }
+                        prints++;
+                        len = 0;
+                }
+                /* each new line continues from the beginning */
+                d_x = 0;        /* next line from beginning */
+                s_x = 0;
+                y += line_decoder->dst_pitch;  /* next line */
+        }
+        return prints - prints_orig;
+}
+
+/**
+ * Copies the packet payload to the tile (compressed or FEC-protected data).
+ * Parameters and return value as for place_packet_line().
+ */
+static int place_packet_copy(struct tile *tile, uint32_t data_pos,
+                             const char *data, int len, int prints)
+{
+        int ret = 0;
+        if (data_pos + len > tile->data_len) {
+                if((prints % 100) == 0) {
+                        log_msg(LOG_LEVEL_ERROR, "WARNING!! Discarding input data as frame buffer is too small.\n"
+                                        "Well this should not happened. Expect troubles pretty soon.\n");
+                }
+                ret = 1;
+                len = max<int>(0, (int) tile->data_len - (int) data_pos);
+        }
+        memcpy(tile->data + data_pos, (const unsigned char *)data, len);
+        return ret;
+}
+
+struct placement_worker_data {
+        const packet_placement *begin;
+        const packet_placement *end;
+        int prints;
+};
+
+static void *placement_worker(void *arg)
+{
+        auto *d = (struct placement_worker_data *) arg;
+        for (const auto *p = d->begin; p != d->end; ++p) {
+                if (p->line_decoder != nullptr) {
+                        d->prints += place_packet_line(p->tile, p->line_decoder,
+                                                       p->data_pos, p->data,
+                                                       p->len, d->prints);
+                } else {
+                        d->prints += place_packet_copy(p->tile, p->data_pos,
+                                                       p->data, p->len,
+                                                       d->prints);
+                }
+        }
+        return nullptr;
+}
+
+/**
+ * Places the packets collected in decoder->placements split to contiguous
+ * packet ranges over placement workers. Returns after all workers have
+ * finished.
+ */
+static void place_packets_parallel(struct state_video_decoder *decoder)
+{
+        enum { MIN_PKTS_PER_WORKER = 32 };
+        const int count = decoder->placements.size();
+        const int workers =
+            clamp(count / MIN_PKTS_PER_WORKER, 1, decoder->placement_workers);
+        struct placement_worker_data data[MAX_CPU_CORES];
+        for (int i = 0; i < workers; ++i) {
+                data[i].begin = decoder->placements.data() + (long) count * i / workers;
+                data[i].end = decoder->placements.data() + (long) count * (i + 1) / workers;
+                data[i].prints = 0;
+        }
+        task_run_parallel(placement_worker, workers, data, sizeof data[0], nullptr);
+        decoder->placements.clear();
+}
+
 /**
  * @brief Decodes a participant buffer representing one video frame.
  * @param cdata        PBUF buffer
@@ -1537,7 +1780,7 @@ int decode_video_frame(struct coded_data *cdata, void *decoder_data, struct pbuf
         // is just the FEC buffer present, so we point to it instead to copying
         struct video_frame *frame = vf_alloc(max_substreams);
         frame->callbacks.data_deleter = vf_data_deleter;
-        unique_ptr<map<int, int>[]> pckt_list(new map<int, int>[max_substreams]);
+        unique_ptr<received_extents[]> pckt_list(new received_extents[max_substreams]);
 
         int buffer_number = 0;
         bool buffer_swapped = false;
@@ -1547,6 +1790,7 @@ int decode_video_frame(struct coded_data *cdata, void *decoder_data, struct pbuf
                 vf_free(frame);
                 return false;
         }
+        decoder->placements.clear();
 
         main_msg_reconfigure *msg_reconf;
         while ((msg_reconf = decoder->msg_queue.pop(true /* nonblock */))) {
@@ -1583,6 +1827,16 @@ int decode_video_frame(struct coded_data *cdata, void *decoder_data, struct pbuf
                                               .symbol_size = 0 };
         }
 
+        // room for an extent per packet so that reordering doesn't reallocate
+        int pkt_count = 0;
+        for (struct coded_data *c = cdata; c != NULL; c = c->nxt) {
+                pkt_count += 1;
+        }
+        for (int i = 0; i < max_substreams; ++i) {
+                pckt_list[i].reserve((pkt_count + max_substreams - 1) /
+                                     max_substreams);
+        }
+
         while (cdata != NULL) {
                 int len;
                 const char *data;
@@ -1699,7 +1953,7 @@ int decode_video_frame(struct coded_data *cdata, void *decoder_data, struct pbuf
 
                 buffer_num[substream] = buffer_number;
                 frame->tiles[substream].data_len = buffer_length;
-                pckt_list[substream][data_pos] = len;
+                pckt_list[substream].add(data_pos, len);
 
                 if ((pt == PT_VIDEO || pt == PT_ENCRYPT_VIDEO) && decoder->decoder_type == LINE_DECODER) {
                         struct tile *tile = NULL;
@@ -1721,97 +1975,34 @@ int decode_video_frame(struct coded_data *cdata, void *decoder_data, struct pbuf
 
                         /* End of critical section */
 
-                        /* MAGIC, don't touch it, you definitely break it
-                         *  *source* is data from network, *destination* is frame buffer
-                         */
-
-                        /* compute Y pos in source frame and convert it to
-                         * byte offset in the destination frame
-                         */
-                        int y = (data_pos / line_decoder->src_linesize) * line_decoder->dst_pitch;
-
-                        /* compute X pos in source frame */
-                        int s_x = data_pos % line_decoder->src_linesize;
-
-                        /* convert X pos from source frame into the destination frame.
-                         * it is byte offset from the beginning of a line.
-                         */
-                        int d_x = s_x * line_decoder->conv_num / line_decoder->conv_den;
-
-                        /* pointer to data payload in packet */
-                        auto *source = (const unsigned char *)(data);
-
-                        /* copy whole packet that can span several lines.
-                         * we need to clip data (v210 case) or center data (RGBA, R10k cases)
-                         */
-                        while (len > 0) {
-                                /* len id payload length in source BPP
-                                 * decoder needs len in destination BPP, so convert it
-                                 */
-                                int l = len * line_decoder->conv_num / line_decoder->conv_den;
-
-                                /* do not copy multiple lines, we need to
-                                 * copy (& clip, center) line by line
-                                 */
-                                if (l + d_x > (int) line_decoder->dst_linesize) {
-                                        l = line_decoder->dst_linesize - d_x;
-                                }
-
-                                /* compute byte offset in destination frame */
-                                const uint32_t offset = y + d_x;
-
-                                /* watch the SEGV */
-                                if (l + line_decoder->base_offset + offset <= tile->data_len) {
-                                        /*decode frame:
-                                         * we have offset for destination
-                                         * we update source contiguously
-                                         * we pass {r,g,b}shifts */
-                                        line_decoder->decode_line((unsigned char*)tile->data + line_decoder->base_offset + offset, source, l,
-                                                        line_decoder->shifts[0], line_decoder->shifts[1],
-                                                        line_decoder->shifts[2]);
-                                        /* we decoded one line (or a part of one line) to the end of the line
-                                         * so decrease *source* len by 1 line (or that part of the line */
-                                        len -= line_decoder->src_linesize - s_x;
-                                        /* jump in source by the same amount */
-                                        source += line_decoder->src_linesize - s_x;
-                                } else {
-                                        /* this should not ever happen as we call reconfigure before each packet
-                                         * iff reconfigure is needed. But if it still happens, something is terribly wrong
-                                         * say it loudly
-                                         */
-                                        if((prints % 100) == 0) {
-                                                log_msg(LOG_LEVEL_ERROR, "WARNING!! Discarding input data as frame buffer is too small.\n"
-                                                                "Well this should not happened. Expect troubles pretty soon.\n");
-                                        }
-                                        prints++;
-                                        len = 0;
-                                }
-                                /* each new line continues from the beginning */
-                                d_x = 0;        /* next line from beginning */
-                                s_x = 0;
-                                y += line_decoder->dst_pitch;  /* next line */
+                        // the conversion chain has a single scratch buffer
+                        if (decoder->placement_workers > 1 && data != plaintext &&
+                                        line_decoder->conv_chain == nullptr) {
+                                decoder->placements.push_back({ tile, line_decoder, data_pos, data, len });
+                        } else {
+                                prints += place_packet_line(tile, line_decoder, data_pos, data, len, prints);
                         }
                 } else { /* PT_VIDEO_LDGM or external decoder */
                         if(!frame->tiles[substream].data) {
                                 frame->tiles[substream].data = (char *) malloc(buffer_length + PADDING);
                         }
 
-                        if (data_pos + len > (unsigned) buffer_length) {
-                                if((prints % 100) == 0) {
-                                        log_msg(LOG_LEVEL_ERROR, "WARNING!! Discarding input data as frame buffer is too small.\n"
-                                                        "Well this should not happened. Expect troubles pretty soon.\n");
-                                }
-                                prints++;
-                                len = max<int>(0, buffer_length - data_pos);
+                        if (decoder->placement_workers > 1 && data != plaintext) {
+                                decoder->placements.push_back({ &frame->tiles[substream], nullptr, data_pos, data, len });
+                        } else {
+                                prints += place_packet_copy(&frame->tiles[substream], data_pos, data, len, prints);
                         }
-                        memcpy(frame->tiles[substream].data + data_pos,
-                               (const unsigned char *)data, len);
                 }
 
 next_packet:
                 cdata = cdata->nxt;
         }
 
+        // barrier - the frame is passed further only when all data are placed
+        if (!decoder->placements.empty()) {
+                place_packets_parallel(decoder);
+        }
+
         if (FRAMEBUFFER_NOT_READY(decoder) && (pt == PT_VIDEO || pt == PT_ENCRYPT_VIDEO)) {
                 ret = false;
                 goto cleanup;
@@ -1825,13 +2016,12 @@ next_packet:
         if (decoder->decoder_type != LINE_DECODER) {
                 for(int i = 0; i < max_substreams; ++i) {
                         unsigned int last_end = 0;
-                        for (auto const & packets : pckt_list[i]) {
-                                unsigned int start = packets.first;
-                                unsigned int len = packets.second;
+                        for (auto const & extent : pckt_list[i]) {
+                                unsigned int start = extent.start;
                                 if (last_end < start) {
                                         memset(frame->tiles[i].data + last_end, 0, start - last_end);
                                 }
-                                last_end = start + len;
+                                last_end = extent.end;
                         }
                         if (last_end < frame->tiles[i].data_len) {
                                 memset(frame->tiles[i].data + last_end, 0, frame->tiles[i].data_len - last_end);
@@ -87,6 +87,7 @@
 #define MAGIC to_fourcc('R', 'T', 'r', 't')
 #define MOD_NAME "[rxtx/rtp] "
 #define RATE_AUTOSELECT (-3)
+#define DEFAULT_RTX_PACKETS 8192
 
 #if !defined _WIN32
 #define VIDEO_MT true
@@ -103,6 +104,12 @@ const enum module_class path_sender_audio[] = { MODULE_CLASS_SENDER,
                                                 MODULE_CLASS_AUDIO,
                                                 MODULE_CLASS_NONE };
 
+ADD_TO_PARAM("rtp-nack", "* rtp-nack[=<packets>]\n"
+                "  request retransmission of lost video packets with RTCP NACKs\n"
+                "  while the frame can still be played out (receiver) and keep the\n"
+                "  last <packets> sent packets for retransmission (sender, default "
+                TOSTRING(DEFAULT_RTX_PACKETS) ")\n");
+
 struct pdb;
 struct rtp;
 
@@ -130,6 +137,7 @@ struct rtp_rxtx_common_priv_state {
         char *mcast_if;
         int   ttl;
         long long vbitrate;
+        enum tx_kernel_pacing vkpacing;
         struct rtp_medium_priv medium[NUM_TX_MEDIA];
 
         struct rtp_rxtx_common pub;
@@ -145,7 +153,8 @@ static struct rtp *initialize_network(const char *addr, int recv_port,
                                       const char *mcast_if, int ttl,
                                       enum tx_media_type medium);
 static void        destroy_rtp_device(struct rtp *network_device);
-static int         parse_bitrate(char *optarg, long long int *bitrate);
+static int         parse_bitrate(char *optarg, long long int *bitrate,
+                                 enum tx_kernel_pacing *kpacing);
 
 static struct response *
 rtp_process_sender_message(struct rtp_rxtx_common_priv_state *s,
@@ -357,6 +366,9 @@ init_medium_state(struct rtp_rxtx_common_priv_state *s,
                         MSG(ERROR, "Unable to open %s transmitter!\n",  medium_str);
                         return false;
                 }
+                if (t == TX_MEDIA_VIDEO) {
+                        tx_set_kernel_pacing(medium_pub->tx, s->vkpacing);
+                }
         }
 
         pthread_mutex_init(&medium_pub->lock, nullptr);
@@ -480,7 +492,8 @@ rtp_rxtx_common_init(struct rtp_rxtx_common **out, struct rxtx_params *params)
         pub->priv                   = s;
         s->magic                    = MAGIC;
 
-        int rc = parse_bitrate(params->video_bitrate_limit, &s->vbitrate);
+        int rc = parse_bitrate(params->video_bitrate_limit, &s->vbitrate,
+                               &s->vkpacing);
         if (rc != 0) {
                 rtp_rxtx_common_done(pub);
                 return rc;
@@ -576,6 +589,12 @@ initialize_network(const char *addr, int recv_port, int send_port,
 
         if (medium == TX_MEDIA_VIDEO) {
                 rtp_set_send_buf(device, INITIAL_VIDEO_SEND_BUFFER_SIZE);
+                const char *nack = get_commandline_param("rtp-nack");
+                if (nack != nullptr) {
+                        rtp_rtx_init(device, strlen(nack) > 0
+                                                 ? atoi(nack)
+                                                 : DEFAULT_RTX_PACKETS);
+                }
         } else {
                 rtp_set_option(device, RTP_OPT_RECORD_SOURCE, true);
         }
@@ -774,8 +793,23 @@ rtp_recv_audio_frame(struct rtp_rxtx_common *s, decode_audio_frame_fn decode)
 }
 
 static int
-parse_bitrate(char *optarg, long long int *bitrate)
+parse_bitrate(char *optarg, long long int *bitrate,
+              enum tx_kernel_pacing *kpacing)
 {
+        char *kpacing_spec = strchr(optarg, ':');
+        if (kpacing_spec != nullptr) {
+                *kpacing_spec++ = '\0';
+                if (strcmp(kpacing_spec, "fq") == 0) {
+                        *kpacing = TX_KPACING_FQ;
+                } else if (strcmp(kpacing_spec, "txtime") == 0) {
+                        *kpacing = TX_KPACING_TXTIME;
+                } else {
+                        log_msg(LOG_LEVEL_ERROR,
+                                "Unknown kernel pacing \"%s\"!\n",
+                                kpacing_spec);
+                        return -1;
+                }
+        }
         if (strlen(optarg) == 0) {
                 *bitrate = RATE_AUTOSELECT;
                 return 0;
@@ -788,7 +822,7 @@ parse_bitrate(char *optarg, long long int *bitrate)
                 { .name = "dynamic",   .val = RATE_DYNAMIC   },
                 { .name = "unlimited", .val = RATE_UNLIMITED },
         };
-        for (unsigned i = 0; countof(bitrate_spec_map); i++) {
+        for (unsigned i = 0; i < countof(bitrate_spec_map); i++) {
                 if (strcmp(bitrate_spec_map[i].name, optarg) == 0) {
                         *bitrate = bitrate_spec_map[i].val;
                         return 0;
@@ -799,7 +833,7 @@ parse_bitrate(char *optarg, long long int *bitrate)
                 color_printf(
                     "Usage:\n"
                     "\tuv " TBOLD ("-l [auto | dynamic | unlimited | "
-                    NUMERIC_PATTERN "]\n")
+                    NUMERIC_PATTERN "][:fq | :txtime]\n")
                     "where\n"
                     "\t"
                     TBOLD("auto")
@@ -813,7 +847,15 @@ parse_bitrate(char *optarg, long long int *bitrate)
                     " - send packets at a wire speed (in bursts)\n"
                     "\t"
                     TBOLD(NUMERIC_PATTERN)
-                    " - send packets at most at specified bitrate\n\n"
+                    " - send packets at most at specified bitrate\n"
+                    "\t"
+                    TBOLD(":fq")
+                    " - offload pacing to the kernel (SO_MAX_PACING_RATE, "
+                    "needs fq qdisc)\n"
+                    "\t"
+                    TBOLD(":txtime")
+                    " - offload pacing to the kernel with per-packet launch "
+                    "times (SO_TXTIME, needs fq or etf qdisc)\n\n"
                     TBOLD("Notes: ")
                     "Use an exclamation mark to indicate intentionally very "
                     "low bitrate. 'E' to use the value as a fixed bitrate, "
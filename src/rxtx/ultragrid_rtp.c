@@ -77,6 +77,7 @@
 #include "rtp/fec.h"            // for fec
 #include "rtp/pbuf.h"
 #include "rtp/rtp.h"
+#include "rtp/rtp_callback.h"  // for rtp_loss_report_app
 #include "rtp/video_decoders.h"
 #include "rxtx.h"
 #include "rxtx/rtp_common.h"  // for rtp_common
@@ -99,9 +100,15 @@ struct display;
 #define MAGIC    to_fourcc('R', 'T', 'u', 'r')
 #define MOD_NAME "[rxtx/ultragrid_rtp] "
 
+enum {
+        RTX_KEEP_FRAMES = 2, ///< sent frames kept for zero-copy retransmission
+        NACK_BATCH      = 64,
+};
+
 struct async_data {
         struct ultragrid_rtp_rxtx *s;
         struct video_frame *f;
+        bool rtx_keep; ///< keep the frame after sending, see rtx_keep_frame()
 };
 
 struct ultragrid_rtp_rxtx {
@@ -128,6 +135,16 @@ struct ultragrid_rtp_rxtx {
         long long int         send_bytes_total;
         struct module        *parent;
 
+        bool fec_streaming; ///< send systematic part before parity is computed
+        bool nack;          ///< rtp-nack - request/retransmit lost packets
+
+        /// sent frames referenced by the RTP retransmission buffer
+        struct rtx_frame {
+                struct video_frame *f;
+                uint16_t end_seq; ///< RTP seqno following the frame
+        } rtx_frames[RTX_KEEP_FRAMES];
+        unsigned rtx_frame_idx;
+
         time_ns_t start_time;
 
         struct module *receiver_mod;
@@ -151,6 +168,10 @@ static void done(void *state)
         free(s);
 }
 
+ADD_TO_PARAM("fec-streaming", "* fec-streaming\n"
+                "  start sending RS/LDGM protected frames before the parity is\n"
+                "  computed (lower latency, wire format is unchanged)\n");
+
 static void *
 init(struct rxtx_params *params)
 {
@@ -169,6 +190,9 @@ init(struct rxtx_params *params)
         s->start_time     = params->start_time;
         s->receiver_mod   = params->receiver_mod;
         s->async_sending_task = nullptr;
+        s->fec_streaming =
+            get_commandline_param("fec-streaming") != nullptr;
+        s->nack = get_commandline_param("rtp-nack") != nullptr;
         int rc = rtp_rxtx_common_init(&s->rtp_common, params);
         if (rc != 0) {
                 done(s);
@@ -189,12 +213,42 @@ init(struct rxtx_params *params)
 }
 
 
+/**
+ * Keeps the sent frame until RTX_KEEP_FRAMES newer frames are sent so that
+ * its packets can be retransmitted without being copied, the oldest kept
+ * frame is released.
+ */
+static void
+rtx_keep_frame(struct ultragrid_rtp_rxtx *s, struct rtp *network_device,
+               struct video_frame *f)
+{
+        struct rtx_frame *slot =
+            &s->rtx_frames[s->rtx_frame_idx++ % RTX_KEEP_FRAMES];
+        if (slot->f != nullptr) {
+                rtp_rtx_release(network_device, slot->end_seq);
+                slot->f->callbacks.dispose(slot->f);
+        }
+        slot->f       = f;
+        slot->end_seq = rtp_get_next_seq(network_device);
+}
+
 static void join(void *state) {
         struct ultragrid_rtp_rxtx *s = state;
         if(s->async_sending_task){
                 wait_task(s->async_sending_task);
                 s->async_sending_task = nullptr;
         }
+        struct rtp *network_device =
+            s->rtp_common->medium[TX_MEDIA_VIDEO].network_device;
+        for (unsigned i = 0; i < RTX_KEEP_FRAMES; ++i) {
+                struct rtx_frame *slot = &s->rtx_frames[i];
+                if (slot->f != nullptr) {
+                        rtp_rtx_release(network_device,
+                                        rtp_get_next_seq(network_device));
+                        slot->f->callbacks.dispose(slot->f);
+                        slot->f = nullptr;
+                }
+        }
 }
 
 static void *send_video_frame_async_callback(void *arg);
@@ -207,8 +261,11 @@ send_video_frame(void *state, struct video_frame *tx_frame)
             &s->rtp_common->medium[TX_MEDIA_VIDEO];
 
         if (video->fec_state != nullptr) {
-                struct video_frame *f = fec_encode_video_frame(
-                    video->fec_state, tx_frame);
+                struct video_frame *f =
+                    s->fec_streaming
+                        ? fec_encode_video_frame_streaming(video->fec_state,
+                                                           tx_frame)
+                        : fec_encode_video_frame(video->fec_state, tx_frame);
                 tx_frame->callbacks.dispose(tx_frame);
                 tx_frame = f;
         }
@@ -219,8 +276,17 @@ send_video_frame(void *state, struct video_frame *tx_frame)
         }
         rtp_rxtx_sender_do_housekeeping(s->rtp_common, TX_MEDIA_VIDEO);
 
+        // FEC and encryption output buffers are reused by the next frame,
+        // plain frames are kept and referenced by the retransmission buffer
+        const bool rtx_copy =
+            video->fec_state != nullptr || s->rtp_common->encryption != nullptr;
+        if (s->nack) {
+                rtp_rtx_set_copy(video->network_device, rtx_copy);
+        }
+
         s->async_data.s = s;
         s->async_data.f = tx_frame;
+        s->async_data.rtx_keep = s->nack && !rtx_copy;
         s->async_sending_task = task_run_async(send_video_frame_async_callback, &s->async_data);
 }
 
@@ -232,9 +298,15 @@ static void *send_video_frame_async_callback(void *arg) {
 
         CHK_PTHR(pthread_mutex_lock(&video->lock));
         tx_send(video->tx, tx_frame, video->network_device);
+        if (data->rtx_keep) {
+                rtx_keep_frame(s, video->network_device, tx_frame);
+                tx_frame = nullptr;
+        }
         CHK_PTHR(pthread_mutex_unlock(&video->lock));
 
-        tx_frame->callbacks.dispose(tx_frame);
+        if (tx_frame != nullptr) {
+                tx_frame->callbacks.dispose(tx_frame);
+        }
 
         return nullptr;
 }
@@ -388,7 +460,7 @@ receiver_thread(void *arg)
                 uint32_t ts = (s->start_time - curr_time) / (100 * 1000 * 9); // at 90000 Hz
 
                 rtp_update(video->network_device, curr_time);
-                rtp_send_ctrl(video->network_device, ts, nullptr, curr_time);
+                rtp_send_ctrl(video->network_device, ts, rtp_loss_report_app, curr_time);
 
                 /* Receive packets from the network... The timeout is adjusted */
                 /* to match the video capture rate, so the transmitter works.  */
@@ -464,6 +536,15 @@ receiver_thread(void *arg)
                                 }
                         }
 
+                        if (s->nack) {
+                                uint16_t seqs[NACK_BATCH];
+                                const int count = pbuf_get_nacks(
+                                    cp->playout_buffer, curr_time, seqs,
+                                    countof(seqs));
+                                rtp_send_nack(video->network_device, cp->ssrc,
+                                              seqs, count);
+                        }
+
                         struct vcodec_state *vdecoder_state = (struct vcodec_state *) cp->decoder_state;
 
                         /* Decode and render video... */
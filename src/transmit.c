@@ -58,7 +58,10 @@
 #include "transmit.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>                  // for UINT_MAX
 #include <math.h>
+#include <stdint.h>                  // for UINT64_MAX
 #include <stdio.h>                   // for snprintf, fprintf, stderr
 #include <stdlib.h>
 #include <string.h>                  // for memcpy, strlen, strchr, strstr
@@ -81,7 +84,10 @@
 #include "lib_common.h"
 #include "messaging.h" // for check_message...
 #include "module.h"
+#include "pdb.h"     // for pdb_take_loss_report
 #include "rtp/fec.h"
+#include "rtp/fec_adapt.h"
+#include "rtp/pbuf.h"  // for pbuf_loss_report
 #include "rtp/rtp.h"
 #include "rtp/rtp_types.h"   // for fec_payload_hdr_t, crypto_payloa...
 #include "rtp/rtpdec_h264.h" // for hevc_nal_type
@@ -93,6 +99,7 @@
 #include "utils/macros.h"
 #include "utils/misc.h" // unit_evaluate
 #include "utils/random.h"
+#include "utils/worker.h"
 #include "video_codec.h"
 #include "video_frame.h" // for vf_get_tile
 
@@ -105,12 +112,22 @@ struct audio_frame2;
 #define RATE_MIN     RATE_DYNAMIC
 
 #define CONTROL_PORT_BANDWIDTH_REPORT_INTERVAL_NS NS_IN_SEC
+#define TX_MAX_BURST_BYTES (64 * 1024) ///< max data sent at once when pacing
+#define TX_PACE_SPIN_DEFAULT_US 50 ///< busy-wait only this long before deadline
+#define TX_PACE_SPIN_PARAM "tx-pace-spin"
+#define TX_PACE_BURST_PARAM "tx-pace-burst"
 
 #define GET_STARTTIME clock_gettime(CLOCK_MONOTONIC, &start)
 #define GET_STOPTIME  clock_gettime(CLOCK_MONOTONIC, &stop)
 #define GET_DELTA delta = (stop.tv_sec - start.tv_sec) * 1000000000l + stop.tv_nsec - start.tv_nsec
 
 static void tx_update(struct tx *tx, struct video_frame *frame, int substream);
+
+ADD_TO_PARAM(TX_PACE_SPIN_PARAM, "* " TX_PACE_SPIN_PARAM "=<us>\n"
+                "  Traffic shaper sleeps between packet bursts and busy-waits only last <us> microseconds\n"
+                "  before each deadline (default " TOSTRING(TX_PACE_SPIN_DEFAULT_US) "), use a large value to busy-wait only\n");
+ADD_TO_PARAM(TX_PACE_BURST_PARAM, "* " TX_PACE_BURST_PARAM "=<n>\n"
+                "  Pace video per bursts of <n> packets (default: matched to the batched send path)\n");
 static uint32_t format_interl_fps_hdr_row(enum interlacing_t interlacing, double input_fps);
 
 static void
@@ -129,6 +146,15 @@ struct rate_limit_dyn {
 };
 enum { EXCESS_GAP = 4 }; ///< minimal gap between excessive frames
 
+/// traffic shaper statistics accumulated since last report
+struct tx_pacing_stats {
+        long long err_sum; ///< sum of absolute pacing errors [ns]
+        long      err_max; ///< max absolute pacing error [ns]
+        long      waits;   ///< number of shaper deadlines
+        long long cpu_ns;  ///< sender thread CPU time
+        long      frames;
+};
+
 struct tx {
         struct module mod;
 
@@ -147,6 +173,7 @@ struct tx {
 
         enum fec_type fec_scheme;
         bool fec_dup_1st_pkt;
+        struct fec_adapt *fec_adapt; ///< RS/LDGM parameters controller (auto)
         int mult_count;
 
         int last_fragment;
@@ -157,9 +184,21 @@ struct tx {
 
         const struct openssl_encrypt_info *enc_funcs;
         struct openssl_encrypt *encryption;
+        char *enc_arena;      ///< encrypted packets of the tile being sent
+        size_t enc_arena_size;
+        int *enc_len;         ///< lengths of packets in enc_arena
+        size_t enc_len_count;
         long long int bitrate;
         struct rate_limit_dyn dyn_rate_limit_state;
-		
+
+        long pace_spin_ns; ///< shaper busy-waits only last pace_spin_ns
+        int pace_burst;    ///< packets per shaper burst (0 - auto)
+        struct tx_pacing_stats pacing_stats;
+
+        enum tx_kernel_pacing kpacing;
+        struct rtp *kpacing_session; ///< session kpacing was configured for
+        uint64_t kpacing_rate;       ///< last set SO_MAX_PACING_RATE
+
         char tmp_packet[RTP_MAX_MTU];
 };
 
@@ -293,6 +332,16 @@ struct tx *tx_init(struct module *parent, unsigned mtu, enum tx_media_type media
         tx->bitrate = bitrate;
         tx->control = get_control_state(parent);
 
+        tx->pace_spin_ns = US_TO_NS(TX_PACE_SPIN_DEFAULT_US);
+        if (get_commandline_param(TX_PACE_SPIN_PARAM) != nullptr) {
+                tx->pace_spin_ns = US_TO_NS(
+                    atol(get_commandline_param(TX_PACE_SPIN_PARAM)));
+        }
+        if (get_commandline_param(TX_PACE_BURST_PARAM) != nullptr) {
+                tx->pace_burst =
+                    MAX(atoi(get_commandline_param(TX_PACE_BURST_PARAM)), 0);
+        }
+
         return tx;
 }
 
@@ -305,7 +354,7 @@ static bool set_fec(struct tx *tx, const char *fec_const)
         // handle  ...[:]nodup
         char *end = fec + MAX(strlen(fec), 5) - 5;
         if (strcmp(end, "nodup") == 0) {
-                req_1st_pkt_dup = true;
+                req_1st_pkt_dup = false;
                 *end            = '\0';
                 if (end > fec) { // ':'
                         end[-1] = '\0';
@@ -325,6 +374,13 @@ static bool set_fec(struct tx *tx, const char *fec_const)
 
         snprintf(msg->fec_cfg, sizeof(msg->fec_cfg), "flush");
 
+        fec_adapt_destroy(tx->fec_adapt);
+        tx->fec_adapt = nullptr;
+        const bool fec_auto = strcasecmp(fec_cfg, "auto") == 0;
+        if (fec_auto) { // start with defaults until the first frame
+                fec_cfg = "";
+        }
+
         tx->mult_count = 1; // default
         if (strcasecmp(fec, "none") == 0) {
                 tx->fec_scheme = FEC_NONE;
@@ -366,6 +422,17 @@ static bool set_fec(struct tx *tx, const char *fec_const)
                 ret = false;
         }
 
+        if (ret && fec_auto) {
+                tx->fec_adapt = fec_adapt_init(tx->fec_scheme, req_1st_pkt_dup);
+                if (tx->fec_adapt == nullptr) {
+                        MSG(ERROR, "Adaptive FEC is supported only for RS and LDGM!\n");
+                        ret = false;
+                } else {
+                        MSG(INFO, "FEC parameters will be adapted to the loss "
+                                  "reported by the receiver.\n");
+                }
+        }
+
         if (tx->fec_dup_1st_pkt) {
                 MSG(VERBOSE, "Duplicating 1st packet of every frame for better "
                              "error resiliency.\n");
@@ -429,9 +496,70 @@ void tx_done(struct tx *tx_session)
 {
         assert(tx_session->magic == TRANSMIT_MAGIC);
         module_done(&tx_session->mod);
+        fec_adapt_destroy(tx_session->fec_adapt);
+        free(tx_session->enc_arena);
+        free(tx_session->enc_len);
         free(tx_session);
 }
 
+/**
+ * Offloads video traffic pacing to the kernel. The rate is still computed
+ * per frame according to the rate mode passed to tx_init().
+ */
+void tx_set_kernel_pacing(struct tx *tx, enum tx_kernel_pacing kpacing)
+{
+        tx->kpacing         = kpacing;
+        tx->kpacing_session = nullptr;
+}
+
+/**
+ * Feeds the loss reported by receivers to the FEC controller. New parameters
+ * are passed to the FEC encoder the same way as by set_fec() so that they
+ * take effect from the next encoded frame.
+ */
+static void
+tx_fec_adapt(struct tx *tx, const struct video_frame *frame,
+             struct rtp *rtp_session)
+{
+        struct pbuf_loss_report report;
+        if (pdb_take_loss_report((struct pdb *) rtp_get_userdata(rtp_session),
+                                 &report) > 0) {
+                fec_adapt_report(tx->fec_adapt, &report);
+        }
+        tx->fec_dup_1st_pkt = fec_adapt_dup_1st_pkt(tx->fec_adapt);
+
+        size_t bytes = 0;
+        for (unsigned i = 0; i < frame->tile_count; ++i) {
+                bytes += frame->fec_params.type == FEC_NONE
+                             ? frame->tiles[i].data_len
+                             : (size_t) frame->tiles[i].data_len *
+                                   frame->fec_params.k /
+                                   (frame->fec_params.k + frame->fec_params.m);
+        }
+        const size_t payload = tx->mtu - (40 + sizeof(fec_payload_hdr_t));
+        const int frame_pkts = (bytes / frame->tile_count + payload - 1) / payload;
+
+        struct fec_desc desc;
+        if (!fec_adapt_update(tx->fec_adapt, frame_pkts, &desc)) {
+                return;
+        }
+        struct msg_sender *msg = (struct msg_sender *)
+                new_message(sizeof(struct msg_sender));
+        msg->type = SENDER_MSG_CHANGE_FEC;
+        if (desc.type == FEC_RS) {
+                snprintf(msg->fec_cfg, sizeof(msg->fec_cfg), "RS cfg %u:%u",
+                         desc.k, desc.k + desc.m);
+        } else {
+                snprintf(msg->fec_cfg, sizeof(msg->fec_cfg), "LDGM cfg %u:%u:%u",
+                         desc.k, desc.m, desc.c);
+        }
+        MSG(VERBOSE, "Adapting FEC to %s (%d pkts per tile)\n", msg->fec_cfg,
+            frame_pkts);
+        struct response *resp = send_message_to_receiver(
+            get_parent_module(&tx->mod), (struct message *) msg);
+        free_response(resp);
+}
+
 /*
  * sends one or more frames (tiles) with same TS in one RTP stream. Only one m-bit is set.
  */
@@ -443,6 +571,9 @@ tx_send(struct tx *tx, struct video_frame *frame, struct rtp *rtp_session)
         assert(!frame->fragment || tx->fec_scheme == FEC_NONE); // currently no support for FEC with fragments
         assert(!frame->fragment || frame->tile_count); // multiple tile are not currently supported for fragmented send
         fec_check_messages(tx);
+        if (tx->fec_adapt != nullptr) {
+                tx_fec_adapt(tx, frame, rtp_session);
+        }
 
         uint32_t ts =
             (frame->flags & TIMESTAMP_VALID) == 0
@@ -622,6 +753,7 @@ static void
 report_stats(struct tx *tx, struct rtp *rtp_session, long data_sent)
 {
         if (!tx->control || !control_stats_enabled(tx->control)) {
+                memset(&tx->pacing_stats, 0, sizeof tx->pacing_stats);
                 return;
         }
 
@@ -641,6 +773,17 @@ report_stats(struct tx *tx, struct rtp *rtp_session, long data_sent)
         control_report_stats(tx->control, buf);
         tx->last_stat_report  = current_time_ns;
         tx->sent_since_report = 0;
+
+        struct tx_pacing_stats *pstats = &tx->pacing_stats;
+        if (pstats->frames == 0) {
+                return;
+        }
+        snprintf_ch(buf, "tx_pacing %x %s %lld %ld %lld",
+                    rtp_my_ssrc(rtp_session), media,
+                    pstats->waits > 0 ? pstats->err_sum / pstats->waits : 0,
+                    pstats->err_max, pstats->cpu_ns / pstats->frames);
+        control_report_stats(tx->control, buf);
+        memset(pstats, 0, sizeof *pstats);
 }
 
 /**
@@ -684,6 +827,207 @@ get_packet_rate(struct tx *tx, struct video_frame *frame, int substream, long pa
         return packet_rate;
 }
 
+/**
+ * Returns number of packets sent at once by the batched send path (see
+ * rtp_async_start()). The traffic shaper then waits per burst, not per
+ * packet. Paced bursts are limited to TX_MAX_BURST_BYTES.
+ */
+static int
+get_burst_packets(struct tx *tx, struct rtp *rtp_session, long packet_rate)
+{
+        if (tx->pace_burst > 0) {
+                return tx->pace_burst;
+        }
+        const int batch = rtp_async_batch_size(rtp_session);
+        if (packet_rate == 0) {
+                return batch;
+        }
+        return MIN(batch, MAX(1, TX_MAX_BURST_BYTES / (int) tx->mtu));
+}
+
+/**
+ * Sleeps until the absolute (CLOCK_MONOTONIC) deadline.
+ */
+static void
+tx_sleep_until(const struct timespec *deadline)
+{
+#if defined __APPLE__ || defined _WIN32
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long ns = (deadline->tv_sec - now.tv_sec) * NS_IN_SEC +
+                       deadline->tv_nsec - now.tv_nsec;
+        if (ns <= 0) {
+                return;
+        }
+        struct timespec rel = { ns / NS_IN_SEC, ns % NS_IN_SEC };
+        nanosleep(&rel, nullptr);
+#else
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline,
+                               nullptr) == EINTR) {
+        }
+#endif
+}
+
+/**
+ * Traffic shaper wait - waits until target ns elapsed since start.
+ *
+ * Long gaps are slept so that the sender doesn't occupy whole CPU core,
+ * only the last spin_ns is busy-waited to keep the precision.
+ *
+ * @returns by how much was the deadline overslept [ns]
+ */
+static long
+tx_pace_wait(struct timespec start, long target, long spin_ns)
+{
+        struct timespec stop;
+        long delta;
+        GET_STOPTIME;
+        GET_DELTA;
+        if (target - delta > spin_ns) {
+                const long long ns = start.tv_nsec + target - spin_ns;
+                struct timespec deadline = { start.tv_sec + ns / NS_IN_SEC,
+                                             ns % NS_IN_SEC };
+                tx_sleep_until(&deadline);
+        }
+        while (target - delta > 0) {
+                GET_STOPTIME;
+                GET_DELTA;
+        }
+        return delta - target;
+}
+
+/**
+ * Configures kernel pacing for the frame (if requested).
+ *
+ * @returns inter-packet interval to be used by the userspace traffic shaper
+ *          (0 if the pacing is offloaded to the kernel)
+ */
+static long
+setup_kernel_pacing(struct tx *tx, struct rtp *rtp_session, long packet_rate)
+{
+        if (tx->kpacing == TX_KPACING_NONE) {
+                return packet_rate;
+        }
+        const bool reconf = tx->kpacing_session != rtp_session;
+        bool       ok     = true;
+        if (tx->kpacing == TX_KPACING_FQ) {
+                // mtu approximates the size of a packet incl. IP/UDP headers
+                const uint64_t rate =
+                    packet_rate == 0
+                        ? UINT64_MAX
+                        : (uint64_t) tx->mtu * NS_IN_SEC / packet_rate;
+                if (reconf || rate != tx->kpacing_rate) {
+                        ok = rtp_set_pacing_rate(rtp_session, rate);
+                        tx->kpacing_rate = rate;
+                }
+        } else if (reconf) {
+                ok = rtp_set_txtime(rtp_session, true);
+        }
+        if (!ok) {
+                MSG(WARNING, "Kernel pacing not available, using the "
+                             "userspace traffic shaper.\n");
+                tx->kpacing = TX_KPACING_NONE;
+                return packet_rate;
+        }
+        if (reconf) {
+                MSG(VERBOSE, "Pacing offloaded to the kernel (%s).\n",
+                    tx->kpacing == TX_KPACING_FQ ? "SO_MAX_PACING_RATE"
+                                                 : "SO_TXTIME");
+        }
+        tx->kpacing_session = rtp_session;
+        return 0;
+}
+
+enum {
+        ENC_MIN_PKTS_PER_WORKER = 32,
+        ENC_MAX_WORKERS         = 16,
+};
+
+struct encrypt_task {
+        struct tx        *tx;
+        char             *data;    ///< tile data
+        uint32_t         *headers; ///< RTP payload headers of the packets
+        int               hdr_len; ///< length of one header in headers
+        int               aad_len;
+        const uint16_t   *packet_sizes;
+        size_t            first;
+        size_t            count;
+        size_t            stride; ///< of tx->enc_arena
+};
+
+static void *
+encrypt_task(void *arg)
+{
+        struct encrypt_task *t = arg;
+        for (size_t i = t->first; i < t->first + t->count; ++i) {
+                uint32_t *hdr = t->headers + i * t->hdr_len / sizeof *hdr;
+                t->tx->enc_len[i] = t->tx->enc_funcs->encrypt(
+                    t->tx->encryption, t->data + ntohl(hdr[1]),
+                    t->packet_sizes[i], (char *) hdr, t->aad_len,
+                    t->tx->enc_arena + i * t->stride);
+        }
+        return NULL;
+}
+
+/**
+ * Encrypts all packets of the tile (in parallel) to tx->enc_arena, packet i
+ * is at offset i * stride, its length in tx->enc_len[i].
+ *
+ * @retval false  on error
+ */
+static bool
+encrypt_packets(struct tx *tx, char *data, uint32_t *headers,
+                int hdr_len, int aad_len, const uint16_t *packet_sizes,
+                size_t nr_packets, size_t stride)
+{
+        if (tx->enc_arena_size < nr_packets * stride) {
+                free(tx->enc_arena);
+                tx->enc_arena_size = nr_packets * stride;
+                tx->enc_arena      = malloc(tx->enc_arena_size);
+        }
+        if (tx->enc_len_count < nr_packets) {
+                free(tx->enc_len);
+                tx->enc_len_count = nr_packets;
+                tx->enc_len       = malloc(nr_packets * sizeof *tx->enc_len);
+        }
+
+        const int workers =
+            CLAMP((int) (nr_packets / ENC_MIN_PKTS_PER_WORKER), 1,
+                  MIN(get_cpu_core_count(), ENC_MAX_WORKERS));
+        struct encrypt_task tasks[ENC_MAX_WORKERS];
+        size_t              first = 0;
+        for (int i = 0; i < workers; ++i) {
+                const size_t count =
+                    nr_packets / workers + (i < (int) (nr_packets % workers));
+                tasks[i] = (struct encrypt_task){
+                        tx,  data,  headers, hdr_len, aad_len, packet_sizes,
+                        first, count, stride
+                };
+                first += count;
+        }
+        task_run_parallel(encrypt_task, workers, tasks, sizeof tasks[0],
+                          nullptr);
+
+        for (size_t i = 0; i < nr_packets; ++i) {
+                if (tx->enc_len[i] <= 0) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+static long long
+get_thread_cpu_time_ns(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+        struct timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+                return ts.tv_sec * NS_IN_SEC + ts.tv_nsec;
+        }
+#endif
+        return 0;
+}
+
 static int
 get_tx_hdr_len(bool is_ipv6)
 {
@@ -708,8 +1052,9 @@ tx_send_base(struct tx *tx, struct video_frame *frame, struct rtp *rtp_session,
         uint32_t rtp_hdr[100];
         int rtp_hdr_len;
         int pt = fec_pt_from_fec_type(TX_MEDIA_VIDEO, frame->fec_params.type, tx->encryption);            /* A value specified in our packet format */
-        struct timespec start, stop;
-        long delta, overslept = 0;
+        struct timespec start;
+        long overslept = 0;
+        const long long cpu_start = get_thread_cpu_time_ns();
         int hdrs_len = get_tx_hdr_len(rtp_is_ipv6(rtp_session));
 
         assert(tx->magic == TRANSMIT_MAGIC);
@@ -749,8 +1094,11 @@ tx_send_base(struct tx *tx, struct video_frame *frame, struct rtp *rtp_session,
         const size_t nr_packets = get_packet_sizes(
             frame, substream, netto_len, countof(packet_sizes), packet_sizes);
         size_t     mult_pkt_cnt = nr_packets * tx->mult_count;
-        const long packet_rate =
+        const long frame_packet_rate =
             get_packet_rate(tx, frame, (int) substream, mult_pkt_cnt);
+        const long packet_rate =
+            setup_kernel_pacing(tx, rtp_session, frame_packet_rate);
+        const time_ns_t launch_base = get_time_in_ns();
 
         // initialize header array with values (except offset which is different among
         // different packts)
@@ -771,55 +1119,98 @@ tx_send_base(struct tx *tx, struct video_frame *frame, struct rtp *rtp_session,
                 rtp_hdr_packet[1] = htonl(0);
         }
 
-        if (!tx->encryption) {
-                rtp_async_start(rtp_session, mult_pkt_cnt);
+        // streaming FEC - parity may still be being computed, wait just before
+        // the first packet reaching it (or now if the packets are encrypted
+        // in advance)
+        unsigned parity_start = UINT_MAX;
+        if (frame->callbacks.wait_parity != nullptr) {
+                if (tx->encryption != nullptr) {
+                        frame->callbacks.wait_parity(frame);
+                } else {
+                        parity_start =
+                            fec_get_parity_offset(frame, substream);
+                }
+        }
+
+        // encrypt packets in advance so that the send loop only transmits
+        const size_t enc_stride =
+            tx->encryption != nullptr
+                ? ((size_t) netto_len +
+                   tx->enc_funcs->get_overhead(tx->encryption) + 63) /
+                      64 * 64
+                : 0;
+        if (tx->encryption != nullptr &&
+            !encrypt_packets(tx, tile->data, (uint32_t *) rtp_headers,
+                             rtp_hdr_len,
+                             frame->fec_params.type != FEC_NONE
+                                 ? sizeof(fec_payload_hdr_t)
+                                 : sizeof(video_payload_hdr_t),
+                             packet_sizes, nr_packets, enc_stride)) {
+                MSG(ERROR, "Encryption failed, dropping the frame!\n");
+                free(rtp_headers);
+                return;
         }
 
+        rtp_async_start(rtp_session, mult_pkt_cnt);
+        const int burst_pkts = get_burst_packets(tx, rtp_session, packet_rate);
+        struct tx_pacing_stats *pstats = &tx->pacing_stats;
+
+        int burst_cnt = 0;
         rtp_hdr_packet = (uint32_t *) rtp_headers;
         for (unsigned i = 0; i < mult_pkt_cnt; ++i) {
-                GET_STARTTIME;
+                if (burst_cnt == 0) {
+                        GET_STARTTIME;
+                }
                 const int m        = i == mult_pkt_cnt - 1 ? send_m : 0;
                 char     *data     = tile->data + ntohl(rtp_hdr_packet[1]);
                 int       data_len = packet_sizes[i % nr_packets];
-
-                char encrypted_data[RTP_MAX_PACKET_LEN + MAX_CRYPTO_EXCEED];
-                if (tx->encryption != nullptr) {
-                        data_len = tx->enc_funcs->encrypt(
-                            tx->encryption, data, data_len,
-                            (char *) rtp_hdr_packet,
-                            frame->fec_params.type != FEC_NONE
-                                ? sizeof(fec_payload_hdr_t)
-                                : sizeof(video_payload_hdr_t),
-                            encrypted_data);
-                        if (data_len <= 0) {
-                                return;
-                        }
-                        data = encrypted_data;
+                if (ntohl(rtp_hdr_packet[1]) + data_len > parity_start) {
+                        frame->callbacks.wait_parity(frame);
+                        parity_start = UINT_MAX;
+                }
+                if (tx->encryption != nullptr) { // multiplied pkts share ciphertext
+                        data     = tx->enc_arena + (i % nr_packets) * enc_stride;
+                        data_len = tx->enc_len[i % nr_packets];
                 }
 
+                if (tx->kpacing == TX_KPACING_TXTIME) {
+                        rtp_set_next_txtime(rtp_session,
+                                            launch_base +
+                                                (time_ns_t) i *
+                                                    frame_packet_rate);
+                }
                 rtp_send_data_hdr(rtp_session, ts, pt, m, 0, nullptr,
                                   (char *) rtp_hdr_packet, rtp_hdr_len, data,
                                   data_len, nullptr, 0, 0);
                 rtp_hdr_packet += rtp_hdr_len / sizeof(uint32_t);
 
                 // TRAFFIC SHAPER
-                if (m != 1) { // wait for all but last packet
-                        do {
-                                GET_STOPTIME;
-                                GET_DELTA;
-                        } while (packet_rate - delta - overslept > 0);
-                        overslept = -(packet_rate - delta - overslept);
-                        //fprintf(stdout, "%ld ", overslept);
+                // wait for all but last packet (per burst if batching)
+                if (m != 1 && ++burst_cnt == burst_pkts) {
+                        if (burst_pkts > 1) {
+                                rtp_async_flush(rtp_session);
+                        }
+                        const long burst_rate = packet_rate * burst_cnt;
+                        if (burst_rate > 0) {
+                                overslept = tx_pace_wait(
+                                    start, burst_rate - overslept,
+                                    tx->pace_spin_ns);
+                                pstats->err_sum += labs(overslept);
+                                pstats->err_max =
+                                    MAX(pstats->err_max, labs(overslept));
+                                pstats->waits += 1;
+                        }
+                        burst_cnt = 0;
                 }
         }
 
+        rtp_async_wait(rtp_session);
+        free(rtp_headers);
+
+        pstats->cpu_ns += get_thread_cpu_time_ns() - cpu_start;
+        pstats->frames += 1;
         const long data_sent = tile->data_len + rtp_hdr_len * mult_pkt_cnt;
         report_stats(tx, rtp_session, data_sent);
-
-        if (!tx->encryption) {
-                rtp_async_wait(rtp_session);
-        }
-        free(rtp_headers);
 }
 
 static void audio_tx_send_chan(struct tx *tx, struct rtp *rtp_session,
@@ -82,12 +82,20 @@ enum {
         /// flag to use the bitrate as fixed, not capped
 #define RATE_FLAG_FIXED_RATE (1ll << 62ll)
 
+/// pacing offloaded to the kernel, used in addition to the rate mode
+enum tx_kernel_pacing {
+        TX_KPACING_NONE = 0, ///< userspace traffic shaper
+        TX_KPACING_FQ,       ///< SO_MAX_PACING_RATE (fq qdisc)
+        TX_KPACING_TXTIME,   ///< per-packet launch time (SO_TXTIME)
+};
+
 struct tx *tx_init(struct module *parent, unsigned mtu, enum tx_media_type media_type,
                 const char *fec, const char *encryption, long long bitrate);
 void             tx_send(struct tx *tx_session, struct video_frame *frame, struct rtp *rtp_session);
 void format_video_header(const struct video_frame *frame, int tile_idx,
                          int buffer_idx, uint32_t *hdr);
 void tx_done(struct tx *tx_session);
+void tx_set_kernel_pacing(struct tx *tx, enum tx_kernel_pacing kpacing);
 
 void tx_send_h264(struct tx *tx_session, struct video_frame *frame, struct rtp *rtp_session);
 void tx_send_h265(struct tx *tx_session, struct video_frame *frame, struct rtp *rtp_session);
@@ -267,6 +267,14 @@ struct video_frame_callbacks {
          * when creating copies of hw frames.
          */
         void               (*copy)(struct video_frame *);
+
+        /**
+         * Set if FEC parity of the tiles is still being computed (streaming
+         * FEC encoding). Must be called before the tile data from
+         * fec_params.k * fec_params.symbol_size on are read.
+         */
+        void               (*wait_parity)(struct video_frame *);
+        void                *wait_parity_udata;
 };
 
 /**
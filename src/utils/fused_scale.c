@@ -0,0 +1,769 @@
+/**
+ * @file   utils/fused_scale.c
+ * @brief  Single-pass scaler working directly on packed pixel formats
+ *
+ * The resampling is separable - every source line needed for an output
+ * line is unpacked to a floating-point working line (3 components in
+ * 16-bit range), scaled horizontally and kept in a small ring so that it
+ * can be reused by the following output lines. The vertical pass then
+ * combines the ring lines, optionally converts between YCbCr and RGB and
+ * packs the result straight to the destination frame.
+ *
+ * Filter weights are computed once at init for every output sample. With
+ * a downscale the filter support is stretched by the scale factor so that
+ * all source samples contribute (area-style averaging rather than point
+ * sampling).
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_space.h"
+#include "compat/c23.h"         // IWYU pragma: keep
+#include "debug.h"
+#include "utils/fused_scale.h"
+#include "utils/macros.h"
+#include "utils/misc.h"         // for get_cpu_core_count
+#include "utils/worker.h"
+#include "video_codec.h"
+
+#define MOD_NAME "[fused_scale] "
+
+enum {
+        PIX_STRIDE = 4, ///< floats per working pixel (Y,Cb,Cr or R,G,B + unused)
+        VEC_FLOATS = 8, ///< vertical pass granularity
+        LINE_PAD   = 6, ///< spare pixels to unpack/pack whole v210 groups
+};
+
+typedef void (*unpack_fn_t)(float *__restrict dst,
+                            const unsigned char *__restrict src, int width);
+typedef void (*pack_fn_t)(unsigned char *__restrict dst,
+                          const float *__restrict src, int width);
+
+static double
+filter_box(double x)
+{
+        return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+}
+
+static double
+filter_tent(double x)
+{
+        x = fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+/// Keys cubic with a = -0.5 (Catmull-Rom)
+static double
+filter_cubic(double x)
+{
+        const double a = -0.5;
+        x = fabs(x);
+        if (x < 1.0) {
+                return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        }
+        if (x < 2.0) {
+                return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+        }
+        return 0.0;
+}
+
+static double
+sinc(double x)
+{
+        if (x == 0.0) {
+                return 1.0;
+        }
+        x *= M_PI;
+        return sin(x) / x;
+}
+
+static double
+filter_lanczos4(double x)
+{
+        if (x > -4.0 && x < 4.0) {
+                return sinc(x) * sinc(x / 4.0);
+        }
+        return 0.0;
+}
+
+static const struct {
+        const char *name;
+        double (*filter)(double);
+        double support;
+} algos[] = {
+        [FUSED_SCALE_LINEAR]   = { "linear",   filter_tent,     1.0 },
+        [FUSED_SCALE_CUBIC]    = { "cubic",    filter_cubic,    2.0 },
+        [FUSED_SCALE_AREA]     = { "area",     filter_box,      0.5 },
+        [FUSED_SCALE_LANCZOS4] = { "lanczos4", filter_lanczos4, 4.0 },
+};
+
+enum fused_scale_algo
+fused_scale_algo_from_string(const char *name)
+{
+        for (unsigned i = 0; i < countof(algos); ++i) {
+                if (strcmp(algos[i].name, name) == 0) {
+                        return (enum fused_scale_algo) i;
+                }
+        }
+        return FUSED_SCALE_ALGO_UNKN;
+}
+
+const char *
+fused_scale_algo_to_string(enum fused_scale_algo algo)
+{
+        if (algo < 0 || (unsigned) algo >= countof(algos)) {
+                return "(unknown)";
+        }
+        return algos[algo].name;
+}
+
+/// per-output-sample filter taps for one dimension
+struct scale_coeffs {
+        int ntaps;      ///< maximal taps of any output sample
+        int *start;     ///< first source sample of every output sample
+        int *count;     ///< number of taps of every output sample
+        float *weights; ///< [out_size][ntaps]
+};
+
+static void
+scale_coeffs_destroy(struct scale_coeffs *c)
+{
+        free(c->start);
+        free(c->count);
+        free(c->weights);
+}
+
+static bool
+scale_coeffs_init(struct scale_coeffs *c, int in_size, int out_size,
+                  enum fused_scale_algo algo)
+{
+        const double scale       = (double) in_size / out_size;
+        const double filterscale = MAX(scale, 1.0);
+        const double support     = algos[algo].support * filterscale;
+
+        c->ntaps   = ((int) support + 1) * 2 + 1;
+        c->start   = calloc(out_size, sizeof *c->start);
+        c->count   = calloc(out_size, sizeof *c->count);
+        c->weights = calloc((size_t) out_size * c->ntaps, sizeof *c->weights);
+        if (c->start == NULL || c->count == NULL || c->weights == NULL) {
+                return false;
+        }
+
+        for (int i = 0; i < out_size; ++i) {
+                const double center = (i + 0.5) * scale;
+                int first = MAX((int) (center - support + 0.5), 0);
+                int count = MIN((int) (center + support + 0.5), in_size) - first;
+                assert(count <= c->ntaps);
+                float *w = c->weights + (size_t) i * c->ntaps;
+                double sum = 0.0;
+                for (int j = 0; j < count; ++j) {
+                        const double val = algos[algo].filter(
+                            (j + first - center + 0.5) / filterscale);
+                        w[j] = (float) val;
+                        sum += val;
+                }
+                // drop zero-weight taps on both sides
+                while (count > 0 && w[count - 1] == 0.F) {
+                        count -= 1;
+                }
+                int skip = 0;
+                while (skip < count && w[skip] == 0.F) {
+                        skip += 1;
+                }
+                count -= skip;
+                first += skip;
+                memmove(w, w + skip, count * sizeof *w);
+                memset(w + count, 0, (c->ntaps - count) * sizeof *w);
+                if (count == 0 || sum == 0.0) { // cannot happen with the above filters
+                        first = CLAMP((int) center, 0, in_size - 1);
+                        count = 1;
+                        w[0]  = 1.F;
+                        sum   = 1.0;
+                }
+                for (int j = 0; j < count; ++j) {
+                        w[j] = (float) (w[j] / sum);
+                }
+                c->start[i] = first;
+                c->count[i] = count;
+        }
+        return true;
+}
+
+/*
+ * Unpackers - produce width (rounded up to the format block) working
+ * pixels with components scaled to 16 bits.
+ */
+
+static void
+unpack_uyvy(float *__restrict dst, const unsigned char *__restrict src,
+            int width)
+{
+        for (int x = 0; x < width; x += 2) {
+                const float cb = (float) (src[0] << 8U);
+                const float cr = (float) (src[2] << 8U);
+                dst[0]         = (float) (src[1] << 8U);
+                dst[1]         = cb;
+                dst[2]         = cr;
+                dst[4]         = (float) (src[3] << 8U);
+                dst[5]         = cb;
+                dst[6]         = cr;
+                dst += 2 * PIX_STRIDE;
+                src += 4;
+        }
+}
+
+static void
+unpack_v210(float *__restrict dst, const unsigned char *__restrict src,
+            int width)
+{
+        for (int x = 0; x < width; x += 6) {
+                uint32_t w[4];
+                memcpy(w, src, sizeof w);
+                src += sizeof w;
+                const unsigned cb[3] = { w[0] & 0x3FFU, (w[1] >> 10U) & 0x3FFU,
+                                         (w[2] >> 20U) & 0x3FFU };
+                const unsigned cr[3] = { (w[0] >> 20U) & 0x3FFU, w[2] & 0x3FFU,
+                                         (w[3] >> 10U) & 0x3FFU };
+                const unsigned y[6]  = { (w[0] >> 10U) & 0x3FFU, w[1] & 0x3FFU,
+                                         (w[1] >> 20U) & 0x3FFU,
+                                         (w[2] >> 10U) & 0x3FFU, w[3] & 0x3FFU,
+                                         (w[3] >> 20U) & 0x3FFU };
+                for (int i = 0; i < 6; ++i) {
+                        dst[0] = (float) (y[i] << 6U);
+                        dst[1] = (float) (cb[i / 2] << 6U);
+                        dst[2] = (float) (cr[i / 2] << 6U);
+                        dst += PIX_STRIDE;
+                }
+        }
+}
+
+static void
+unpack_rgb(float *__restrict dst, const unsigned char *__restrict src,
+           int width)
+{
+        for (int x = 0; x < width; ++x) {
+                dst[0] = (float) (src[0] << 8U);
+                dst[1] = (float) (src[1] << 8U);
+                dst[2] = (float) (src[2] << 8U);
+                dst += PIX_STRIDE;
+                src += 3;
+        }
+}
+
+static void
+unpack_rgba(float *__restrict dst, const unsigned char *__restrict src,
+            int width)
+{
+        for (int x = 0; x < width; ++x) {
+                dst[0] = (float) (src[0] << 8U);
+                dst[1] = (float) (src[1] << 8U);
+                dst[2] = (float) (src[2] << 8U);
+                dst += PIX_STRIDE;
+                src += 4;
+        }
+}
+
+static void
+unpack_r10k(float *__restrict dst, const unsigned char *__restrict src,
+            int width)
+{
+        for (int x = 0; x < width; ++x) {
+                const unsigned r = src[0] << 2U | src[1] >> 6U;
+                const unsigned g = (src[1] & 0x3FU) << 4U | src[2] >> 4U;
+                const unsigned b = (src[2] & 0xFU) << 6U | src[3] >> 2U;
+                dst[0] = (float) (r << 6U);
+                dst[1] = (float) (g << 6U);
+                dst[2] = (float) (b << 6U);
+                dst += PIX_STRIDE;
+                src += 4;
+        }
+}
+
+static void
+unpack_rg48(float *__restrict dst, const unsigned char *__restrict src,
+            int width)
+{
+        for (int x = 0; x < width; ++x) {
+                uint16_t rgb[3];
+                memcpy(rgb, src, sizeof rgb);
+                dst[0] = rgb[0];
+                dst[1] = rgb[1];
+                dst[2] = rgb[2];
+                dst += PIX_STRIDE;
+                src += sizeof rgb;
+        }
+}
+
+/*
+ * Packers - consume width (rounded up to the format block) working pixels;
+ * the values are rounded and clamped to the target depth.
+ */
+
+static inline unsigned
+to_depth(float val, unsigned depth)
+{
+        // clamped as an integer, which compiles to branchless code
+        const int max = (int) ((1U << depth) - 1U);
+        const int ret = (int) (val * (1.F / (float) (1U << (16U - depth))) + .5F);
+        return ret < 0 ? 0 : ret > max ? max : ret;
+}
+
+static void
+pack_uyvy(unsigned char *__restrict dst, const float *__restrict src,
+          int width)
+{
+        for (int x = 0; x < width; x += 2) {
+                const float *p0 = src;
+                const float *p1 = src + PIX_STRIDE;
+                *dst++ = to_depth((p0[1] + p1[1]) * .5F, DEPTH8);
+                *dst++ = to_depth(p0[0], DEPTH8);
+                *dst++ = to_depth((p0[2] + p1[2]) * .5F, DEPTH8);
+                *dst++ = to_depth(p1[0], DEPTH8);
+                src += 2 * PIX_STRIDE;
+        }
+}
+
+static void
+pack_v210(unsigned char *__restrict dst, const float *__restrict src,
+          int width)
+{
+        for (int x = 0; x < width; x += 6) {
+                unsigned y[6];
+                unsigned cb[3];
+                unsigned cr[3];
+                for (int i = 0; i < 3; ++i) {
+                        const float *p0 = src + (size_t) 2 * i * PIX_STRIDE;
+                        const float *p1 = p0 + PIX_STRIDE;
+                        y[2 * i]        = to_depth(p0[0], DEPTH10);
+                        y[2 * i + 1]    = to_depth(p1[0], DEPTH10);
+                        cb[i] = to_depth((p0[1] + p1[1]) * .5F, DEPTH10);
+                        cr[i] = to_depth((p0[2] + p1[2]) * .5F, DEPTH10);
+                }
+                const uint32_t w[4] = {
+                        cb[0] | y[0] << 10U | cr[0] << 20U,
+                        y[1] | cb[1] << 10U | y[2] << 20U,
+                        cr[1] | y[3] << 10U | cb[2] << 20U,
+                        y[4] | cr[2] << 10U | y[5] << 20U,
+                };
+                memcpy(dst, w, sizeof w);
+                dst += sizeof w;
+                src += 6 * PIX_STRIDE;
+        }
+}
+
+static void
+pack_rgb(unsigned char *__restrict dst, const float *__restrict src, int width)
+{
+        for (int x = 0; x < width; ++x) {
+                *dst++ = to_depth(src[0], DEPTH8);
+                *dst++ = to_depth(src[1], DEPTH8);
+                *dst++ = to_depth(src[2], DEPTH8);
+                src += PIX_STRIDE;
+        }
+}
+
+static void
+pack_rgba(unsigned char *__restrict dst, const float *__restrict src,
+          int width)
+{
+        for (int x = 0; x < width; ++x) {
+                *dst++ = to_depth(src[0], DEPTH8);
+                *dst++ = to_depth(src[1], DEPTH8);
+                *dst++ = to_depth(src[2], DEPTH8);
+                *dst++ = 0xFFU;
+                src += PIX_STRIDE;
+        }
+}
+
+static void
+pack_r10k(unsigned char *__restrict dst, const float *__restrict src,
+          int width)
+{
+        for (int x = 0; x < width; ++x) {
+                const unsigned r = to_depth(src[0], DEPTH10);
+                const unsigned g = to_depth(src[1], DEPTH10);
+                const unsigned b = to_depth(src[2], DEPTH10);
+                *dst++ = r >> 2U;
+                *dst++ = (r & 0x3U) << 6U | g >> 4U;
+                *dst++ = (g & 0xFU) << 4U | b >> 6U;
+                *dst++ = (b & 0x3FU) << 2U | 0x3U;
+                src += PIX_STRIDE;
+        }
+}
+
+static void
+pack_rg48(unsigned char *__restrict dst, const float *__restrict src,
+          int width)
+{
+        for (int x = 0; x < width; ++x) {
+                const uint16_t rgb[3] = { to_depth(src[0], DEPTH16),
+                                          to_depth(src[1], DEPTH16),
+                                          to_depth(src[2], DEPTH16) };
+                memcpy(dst, rgb, sizeof rgb);
+                dst += sizeof rgb;
+                src += PIX_STRIDE;
+        }
+}
+
+static const struct {
+        codec_t codec;
+        unpack_fn_t unpack;
+        pack_fn_t pack;
+} formats[] = {
+        { UYVY, unpack_uyvy, pack_uyvy },
+        { v210, unpack_v210, pack_v210 },
+        { RGB,  unpack_rgb,  pack_rgb  },
+        { RGBA, unpack_rgba, pack_rgba },
+        { R10k, unpack_r10k, pack_r10k },
+        { RG48, unpack_rg48, pack_rg48 },
+};
+
+static int
+get_format_idx(codec_t codec)
+{
+        for (unsigned i = 0; i < countof(formats); ++i) {
+                if (formats[i].codec == codec) {
+                        return (int) i;
+                }
+        }
+        return -1;
+}
+
+bool
+fused_scale_is_supported(codec_t codec)
+{
+        return get_format_idx(codec) != -1;
+}
+
+enum color_conv {
+        CONV_NONE,
+        CONV_YCBCR_TO_RGB,
+        CONV_RGB_TO_YCBCR,
+};
+
+struct fused_scale_stripe {
+        struct fused_scale *s;
+        int y_start;
+        int y_end;
+        float *unpacked; ///< one source line
+        float *ring;     ///< v.ntaps horizontally scaled source lines
+        int *ring_row;   ///< source line held by the ring slot
+        float *out_line; ///< vertically scaled line
+};
+
+struct fused_scale {
+        struct fused_scale_params p;
+        struct scale_coeffs h;
+        struct scale_coeffs v;
+        unpack_fn_t unpack;
+        pack_fn_t pack;
+        enum color_conv conv;
+        struct color_coeffs cfs;
+        size_t line_stride; ///< floats per horizontally scaled line
+
+        int stripe_count;
+        struct fused_scale_stripe *stripes;
+
+        // current frame
+        const char *in;
+        int in_pitch;
+        char *out;
+        int out_pitch;
+};
+
+/**
+ * All 4 lanes of the working pixel are processed together so that the
+ * compiler can keep the accumulator in a single SIMD register; two
+ * accumulators hide the latency of the additions.
+ */
+static void
+scale_line_h(const struct scale_coeffs *c, float *__restrict dst,
+             const float *__restrict src, int width)
+{
+        for (int x = 0; x < width; ++x) {
+                const float *w  = c->weights + (size_t) x * c->ntaps;
+                const float *in = src + (size_t) c->start[x] * PIX_STRIDE;
+                const int count = c->count[x];
+                float acc0[PIX_STRIDE] = { 0 };
+                float acc1[PIX_STRIDE] = { 0 };
+                int i = 0;
+                for (; i + 1 < count; i += 2) {
+                        for (int j = 0; j < PIX_STRIDE; ++j) {
+                                acc0[j] += in[j] * w[i];
+                                acc1[j] += in[j + PIX_STRIDE] * w[i + 1];
+                        }
+                        in += 2 * PIX_STRIDE;
+                }
+                if (i < count) {
+                        for (int j = 0; j < PIX_STRIDE; ++j) {
+                                acc0[j] += in[j] * w[i];
+                        }
+                }
+                for (int j = 0; j < PIX_STRIDE; ++j) {
+                        dst[j] = acc0[j] + acc1[j];
+                }
+                dst += PIX_STRIDE;
+        }
+}
+
+/// @param len multiple of VEC_FLOATS
+static void
+scale_line_v(float *__restrict dst, const float *__restrict src, float w,
+             size_t len, bool accumulate)
+{
+        if (accumulate) {
+                for (size_t x = 0; x < len; x += VEC_FLOATS) {
+                        for (int i = 0; i < VEC_FLOATS; ++i) {
+                                dst[x + i] += src[x + i] * w;
+                        }
+                }
+        } else {
+                for (size_t x = 0; x < len; x += VEC_FLOATS) {
+                        for (int i = 0; i < VEC_FLOATS; ++i) {
+                                dst[x + i] = src[x + i] * w;
+                        }
+                }
+        }
+}
+
+static void
+convert_line(const struct fused_scale *s, float *line, int width)
+{
+        const struct color_coeffs cfs = s->cfs;
+        const float norm = 1.F / (1 << COMP_BASE);
+        if (s->conv == CONV_YCBCR_TO_RGB) {
+                for (int x = 0; x < width; ++x) {
+                        const float y  = cfs.y_scale * (line[0] - LIMIT_LO(DEPTH16));
+                        const float cb = line[1] - (1 << (DEPTH16 - 1));
+                        const float cr = line[2] - (1 << (DEPTH16 - 1));
+                        line[0] = YCBCR_TO_R(cfs, y, cb, cr) * norm;
+                        line[1] = YCBCR_TO_G(cfs, y, cb, cr) * norm;
+                        line[2] = YCBCR_TO_B(cfs, y, cb, cr) * norm;
+                        line += PIX_STRIDE;
+                }
+        } else {
+                for (int x = 0; x < width; ++x) {
+                        const float r = line[0];
+                        const float g = line[1];
+                        const float b = line[2];
+                        line[0] = RGB_TO_Y(cfs, r, g, b) * norm +
+                                  LIMIT_LO(DEPTH16);
+                        line[1] = RGB_TO_CB(cfs, r, g, b) * norm +
+                                  (1 << (DEPTH16 - 1));
+                        line[2] = RGB_TO_CR(cfs, r, g, b) * norm +
+                                  (1 << (DEPTH16 - 1));
+                        line += PIX_STRIDE;
+                }
+        }
+}
+
+static void *
+scale_stripe(void *arg)
+{
+        struct fused_scale_stripe *st = arg;
+        const struct fused_scale *s   = st->s;
+        const int out_w               = s->p.out_width;
+        const int nslots              = s->v.ntaps;
+        const size_t stride           = s->line_stride;
+
+        for (int i = 0; i < nslots; ++i) {
+                st->ring_row[i] = -1;
+        }
+
+        for (int y = st->y_start; y < st->y_end; ++y) {
+                const int first = s->v.start[y];
+                const int count = s->v.count[y];
+                const float *w  = s->v.weights + (size_t) y * s->v.ntaps;
+
+                for (int i = 0; i < count; ++i) {
+                        const int row  = first + i;
+                        const int slot = row % nslots;
+                        if (st->ring_row[slot] == row) {
+                                continue;
+                        }
+                        s->unpack(st->unpacked,
+                                  (const unsigned char *) s->in +
+                                      (size_t) row * s->in_pitch,
+                                  s->p.in_width);
+                        scale_line_h(&s->h, st->ring + slot * stride,
+                                     st->unpacked, out_w);
+                        st->ring_row[slot] = row;
+                }
+
+                float *dst = st->out_line;
+                scale_line_v(dst, st->ring + (first % nslots) * stride, w[0],
+                             stride, false);
+                for (int i = 1; i < count; ++i) {
+                        scale_line_v(dst,
+                                     st->ring + ((first + i) % nslots) * stride,
+                                     w[i], stride, true);
+                }
+                if (s->conv != CONV_NONE) {
+                        convert_line(s, dst, out_w);
+                }
+                // replicate the last pixel to fill the last pixel block
+                for (int x = out_w; x < out_w + LINE_PAD; ++x) {
+                        memcpy(dst + (size_t) x * PIX_STRIDE,
+                               dst + (size_t) (out_w - 1) * PIX_STRIDE,
+                               PIX_STRIDE * sizeof *dst);
+                }
+                s->pack((unsigned char *) s->out + (size_t) y * s->out_pitch,
+                        dst, out_w);
+        }
+        return NULL;
+}
+
+struct fused_scale *
+fused_scale_init(const struct fused_scale_params *params)
+{
+        const int in_idx  = get_format_idx(params->in_codec);
+        const int out_idx = get_format_idx(params->out_codec);
+        if (in_idx == -1 || out_idx == -1) {
+                MSG(ERROR, "Unsupported conversion %s->%s!\n",
+                    get_codec_name(params->in_codec),
+                    get_codec_name(params->out_codec));
+                return NULL;
+        }
+        if (params->in_width <= 0 || params->in_height <= 0 ||
+            params->out_width <= 0 || params->out_height <= 0) {
+                MSG(ERROR, "Wrong dimensions %dx%d->%dx%d!\n",
+                    params->in_width, params->in_height, params->out_width,
+                    params->out_height);
+                return NULL;
+        }
+        if (params->algo < 0 || (unsigned) params->algo >= countof(algos)) {
+                MSG(ERROR, "Unknown algorithm %d!\n", (int) params->algo);
+                return NULL;
+        }
+
+        struct fused_scale *s = calloc(1, sizeof *s);
+        if (s == NULL) {
+                return NULL;
+        }
+        s->p      = *params;
+        s->unpack = formats[in_idx].unpack;
+        s->pack   = formats[out_idx].pack;
+        s->cfs    = *get_color_coeffs(CS_DFL, DEPTH16);
+        if (codec_is_a_rgb(params->in_codec) !=
+            codec_is_a_rgb(params->out_codec)) {
+                s->conv = codec_is_a_rgb(params->in_codec) ? CONV_RGB_TO_YCBCR
+                                                           : CONV_YCBCR_TO_RGB;
+        }
+
+        if (!scale_coeffs_init(&s->h, params->in_width, params->out_width,
+                               params->algo) ||
+            !scale_coeffs_init(&s->v, params->in_height, params->out_height,
+                               params->algo)) {
+                fused_scale_destroy(s);
+                return NULL;
+        }
+
+        const size_t in_line_len =
+            (size_t) (params->in_width + LINE_PAD) * PIX_STRIDE;
+        const size_t out_line_len =
+            (size_t) (params->out_width + LINE_PAD) * PIX_STRIDE;
+        s->line_stride = (size_t) params->out_width * PIX_STRIDE;
+        s->line_stride = (s->line_stride + VEC_FLOATS - 1) / VEC_FLOATS *
+                         VEC_FLOATS;
+        assert(s->line_stride <= out_line_len);
+
+        int threads = params->threads == 0 ? get_cpu_core_count()
+                                           : params->threads;
+        s->stripe_count = CLAMP(threads, 1, params->out_height);
+        s->stripes = calloc(s->stripe_count, sizeof *s->stripes);
+        if (s->stripes == NULL) {
+                fused_scale_destroy(s);
+                return NULL;
+        }
+        const int stripe_h = params->out_height / s->stripe_count;
+        for (int i = 0; i < s->stripe_count; ++i) {
+                struct fused_scale_stripe *st = &s->stripes[i];
+                st->s       = s;
+                st->y_start = i * stripe_h;
+                st->y_end   = i == s->stripe_count - 1 ? params->out_height
+                                                       : (i + 1) * stripe_h;
+                st->unpacked = calloc(in_line_len, sizeof(float));
+                st->ring     = calloc(s->v.ntaps * s->line_stride,
+                                      sizeof(float));
+                st->ring_row = malloc(s->v.ntaps * sizeof(int));
+                st->out_line = calloc(out_line_len, sizeof(float));
+                if (st->unpacked == NULL || st->ring == NULL ||
+                    st->ring_row == NULL || st->out_line == NULL) {
+                        fused_scale_destroy(s);
+                        return NULL;
+                }
+        }
+
+        MSG(VERBOSE, "%s %dx%d -> %s %dx%d, %s, %d stripe(s), %dx%d taps\n",
+            get_codec_name(params->in_codec), params->in_width,
+            params->in_height, get_codec_name(params->out_codec),
+            params->out_width, params->out_height, algos[params->algo].name,
+            s->stripe_count, s->h.ntaps, s->v.ntaps);
+        return s;
+}
+
+void
+fused_scale_frame(struct fused_scale *s, const char *in, int in_pitch,
+                  char *out, int out_pitch)
+{
+        s->in        = in;
+        s->in_pitch  = in_pitch;
+        s->out       = out;
+        s->out_pitch = out_pitch;
+        task_run_parallel(scale_stripe, s->stripe_count, s->stripes,
+                          sizeof s->stripes[0], NULL);
+}
+
+void
+fused_scale_destroy(struct fused_scale *s)
+{
+        if (s == NULL) {
+                return;
+        }
+        for (int i = 0; s->stripes != NULL && i < s->stripe_count; ++i) {
+                free(s->stripes[i].unpacked);
+                free(s->stripes[i].ring);
+                free(s->stripes[i].ring_row);
+                free(s->stripes[i].out_line);
+        }
+        free(s->stripes);
+        scale_coeffs_destroy(&s->h);
+        scale_coeffs_destroy(&s->v);
+        free(s);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file   utils/fused_scale.h
+ * @brief  Single-pass scaler working directly on packed pixel formats
+ *
+ * Unpacks the source lines, resamples them with a separable filter and
+ * packs the result to the destination pixel format without any
+ * intermediate full-size frame. Output lines are split into stripes that
+ * are processed in parallel; all scratch memory is allocated by
+ * fused_scale_init() so that scaling a frame doesn't allocate.
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_FUSED_SCALE_H_
+#define UTILS_FUSED_SCALE_H_
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "types.h" // codec_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum fused_scale_algo {
+        FUSED_SCALE_ALGO_UNKN = -1,
+        FUSED_SCALE_LINEAR,
+        FUSED_SCALE_CUBIC,
+        FUSED_SCALE_AREA,
+        FUSED_SCALE_LANCZOS4,
+};
+
+struct fused_scale_params {
+        codec_t in_codec;
+        int in_width;
+        int in_height;
+        codec_t out_codec;
+        int out_width;
+        int out_height;
+        enum fused_scale_algo algo;
+        int threads; ///< 0 - use all logical cores
+};
+
+struct fused_scale;
+
+bool fused_scale_is_supported(codec_t codec);
+enum fused_scale_algo fused_scale_algo_from_string(const char *name);
+const char *fused_scale_algo_to_string(enum fused_scale_algo algo);
+
+struct fused_scale *fused_scale_init(const struct fused_scale_params *params);
+/**
+ * @param in_pitch  source line stride in bytes
+ * @param out       first byte of the destination rectangle (may be inside
+ *                  a larger frame, eg. when letterboxing)
+ * @param out_pitch destination line stride in bytes
+ */
+void fused_scale_frame(struct fused_scale *s, const char *in, int in_pitch,
+                       char *out, int out_pitch);
+void fused_scale_destroy(struct fused_scale *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // defined UTILS_FUSED_SCALE_H_
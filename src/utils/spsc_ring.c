@@ -0,0 +1,349 @@
+/**
+ * @file   utils/spsc_ring.c
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "utils/spsc_ring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "compat/aligned_malloc.h"
+#include "utils/macros.h"
+#include "utils/pthread.h"
+
+enum { CACHE_LINE_SIZE = 64 };
+
+/// sleeping side of the ring (either consumer or producer)
+struct spsc_waiter {
+        atomic_uint seq; ///< incremented on wake-up (futex word on Linux)
+        atomic_bool waiting;
+#ifndef __linux__
+        pthread_mutex_t lock;
+        pthread_cond_t  cv;
+#endif
+};
+
+struct spsc_ring {
+        void   **items;
+        unsigned mask;
+        atomic_bool interrupted;
+
+        // producer part
+        alignas(CACHE_LINE_SIZE) atomic_uint tail;
+        unsigned           head_cache;
+        atomic_uint        max_occupancy;
+        atomic_ullong      pushed;
+        atomic_ullong      overflows;
+        struct spsc_waiter writer;
+
+        // consumer part
+        alignas(CACHE_LINE_SIZE) atomic_uint head;
+        unsigned           tail_cache;
+        struct spsc_waiter reader;
+};
+
+static void
+spsc_waiter_init(struct spsc_waiter *w)
+{
+        atomic_init(&w->seq, 0);
+        atomic_init(&w->waiting, false);
+#ifndef __linux__
+        CHK_PTHR(pthread_mutex_init(&w->lock, NULL));
+        CHK_PTHR(pthread_cond_init(&w->cv, NULL));
+#endif
+}
+
+static void
+spsc_waiter_destroy(struct spsc_waiter *w)
+{
+#ifdef __linux__
+        (void) w;
+#else
+        CHK_PTHR(pthread_mutex_destroy(&w->lock));
+        CHK_PTHR(pthread_cond_destroy(&w->cv));
+#endif
+}
+
+/**
+ * @param capacity  will be rounded up to a power of two
+ */
+struct spsc_ring *
+spsc_ring_init(unsigned capacity)
+{
+        assert(capacity > 0 && capacity <= 1U << 31U);
+        unsigned size = 1;
+        while (size < capacity) {
+                size <<= 1U;
+        }
+        struct spsc_ring *ring = aligned_malloc(sizeof *ring, CACHE_LINE_SIZE);
+        if (ring == NULL) {
+                return NULL;
+        }
+        ring->items = calloc(size, sizeof *ring->items);
+        ring->mask  = size - 1;
+        atomic_init(&ring->interrupted, false);
+        atomic_init(&ring->tail, 0);
+        ring->head_cache = 0;
+        atomic_init(&ring->max_occupancy, 0);
+        atomic_init(&ring->pushed, 0);
+        atomic_init(&ring->overflows, 0);
+        spsc_waiter_init(&ring->writer);
+        atomic_init(&ring->head, 0);
+        ring->tail_cache = 0;
+        spsc_waiter_init(&ring->reader);
+        return ring;
+}
+
+void
+spsc_ring_destroy(struct spsc_ring *ring)
+{
+        if (ring == NULL) {
+                return;
+        }
+        spsc_waiter_destroy(&ring->writer);
+        spsc_waiter_destroy(&ring->reader);
+        free(ring->items);
+        aligned_free(ring);
+}
+
+static void
+spsc_waiter_wake(struct spsc_waiter *w, bool force)
+{
+        if (!force && !atomic_load(&w->waiting)) {
+                return;
+        }
+        atomic_fetch_add(&w->seq, 1);
+#ifdef __linux__
+        syscall(SYS_futex, (void *) (uintptr_t) &w->seq, FUTEX_WAKE_PRIVATE, 1, NULL,
+                NULL, 0);
+#else
+        CHK_PTHR(pthread_mutex_lock(&w->lock));
+        CHK_PTHR(pthread_cond_broadcast(&w->cv));
+        CHK_PTHR(pthread_mutex_unlock(&w->lock));
+#endif
+}
+
+static void
+spsc_waiter_sleep(struct spsc_waiter *w, unsigned seq, time_ns_t *timeout_ns)
+{
+#ifdef __linux__
+        struct timespec  ts  = { 0, 0 };
+        struct timespec *tsp = NULL;
+        time_ns_t        t0  = 0;
+        if (timeout_ns != NULL) {
+                ts.tv_sec  = *timeout_ns / NS_IN_SEC;
+                ts.tv_nsec = *timeout_ns % NS_IN_SEC;
+                tsp        = &ts;
+                t0         = get_time_in_ns();
+        }
+        syscall(SYS_futex, (void *) (uintptr_t) &w->seq, FUTEX_WAIT_PRIVATE, seq, tsp,
+                NULL, 0);
+        if (timeout_ns != NULL) {
+                *timeout_ns = MAX(*timeout_ns - (get_time_in_ns() - t0), 0);
+        }
+#else
+        CHK_PTHR(pthread_mutex_lock(&w->lock));
+        while (atomic_load(&w->seq) == seq) {
+                if (timeout_ns == NULL) {
+                        pthread_cond_wait(&w->cv, &w->lock);
+                        continue;
+                }
+                if (*timeout_ns == 0 ||
+                    ug_pthread_cond_reltimedwait(&w->cv, &w->lock,
+                                                 timeout_ns) == ETIMEDOUT) {
+                        break;
+                }
+        }
+        CHK_PTHR(pthread_mutex_unlock(&w->lock));
+#endif
+}
+
+static bool
+spsc_ring_readable(struct spsc_ring *ring)
+{
+        return atomic_load(&ring->tail) != atomic_load(&ring->head);
+}
+
+static bool
+spsc_ring_writable(struct spsc_ring *ring)
+{
+        return atomic_load(&ring->tail) - atomic_load(&ring->head) <=
+               ring->mask;
+}
+
+/**
+ * The waiting flag is set before re-checking the condition and the peer
+ * checks the flag after publishing its index (both sequentially consistent)
+ * so either the waiter sees the change or the peer sees the flag.
+ */
+static bool
+spsc_waiter_wait(struct spsc_waiter *w, struct spsc_ring *ring,
+                 bool (*ready)(struct spsc_ring *), time_ns_t *timeout_ns)
+{
+        while (true) {
+                if (ready(ring)) {
+                        return true;
+                }
+                if (atomic_load(&ring->interrupted) ||
+                    (timeout_ns != NULL && *timeout_ns <= 0)) {
+                        return false;
+                }
+                const unsigned seq = atomic_load(&w->seq);
+                atomic_store(&w->waiting, true);
+                if (!ready(ring) && !atomic_load(&ring->interrupted)) {
+                        spsc_waiter_sleep(w, seq, timeout_ns);
+                }
+                atomic_store(&w->waiting, false);
+        }
+}
+
+unsigned
+spsc_ring_push(struct spsc_ring *ring, void *const *items, unsigned count)
+{
+        const unsigned capacity = ring->mask + 1;
+        const unsigned tail =
+            atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        unsigned free_cnt = capacity - (tail - ring->head_cache);
+        if (free_cnt < count) {
+                ring->head_cache =
+                    atomic_load_explicit(&ring->head, memory_order_acquire);
+                free_cnt = capacity - (tail - ring->head_cache);
+        }
+        const unsigned n = MIN(count, free_cnt);
+        if (n < count) {
+                atomic_fetch_add_explicit(&ring->overflows, 1,
+                                          memory_order_relaxed);
+        }
+        for (unsigned i = 0; i < n; ++i) {
+                ring->items[(tail + i) & ring->mask] = items[i];
+        }
+        if (n == 0) {
+                return 0;
+        }
+        atomic_store(&ring->tail, tail + n);
+
+        const unsigned occupancy =
+            tail + n -
+            atomic_load_explicit(&ring->head, memory_order_relaxed);
+        if (occupancy > atomic_load_explicit(&ring->max_occupancy,
+                                             memory_order_relaxed)) {
+                atomic_store_explicit(&ring->max_occupancy, occupancy,
+                                      memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&ring->pushed, n, memory_order_relaxed);
+
+        spsc_waiter_wake(&ring->reader, false);
+        return n;
+}
+
+unsigned
+spsc_ring_pop(struct spsc_ring *ring, void **items, unsigned max_count)
+{
+        const unsigned head =
+            atomic_load_explicit(&ring->head, memory_order_relaxed);
+        unsigned avail = ring->tail_cache - head;
+        if (avail < max_count) {
+                ring->tail_cache =
+                    atomic_load_explicit(&ring->tail, memory_order_acquire);
+                avail = ring->tail_cache - head;
+        }
+        const unsigned n = MIN(max_count, avail);
+        if (n == 0) {
+                return 0;
+        }
+        for (unsigned i = 0; i < n; ++i) {
+                items[i] = ring->items[(head + i) & ring->mask];
+        }
+        atomic_store(&ring->head, head + n);
+
+        spsc_waiter_wake(&ring->writer, false);
+        return n;
+}
+
+bool
+spsc_ring_wait_readable(struct spsc_ring *ring, time_ns_t *timeout_ns)
+{
+        return spsc_waiter_wait(&ring->reader, ring, spsc_ring_readable,
+                                timeout_ns);
+}
+
+bool
+spsc_ring_wait_writable(struct spsc_ring *ring, time_ns_t *timeout_ns)
+{
+        if (!spsc_ring_writable(ring)) {
+                atomic_fetch_add_explicit(&ring->overflows, 1,
+                                          memory_order_relaxed);
+        }
+        return spsc_waiter_wait(&ring->writer, ring, spsc_ring_writable,
+                                timeout_ns);
+}
+
+void
+spsc_ring_interrupt(struct spsc_ring *ring)
+{
+        atomic_store(&ring->interrupted, true);
+        spsc_waiter_wake(&ring->reader, true);
+        spsc_waiter_wake(&ring->writer, true);
+}
+
+unsigned
+spsc_ring_size(struct spsc_ring *ring)
+{
+        return atomic_load(&ring->tail) - atomic_load(&ring->head);
+}
+
+void
+spsc_ring_get_stats(struct spsc_ring *ring, struct spsc_ring_stats *stats)
+{
+        stats->capacity      = ring->mask + 1;
+        stats->occupancy     = spsc_ring_size(ring);
+        stats->max_occupancy = atomic_load_explicit(&ring->max_occupancy,
+                                                    memory_order_relaxed);
+        stats->pushed =
+            atomic_load_explicit(&ring->pushed, memory_order_relaxed);
+        stats->overflows =
+            atomic_load_explicit(&ring->overflows, memory_order_relaxed);
+}
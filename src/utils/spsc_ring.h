@@ -0,0 +1,99 @@
+/**
+ * @file   utils/spsc_ring.h
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_SPSC_RING_H_2B0C6E1A_7F3D_4C8E_9A51_3D2E8F4B6C10
+#define UTILS_SPSC_RING_H_2B0C6E1A_7F3D_4C8E_9A51_3D2E8F4B6C10
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#endif
+
+#include "tv.h" // for time_ns_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Lock-free single-producer single-consumer ring of pointers.
+ *
+ * Both publishing and consuming can be batched. The waiting functions block
+ * only if the ring is empty (full respectively) and the other side issues a
+ * wake-up (futex on Linux, condition variable elsewhere) only if the peer is
+ * actually waiting, so there is no syscall per item in a steady state.
+ */
+struct spsc_ring;
+
+struct spsc_ring_stats {
+        unsigned capacity;
+        unsigned occupancy;
+        unsigned max_occupancy; ///< high-water mark since init
+        uint64_t pushed;
+        uint64_t overflows;     ///< number of times the producer found the ring full
+};
+
+struct spsc_ring *spsc_ring_init(unsigned capacity);
+void              spsc_ring_destroy(struct spsc_ring *ring);
+
+/// @returns number of items actually published (less than count if full)
+unsigned spsc_ring_push(struct spsc_ring *ring, void *const *items,
+                        unsigned count);
+/// @returns number of items consumed
+unsigned spsc_ring_pop(struct spsc_ring *ring, void **items, unsigned max_count);
+
+/**
+ * Waits (consumer) until the ring is non-empty.
+ * @param timeout_ns  relative timeout, NULL to wait indefinitely
+ * @retval false      on timeout or when interrupted by spsc_ring_interrupt()
+ */
+bool spsc_ring_wait_readable(struct spsc_ring *ring, time_ns_t *timeout_ns);
+/// producer counterpart of spsc_ring_wait_readable() - waits for free space
+bool spsc_ring_wait_writable(struct spsc_ring *ring, time_ns_t *timeout_ns);
+/// wakes up both sides, subsequent waits return immediately
+void spsc_ring_interrupt(struct spsc_ring *ring);
+
+unsigned spsc_ring_size(struct spsc_ring *ring);
+void     spsc_ring_get_stats(struct spsc_ring *ring,
+                             struct spsc_ring_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // defined UTILS_SPSC_RING_H_2B0C6E1A_7F3D_4C8E_9A51_3D2E8F4B6C10
@@ -39,14 +39,16 @@
 
 #include <cassert>
 #include <cstdlib>             // for free, malloc
+#include <cstring>             // for memset
 #include <condition_variable>
 #include <exception>           // for exception
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "debug.h"             // for log_msg
 #include "video_codec.h"
@@ -64,14 +66,22 @@ struct video_frame_pool::impl {
         struct video_frame          *get_disposable_frame();
         struct video_frame          *get_pod_frame();
         video_frame_pool_allocator const &get_allocator();
+        static void                  release(std::unique_ptr<impl> self);
+        static void                  dispose_frame(struct video_frame *frame);
 
       private:
+        struct video_frame *acquire_frame();
+        void                return_frame(struct video_frame *frame);
+        void                reset_frame(struct video_frame *frame);
         void remove_free_frames();
         void deallocate_frame(struct video_frame *frame);
 
         std::unique_ptr<video_frame_pool_allocator> m_allocator = std::make_unique<default_data_allocator>();
         bool                                        m_quiet;
-        std::queue<struct video_frame *>            m_free_frames;
+        std::vector<struct video_frame *>           m_free_frames; ///< LIFO to keep recently used buffers hot
+        /// generation of every allocated frame (inserted only on allocation
+        /// so that returning a frame never allocates)
+        std::unordered_map<struct video_frame *, int> m_frame_generation;
         std::mutex                                  m_lock;
         std::condition_variable                     m_frame_returned;
         int                                         m_generation = 0;
@@ -79,6 +89,7 @@ struct video_frame_pool::impl {
         size_t                                      m_max_data_len = 0;
         unsigned int                                m_unreturned_frames = 0;
         unsigned int                                m_max_used_frames;
+        bool                                        m_released = false; ///< owner gone, delete when last frame returns
 };
 
 //                      _
@@ -122,6 +133,16 @@ video_frame_pool::get_allocator()
 {
         return m_impl->get_allocator();
 }
+void
+video_frame_pool::release()
+{
+        impl::release(std::move(m_impl));
+}
+bool
+video_frame_pool::is_disposable_frame(const struct video_frame *frame)
+{
+        return frame->callbacks.dispose == impl::dispose_frame;
+}
 
 //          _
 //   _|  _ (_  _      | |_     _|  _  |_  _      _  | |  _   _  _  |_  _   _
@@ -154,6 +175,22 @@ video_frame_pool::impl::~impl() {
         m_frame_returned.wait(lk, [this] {return m_unreturned_frames == 0;});
 }
 
+/**
+ * Destroys the pool without waiting for the frames that were given out -
+ * the last returned frame deletes the pool.
+ */
+void video_frame_pool::impl::release(std::unique_ptr<impl> self) {
+        std::unique_lock<std::mutex> lk(self->m_lock);
+        self->remove_free_frames();
+        if (self->m_unreturned_frames == 0) {
+                lk.unlock();
+                return; // deleted by self
+        }
+        self->m_released = true;
+        lk.unlock();
+        (void) self.release();
+}
+
 void video_frame_pool::impl::reconfigure(struct video_desc new_desc, size_t new_size) {
         std::unique_lock<std::mutex> lk(m_lock);
         m_desc = new_desc;
@@ -162,18 +199,18 @@ void video_frame_pool::impl::reconfigure(struct video_desc new_desc, size_t new_
         m_generation++;
 }
 
-std::shared_ptr<video_frame> video_frame_pool::impl::get_frame() {
+struct video_frame *video_frame_pool::impl::acquire_frame() {
         struct video_frame *ret = NULL;
         std::unique_lock<std::mutex> lk(m_lock);
         assert(m_generation != 0);
-        if (!m_free_frames.empty()) {
-                ret = m_free_frames.front();
-                m_free_frames.pop();
-        } else if (m_max_used_frames > 0 && m_max_used_frames == m_unreturned_frames) {
+        if (m_free_frames.empty() && m_max_used_frames > 0 &&
+            m_max_used_frames == m_unreturned_frames) {
                 m_frame_returned.wait(lk, [this] {return m_unreturned_frames < m_max_used_frames;});
-                assert(!m_free_frames.empty());
-                ret = m_free_frames.front();
-                m_free_frames.pop();
+        }
+        if (!m_free_frames.empty()) {
+                ret = m_free_frames.back();
+                m_free_frames.pop_back();
+                reset_frame(ret);
         } else {
                 try {
                         ret = vf_alloc_desc(m_desc);
@@ -186,6 +223,7 @@ std::shared_ptr<video_frame> video_frame_pool::impl::get_frame() {
                                 }
                                 ret->tiles[i].data_len = m_max_data_len;
                         }
+                        m_frame_generation[ret] = m_generation;
                 } catch (std::exception &e) {
                         log_msg(m_quiet ? LOG_LEVEL_DEBUG : LOG_LEVEL_ERROR,
                                 MOD_NAME "%s\n", e.what());
@@ -194,31 +232,63 @@ std::shared_ptr<video_frame> video_frame_pool::impl::get_frame() {
                 }
         }
         m_unreturned_frames += 1;
-        return std::shared_ptr<video_frame>(ret, [this, generation = m_generation](video_frame *frame) {
-                std::scoped_lock lk(m_lock);
+        return ret;
+}
+
+void video_frame_pool::impl::return_frame(struct video_frame *frame) {
+        std::unique_lock<std::mutex> lk(m_lock);
 
-                assert(m_unreturned_frames > 0);
-                m_unreturned_frames -= 1;
-                m_frame_returned.notify_one();
+        assert(m_unreturned_frames > 0);
+        m_unreturned_frames -= 1;
 
-                if(this->m_generation != generation){
-                        this->deallocate_frame(frame);
-                } else{
-                        m_free_frames.push(frame);
-                }
-        });
+        if (m_released || m_frame_generation.at(frame) != m_generation) {
+                deallocate_frame(frame);
+        } else {
+                m_free_frames.push_back(frame);
+        }
+        if (m_released && m_unreturned_frames == 0) {
+                lk.unlock();
+                delete this;
+                return;
+        }
+        m_frame_returned.notify_one();
 }
 
+/// restores properties a holder of the frame might have changed
+void video_frame_pool::impl::reset_frame(struct video_frame *frame) {
+        frame->color_spec = m_desc.color_spec;
+        frame->interlacing = m_desc.interlacing;
+        frame->fps = m_desc.fps;
+        frame->callbacks.dispose = nullptr;
+        frame->callbacks.dispose_udata = nullptr;
+        memset(&frame->VF_METADATA_START, 0, VF_METADATA_SIZE);
+        for (unsigned int i = 0; i < frame->tile_count; ++i) {
+                frame->tiles[i].width = m_desc.width;
+                frame->tiles[i].height = m_desc.height;
+                frame->tiles[i].data_len = m_max_data_len;
+        }
+}
+
+std::shared_ptr<video_frame> video_frame_pool::impl::get_frame() {
+        return std::shared_ptr<video_frame>(
+            acquire_frame(), [this](video_frame *frame) { return_frame(frame); });
+}
+
+/**
+ * Unlike get_frame(), this doesn't allocate anything if a free frame is
+ * available - the pool is referenced directly from dispose_udata.
+ */
 struct video_frame *video_frame_pool::impl::get_disposable_frame() {
-        auto && frame = get_frame();
-        struct video_frame *out = frame.get();
-        out->callbacks.dispose_udata =
-            new std::shared_ptr<video_frame>(std::move(frame));
-        static auto dispose = [](video_frame *f) { delete static_cast<std::shared_ptr<video_frame> *>(f->callbacks.dispose_udata); };
-        out->callbacks.dispose = dispose;
+        struct video_frame *out = acquire_frame();
+        out->callbacks.dispose_udata = this;
+        out->callbacks.dispose = dispose_frame;
         return out;
 }
 
+void video_frame_pool::impl::dispose_frame(struct video_frame *frame) {
+        static_cast<impl *>(frame->callbacks.dispose_udata)->return_frame(frame);
+}
+
 struct video_frame *video_frame_pool::impl::get_pod_frame() {
         auto && frame = get_frame();
         struct video_frame *out = vf_alloc_desc(video_desc_from_frame(frame.get()));
@@ -237,11 +307,10 @@ video_frame_pool_allocator const & video_frame_pool::impl::get_allocator() {
 }
 
 void video_frame_pool::impl::remove_free_frames() {
-        while (!m_free_frames.empty()) {
-                struct video_frame *frame = m_free_frames.front();
-                m_free_frames.pop();
+        for (struct video_frame *frame : m_free_frames) {
                 deallocate_frame(frame);
         }
+        m_free_frames.clear();
 }
 
 void video_frame_pool::impl::deallocate_frame(struct video_frame *frame) {
@@ -250,6 +319,7 @@ void video_frame_pool::impl::deallocate_frame(struct video_frame *frame) {
         for (unsigned int i = 0; i < frame->tile_count; ++i) {
                 m_allocator->deallocate(frame->tiles[i].data);
         }
+        m_frame_generation.erase(frame);
         vf_free(frame);
 }
 
@@ -275,6 +345,12 @@ video_frame_pool_init(struct video_desc desc, int len)
         return video_frame_pool_init_with_allocator(desc, len, &allocator);
 }
 
+void
+video_frame_pool_reconfigure(struct video_frame_pool *s, struct video_desc desc)
+{
+        s->reconfigure(desc);
+}
+
 struct video_frame *
 video_frame_pool_get_disposable_frame(struct video_frame_pool *s)
 {
@@ -286,3 +362,16 @@ video_frame_pool_destroy(struct video_frame_pool *s)
 {
         delete s;
 }
+
+void
+video_frame_pool_release(struct video_frame_pool *s)
+{
+        s->release();
+        delete s;
+}
+
+bool
+video_frame_pool_is_disposable_frame(const struct video_frame *frame)
+{
+        return video_frame_pool::is_disposable_frame(frame);
+}
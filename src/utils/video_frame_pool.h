@@ -93,7 +93,12 @@ struct video_frame_pool {
                  */
                 std::shared_ptr<video_frame> get_frame() noexcept(false);
 
-                /** @returns legacy struct pointer with dispose callback properly set */
+                /**
+                 * @returns legacy struct pointer with dispose callback properly set
+                 *
+                 * The frame is exclusively owned by the caller until disposed and
+                 * no allocation is performed if a free frame is available.
+                 */
                 struct video_frame *get_disposable_frame();
 
                 /** @returns frame eligible to be freed by vf_free() */
@@ -101,6 +106,16 @@ struct video_frame_pool {
 
                 video_frame_pool_allocator const & get_allocator();
 
+                /**
+                 * Frees the pool without waiting for the frames given out
+                 * (as the destructor does). Those are freed when returned.
+                 * The object may only be destroyed afterwards.
+                 */
+                void release();
+
+                /// @returns true if frame was obtained by get_disposable_frame()
+                static bool is_disposable_frame(const struct video_frame *frame);
+
         private:
                 struct impl;
                 std::unique_ptr<impl> m_impl;
@@ -114,8 +129,14 @@ EXTERN_C struct video_frame_pool *video_frame_pool_init(struct video_desc desc,
 EXTERN_C struct video_frame_pool *video_frame_pool_init_with_allocator(
     struct video_desc desc, int len,
     struct video_frame_pool_allocator *allocator);
+EXTERN_C void video_frame_pool_reconfigure(struct video_frame_pool *,
+                                           struct video_desc desc);
 EXTERN_C struct video_frame *
 video_frame_pool_get_disposable_frame(struct video_frame_pool *);
 EXTERN_C void video_frame_pool_destroy(struct video_frame_pool *);
+/// @copydoc video_frame_pool::release
+EXTERN_C void video_frame_pool_release(struct video_frame_pool *);
+EXTERN_C bool
+video_frame_pool_is_disposable_frame(const struct video_frame *frame);
 
 #endif // VIDEO_FRAME_POOL_H_
@@ -246,7 +246,9 @@ static const struct vo_postprocess_info vo_pp_crop_info = {
 static const struct capture_filter_info capture_filter_crop_info = {
         cf_crop_init,
         crop_done,
-        cf_crop_filter
+        cf_crop_filter,
+        NULL,
+        0,
 };
 
 REGISTER_MODULE(crop, &vo_pp_crop_info, LIBRARY_CLASS_VIDEO_POSTPROCESS, VO_PP_ABI_VERSION);
@@ -237,7 +237,9 @@ static const struct vo_postprocess_info vo_pp_deinterlace_info = {
 static const struct capture_filter_info capture_filter_deinterlace_info = {
         cf_deinterlace_init,
         deinterlace_done,
-        cf_deinterlace_filter
+        cf_deinterlace_filter,
+        NULL,
+        0,
 };
 
 REGISTER_MODULE(deinterlace_blend, &vo_pp_deinterlace_blend_info, LIBRARY_CLASS_VIDEO_POSTPROCESS, VO_PP_ABI_VERSION);
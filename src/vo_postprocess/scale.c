@@ -45,6 +45,7 @@
 #include "debug.h"
 #include "gl_context.h"      // for GL_TEXTURE_2D, glTexParameteri, glBindTe...
 #include "lib_common.h"
+#include "utils/fused_scale.h"
 #include "video_codec.h"
 #include "video_frame.h"
 #include "video_display.h"
@@ -54,6 +55,9 @@ static_assert(VO_PP_ABI_VERSION  == VO_PP_ABI_POSTPROCESS_NULLPTR);
 
 struct state_scale {
         struct video_frame *in;
+        bool use_gl;
+        enum fused_scale_algo algo;
+        struct fused_scale *fused; ///< CPU scaler (if !use_gl)
         struct gl_context context;
 
         int scaled_width, scaled_height;
@@ -64,19 +68,21 @@ struct state_scale {
 
 static bool scale_get_property(void *state, int property, void *val, size_t *len)
 {
+        struct state_scale *s = (struct state_scale *) state;
         bool ret = false;
-        codec_t supported[] = {UYVY, RGBA};
-
-        UNUSED(state);
+        codec_t supported_gl[] = {UYVY, RGBA};
+        codec_t supported[] = {UYVY, v210, RGB, RGBA, R10k, RG48};
+        const void *codecs = s->use_gl ? (void *) supported_gl : (void *) supported;
+        const size_t codecs_len = s->use_gl ? sizeof supported_gl : sizeof supported;
 
         switch(property) {
                 case VO_PP_PROPERTY_CODECS:
-                        if(*len < (int) sizeof(supported)) {
+                        if(*len < codecs_len) {
                                 fprintf(stderr, "Scale postprocessor query little space.\n");
                                 *len = 0; 
                         } else {
-                                memcpy(val, &supported, sizeof(supported));
-                                *len = sizeof(supported);
+                                memcpy(val, codecs, codecs_len);
+                                *len = codecs_len;
                         }
                         ret = true;
                         break;
@@ -88,7 +94,9 @@ static bool scale_get_property(void *state, int property, void *val, size_t *len
 static void usage()
 {
         printf("Scale postprocessor settings:\n");
-        printf("\t-p scale:width:height\n");
+        printf("\t-p scale:width:height[:algo=<a>][:gl]\n");
+        printf("\n\talgo - CPU scaling algorithm: linear (default), cubic, area or lanczos4\n");
+        printf("\tgl   - scale with OpenGL (bilinear, UYVY and RGBA only)\n");
 }
 
 static void * scale_init(const char *config) {
@@ -115,7 +123,18 @@ static void * scale_init(const char *config) {
         if (ptr != NULL) {
                 s->scaled_height = atoi(ptr);
         }
-        if (s->scaled_width <= 0 || s->scaled_height <= 0) {
+        s->algo = FUSED_SCALE_LINEAR;
+        while ((ptr = strtok_r(NULL, ":", &save_ptr)) != NULL) {
+                if (strcmp(ptr, "gl") == 0) {
+                        s->use_gl = true;
+                } else if (strncmp(ptr, "algo=", strlen("algo=")) == 0) {
+                        s->algo = fused_scale_algo_from_string(ptr + strlen("algo="));
+                } else {
+                        s->algo = FUSED_SCALE_ALGO_UNKN;
+                }
+        }
+        if (s->scaled_width <= 0 || s->scaled_height <= 0 ||
+                        s->algo == FUSED_SCALE_ALGO_UNKN) {
                 fprintf(stderr, "Scale postprocessor incorrect usage.\n");
                 usage();
                 free(s);
@@ -127,6 +146,10 @@ static void * scale_init(const char *config) {
 
         s->in = NULL;
 
+        if (!s->use_gl) {
+                return s;
+        }
+
         init_gl_context(&s->context, GL_CONTEXT_LEGACY);
         gl_context_make_current(&s->context);
 
@@ -187,6 +210,24 @@ scale_reconfigure(void *state, struct video_desc desc)
         assert(desc.tile_count >= 1);
         in_tile = vf_get_tile(s->in, 0);
 
+        if (!s->use_gl) {
+                // merged interlaced frames are scaled field by field
+                const int fields = desc.interlacing == INTERLACED_MERGED ? 2 : 1;
+                const struct fused_scale_params params = {
+                        .in_codec = desc.color_spec,
+                        .in_width = (int) desc.width,
+                        .in_height = (int) desc.height / fields,
+                        .out_codec = desc.color_spec,
+                        .out_width = s->scaled_width,
+                        .out_height = s->scaled_height / fields,
+                        .algo = s->algo,
+                        .threads = 0,
+                };
+                fused_scale_destroy(s->fused);
+                s->fused = fused_scale_init(&params);
+                return s->fused != NULL;
+        }
+
         gl_context_make_current(&s->context);
 
         glBindTexture(GL_TEXTURE_2D, s->tex_input);
@@ -238,6 +279,21 @@ static bool scale_postprocess(void *state, struct video_frame *in, struct video_
         int i;
         int width, height;
 
+        if (!s->use_gl) {
+                const int fields = in->interlacing == INTERLACED_MERGED ? 2 : 1;
+                for (i = 0; i < (int) in->tile_count; ++i) {
+                        const int in_linesize = vc_get_linesize(in->tiles[i].width, in->color_spec);
+                        for (int field = 0; field < fields; ++field) {
+                                fused_scale_frame(s->fused,
+                                                in->tiles[i].data + field * in_linesize,
+                                                fields * in_linesize,
+                                                out->tiles[i].data + field * req_pitch,
+                                                fields * req_pitch);
+                        }
+                }
+                return true;
+        }
+
         int src_linesize = vc_get_linesize(out->tiles[0].width, out->color_spec);
 
         char *tmp_data = NULL;
@@ -315,15 +371,18 @@ static void scale_done(void *state)
 {
         struct state_scale *s = (struct state_scale *) state;
 
-        glDeleteTextures(1, &s->tex_input);
-        glDeleteTextures(1, &s->tex_output);
-        glDeleteFramebuffers(1, &s->fbo);
-
-        free(s->in->tiles[0].data);
-
-        vf_free(s->in);
+        if (s->use_gl) {
+                glDeleteTextures(1, &s->tex_input);
+                glDeleteTextures(1, &s->tex_output);
+                glDeleteFramebuffers(1, &s->fbo);
+                destroy_gl_context(&s->context);
+        }
+        fused_scale_destroy(s->fused);
 
-        destroy_gl_context(&s->context);
+        if (s->in != NULL) {
+                free(s->in->tiles[0].data);
+                vf_free(s->in);
+        }
 
         free(state);
 }
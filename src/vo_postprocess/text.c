@@ -529,7 +529,9 @@ static const struct vo_postprocess_info vo_pp_text_info = {
 static const struct capture_filter_info capture_filter_text_info = {
         cf_text_init,
         text_done,
-        cf_text_filter
+        cf_text_filter,
+        NULL,
+        0,
 };
 
 
@@ -0,0 +1,302 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture_filter.h"
+#include "lib_common.h"
+#include "types.h"
+#include "unit_common.h"
+#include "utils/video_frame_pool.h"
+#include "video_codec.h"
+#include "video_frame.h"
+
+int capture_filter_test_pool_recycle(void);
+int capture_filter_test_pool_deferred_destroy(void);
+int capture_filter_test_chain_metadata_only(void);
+int capture_filter_test_chain_drop_wrapped(void);
+int capture_filter_test_chain_in_place(void);
+
+static const struct video_desc desc = { .width = 64, .height = 32,
+        .color_spec = UYVY, .interlacing = PROGRESSIVE, .fps = 25,
+        .tile_count = 1 };
+
+/**
+ * A returned frame must be handed out again (without allocation) with the
+ * properties changed by its previous holder restored.
+ */
+int capture_filter_test_pool_recycle(void)
+{
+        struct capture_filter_pool *pool = capture_filter_pool_init();
+        struct video_frame *f = capture_filter_pool_get_frame(pool, desc, NULL);
+        ASSERT(video_frame_pool_is_disposable_frame(f));
+        ASSERT_EQUAL(64, f->tiles[0].width);
+        struct video_frame *first = f;
+        f->fps = 50;
+        f->timestamp = 1000;
+        f->flags = TIMESTAMP_VALID;
+        VIDEO_FRAME_DISPOSE(f);
+
+        f = capture_filter_pool_get_frame(pool, desc, NULL);
+        ASSERT(f == first);
+        ASSERT(f->fps == 25);
+        ASSERT_EQUAL(0, f->timestamp);
+        ASSERT_EQUAL(0, f->flags);
+        struct video_frame *second = capture_filter_pool_get_frame(pool, desc, NULL);
+        ASSERT(second != f);
+        VIDEO_FRAME_DISPOSE(second);
+        VIDEO_FRAME_DISPOSE(f);
+
+        struct video_desc desc2 = desc;
+        desc2.width = 128;
+        f = capture_filter_pool_get_frame(pool, desc2, NULL);
+        ASSERT_EQUAL(128, f->tiles[0].width);
+        ASSERT_EQUAL(vc_get_datalen(128, 32, UYVY), f->tiles[0].data_len);
+        VIDEO_FRAME_DISPOSE(f);
+
+        char buf[64 * 32 * 2];
+        f = capture_filter_pool_get_frame(pool, desc, buf);
+        ASSERT(f->tiles[0].data == buf);
+        ASSERT(!video_frame_pool_is_disposable_frame(f));
+        VIDEO_FRAME_DISPOSE(f);
+
+        capture_filter_pool_destroy(pool);
+        return 0;
+}
+
+/**
+ * Destroying a pool must not wait for the frames still in use, those remain
+ * valid until disposed.
+ */
+int capture_filter_test_pool_deferred_destroy(void)
+{
+        struct capture_filter_pool *pool = capture_filter_pool_init();
+        struct video_frame *f1 = capture_filter_pool_get_frame(pool, desc, NULL);
+        struct video_frame *f2 = capture_filter_pool_get_frame(pool, desc, NULL);
+        VIDEO_FRAME_DISPOSE(f2);
+        capture_filter_pool_destroy(pool);
+
+        memset(f1->tiles[0].data, 0, f1->tiles[0].data_len);
+        VIDEO_FRAME_DISPOSE(f1);
+        return 0;
+}
+
+/*
+ * Filters exercising the chain - registered just in the test binary.
+ */
+static struct {
+        int producer_disposed;
+        int filter_called;
+        int in_place_called;
+        struct video_frame *pooled_out; ///< last frame returned by test_pooled
+        struct video_frame *pixel_in; ///< last frame seen by test_pixel
+} cnt;
+
+static void count_dispose(struct video_frame *f)
+{
+        cnt.producer_disposed += 1;
+        vf_free(f);
+}
+
+/// frame owned by a producer (capture), not by the chain
+static struct video_frame *producer_frame(void)
+{
+        struct video_frame *f = vf_alloc_desc_data(desc);
+        memset(f->tiles[0].data, 0x10, f->tiles[0].data_len);
+        f->callbacks.dispose = count_dispose;
+        return f;
+}
+
+static int test_init(struct module *parent, const char *cfg, void **state)
+{
+        (void) parent, (void) cfg;
+        *state = capture_filter_pool_init();
+        return 0;
+}
+
+static void test_done(void *state)
+{
+        capture_filter_pool_destroy(state);
+}
+
+static struct video_frame *meta_filter(void *state, struct video_frame *f)
+{
+        (void) state;
+        cnt.filter_called += 1;
+        return f;
+}
+
+static struct video_frame *meta_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        cnt.in_place_called += 1;
+        f->fps = 60;
+        f->timestamp = 1234;
+        return f;
+}
+
+static struct video_frame *drop_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        cnt.in_place_called += 1;
+        VIDEO_FRAME_DISPOSE(f);
+        return NULL;
+}
+
+static struct video_frame *pooled_filter(void *state, struct video_frame *in)
+{
+        if (in == NULL) {
+                return NULL;
+        }
+        struct video_frame *out =
+            capture_filter_pool_get_frame(state, video_desc_from_frame(in), NULL);
+        memcpy(out->tiles[0].data, in->tiles[0].data, in->tiles[0].data_len);
+        VIDEO_FRAME_DISPOSE(in);
+        cnt.pooled_out = out;
+        return out;
+}
+
+static struct video_frame *pixel_filter(void *state, struct video_frame *in)
+{
+        if (in == NULL) {
+                return NULL;
+        }
+        cnt.filter_called += 1;
+        cnt.pixel_in = in;
+        struct video_frame *out =
+            capture_filter_pool_get_frame(state, video_desc_from_frame(in), NULL);
+        for (unsigned i = 0; i < in->tiles[0].data_len; ++i) {
+                out->tiles[0].data[i] = (char) ~in->tiles[0].data[i];
+        }
+        VIDEO_FRAME_DISPOSE(in);
+        return out;
+}
+
+static struct video_frame *pixel_in_place(void *state, struct video_frame *f)
+{
+        (void) state;
+        cnt.in_place_called += 1;
+        cnt.pixel_in = f;
+        for (unsigned i = 0; i < f->tiles[0].data_len; ++i) {
+                f->tiles[0].data[i] = (char) ~f->tiles[0].data[i];
+        }
+        return f;
+}
+
+static const struct capture_filter_info test_meta_info = {
+        .init = test_init,
+        .done = test_done,
+        .filter = meta_filter,
+        .filter_in_place = meta_in_place,
+        .flags = CAPTURE_FILTER_METADATA_ONLY,
+};
+
+static const struct capture_filter_info test_drop_info = {
+        .init = test_init,
+        .done = test_done,
+        .filter = meta_filter,
+        .filter_in_place = drop_in_place,
+        .flags = CAPTURE_FILTER_METADATA_ONLY,
+};
+
+static const struct capture_filter_info test_pooled_info = {
+        .init = test_init,
+        .done = test_done,
+        .filter = pooled_filter,
+};
+
+static const struct capture_filter_info test_pixel_info = {
+        .init = test_init,
+        .done = test_done,
+        .filter = pixel_filter,
+        .filter_in_place = pixel_in_place,
+};
+
+REGISTER_HIDDEN_MODULE(test_meta, &test_meta_info, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
+REGISTER_HIDDEN_MODULE(test_drop, &test_drop_info, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
+REGISTER_HIDDEN_MODULE(test_pooled, &test_pooled_info, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
+REGISTER_HIDDEN_MODULE(test_pixel, &test_pixel_info, LIBRARY_CLASS_CAPTURE_FILTER, CAPTURE_FILTER_ABI_VERSION);
+
+/**
+ * Metadata-only filter must not alter the frame struct owned by the
+ * producer, which is disposed exactly once together with the output.
+ */
+int capture_filter_test_chain_metadata_only(void)
+{
+        struct capture_filter *cf = NULL;
+        ASSERT_EQUAL(0, capture_filter_init(NULL, "test_meta,test_meta", &cf));
+
+        for (int i = 0; i < 3; ++i) { // shells get recycled
+                memset(&cnt, 0, sizeof cnt);
+                struct video_frame *in = producer_frame();
+                struct video_frame *out = capture_filter(cf, in);
+                ASSERT(out != NULL);
+                ASSERT(out != in);
+                ASSERT_EQUAL(2, cnt.in_place_called);
+                ASSERT_EQUAL(0, cnt.filter_called);
+                ASSERT(out->fps == 60);
+                ASSERT_EQUAL(1234, out->timestamp);
+                ASSERT(out->tiles[0].data == in->tiles[0].data);
+                ASSERT(in->fps == 25);
+                ASSERT_EQUAL(0, in->timestamp);
+                ASSERT_EQUAL(0, cnt.producer_disposed);
+                VIDEO_FRAME_DISPOSE(out);
+                ASSERT_EQUAL(1, cnt.producer_disposed);
+        }
+
+        capture_filter_destroy(cf);
+        return 0;
+}
+
+/**
+ * Dropping a wrapped frame (eg. by every or ratelimit) must release the
+ * wrapped producer frame.
+ */
+int capture_filter_test_chain_drop_wrapped(void)
+{
+        struct capture_filter *cf = NULL;
+        ASSERT_EQUAL(0, capture_filter_init(NULL, "test_meta,test_drop", &cf));
+
+        for (int i = 0; i < 3; ++i) {
+                memset(&cnt, 0, sizeof cnt);
+                ASSERT(capture_filter(cf, producer_frame()) == NULL);
+                ASSERT_EQUAL(2, cnt.in_place_called);
+                ASSERT_EQUAL(1, cnt.producer_disposed);
+        }
+
+        capture_filter_destroy(cf);
+        return 0;
+}
+
+/**
+ * Pixel filter following a filter producing pooled frames runs in place,
+ * while on a producer-owned frame the regular (copying) callback is used.
+ */
+int capture_filter_test_chain_in_place(void)
+{
+        struct capture_filter *cf = NULL;
+        ASSERT_EQUAL(0, capture_filter_init(NULL, "test_pooled,test_pixel", &cf));
+        memset(&cnt, 0, sizeof cnt);
+        struct video_frame *out = capture_filter(cf, producer_frame());
+        ASSERT(out != NULL);
+        ASSERT(out == cnt.pooled_out);
+        ASSERT(cnt.pixel_in == cnt.pooled_out);
+        ASSERT_EQUAL(1, cnt.in_place_called);
+        ASSERT_EQUAL(0, cnt.filter_called);
+        ASSERT_EQUAL(1, cnt.producer_disposed);
+        ASSERT_EQUAL((char) ~0x10, out->tiles[0].data[0]);
+        VIDEO_FRAME_DISPOSE(out);
+        capture_filter_destroy(cf);
+
+        ASSERT_EQUAL(0, capture_filter_init(NULL, "test_pixel", &cf));
+        memset(&cnt, 0, sizeof cnt);
+        struct video_frame *in = producer_frame();
+        out = capture_filter(cf, in);
+        ASSERT(out != in);
+        ASSERT_EQUAL(0, cnt.in_place_called);
+        ASSERT_EQUAL(1, cnt.filter_called);
+        ASSERT_EQUAL(1, cnt.producer_disposed);
+        ASSERT_EQUAL((char) ~0x10, out->tiles[0].data[0]);
+        VIDEO_FRAME_DISPOSE(out);
+        capture_filter_destroy(cf);
+        return 0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <list>
 #include <sstream>
@@ -5,6 +7,10 @@
 #include <utility>
 #include <vector>
 
+#include "from_planar.h"
+#include "host.h"
+#include "pixfmt_conv.h"
+#include "pixfmt_conv_plan.h"
 #include "to_planar.h"
 #include "unit_common.h"
 #include "video_codec.h"
@@ -18,6 +24,9 @@ using std::to_string;
 using std::ostringstream;
 using std::vector;
 
+extern "C" int codec_conversion_test_multi_hop(void);
+extern "C" int codec_conversion_test_multi_hop_planar(void);
+extern "C" int codec_conversion_test_simd_bitexact(void);
 extern "C" int codec_conversion_test_testcard_uyvy_to_i420(void);
 extern "C" int codec_conversion_test_y216_to_p010le(void);
 
@@ -164,3 +173,248 @@ codec_conversion_test_y216_to_p010le(void)
         }
         return 0;
 }
+
+/**
+ * Checks that the SIMD line decoders produce the same output as the scalar
+ * ones, including line tails and no writes past dst_len. Variants not
+ * supported by the CPU running the test are skipped.
+ */
+int
+codec_conversion_test_simd_bitexact(void)
+{
+        const char *isas[] = { "avx2", "avx512" };
+        const int shifts[][3] = { { DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                                    DEFAULT_B_SHIFT },
+                                  { 16, 8, 0 },
+                                  { 24, 16, 8 } };
+        vector<int> widths = { 1920, 1921, 3840 };
+        for (int i = 1; i <= 130; ++i) {
+                widths.push_back(i);
+        }
+        srand(0);
+        for (int in = VIDEO_CODEC_FIRST; in < VIDEO_CODEC_COUNT; ++in) {
+                for (int out = VIDEO_CODEC_FIRST; out < VIDEO_CODEC_COUNT;
+                     ++out) {
+                        for (const char *isa : isas) {
+                                decoder_t simd = get_decoder_from_to_isa(
+                                    (codec_t) in, (codec_t) out, isa);
+                                if (simd == nullptr) {
+                                        continue;
+                                }
+                                decoder_t scalar = get_decoder_from_to_isa(
+                                    (codec_t) in, (codec_t) out, "scalar");
+                                ASSERT_MESSAGE(string("no scalar decoder for ") + isa,
+                                               scalar != nullptr);
+                                for (int width : widths) {
+                                        const int src_len = vc_get_linesize(
+                                            width, (codec_t) in);
+                                        const int dst_len = vc_get_linesize(
+                                            width, (codec_t) out);
+                                        // decoders may consume more than src_len if dst_len is padded (v210)
+                                        vector<unsigned char> src(
+                                            std::max(src_len, 2 * dst_len) +
+                                            MAX_PADDING);
+                                        for (auto &b : src) {
+                                                b = rand() & 0xFF;
+                                        }
+                                        for (const auto &sh : shifts) {
+                                                vector<unsigned char> expected(
+                                                    dst_len + MAX_PADDING, 0xA5);
+                                                vector<unsigned char> actual = expected;
+                                                scalar(expected.data(), src.data(),
+                                                       dst_len, sh[0], sh[1], sh[2]);
+                                                simd(actual.data(), src.data(),
+                                                     dst_len, sh[0], sh[1], sh[2]);
+                                                ostringstream oss;
+                                                oss << get_codec_name((codec_t) in)
+                                                    << "->"
+                                                    << get_codec_name((codec_t) out)
+                                                    << " " << isa
+                                                    << " width: " << width
+                                                    << " shifts: " << sh[0]
+                                                    << "," << sh[1] << ","
+                                                    << sh[2];
+                                                ASSERT_MESSAGE(oss.str(),
+                                                               expected == actual);
+                                        }
+                                }
+                        }
+                }
+        }
+        return 0;
+}
+
+/**
+ * R12L can be converted directly to UYVY only, but the planner should prefer
+ * the 10-bit v210 reachable over intermediate formats of at least 12 bits. Result must
+ * be the same as running the decoders along the path by hand.
+ */
+int
+codec_conversion_test_multi_hop(void)
+{
+        set_commandline_param("pixfmt-conv-costs", "none");
+        const codec_t candidates[] = { UYVY, v210, VIDEO_CODEC_NONE };
+        codec_t out = VIDEO_CODEC_NONE;
+        const int width = 1920;
+        struct pixfmt_conv_chain *chain =
+            pixfmt_conv_chain_create(R12L, candidates, &out, width);
+        ASSERT_MESSAGE("no conversion from R12L", chain != nullptr);
+        ASSERT_EQUAL(v210, out);
+        codec_t path[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        const int hops = pixfmt_conv_chain_get_path(chain, path);
+        ASSERT_MESSAGE("no intermediate format", hops >= 2);
+        for (int i = 1; i < hops; ++i) {
+                ASSERT_MESSAGE("intermediate format degrades bit depth",
+                               get_pixfmt_desc(path[i]).depth >= 12);
+        }
+
+        vector<unsigned char> src(vc_get_linesize(width, R12L) + MAX_PADDING);
+        for (size_t i = 0; i < src.size(); ++i) {
+                src[i] = i * 37;
+        }
+        // run the decoders along the path by hand
+        vector<unsigned char> expected = src;
+        for (int i = 1; i <= hops; ++i) {
+                const int len = vc_get_linesize(width, path[i]);
+                vector<unsigned char> next(2 * len + MAX_PADDING);
+                get_decoder_from_to(path[i - 1], path[i])(
+                    next.data(), expected.data(), len, DEFAULT_R_SHIFT,
+                    DEFAULT_G_SHIFT, DEFAULT_B_SHIFT);
+                expected = std::move(next);
+        }
+        expected.resize(vc_get_linesize(width, out));
+        vector<unsigned char> actual(expected.size());
+        pixfmt_conv_chain_line(chain, actual.data(), src.data(),
+                               DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                               DEFAULT_B_SHIFT);
+        ASSERT_MESSAGE("chain output differs", expected == actual);
+
+        // parts of the line (as received in packets) aligned to 48 pixels
+        enum { PART_PX = 48 };
+        vector<unsigned char> parts(expected.size() + MAX_PADDING);
+        for (int x = 0; x < width; x += PART_PX) {
+                const int dst_len = vc_get_size(PART_PX, out);
+                pixfmt_conv_chain_line_part(
+                    chain, parts.data() + vc_get_size(x, out),
+                    src.data() + vc_get_size(x, R12L), dst_len,
+                    DEFAULT_R_SHIFT, DEFAULT_G_SHIFT, DEFAULT_B_SHIFT);
+        }
+        parts.resize(vc_get_size(width, out));
+        actual.resize(parts.size());
+        pixfmt_conv_chain_destroy(chain);
+        ASSERT_MESSAGE("line parts differ", parts == actual);
+
+        // natively supported format is just copied
+        chain = pixfmt_conv_chain_create(UYVY, candidates, &out, width);
+        ASSERT_EQUAL(UYVY, out);
+        ASSERT_EQUAL(1, pixfmt_conv_chain_get_path(chain, path));
+        pixfmt_conv_chain_destroy(chain);
+        return 0;
+}
+
+/// runs line decoders path[from] -> ... -> path[to] on a whole frame
+static vector<unsigned char>
+decode_frame_along(const vector<unsigned char> &src, const codec_t *path,
+                   int from, int to, int width, int height)
+{
+        vector<unsigned char> ret = src;
+        for (int i = from + 1; i <= to; ++i) {
+                const int src_linesize = vc_get_linesize(width, path[i - 1]);
+                const int dst_linesize = vc_get_linesize(width, path[i]);
+                vector<unsigned char> next(
+                    vc_get_datalen(width, height, path[i]) + MAX_PADDING);
+                for (int y = 0; y < height; ++y) {
+                        get_decoder_from_to(path[i - 1], path[i])(
+                            next.data() + y * dst_linesize,
+                            ret.data() + y * src_linesize, dst_linesize,
+                            DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                            DEFAULT_B_SHIFT);
+                }
+                ret = std::move(next);
+        }
+        return ret;
+}
+
+/**
+ * Chains created with pixfmt_conv_chain_create_frame() may start or end with
+ * I420. Converted frames must be the same as when running the conversions
+ * along the path on whole frames by hand.
+ */
+int
+codec_conversion_test_multi_hop_planar(void)
+{
+        set_commandline_param("pixfmt-conv-costs", "none");
+        const int width = 1920;
+        const int height = 7; // odd to test the last 4:2:0 strip
+        const int uyvy_linesize = vc_get_linesize(width, UYVY);
+        vector<unsigned char> rgba(vc_get_datalen(width, height, RGBA) +
+                                   MAX_PADDING);
+        for (size_t i = 0; i < rgba.size(); ++i) {
+                rgba[i] = i * 37;
+        }
+
+        // RGBA [-> ...] -> UYVY -> I420
+        const codec_t i420_out[] = { I420, VIDEO_CODEC_NONE };
+        codec_t out = VIDEO_CODEC_NONE;
+        struct pixfmt_conv_chain *chain = pixfmt_conv_chain_create_frame(
+            RGBA, i420_out, &out, width);
+        ASSERT_MESSAGE("no conversion from RGBA to I420", chain != nullptr);
+        ASSERT_EQUAL(I420, out);
+        ASSERT_MESSAGE("line chain must not convert to planar",
+                       pixfmt_conv_chain_create(RGBA, i420_out, &out, width) ==
+                           nullptr);
+        codec_t path[PIXFMT_CONV_PLAN_MAX_HOPS + 1];
+        int hops = pixfmt_conv_chain_get_path(chain, path);
+        ASSERT_EQUAL(UYVY, path[hops - 1]);
+        vector<unsigned char> uyvy =
+            decode_frame_along(rgba, path, 0, hops - 1, width, height);
+        const size_t i420_len = vc_get_datalen(width, height, I420);
+        vector<unsigned char> expected(i420_len + MAX_PADDING);
+        testcard_convert_buffer(UYVY, I420, expected.data(), uyvy.data(),
+                                width, height);
+        vector<unsigned char> i420(i420_len + MAX_PADDING);
+        pixfmt_conv_chain_frame(chain, i420.data(), rgba.data(), height,
+                                DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                                DEFAULT_B_SHIFT);
+        pixfmt_conv_chain_destroy(chain);
+        ASSERT_MESSAGE("RGBA->I420 differs",
+                       std::equal(expected.begin(),
+                                  expected.begin() + i420_len, i420.begin()));
+
+        // I420 -> UYVY [-> ...] -> RGBA
+        const codec_t rgba_out[] = { RGBA, VIDEO_CODEC_NONE };
+        chain = pixfmt_conv_chain_create_frame(I420, rgba_out, &out, width);
+        ASSERT_MESSAGE("no conversion from I420 to RGBA", chain != nullptr);
+        ASSERT_EQUAL(RGBA, out);
+        hops = pixfmt_conv_chain_get_path(chain, path);
+        ASSERT_EQUAL(UYVY, path[1]);
+        const int chr_w = (width + 1) / 2;
+        const int chr_h = (height + 1) / 2;
+        struct from_planar_data d = {
+                .width = width,
+                .height = height,
+                .out_data = uyvy.data(),
+                .out_pitch = (unsigned) uyvy_linesize,
+                .in_data = { i420.data(), i420.data() + width * height,
+                             i420.data() + width * height + chr_w * chr_h },
+                .in_linesize = { (unsigned) width, (unsigned) chr_w,
+                                 (unsigned) chr_w },
+                .in_depth = DEPTH8,
+                .log2_chroma_h = 1,
+                .rgb_shift = { DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                               DEFAULT_B_SHIFT },
+        };
+        yuv420p_to_uyvy(d);
+        expected = decode_frame_along(uyvy, path, 1, hops, width, height);
+        const size_t rgba_len = vc_get_datalen(width, height, RGBA);
+        vector<unsigned char> actual(rgba_len + MAX_PADDING);
+        pixfmt_conv_chain_frame(chain, actual.data(), i420.data(), height,
+                                DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                                DEFAULT_B_SHIFT);
+        pixfmt_conv_chain_destroy(chain);
+        ASSERT_MESSAGE("I420->RGBA differs",
+                       std::equal(expected.begin(),
+                                  expected.begin() + rgba_len,
+                                  actual.begin()));
+        return 0;
+}
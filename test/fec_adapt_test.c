@@ -0,0 +1,62 @@
+#include <stdbool.h>
+
+#include "rtp/fec_adapt.h"
+#include "rtp/pbuf.h"
+#include "types.h"
+#include "unit_common.h"
+
+int fec_adapt_test_rs(void);
+
+enum {
+        FRAME_PKTS = 1000,
+        REPORT_PKTS = 10000,
+};
+
+static void report(struct fec_adapt *s, double loss, int burst_bucket)
+{
+        struct pbuf_loss_report r = { .expected = REPORT_PKTS,
+                .received = REPORT_PKTS - (uint32_t) (loss * REPORT_PKTS) };
+        if (loss > 0.0) {
+                r.bursts[burst_bucket] = (r.expected - r.received) / (1U << burst_bucket);
+        }
+        fec_adapt_report(s, &r);
+}
+
+/**
+ * RS parity must follow the reported loss - rise immediately, decrease only
+ * after several clean reports, and stay untouched without new reports.
+ */
+int fec_adapt_test_rs(void)
+{
+        struct fec_adapt *s = fec_adapt_init(FEC_RS, true);
+        struct fec_desc d;
+        ASSERT(fec_adapt_update(s, FRAME_PKTS, &d));
+        ASSERT_EQUAL(FEC_RS, d.type);
+        ASSERT_EQUAL(255, d.k + d.m);
+        const unsigned initial_m = d.m;
+        ASSERT(!fec_adapt_update(s, FRAME_PKTS, &d));
+
+        report(s, 0.05, 2); // 5 %, bursts of 4-7 packets
+        ASSERT(fec_adapt_update(s, FRAME_PKTS, &d));
+        ASSERT(d.m > initial_m);
+        ASSERT(d.m >= 2 * 0.05 * (d.k + d.m));
+        ASSERT(fec_adapt_dup_1st_pkt(s));
+        const unsigned lossy_m = d.m;
+
+        for (int i = 0; i < 2; ++i) {
+                report(s, 0.0, 0);
+                ASSERT(!fec_adapt_update(s, FRAME_PKTS, &d));
+        }
+        report(s, 0.0, 0);
+        ASSERT(fec_adapt_update(s, FRAME_PKTS, &d));
+        ASSERT(d.m < lossy_m);
+
+        fec_adapt_destroy(s);
+
+        s = fec_adapt_init(FEC_RS, false);
+        report(s, 0.05, 0);
+        ASSERT(!fec_adapt_dup_1st_pkt(s));
+        fec_adapt_destroy(s);
+        ASSERT(fec_adapt_init(FEC_MULT, true) == NULL);
+        return 0;
+}
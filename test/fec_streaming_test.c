@@ -0,0 +1,120 @@
+/**
+ * @file   test/fec_streaming_test.c
+ * @brief  streaming FEC encoding tests
+ */
+/*
+ * Copyright (c) 2026 CESNET, zájmové sdružení právnických osob
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, is permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of CESNET nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp/fec.h"
+#include "types.h"
+#include "unit_common.h"
+#include "video_frame.h"
+
+int fec_streaming_test_unequal_tiles(void);
+
+static const int tile_len[] = { 3000, 100000 }; // smaller tile first
+
+static int check_streaming(const char *cfg)
+{
+        struct video_desc desc = { .width = 1920, .height = 1080,
+                .color_spec = H264, .interlacing = PROGRESSIVE, .fps = 25,
+                .tile_count = 2 };
+        struct video_frame *in = vf_alloc_desc(desc);
+        srand(1);
+        for (int i = 0; i < 2; ++i) {
+                in->tiles[i].data_len = tile_len[i];
+                in->tiles[i].data = malloc(tile_len[i]);
+                for (int j = 0; j < tile_len[i]; ++j) {
+                        in->tiles[i].data[j] = (char) rand();
+                }
+        }
+        in->callbacks.data_deleter = vf_data_deleter;
+
+        struct fec *fec = fec_create_from_config(cfg, false);
+        ASSERT_MESSAGE(cfg, fec != NULL);
+        struct video_frame *ref = fec_encode_video_frame(fec, in);
+        struct video_frame *out = fec_encode_video_frame_streaming(fec, in);
+        ASSERT_MESSAGE(cfg, out->callbacks.wait_parity != NULL);
+
+        const unsigned k = out->fec_params.k;
+        const unsigned n = k + out->fec_params.m;
+        for (unsigned i = 0; i < 2; ++i) {
+                ASSERT_EQUAL(ref->tiles[i].data_len, out->tiles[i].data_len);
+                const size_t parity = fec_get_parity_offset(out, i);
+                ASSERT_EQUAL(out->tiles[i].data_len / n * k, parity);
+                // systematic part must be ready before waiting for parity
+                ASSERT_MESSAGE(cfg, memcmp(ref->tiles[i].data,
+                                           out->tiles[i].data, parity) == 0);
+        }
+        // frame-wide symbol size is the one of the last (larger) tile
+        ASSERT(fec_get_parity_offset(out, 0) <
+               (size_t) k * out->fec_params.symbol_size);
+
+        out->callbacks.wait_parity(out);
+        for (unsigned i = 0; i < 2; ++i) {
+                ASSERT_MESSAGE(cfg, memcmp(ref->tiles[i].data,
+                                           out->tiles[i].data,
+                                           out->tiles[i].data_len) == 0);
+        }
+
+        VIDEO_FRAME_DISPOSE(out);
+        VIDEO_FRAME_DISPOSE(ref);
+        fec_destroy(fec);
+        vf_free(in);
+        return 0;
+}
+
+/**
+ * Parity offset must be computed per tile - tiles of a frame differ in the
+ * symbol size and only the last one is stored in video_frame::fec_params.
+ */
+int fec_streaming_test_unequal_tiles(void)
+{
+        if (check_streaming("RS cfg 200:240") != 0) {
+                return -1;
+        }
+#ifdef HAVE_LDGM
+        if (check_streaming("LDGM cfg 256:64:5") != 0) {
+                return -1;
+        }
+#endif
+        return 0;
+}
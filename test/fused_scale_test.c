@@ -0,0 +1,142 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat/c23.h" // IWYU pragma: keep
+#include "types.h"
+#include "unit_common.h"
+#include "utils/fused_scale.h"
+#include "video_codec.h"
+
+int fused_scale_test_identity(void);
+int fused_scale_test_downscale(void);
+
+static int
+scale(codec_t in_codec, int in_w, int in_h, const char *in, codec_t out_codec,
+      int out_w, int out_h, char *out, enum fused_scale_algo algo,
+      int threads)
+{
+        const struct fused_scale_params p = { in_codec,  in_w,  in_h, out_codec,
+                                              out_w,     out_h, algo, threads };
+        struct fused_scale *s = fused_scale_init(&p);
+        if (s == NULL) {
+                return -1;
+        }
+        fused_scale_frame(s, in, vc_get_linesize(in_w, in_codec), out,
+                          vc_get_linesize(out_w, out_codec));
+        fused_scale_destroy(s);
+        return 0;
+}
+
+/// same-size scaling must reproduce the input in every supported format
+int
+fused_scale_test_identity(void)
+{
+        const codec_t codecs[] = { UYVY, v210, RGB, RGBA, R10k, RG48 };
+        enum {
+                W = 192, // no line padding in any of the formats
+                H = 10,
+        };
+        for (unsigned i = 0; i < countof(codecs); ++i) {
+                const codec_t c  = codecs[i];
+                const int len    = vc_get_linesize(W, c) * H;
+                unsigned char *in  = malloc(len);
+                unsigned char *out = malloc(len);
+                srand(i);
+                for (int j = 0; j < len; ++j) {
+                        in[j] = rand() % 256;
+                }
+                if (c == RGBA) {
+                        for (int j = 3; j < len; j += 4) {
+                                in[j] = 0xFF;
+                        }
+                } else if (c == R10k) { // padding bits
+                        for (int j = 3; j < len; j += 4) {
+                                in[j] |= 0x3;
+                        }
+                } else if (c == v210) {
+                        for (int j = 3; j < len; j += 4) {
+                                in[j] &= 0x3F;
+                        }
+                }
+                ASSERT_EQUAL(0, scale(c, W, H, (char *) in, c, W, H,
+                                      (char *) out, FUSED_SCALE_LINEAR, 2));
+                ASSERT_MESSAGE(get_codec_name(c), memcmp(in, out, len) == 0);
+                free(in);
+                free(out);
+        }
+        return 0;
+}
+
+/**
+ * a uniform frame must stay uniform with every filter, results must not
+ * depend on the stripe count and a 2:1 area downscale averages the pixels
+ */
+int
+fused_scale_test_downscale(void)
+{
+        enum {
+                IN_W  = 384,
+                IN_H  = 216,
+                OUT_W = 128,
+                OUT_H = 72,
+        };
+        const unsigned char uyvy_px[] = { 60, 100, 200, 100 };
+        const int in_len  = vc_get_linesize(IN_W, UYVY) * IN_H;
+        const int out_len = vc_get_linesize(OUT_W, UYVY) * OUT_H;
+        unsigned char *in   = malloc(in_len);
+        unsigned char *out  = malloc(in_len); // big enough for all outputs
+        unsigned char *out2 = malloc(out_len);
+        for (int i = 0; i < in_len; ++i) {
+                in[i] = uyvy_px[i % 4];
+        }
+        const enum fused_scale_algo algos[] = {
+                FUSED_SCALE_LINEAR, FUSED_SCALE_CUBIC, FUSED_SCALE_AREA,
+                FUSED_SCALE_LANCZOS4
+        };
+        for (unsigned i = 0; i < countof(algos); ++i) {
+                ASSERT_EQUAL(0, scale(UYVY, IN_W, IN_H, (char *) in, UYVY,
+                                      OUT_W, OUT_H, (char *) out, algos[i],
+                                      1));
+                for (int j = 0; j < out_len; ++j) {
+                        ASSERT_OP(abs(out[j] - uyvy_px[j % 4]), <=, 1);
+                }
+        }
+
+        for (int i = 0; i < in_len; ++i) {
+                in[i] = rand() % 256;
+        }
+        ASSERT_EQUAL(0, scale(UYVY, IN_W, IN_H, (char *) in, UYVY, OUT_W,
+                              OUT_H, (char *) out, FUSED_SCALE_LANCZOS4, 1));
+        ASSERT_EQUAL(0, scale(UYVY, IN_W, IN_H, (char *) in, UYVY, OUT_W,
+                              OUT_H, (char *) out2, FUSED_SCALE_LANCZOS4, 5));
+        ASSERT(memcmp(out, out2, out_len) == 0);
+
+        // 2:1 RGB area downscale of vertical 0/255 stripes
+        const int rgb_in_len = vc_get_linesize(IN_W, RGB) * IN_H;
+        unsigned char *rgb   = malloc(rgb_in_len);
+        for (int i = 0; i < rgb_in_len; ++i) {
+                rgb[i] = (i / 3) % 2 == 0 ? 0 : 255;
+        }
+        ASSERT_EQUAL(0, scale(RGB, IN_W, IN_H, (char *) rgb, RGB, IN_W / 2,
+                              IN_H / 2, (char *) out, FUSED_SCALE_AREA, 3));
+        for (int i = 0; i < vc_get_linesize(IN_W / 2, RGB) * IN_H / 2; ++i) {
+                ASSERT_OP(abs(out[i] - 128), <=, 1);
+        }
+
+        // RGB white to limited-range UYVY
+        memset(rgb, 0xFF, rgb_in_len);
+        ASSERT_EQUAL(0, scale(RGB, IN_W, IN_H, (char *) rgb, UYVY, OUT_W,
+                              OUT_H, (char *) out, FUSED_SCALE_LINEAR, 2));
+        for (int i = 0; i < out_len; i += 2) {
+                ASSERT_OP(abs(out[i] - 128), <=, 1);
+                ASSERT_OP(abs(out[i + 1] - 235), <=, 1);
+        }
+
+        free(rgb);
+        free(in);
+        free(out);
+        free(out2);
+        return 0;
+}
@@ -0,0 +1,193 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "compat/net.h"
+#include "host.h"
+#include "rtp/net_udp.h"
+#include "rtp/pbuf.h"
+#include "rtp/rtp.h"
+#include "rtp/rtp_types.h"
+#include "tv.h"
+#include "unit_common.h"
+
+int pbuf_test_early_fec(void);
+int pbuf_test_nack(void);
+int pbuf_test_reordered(void);
+
+enum {
+        FRAME_PKTS = 600,
+        REORDER_DIST = 300,
+        FEC_K = 4,
+        FEC_M = 2,
+        FEC_SS = 100,
+};
+
+struct decoded {
+        int frames;
+        int pkts;
+        bool descending;
+};
+
+static void insert(struct pbuf *p, uint16_t seq, uint32_t ts, bool m)
+{
+        rtp_packet *pkt = udp_data_alloc(RTP_MAX_PACKET_LEN);
+        memset(pkt, 0, sizeof *pkt);
+        pkt->seq = seq;
+        pkt->ts = ts;
+        pkt->m = m;
+        pbuf_insert(p, pkt);
+}
+
+/// inserts a RS packet carrying FEC symbol sym of a single-tile frame
+static void insert_rs(struct pbuf *p, uint16_t seq, uint32_t ts, int sym)
+{
+        rtp_packet *pkt = udp_data_alloc(RTP_MAX_PACKET_LEN);
+        memset(pkt, 0, sizeof *pkt);
+        pkt->seq = seq;
+        pkt->ts = ts;
+        pkt->m = sym == FEC_K + FEC_M - 1;
+        pkt->pt = PT_VIDEO_RS;
+        pkt->data = (char *) (pkt + 1);
+        pkt->data_len = sizeof(fec_payload_hdr_t) + FEC_SS;
+        uint32_t hdr[5] = { htonl(ts), htonl(sym * FEC_SS), htonl((FEC_K + FEC_M) * FEC_SS),
+                htonl(FEC_K << 19 | FEC_M << 6), 0 };
+        memcpy(pkt->data, hdr, sizeof hdr);
+        pbuf_insert(p, pkt);
+}
+
+static int decode(struct coded_data *cdata, void *decode_data, struct pbuf_stats *stats)
+{
+        (void) stats;
+        struct decoded *d = decode_data;
+        d->frames += 1;
+        for (; cdata != NULL; cdata = cdata->nxt) {
+                d->pkts += 1;
+                if (cdata->nxt != NULL &&
+                    ((int16_t) (cdata->seqno - cdata->nxt->seqno) != 1 ||
+                     cdata->nxt->prv != cdata)) {
+                        d->descending = false;
+                }
+        }
+        return 1;
+}
+
+/**
+ * Inserts two frames with packets swapped in blocks of REORDER_DIST, the
+ * second one across the sequence number wrap-around, and a duplicate and
+ * a late packet for the first frame. Each frame must be decoded with all
+ * packets linked in descending sequence number order.
+ */
+int pbuf_test_reordered(void)
+{
+        struct pbuf *p = pbuf_init("test", NULL);
+        pbuf_set_playout_delay(p, 0);
+        const uint16_t first_seq[] = { 1000, (uint16_t) (65536 - FRAME_PKTS / 2) };
+        for (int f = 0; f < 2; ++f) {
+                for (int i = 0; i < FRAME_PKTS; ++i) {
+                        int idx = i ^ 1; // swap neighbours
+                        if (i < 2 * REORDER_DIST) { // and blocks
+                                idx = (idx + REORDER_DIST) % (2 * REORDER_DIST);
+                        }
+                        if (f == 0 && idx == FRAME_PKTS - 1) {
+                                continue; // delivered late
+                        }
+                        insert(p, first_seq[f] + idx, 3000 * (f + 1), idx == FRAME_PKTS - 1);
+                }
+                if (f == 1) {
+                        insert(p, first_seq[0] + 5, 3000, false); // duplicate
+                        insert(p, first_seq[0] + FRAME_PKTS - 1, 3000, true);
+                }
+        }
+
+        struct decoded d = { .descending = true };
+        const time_ns_t now = get_time_in_ns() + NS_IN_SEC;
+        ASSERT_EQUAL(1, pbuf_decode(p, now, decode, &d));
+        ASSERT_EQUAL(1, pbuf_decode(p, now, decode, &d));
+        ASSERT_EQUAL(0, pbuf_decode(p, now, decode, &d));
+        ASSERT_EQUAL(2, d.frames);
+        ASSERT_EQUAL(2 * FRAME_PKTS, d.pkts);
+        ASSERT(d.descending);
+
+        pbuf_remove(p, now + NS_IN_SEC);
+        ASSERT(pbuf_is_empty(p));
+        pbuf_destroy(p);
+        return 0;
+}
+
+/**
+ * With pbuf-early-fec, a RS frame must be passed to the decoder as soon as
+ * k symbols are received (tile count learnt from the previous frame) and
+ * the remaining parity discarded.
+ */
+int pbuf_test_early_fec(void)
+{
+        set_commandline_param("pbuf-early-fec", "");
+        struct pbuf *p = pbuf_init("test", NULL);
+        // read by pbuf_init() only - unset so that it doesn't leak to others
+        set_commandline_param("pbuf-early-fec", NULL);
+        pbuf_set_playout_delay(p, 0);
+        const time_ns_t now = get_time_in_ns() + NS_IN_SEC;
+
+        // no tile count known yet - decoded on M bit, the parity of the
+        // decodable tile is still discarded
+        for (int i = 0; i < FEC_K + FEC_M; ++i) {
+                insert_rs(p, 100 + i, 3000, i);
+        }
+        struct decoded d = { .descending = true };
+        ASSERT_EQUAL(1, pbuf_decode(p, now, decode, &d));
+        ASSERT_EQUAL(FEC_K, d.pkts);
+
+        // symbol 1 lost, the first parity completes the frame
+        const int syms[] = { 0, 2, 3 };
+        for (unsigned i = 0; i < sizeof syms / sizeof syms[0]; ++i) {
+                insert_rs(p, 200 + syms[i], 6000, syms[i]);
+        }
+        ASSERT_EQUAL(0, pbuf_decode(p, now, decode, &d));
+        insert_rs(p, 200 + FEC_K, 6000, FEC_K);
+        d = (struct decoded) { .descending = true };
+        ASSERT_EQUAL(1, pbuf_decode(p, now, decode, &d));
+        ASSERT_EQUAL(FEC_K, d.pkts);
+        insert_rs(p, 200 + FEC_K + 1, 6000, FEC_K + 1); // surplus
+        ASSERT_EQUAL(0, pbuf_decode(p, now, decode, &d));
+
+        pbuf_remove(p, now + NS_IN_SEC);
+        ASSERT(pbuf_is_empty(p));
+        pbuf_destroy(p);
+        return 0;
+}
+
+/**
+ * Missing packets must be requested by pbuf_get_nacks() once, again after the
+ * retry interval unless they arrived (a retransmission must not produce a
+ * false gap) and no longer when their frame is past the playout time.
+ */
+int pbuf_test_nack(void)
+{
+        struct pbuf *p = pbuf_init("test", NULL);
+        pbuf_set_playout_delay(p, 0.1);
+        uint16_t seqs[16];
+        ASSERT_EQUAL(0, pbuf_get_nacks(p, get_time_in_ns(), seqs, 16)); // enables
+
+        for (uint16_t seq = 10; seq < 20; ++seq) {
+                if (seq != 13 && seq != 14 && seq != 17) {
+                        insert(p, seq, 3000, seq == 19);
+                }
+        }
+        const time_ns_t t0 = get_time_in_ns();
+        ASSERT_EQUAL(3, pbuf_get_nacks(p, t0, seqs, 16));
+        ASSERT_EQUAL(13, seqs[0]);
+        ASSERT_EQUAL(14, seqs[1]);
+        ASSERT_EQUAL(17, seqs[2]);
+        ASSERT_EQUAL(0, pbuf_get_nacks(p, t0, seqs, 16));
+
+        insert(p, 14, 3000, false); // retransmitted
+        insert(p, 20, 6000, false);
+        ASSERT_EQUAL(2, pbuf_get_nacks(p, t0 + 20 * 1000 * 1000, seqs, 16));
+        ASSERT_EQUAL(13, seqs[0]);
+        ASSERT_EQUAL(17, seqs[1]);
+
+        ASSERT_EQUAL(0, pbuf_get_nacks(p, t0 + NS_IN_SEC, seqs, 16));
+
+        pbuf_destroy(p);
+        return 0;
+}
@@ -0,0 +1,68 @@
+#include <vector>
+
+#include "rtp/received_extents.hpp"
+#include "unit_common.h"
+
+extern "C" {
+        int received_extents_test_in_order();
+        int received_extents_test_out_of_order();
+}
+
+int received_extents_test_in_order()
+{
+        received_extents e;
+        for (int i = 0; i < 100; ++i) {
+                e.add(i * 1000, 1000);
+        }
+        ASSERT_EQUAL(1, (int) e.size());
+        ASSERT_EQUAL(100000, e.received_bytes());
+        ASSERT(e.contains(0, 100000));
+        ASSERT(!e.contains(0, 100001));
+
+        // duplicates and overlaps are not counted twice
+        e.add(5000, 1000);
+        e.add(99500, 1000);
+        ASSERT_EQUAL(100500, e.received_bytes());
+
+        e.clear();
+        ASSERT(e.empty());
+        ASSERT_EQUAL(0, e.received_bytes());
+        return 0;
+}
+
+int received_extents_test_out_of_order()
+{
+        received_extents e;
+        e.add(3000, 1000);
+        e.add(0, 1000);
+        e.add(6000, 1000);
+        ASSERT_EQUAL(3, (int) e.size());
+        ASSERT_EQUAL(3000, e.received_bytes());
+        ASSERT(e.contains(3000, 1000));
+        ASSERT(!e.contains(1000, 1000));
+        ASSERT(!e.contains(2500, 1000));
+
+        // fill the gap between the first two extents
+        e.add(1000, 2000);
+        ASSERT_EQUAL(2, (int) e.size());
+        ASSERT_EQUAL(5000, e.received_bytes());
+        ASSERT(e.contains(0, 4000));
+
+        // overlap both remaining extents
+        e.add(3500, 3000);
+        ASSERT_EQUAL(1, (int) e.size());
+        ASSERT_EQUAL(7000, e.received_bytes());
+        ASSERT_EQUAL(0, e[0].start);
+        ASSERT_EQUAL(7000, e[0].end);
+
+        // reversed order with a duplicate, merged on the first query
+        e.clear();
+        for (int i = 99; i >= 0; --i) {
+                e.add(i * 1000, 1000);
+        }
+        e.add(42000, 1000);
+        ASSERT_EQUAL(100000, e.received_bytes());
+        ASSERT_EQUAL(1, (int) e.size());
+        ASSERT(e.contains(0, 100000));
+        return 0;
+}
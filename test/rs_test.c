@@ -0,0 +1,110 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp/rs_simd.h"
+#include "unit_common.h"
+
+int rs_test_roundtrip(void);
+
+enum {
+        K    = 20,
+        N    = 28,
+        SZ   = 40000 + 37, // large enough to be split among workers, odd tail
+        LOST = N - K,
+};
+
+/// reference carry-less multiplication modulo 0x11d
+static uint8_t gf_mul_ref(uint8_t a, uint8_t b)
+{
+        unsigned r = 0;
+        for (int i = 0; i < 8; ++i) {
+                if (b & (1U << i)) {
+                        r ^= (unsigned) a << i;
+                }
+        }
+        for (int i = 15; i >= 8; --i) {
+                if (r & (1U << i)) {
+                        r ^= 0x11dU << (i - 8);
+                }
+        }
+        return r;
+}
+
+/**
+ * Checks zfec-compatible parity for k=2, n=3 (enc. row is {3, 2}), then
+ * encodes with all available kernels, checks that they agree and recovers
+ * LOST dropped primary symbols.
+ */
+int rs_test_roundtrip(void)
+{
+        struct rs_code *small = rs_code_new(2, 3);
+        const uint8_t   a = 0x57, b = 0xa3;
+        const uint8_t  *small_src[] = { &a, &b };
+        uint8_t         parity = 0;
+        uint8_t        *small_dst[] = { &parity };
+        const unsigned  small_idx[] = { 2 };
+        rs_code_encode(small, small_src, small_dst, small_idx, 1, 1);
+        ASSERT_EQUAL(gf_mul_ref(3, a) ^ gf_mul_ref(2, b), parity);
+        rs_code_destroy(small);
+
+        uint8_t *data = malloc((size_t) N * SZ);
+        uint8_t *ref  = malloc((size_t) N * SZ);
+        srand(1);
+        for (int i = 0; i < K * SZ; ++i) {
+                data[i] = rand();
+        }
+        const uint8_t *src[K];
+        uint8_t       *dst[N - K];
+        unsigned       dst_idx[N - K];
+        for (int i = 0; i < K; ++i) {
+                src[i] = data + i * SZ;
+        }
+        for (int i = 0; i < N - K; ++i) {
+                dst[i]     = data + (K + i) * SZ;
+                dst_idx[i] = K + i;
+        }
+
+        bool first = true;
+        for (int i = 0; i < 3; ++i) {
+                const char *isa = (const char *[]){ "scalar", "ssse3", "avx2" }[i];
+                struct rs_code *code = rs_code_new(K, N);
+                if (!rs_code_set_isa(code, isa)) {
+                        rs_code_destroy(code);
+                        continue;
+                }
+                rs_code_set_threads(code, 4);
+                memset(data + K * SZ, 0, (N - K) * SZ);
+                rs_code_encode(code, src, dst, dst_idx, N - K, SZ);
+                if (first) {
+                        memcpy(ref, data, (size_t) N * SZ);
+                        first = false;
+                } else {
+                        ASSERT_MESSAGE(isa, memcmp(ref, data, (size_t) N * SZ) == 0);
+                }
+
+                // drop every other primary symbol (up to LOST) and use parity
+                const uint8_t *in[K];
+                unsigned       index[K];
+                uint8_t       *out[LOST];
+                int            lost = 0;
+                for (int j = 0; j < K; ++j) {
+                        if (j % 2 == 1 && lost < LOST) {
+                                in[j]       = data + (K + lost) * SZ;
+                                index[j]    = K + lost;
+                                out[lost++] = data + j * SZ;
+                                memset(data + j * SZ, 0, SZ);
+                        } else {
+                                in[j]    = data + j * SZ;
+                                index[j] = j;
+                        }
+                }
+                ASSERT(rs_code_decode(code, in, out, index, SZ));
+                ASSERT_MESSAGE(isa, memcmp(ref, data, (size_t) K * SZ) == 0);
+                rs_code_destroy(code);
+        }
+        ASSERT(!first);
+        free(data);
+        free(ref);
+        return 0;
+}
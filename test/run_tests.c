@@ -72,13 +72,25 @@ long packet_rate = 13600;
 #define DEFINE_QUIET_TEST(func) { #func, func, true } // original tests that print status by itselves
 #define DEFINE_TEST(func) { #func, func, false }
 
+DECLARE_TEST(capture_filter_test_chain_drop_wrapped);
+DECLARE_TEST(capture_filter_test_chain_in_place);
+DECLARE_TEST(capture_filter_test_chain_metadata_only);
+DECLARE_TEST(capture_filter_test_pool_deferred_destroy);
+DECLARE_TEST(capture_filter_test_pool_recycle);
+DECLARE_TEST(codec_conversion_test_multi_hop);
+DECLARE_TEST(codec_conversion_test_multi_hop_planar);
+DECLARE_TEST(codec_conversion_test_simd_bitexact);
 DECLARE_TEST(codec_conversion_test_testcard_uyvy_to_i420);
 DECLARE_TEST(codec_conversion_test_y216_to_p010le);
+DECLARE_TEST(fec_adapt_test_rs);
+DECLARE_TEST(fec_streaming_test_unequal_tiles);
 DECLARE_TEST(ff_codec_conversions_test_yuv444pXXle_from_to_r10k);
 DECLARE_TEST(ff_codec_conversions_test_yuv444pXXle_from_to_r12l);
 DECLARE_TEST(ff_codec_conversions_test_yuv444p16le_from_to_rg48);
 DECLARE_TEST(ff_codec_conversions_test_yuv444p16le_from_to_rg48_out_of_range);
 DECLARE_TEST(ff_codec_conversions_test_pX10_from_to_v210);
+DECLARE_TEST(fused_scale_test_downscale);
+DECLARE_TEST(fused_scale_test_identity);
 DECLARE_TEST(get_framerate_test_2997);
 DECLARE_TEST(get_framerate_test_3000);
 DECLARE_TEST(get_framerate_test_free);
@@ -91,6 +103,12 @@ DECLARE_TEST(misc_test_replace_all);
 DECLARE_TEST(misc_test_ug_reltimedwait);
 DECLARE_TEST(misc_test_unit_evaluate);
 DECLARE_TEST(misc_test_video_desc_io_op_symmetry);
+DECLARE_TEST(pbuf_test_early_fec);
+DECLARE_TEST(pbuf_test_nack);
+DECLARE_TEST(pbuf_test_reordered);
+DECLARE_TEST(received_extents_test_in_order);
+DECLARE_TEST(received_extents_test_out_of_order);
+DECLARE_TEST(rs_test_roundtrip);
 
 static const struct {
         const char *name;
@@ -107,8 +125,18 @@ static const struct {
         DEFINE_QUIET_TEST(test_video_capture),
         DEFINE_QUIET_TEST(test_video_display),
 #endif
+        DEFINE_TEST(capture_filter_test_pool_recycle),
+        DEFINE_TEST(capture_filter_test_pool_deferred_destroy),
+        DEFINE_TEST(capture_filter_test_chain_metadata_only),
+        DEFINE_TEST(capture_filter_test_chain_drop_wrapped),
+        DEFINE_TEST(capture_filter_test_chain_in_place),
         DEFINE_TEST(codec_conversion_test_y216_to_p010le),
+        DEFINE_TEST(codec_conversion_test_multi_hop),
+        DEFINE_TEST(codec_conversion_test_multi_hop_planar),
+        DEFINE_TEST(codec_conversion_test_simd_bitexact),
         DEFINE_TEST(codec_conversion_test_testcard_uyvy_to_i420),
+        DEFINE_TEST(fec_adapt_test_rs),
+        DEFINE_TEST(fec_streaming_test_unequal_tiles),
 #if defined HAVE_LAVC
         DEFINE_TEST(ff_codec_conversions_test_yuv444pXXle_from_to_r10k),
         DEFINE_TEST(ff_codec_conversions_test_yuv444pXXle_from_to_r12l),
@@ -116,6 +144,8 @@ static const struct {
         DEFINE_TEST(ff_codec_conversions_test_yuv444p16le_from_to_rg48_out_of_range),
         DEFINE_TEST(ff_codec_conversions_test_pX10_from_to_v210),
 #endif // defined HAVE_LAVC
+        DEFINE_TEST(fused_scale_test_identity),
+        DEFINE_TEST(fused_scale_test_downscale),
         DEFINE_TEST(get_framerate_test_2997),
         DEFINE_TEST(get_framerate_test_3000),
         DEFINE_TEST(get_framerate_test_free),
@@ -128,6 +158,12 @@ static const struct {
         DEFINE_TEST(misc_test_ug_reltimedwait),
         DEFINE_TEST(misc_test_unit_evaluate),
         DEFINE_TEST(misc_test_video_desc_io_op_symmetry),
+        DEFINE_TEST(pbuf_test_early_fec),
+        DEFINE_TEST(pbuf_test_nack),
+        DEFINE_TEST(pbuf_test_reordered),
+        DEFINE_TEST(received_extents_test_in_order),
+        DEFINE_TEST(received_extents_test_out_of_order),
+        DEFINE_TEST(rs_test_roundtrip),
         DEFINE_TEST(test_sdp_parser),
 };
 
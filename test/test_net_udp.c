@@ -308,6 +308,50 @@ int test_net_udp(void)
  abort_length:
         udp_exit(s1);
 
+        /**********************************************************************/
+        /* Loopback packets to a socket with a receiving thread in bursts so  */
+        /* that they are received in batches to recycled buffers...           */
+        printf
+            ("Testing UDP/IP networking (IPv4 multithreaded) ........................... ");
+        fflush(stdout);
+        s1 = udp_init("127.0.0.1", 5004, 5004, 1, 0, true);
+        if (s1 == NULL) {
+                printf("FAIL\n");
+                printf("  Cannot initialize socket\n");
+                return -1;
+        }
+        for (i = 0; i < 64; i++) {
+                enum { BURST = 16 };
+                for (int j = 0; j < BURST; j++) {
+                        memset(buf1, i * BURST + j, BUFSIZE);
+                        if (udp_send(s1, buf1, BUFSIZE - j) < 0) {
+                                printf("FAIL\n");
+                                perror("  Cannot send");
+                                goto abort_multithreaded;
+                        }
+                }
+                for (int j = 0; j < BURST; j++) {
+                        memset(buf1, i * BURST + j, BUFSIZE);
+                        timeout.tv_sec = 1;
+                        timeout.tv_usec = 0;
+                        rc = udp_recv_timeout(s1, buf2, BUFSIZE, &timeout);
+                        if (rc != BUFSIZE - j) {
+                                printf("FAIL\n");
+                                printf("  Received %d B, expected %d B\n", rc,
+                                       BUFSIZE - j);
+                                goto abort_multithreaded;
+                        }
+                        if (memcmp(buf1, buf2, rc) != 0) {
+                                printf("FAIL\n");
+                                printf("  Buffer corrupt\n");
+                                goto abort_multithreaded;
+                        }
+                }
+        }
+        printf("Ok\n");
+ abort_multithreaded:
+        udp_exit(s1);
+
 #ifdef HAVE_IPv6
         /**********************************************************************/
         /* The first test is to loopback a packet to ourselves...             */
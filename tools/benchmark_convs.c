@@ -0,0 +1,486 @@
+/**
+ * Benchmarks UltraGrid pixel format conversions - all line decoders from
+ * pixfmt_conv.c (including SIMD variants), to_planar and from_planar
+ * conversions, each run directly and through the parallel wrappers
+ * (parallel_pix_conv, decode_to_planar_parallel, decode_planar_parallel).
+ *
+ * Every conversion is run over a whole frame with warm-up and repetitions,
+ * median and 99th percentile of ns/pixel and throughput (GB/s of source
+ * plus destination data per median frame time) are reported either as a
+ * table or as JSON (-j), which is suitable for tracking across releases.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "debug.h"
+#include "from_planar.h"
+#include "pixfmt_conv.h"
+#include "to_planar.h"
+#include "utils/parallel_conv.h"
+#include "video_codec.h"
+
+#define DEFAULT_SIZES   "1920x1080,3840x2160"
+#define DEFAULT_THREADS "1,0"
+
+enum {
+        MAX_LIST      = 16,
+        PLANE_PADDING = 4096,
+};
+
+struct opts {
+        int sizes[MAX_LIST][2];
+        int size_count;
+        int threads[MAX_LIST]; ///< 0 = all logical cores
+        int thread_count;
+        int warmup;
+        int repeats;
+        const char *filter;
+        bool json;
+};
+
+struct bench_ctx {
+        int width;
+        int height;
+        int threads;
+        unsigned char *in;
+        unsigned char *out;
+        unsigned char *planes[4];
+        // line decoder
+        decoder_t decoder;
+        codec_t in_codec;
+        codec_t out_codec;
+        // to/from planar
+        const struct to_planar_item *to;
+        const struct from_planar_item *from;
+};
+
+/// to_planar conversion; linesize of plane i is width * ls2[i] / 2
+struct to_planar_item {
+        const char *name;
+        decode_buffer_func_t *func;
+        codec_t in;
+        int ls2[4];
+        int h_div[4];
+};
+
+static const struct to_planar_item to_planar_items[] = {
+        { "v210_to_p010le",   v210_to_p010le,   v210, { 4, 4 },    { 1, 2 }    },
+        { "y216_to_p010le",   y216_to_p010le,   Y216, { 4, 4 },    { 1, 2 }    },
+        { "uyvy_to_nv12",     uyvy_to_nv12,     UYVY, { 2, 2 },    { 1, 2 }    },
+        { "rgba_to_bgra",     rgba_to_bgra,     RGBA, { 8 },       { 1 }       },
+        { "vuya_to_i444",     vuya_to_i444,     VUYA, { 2, 2, 2 }, { 1, 1, 1 } },
+        { "uyvy_to_i420",     uyvy_to_i420,     UYVY, { 2, 1, 1 }, { 1, 2, 2 } },
+        { "r12l_to_gbrp12le", r12l_to_gbrp12le, R12L, { 4, 4, 4 }, { 1, 1, 1 } },
+        { "r12l_to_gbrp16le", r12l_to_gbrp16le, R12L, { 4, 4, 4 }, { 1, 1, 1 } },
+        { "r12l_to_rgbp12le", r12l_to_rgbp12le, R12L, { 4, 4, 4 }, { 1, 1, 1 } },
+};
+
+/// from_planar conversion
+struct from_planar_item {
+        const char *name;
+        decode_planar_func_t *func;
+        codec_t out;
+        int planes;
+        int bps;           ///< bytes per sample
+        int chroma_w_div;
+        int log2_chroma_h;
+        int depth;
+        bool planar_out;   ///< cannot be run with decode_planar_parallel
+};
+
+static const struct from_planar_item from_planar_items[] = {
+        { "gbrap_to_rgb",        gbrap_to_rgb,        RGB,  4, 1, 1, 0, 8,  false },
+        { "gbrap_to_rgba",       gbrap_to_rgba,       RGBA, 4, 1, 1, 0, 8,  false },
+        { "gbrp10le_to_rgb",     gbrp10le_to_rgb,     RGB,  3, 2, 1, 0, 10, false },
+        { "gbrp10le_to_rgba",    gbrp10le_to_rgba,    RGBA, 3, 2, 1, 0, 10, false },
+        { "gbrp10le_to_rg48",    gbrp10le_to_rg48,    RG48, 3, 2, 1, 0, 10, false },
+        { "gbrp10le_to_r10k",    gbrp10le_to_r10k,    R10k, 3, 2, 1, 0, 10, false },
+        { "gbrp12le_to_rgb",     gbrp12le_to_rgb,     RGB,  3, 2, 1, 0, 12, false },
+        { "gbrp12le_to_rgba",    gbrp12le_to_rgba,    RGBA, 3, 2, 1, 0, 12, false },
+        { "gbrp12le_to_rg48",    gbrp12le_to_rg48,    RG48, 3, 2, 1, 0, 12, false },
+        { "gbrp12le_to_r10k",    gbrp12le_to_r10k,    R10k, 3, 2, 1, 0, 12, false },
+        { "gbrp12le_to_r12l",    gbrp12le_to_r12l,    R12L, 3, 2, 1, 0, 12, false },
+        { "gbrp16le_to_rgb",     gbrp16le_to_rgb,     RGB,  3, 2, 1, 0, 16, false },
+        { "gbrp16le_to_rgba",    gbrp16le_to_rgba,    RGBA, 3, 2, 1, 0, 16, false },
+        { "gbrp16le_to_rg48",    gbrp16le_to_rg48,    RG48, 3, 2, 1, 0, 16, false },
+        { "gbrp16le_to_r10k",    gbrp16le_to_r10k,    R10k, 3, 2, 1, 0, 16, false },
+        { "gbrp16le_to_r12l",    gbrp16le_to_r12l,    R12L, 3, 2, 1, 0, 16, false },
+        { "rgbpXX_to_rgb",       rgbpXX_to_rgb,       RGB,  3, 1, 1, 0, 8,  false },
+        { "rgbpXXle_to_rg48",    rgbpXXle_to_rg48,    RG48, 3, 2, 1, 0, 10, false },
+        { "rgbpXXle_to_r10k",    rgbpXXle_to_r10k,    R10k, 3, 2, 1, 0, 10, false },
+        { "rgbpXXle_to_r12l",    rgbpXXle_to_r12l,    R12L, 3, 2, 1, 0, 10, false },
+        { "yuv444p_to_vuya",     yuv444p_to_vuya,     VUYA, 3, 1, 1, 0, 8,  false },
+        { "yuv420p_to_uyvy",     yuv420p_to_uyvy,     UYVY, 3, 1, 2, 1, 8,  false },
+        { "yuv420_to_i420",      yuv420_to_i420,      I420, 3, 1, 2, 1, 8,  true  },
+        { "yuv422p_to_uyvy",     yuv422p_to_uyvy,     UYVY, 3, 1, 2, 0, 8,  false },
+        { "yuv422p_to_yuyv",     yuv422p_to_yuyv,     YUYV, 3, 1, 2, 0, 8,  false },
+        { "yuv422pXX_to_uyvy",   yuv422pXX_to_uyvy,   UYVY, 3, 2, 2, 0, 10, false },
+        { "yuv422p10le_to_uyvy", yuv422p10le_to_uyvy, UYVY, 3, 2, 2, 0, 10, false },
+        { "yuv422p10le_to_v210", yuv422p10le_to_v210, v210, 3, 2, 2, 0, 10, false },
+};
+
+static uint64_t
+now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+        uint64_t ta = *(const uint64_t *) a;
+        uint64_t tb = *(const uint64_t *) b;
+        return ta < tb ? -1 : ta > tb;
+}
+
+static void
+run_decoder(const struct bench_ctx *c)
+{
+        const int in_ls = vc_get_linesize(c->width, c->in_codec);
+        const int out_ls = vc_get_linesize(c->width, c->out_codec);
+        if (c->threads != 1) {
+                parallel_pix_conv(c->height, (char *) c->out, out_ls,
+                                  (const char *) c->in, in_ls, c->decoder,
+                                  c->threads);
+                return;
+        }
+        for (int y = 0; y < c->height; ++y) {
+                c->decoder(c->out + (size_t) y * out_ls,
+                           c->in + (size_t) y * in_ls, out_ls,
+                           DEFAULT_R_SHIFT, DEFAULT_G_SHIFT, DEFAULT_B_SHIFT);
+        }
+}
+
+static struct to_planar_data
+get_to_planar_data(const struct bench_ctx *c)
+{
+        struct to_planar_data d = { .width = c->width,
+                                    .height = c->height,
+                                    .in_data = c->in };
+        for (int i = 0; i < 4; ++i) {
+                d.out_data[i] = c->planes[i];
+                d.out_linesize[i] = c->width * c->to->ls2[i] / 2;
+        }
+        return d;
+}
+
+static void
+run_to_planar(const struct bench_ctx *c)
+{
+        struct to_planar_data d = get_to_planar_data(c);
+        if (c->threads != 1) {
+                decode_to_planar_parallel(c->to->func, d,
+                                          vc_get_linesize(c->width,
+                                                          c->to->in),
+                                          c->threads);
+        } else {
+                c->to->func(d);
+        }
+}
+
+static struct from_planar_data
+get_from_planar_data(const struct bench_ctx *c)
+{
+        const struct from_planar_item *it = c->from;
+        struct from_planar_data d = {
+                .width = c->width,
+                .height = c->height,
+                .out_data = c->out,
+                .out_pitch = it->planar_out ? c->width
+                                            : vc_get_linesize(c->width, it->out),
+                .in_depth = it->depth,
+                .log2_chroma_h = it->log2_chroma_h,
+                .rgb_shift = { DEFAULT_R_SHIFT, DEFAULT_G_SHIFT,
+                               DEFAULT_B_SHIFT },
+        };
+        for (int i = 0; i < 4; ++i) {
+                const bool chroma = i == 1 || i == 2;
+                d.in_data[i] = c->planes[i];
+                d.in_linesize[i] = c->width * it->bps /
+                                   (chroma ? it->chroma_w_div : 1);
+        }
+        return d;
+}
+
+static void
+run_from_planar(const struct bench_ctx *c)
+{
+        struct from_planar_data d = get_from_planar_data(c);
+        if (c->threads != 1) {
+                decode_planar_parallel(c->from->func, d, c->threads);
+        } else {
+                c->from->func(d);
+        }
+}
+
+static void
+report(const struct opts *o, bool *first, const char *kind, const char *name,
+       const char *isa, const struct bench_ctx *c, size_t bytes,
+       uint64_t *t)
+{
+        qsort(t, o->repeats, sizeof t[0], u64_cmp);
+        const double pixels = (double) c->width * c->height;
+        const double median = t[o->repeats / 2] / pixels;
+        const double p99 = t[(o->repeats * 99 + 99) / 100 - 1] / pixels;
+        const double gbps = bytes / (median * pixels);
+        if (o->json) {
+                printf("%s\n    { \"kind\": \"%s\", \"name\": \"%s\", "
+                       "\"isa\": \"%s\", \"width\": %d, \"height\": %d, "
+                       "\"threads\": %d, \"median_ns_per_px\": %.4f, "
+                       "\"p99_ns_per_px\": %.4f, \"gb_per_s\": %.3f }",
+                       *first ? "" : ",", kind, name, isa, c->width,
+                       c->height, c->threads, median, p99, gbps);
+        } else {
+                printf("%-20s %-22s %-7s %5dx%-5d %3d %10.4f %10.4f %9.3f\n",
+                       kind, name, isa, c->width, c->height, c->threads,
+                       median, p99, gbps);
+        }
+        *first = false;
+        fflush(stdout);
+}
+
+static void
+bench(const struct opts *o, bool *first, const char *kind, const char *name,
+      const char *isa, const struct bench_ctx *c, size_t bytes,
+      void (*run)(const struct bench_ctx *))
+{
+        if (o->filter != NULL && strstr(name, o->filter) == NULL) {
+                return;
+        }
+        uint64_t *t = malloc(o->repeats * sizeof *t);
+        for (int i = -o->warmup; i < o->repeats; ++i) {
+                const uint64_t start = now_ns();
+                run(c);
+                if (i >= 0) {
+                        t[i] = now_ns() - start;
+                }
+        }
+        report(o, first, kind, name, isa, c, bytes, t);
+        free(t);
+}
+
+static void
+bench_decoders(const struct opts *o, bool *first, struct bench_ctx *c)
+{
+        const char *isas[] = { "scalar", "avx2", "avx512" };
+        for (int in = VIDEO_CODEC_FIRST; in < VIDEO_CODEC_COUNT; ++in) {
+                for (int out = VIDEO_CODEC_FIRST; out < VIDEO_CODEC_COUNT;
+                     ++out) {
+                        for (unsigned i = 0; i < sizeof isas / sizeof isas[0];
+                             ++i) {
+                                c->decoder =
+                                    get_decoder_from_to_isa(in, out, isas[i]);
+                                if (c->decoder == NULL) {
+                                        continue;
+                                }
+                                c->in_codec = in;
+                                c->out_codec = out;
+                                char name[64];
+                                snprintf(name, sizeof name, "%s->%s",
+                                         get_codec_name(in),
+                                         get_codec_name(out));
+                                const size_t bytes =
+                                    vc_get_datalen(c->width, c->height, in) +
+                                    vc_get_datalen(c->width, c->height, out);
+                                bench(o, first,
+                                      c->threads == 1 ? "decoder"
+                                                      : "parallel_pix_conv",
+                                      name, isas[i], c, bytes, run_decoder);
+                        }
+                }
+        }
+}
+
+static void
+bench_planar(const struct opts *o, bool *first, struct bench_ctx *c)
+{
+        for (unsigned i = 0;
+             i < sizeof to_planar_items / sizeof to_planar_items[0]; ++i) {
+                c->to = &to_planar_items[i];
+                bool subsampled = false;
+                size_t bytes = vc_get_datalen(c->width, c->height, c->to->in);
+                for (int p = 0; p < 4 && c->to->ls2[p] != 0; ++p) {
+                        bytes += (size_t) c->width * c->to->ls2[p] / 2 *
+                                 (c->height / c->to->h_div[p]);
+                        subsampled = subsampled || c->to->h_div[p] != 1;
+                }
+                // the parallel wrapper splits only full-height planes
+                if (c->threads != 1 && subsampled) {
+                        continue;
+                }
+                bench(o, first,
+                      c->threads == 1 ? "to_planar"
+                                      : "to_planar_parallel",
+                      c->to->name, "", c, bytes, run_to_planar);
+        }
+        for (unsigned i = 0;
+             i < sizeof from_planar_items / sizeof from_planar_items[0];
+             ++i) {
+                c->from = &from_planar_items[i];
+                if (c->threads != 1 && c->from->planar_out) {
+                        continue;
+                }
+                const int w = c->width;
+                const int h = c->height;
+                const int cw = w / c->from->chroma_w_div;
+                const int ch = h >> c->from->log2_chroma_h;
+                size_t bytes = vc_get_datalen(w, h, c->from->out) +
+                               (size_t) c->from->bps * w * h +
+                               (size_t) c->from->bps * 2 * cw * ch;
+                if (c->from->planes == 4) {
+                        bytes += (size_t) c->from->bps * w * h;
+                }
+                bench(o, first,
+                      c->threads == 1 ? "from_planar"
+                                      : "from_planar_parallel",
+                      c->from->name, "", c, bytes, run_from_planar);
+        }
+}
+
+/// fills buffer with 16-bit values fitting into 10 bits (valid for any depth)
+static void
+fill_random(unsigned char *buf, size_t len)
+{
+        for (size_t i = 0; i + 1 < len; i += 2) {
+                const unsigned val = rand() & 0x3FF;
+                buf[i] = val & 0xFF;
+                buf[i + 1] = val >> 8;
+        }
+}
+
+static int
+parse_list(char *str, int *out, int max, bool size)
+{
+        int count = 0;
+        char *save = NULL;
+        for (char *tok = strtok_r(str, ",", &save); tok != NULL;
+             tok = strtok_r(NULL, ",", &save)) {
+                if (count == max) {
+                        return -1;
+                }
+                if (size) {
+                        if (sscanf(tok, "%dx%d", &out[2 * count],
+                                   &out[2 * count + 1]) != 2 ||
+                            out[2 * count] <= 0 || out[2 * count + 1] <= 0) {
+                                return -1;
+                        }
+                } else {
+                        char *end = NULL;
+                        out[count] = (int) strtol(tok, &end, 10);
+                        if (*end != '\0' || out[count] < 0) {
+                                return -1;
+                        }
+                }
+                count += 1;
+        }
+        return count;
+}
+
+static void
+usage(const char *progname)
+{
+        printf("Usage:\n"
+               "%s [-s <W>x<H>[,...]] [-t <threads>[,...]] [-w <warmup>] "
+               "[-r <repeats>] [-f <name_substr>] [-j]\n"
+               "\t-s - frame sizes (default " DEFAULT_SIZES ")\n"
+               "\t-t - thread counts, 1 runs the conversion directly, other "
+               "values\n\t     through the parallel wrappers, 0 uses all "
+               "cores (default " DEFAULT_THREADS ")\n"
+               "\t-w - warm-up runs (default 3)\n"
+               "\t-r - measured runs (default 20)\n"
+               "\t-f - run only conversions whose name contains the string\n"
+               "\t-j - JSON output\n",
+               progname);
+}
+
+int
+main(int argc, char *argv[])
+{
+        // silence warnings about reducing bit depth - not relevant here
+        log_level = LOG_LEVEL_ERROR;
+        struct opts o = { .warmup = 3, .repeats = 20 };
+        char sizes[1024] = DEFAULT_SIZES;
+        char threads[1024] = DEFAULT_THREADS;
+        int ch = 0;
+        while ((ch = getopt(argc, argv, "f:hjr:s:t:w:")) != -1) {
+                switch (ch) {
+                case 'f':
+                        o.filter = optarg;
+                        break;
+                case 'j':
+                        o.json = true;
+                        break;
+                case 'r':
+                        o.repeats = atoi(optarg);
+                        break;
+                case 's':
+                        snprintf(sizes, sizeof sizes, "%s", optarg);
+                        break;
+                case 't':
+                        snprintf(threads, sizeof threads, "%s", optarg);
+                        break;
+                case 'w':
+                        o.warmup = atoi(optarg);
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+        o.size_count = parse_list(sizes, &o.sizes[0][0], MAX_LIST, true);
+        o.thread_count = parse_list(threads, o.threads, MAX_LIST, false);
+        if (o.size_count <= 0 || o.thread_count <= 0 || o.repeats <= 0 ||
+            o.warmup < 0 || optind != argc) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        if (o.json) {
+                printf("{\n  \"best_isa\": \"%s\",\n  \"warmup\": %d,\n"
+                       "  \"repeats\": %d,\n  \"results\": [",
+                       pixfmt_conv_best_isa(), o.warmup, o.repeats);
+        } else {
+                printf("%-20s %-22s %-7s %11s %3s %10s %10s %9s\n", "kind",
+                       "conversion", "isa", "size", "thr", "med ns/px",
+                       "p99 ns/px", "GB/s");
+        }
+        bool first = true;
+        for (int s = 0; s < o.size_count; ++s) {
+                struct bench_ctx c = { .width = o.sizes[s][0],
+                                       .height = o.sizes[s][1] };
+                const size_t buf_len =
+                    (size_t) c.width * c.height * MAX_BPS + PLANE_PADDING;
+                c.in = malloc(buf_len);
+                c.out = malloc(buf_len);
+                fill_random(c.in, buf_len);
+                memset(c.out, 0, buf_len);
+                for (int i = 0; i < 4; ++i) {
+                        c.planes[i] = malloc(buf_len);
+                        fill_random(c.planes[i], buf_len);
+                }
+                for (int t = 0; t < o.thread_count; ++t) {
+                        c.threads = o.threads[t];
+                        bench_decoders(&o, &first, &c);
+                        bench_planar(&o, &first, &c);
+                }
+                free(c.in);
+                free(c.out);
+                for (int i = 0; i < 4; ++i) {
+                        free(c.planes[i]);
+                }
+        }
+        if (o.json) {
+                printf("\n  ]\n}\n");
+        }
+}